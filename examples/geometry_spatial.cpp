@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/geometry/spatial.h"
+
+// Build time and query throughput of KDTree and HashGrid over 2M random
+// points, with a million kNN and radius queries split between threads
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    constexpr size_t n = 2000000, num_queries = 1000000, k = 8;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(0, 1);
+    common::VecList3f points(n), queries(num_queries);
+    for (auto& p : points) p = common::Vec3f(dist(rng), dist(rng), dist(rng));
+    for (auto& p : queries) p = common::Vec3f(dist(rng), dist(rng), dist(rng));
+    // about 10 neighbours per radius query
+    const float r = std::cbrt(10 / (n * 4.18879f));
+    std::printf("%zu points, %zu queries, %zu threads\n", n, num_queries,
+                common::detail::num_threads());
+
+    common::KDTree3f tree;
+    double t = seconds([&]() { tree.build(points); });
+    std::printf("KDTree build: %.1f ms\n", t * 1e3);
+    std::vector<common::Neighbor<float>> knn(num_queries * k);
+    t = seconds([&]() {
+        tree.knn(queries.data(), num_queries, k, knn.data());
+    });
+    std::printf("  %zu-NN: %.1f ms (%.2f Mqueries/s)\n", k, t * 1e3,
+                num_queries / t * 1e-6);
+    size_t found = 0;
+    t = seconds([&]() {
+        found = tree.radius(queries.data(), num_queries, r).neighbors.size();
+    });
+    std::printf("  radius: %.1f ms (%.2f Mqueries/s), %.1f neighbours each\n",
+                t * 1e3, num_queries / t * 1e-6, double(found) / num_queries);
+
+    common::HashGrid3f grid;
+    t = seconds([&]() { grid.build(points, r); });
+    std::printf("HashGrid build: %.1f ms\n", t * 1e3);
+    t = seconds([&]() {
+        found = grid.radius(queries.data(), num_queries, r).neighbors.size();
+    });
+    std::printf("  radius: %.1f ms (%.2f Mqueries/s), %.1f neighbours each\n",
+                t * 1e3, num_queries / t * 1e-6, double(found) / num_queries);
+
+    // a few queries by brute force, for comparison
+    constexpr size_t brute_queries = 100;
+    t = seconds([&]() {
+        for (size_t i = 0; i < brute_queries; ++i) {
+            float best = 1e30f;
+            for (const auto& p : points)
+                best = std::min(best, (p - queries[i]).module2());
+            found += best < 0;
+        }
+    });
+    std::printf("Brute force nearest: %.2f queries/s\n", brute_queries / t);
+    return 0;
+}
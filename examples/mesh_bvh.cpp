@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/mesh.h"
+
+// Builds a BVH over a ~2M triangle mesh and casts a grid of camera rays
+// against it, in one thread and in all of them (COMMON_NUM_THREADS). Pass a
+// filename to use your own mesh instead of the generated one
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Sphere of radius ~1 with bumps, n x n quads in longitude/latitude
+common::Mesh bumpy_sphere(unsigned int n) {
+    common::Mesh mesh;
+    const float pi = 3.14159265f;
+    for (unsigned int i = 0; i <= n; ++i)
+        for (unsigned int j = 0; j < n; ++j) {
+            const float theta = pi * i / n, phi = 2 * pi * j / n;
+            const float r =
+                1 + 0.05f * std::sin(12 * theta) * std::sin(9 * phi);
+            mesh.vertices.push_back(common::Vec4f(
+                r * std::sin(theta) * std::cos(phi),
+                r * std::sin(theta) * std::sin(phi), r * std::cos(theta), 1));
+        }
+    for (unsigned int i = 0; i < n; ++i)
+        for (unsigned int j = 0; j < n; ++j) {
+            const unsigned int a = i * n + j, b = i * n + (j + 1) % n;
+            mesh.faces.push_back(common::Vec3u(a, a + n, b + n));
+            mesh.faces.push_back(common::Vec3u(a, b + n, b));
+        }
+    return mesh;
+}
+
+// Pinhole camera looking at the center of the mesh from outside of it
+std::vector<common::Ray> camera_rays(const common::Mesh& mesh,
+                                     unsigned int resolution) {
+    common::Vec3f min(1e30f), max(-1e30f);
+    for (const common::Vec4f& v : mesh.vertices)
+        for (unsigned int k = 0; k < 3; ++k) {
+            min[k] = std::min(min[k], v[k]);
+            max[k] = std::max(max[k], v[k]);
+        }
+    const common::Vec3f center = (min + max) * 0.5f;
+    const float size = (max - min).module();
+    const common::Vec3f eye = center + common::Vec3f(0.3f, 0.2f, 1) * size;
+    std::vector<common::Ray> rays;
+    rays.reserve(resolution * resolution);
+    for (unsigned int y = 0; y < resolution; ++y)
+        for (unsigned int x = 0; x < resolution; ++x) {
+            const common::Vec3f target =
+                center + common::Vec3f(x / float(resolution) - 0.5f,
+                                       y / float(resolution) - 0.5f, 0) *
+                             size;
+            rays.push_back(common::Ray(eye, target - eye));
+        }
+    return rays;
+}
+
+int main(int argc, char** argv) {
+    const common::Mesh mesh =
+        argc > 1 ? common::load_mesh(argv[1]) : bumpy_sphere(1000);
+    const std::vector<common::Ray> rays = camera_rays(mesh, 1024);
+    const size_t n = rays.size();
+
+    common::BVH bvh;
+    const double t_build = seconds([&]() { bvh.build(mesh); });
+    std::printf("%zu triangles, %zu nodes, depth %zu, built in %.1f ms\n",
+                mesh.faces.size(), bvh.num_nodes(), bvh.depth(),
+                t_build * 1e3);
+
+    std::vector<common::RayHit> hits(n);
+    std::unique_ptr<bool[]> occluded(new bool[n]);
+    const double t_single = seconds([&]() {
+        for (size_t i = 0; i < n; ++i) hits[i] = bvh.intersect(rays[i]);
+    });
+    const double t_multi =
+        seconds([&]() { bvh.intersect(rays.data(), n, hits.data()); });
+    const double t_any_single = seconds([&]() {
+        for (size_t i = 0; i < n; ++i) occluded[i] = bvh.occluded(rays[i]);
+    });
+    const double t_any_multi =
+        seconds([&]() { bvh.occluded(rays.data(), n, occluded.get()); });
+
+    size_t num_hits = 0;
+    for (const common::RayHit& hit : hits) num_hits += hit.hit();
+
+    // points close to the surface, in front of the hits
+    std::vector<common::Vec3f> points;
+    for (size_t i = 0; i < n; ++i)
+        if (hits[i].hit()) points.push_back(rays[i].at(hits[i].t * 0.99f));
+    std::vector<common::ClosestPoint> closest(points.size());
+    const double t_closest = seconds([&]() {
+        bvh.closest_point(points.data(), points.size(), closest.data());
+    });
+
+    const size_t threads = common::detail::num_threads();
+    std::printf("%zu rays, %zu hits\n", n, num_hits);
+    std::printf("  first hit, 1 thread        %8.2f Mrays/s\n",
+                n / t_single * 1e-6);
+    std::printf("  first hit, %2zu threads      %8.2f Mrays/s\n", threads,
+                n / t_multi * 1e-6);
+    std::printf("  any hit, 1 thread          %8.2f Mrays/s\n",
+                n / t_any_single * 1e-6);
+    std::printf("  any hit, %2zu threads        %8.2f Mrays/s\n", threads,
+                n / t_any_multi * 1e-6);
+    std::printf("  closest point, %2zu threads  %8.2f Mqueries/s\n", threads,
+                points.size() / t_closest * 1e-6);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+#include "libcpp-common/mesh.h"
+
+// Time to open a large mesh saved as binary PLY, and as a mesh cache (copied
+// with load_mesh, or used in place with MappedMesh)
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    // n x n grid of vertices, two triangles per cell
+    const unsigned int n = 2048;
+    common::Mesh mesh;
+    mesh.vertices.resize(n * n);
+    for (unsigned int y = 0; y < n; ++y)
+        for (unsigned int x = 0; x < n; ++x)
+            mesh.vertices[y * n + x] = common::Vec4f(x, y, (x ^ y) & 7, 1);
+    for (unsigned int y = 0; y + 1 < n; ++y)
+        for (unsigned int x = 0; x + 1 < n; ++x) {
+            const unsigned int i = y * n + x;
+            mesh.faces.push_back(common::Vec3u(i, i + 1, i + n));
+            mesh.faces.push_back(common::Vec3u(i + 1, i + n + 1, i + n));
+        }
+
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::string ply = (dir / "mesh_cache_example.ply").string();
+    const std::string cache = (dir / "mesh_cache_example.cmesh").string();
+    const double t_save_ply =
+        seconds([&]() { common::save_mesh(ply.c_str(), mesh); });
+    const double t_save_cache =
+        seconds([&]() { common::save_mesh(cache.c_str(), mesh); });
+
+    common::Mesh from_ply, from_cache;
+    common::MappedMesh mapped;
+    const double t_ply =
+        seconds([&]() { from_ply = common::load_mesh(ply.c_str()); });
+    const double t_cache =
+        seconds([&]() { from_cache = common::load_mesh(cache.c_str()); });
+    const double t_mapped = seconds([&]() { mapped.open(cache.c_str()); });
+
+    const bool ok = from_ply.vertices == mesh.vertices &&
+                    from_cache.vertices == mesh.vertices &&
+                    from_cache.faces == mesh.faces &&
+                    mapped.face(12345) == mesh.faces[12345];
+    std::printf("%zu vertices, %zu faces (%s)\n", mesh.vertices.size(),
+                mesh.faces.size(), ok ? "ok" : "error");
+    std::printf("  save ply            %8.2f ms\n", t_save_ply * 1e3);
+    std::printf("  save cache          %8.2f ms\n", t_save_cache * 1e3);
+    std::printf("  load_mesh (ply)     %8.2f ms\n", t_ply * 1e3);
+    std::printf("  load_mesh (cache)   %8.2f ms\n", t_cache * 1e3);
+    std::printf("  MappedMesh (cache)  %8.2f ms\n", t_mapped * 1e3);
+
+    std::filesystem::remove(ply);
+    std::filesystem::remove(cache);
+    return 0;
+}
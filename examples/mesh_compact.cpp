@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "libcpp-common/mesh.h"
+
+// Compares Mesh (Vec4f vertices, 32-bit indices) with CompactMesh (Vec3f
+// vertices, 16/32-bit indices) when transforming the vertices and when
+// gathering the vertices of every face, for a small and a large grid mesh
+
+template <typename Func>
+double seconds(const Func& f, int repetitions) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < repetitions; ++i) f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count() / repetitions;
+}
+
+// n x n grid of vertices, two triangles per cell
+common::Mesh grid_mesh(size_t n) {
+    common::Mesh mesh;
+    mesh.vertices.resize(n * n);
+    for (size_t y = 0; y < n; ++y)
+        for (size_t x = 0; x < n; ++x)
+            mesh.vertices[y * n + x] = common::Vec4f(x, y, (x ^ y) & 7, 1);
+    for (unsigned int y = 0; y + 1 < n; ++y)
+        for (unsigned int x = 0; x + 1 < n; ++x) {
+            const unsigned int i = y * n + x;
+            mesh.faces.push_back(common::Vec3u(i, i + 1, i + n));
+            mesh.faces.push_back(common::Vec3u(i + 1, i + n + 1, i + n));
+        }
+    return mesh;
+}
+
+void benchmark(size_t n) {
+    const common::Mesh mesh = grid_mesh(n);
+    const common::CompactMesh compact = common::compact(mesh);
+    const common::Mat4f m(0, -1, 0, 2, 1, 0, 0, 3, 0, 0, 2, 1, 0, 0, 0, 1);
+    const int repetitions = std::max<int>(1, int(2e7 / (n * n)));
+
+    float a[4][4];
+    for (unsigned int r = 0; r < 4; ++r)
+        for (unsigned int c = 0; c < 4; ++c) a[r][c] = m(r, c);
+
+    // transform: 4x4 product in homogeneous coordinates, affine for Vec3f
+    common::VecList4f out4(mesh.vertices.size());
+    common::VecList3f out3(compact.vertices.size());
+    const double t_transform4 = seconds(
+        [&]() {
+            for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+                const common::Vec4f& v = mesh.vertices[i];
+                for (unsigned int r = 0; r < 4; ++r)
+                    out4[i][r] = a[r][0] * v[0] + a[r][1] * v[1] +
+                                 a[r][2] * v[2] + a[r][3] * v[3];
+            }
+        },
+        repetitions);
+    const double t_transform3 = seconds(
+        [&]() {
+            for (size_t i = 0; i < compact.vertices.size(); ++i) {
+                const common::Vec3f& v = compact.vertices[i];
+                for (unsigned int r = 0; r < 3; ++r)
+                    out3[i][r] = a[r][0] * v[0] + a[r][1] * v[1] +
+                                 a[r][2] * v[2] + a[r][3];
+            }
+        },
+        repetitions);
+
+    // iteration: centroid of every face, gathering its vertices
+    common::VecList3f centroids4(mesh.faces.size());
+    common::VecList3f centroids3(compact.num_faces());
+    const double t_faces4 = seconds(
+        [&]() {
+            for (size_t i = 0; i < mesh.faces.size(); ++i) {
+                const common::Vec3u& f = mesh.faces[i];
+                for (unsigned int r = 0; r < 3; ++r)
+                    centroids4[i][r] = (mesh.vertices[f[0]][r] +
+                                        mesh.vertices[f[1]][r] +
+                                        mesh.vertices[f[2]][r]) /
+                                       3;
+            }
+        },
+        repetitions);
+    const double t_faces3 = seconds(
+        [&]() {
+            compact.visit_faces([&](const auto& faces) {
+                for (size_t i = 0; i < faces.size(); ++i) {
+                    const auto& f = faces[i];
+                    for (unsigned int r = 0; r < 3; ++r)
+                        centroids3[i][r] = (compact.vertices[f[0]][r] +
+                                            compact.vertices[f[1]][r] +
+                                            compact.vertices[f[2]][r]) /
+                                           3;
+                }
+            });
+        },
+        repetitions);
+
+    const double mb4 = (mesh.vertices.size() * sizeof(common::Vec4f) +
+                        mesh.faces.size() * sizeof(common::Vec3u)) /
+                       1e6;
+    const double mb3 =
+        (compact.vertices.size() * sizeof(common::Vec3f) +
+         compact.faces16.size() * sizeof(compact.faces16[0]) +
+         compact.faces32.size() * sizeof(common::Vec3u)) /
+        1e6;
+    std::printf("%8zu vertices (%s indices)\n", mesh.vertices.size(),
+                compact.has_16bit_indices() ? "16-bit" : "32-bit");
+    std::printf("    memory     %9.2f MB %9.2f MB\n", mb4, mb3);
+    std::printf("    transform  %9.3f ms %9.3f ms\n", t_transform4 * 1e3,
+                t_transform3 * 1e3);
+    std::printf("    faces      %9.3f ms %9.3f ms   (%s)\n", t_faces4 * 1e3,
+                t_faces3 * 1e3, centroids4 == centroids3 ? "ok" : "error");
+}
+
+int main() {
+    std::cout << "                   Mesh     CompactMesh" << std::endl;
+    benchmark(256);
+    benchmark(2048);
+    return 0;
+}
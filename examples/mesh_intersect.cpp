@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "libcpp-common/mesh.h"
+
+// Throughput of the ray-triangle kernels of mesh/intersect.h, finding the
+// closest hit of each ray of a grid of coherent rays by testing it against
+// every triangle of a random set. Configure with -DLIBCPP_COMMON_NATIVE=ON so
+// that 8-wide packets use AVX registers
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Möller-Trumbore written with the Vec operations, as a reference
+bool intersect_vec(const common::Ray& ray, const common::Vec3f& v0,
+                   const common::Vec3f& v1, const common::Vec3f& v2,
+                   float tmax, float& t) {
+    const common::Vec3f e1 = v1 - v0, e2 = v2 - v0;
+    const common::Vec3f p = common::cross(ray.direction, e2);
+    const float det = common::dot(e1, p);
+    if (det == 0) return false;
+    const common::Vec3f s = ray.origin - v0;
+    const float u = common::dot(s, p) / det;
+    if (u < 0 || u > 1) return false;
+    const common::Vec3f q = common::cross(s, e1);
+    const float v = common::dot(ray.direction, q) / det;
+    if (v < 0 || u + v > 1) return false;
+    const float hit = common::dot(e2, q) / det;
+    if (hit < ray.tmin || hit > tmax) return false;
+    t = hit;
+    return true;
+}
+
+template <size_t W>
+size_t triangle_packets(const std::vector<common::Ray>& rays,
+                        const std::vector<common::Vec3f>& v) {
+    std::vector<common::TrianglePacket<W>> packets(v.size() / (3 * W));
+    for (size_t i = 0; i < packets.size() * W; ++i)
+        packets[i / W].set(i % W, v[3 * i], v[3 * i + 1], v[3 * i + 2]);
+    size_t hits = 0;
+    for (common::Ray ray : rays) {
+        bool hit = false;
+        for (const auto& packet : packets) {
+            const common::RayHit packet_hit = common::intersect(ray, packet);
+            if (!packet_hit.hit()) continue;
+            ray.tmax = packet_hit.t;
+            hit = true;
+        }
+        hits += hit;
+    }
+    return hits;
+}
+
+template <size_t W>
+size_t ray_packets(const std::vector<common::Ray>& rays,
+                   const std::vector<common::Vec3f>& v) {
+    size_t hits = 0;
+    for (size_t r = 0; r + W <= rays.size(); r += W) {
+        common::RayPacket<W> packet;
+        for (size_t i = 0; i < W; ++i) packet.set(i, rays[r + i]);
+        common::HitPacket<W> packet_hits;
+        for (size_t i = 0; i < v.size(); i += 3)
+            common::intersect(packet, v[i], v[i + 1], v[i + 2], i / 3,
+                              packet_hits);
+        for (size_t i = 0; i < W; ++i) hits += packet_hits.get(i).hit();
+    }
+    return hits;
+}
+
+int main() {
+    const size_t num_triangles = 2048, resolution = 64;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> position(-1, 1);
+    std::uniform_real_distribution<float> offset(-0.2f, 0.2f);
+    std::vector<common::Vec3f> v;
+    for (size_t i = 0; i < num_triangles; ++i) {
+        const common::Vec3f c(position(rng), position(rng), position(rng));
+        for (unsigned int k = 0; k < 3; ++k)
+            v.push_back(c +
+                        common::Vec3f(offset(rng), offset(rng), offset(rng)));
+    }
+    std::vector<common::Ray> rays;
+    for (size_t y = 0; y < resolution; ++y)
+        for (size_t x = 0; x < resolution; ++x)
+            rays.push_back(common::Ray(
+                common::Vec3f(0, 0, -4),
+                common::Vec3f(2.0f * x / resolution - 1,
+                              2.0f * y / resolution - 1, 4)));
+    const double tests = double(rays.size()) * num_triangles;
+
+    auto report = [&](const char* name, const auto& f) {
+        size_t hits = 0;
+        const double t = seconds([&]() { hits = f(); });
+        std::printf("  %-24s %8.1f Mtests/s  (%zu rays hit)\n", name,
+                    tests / t * 1e-6, hits);
+    };
+    std::printf("%zu rays x %zu triangles\n", rays.size(), num_triangles);
+    report("Vec operations", [&]() {
+        size_t hits = 0;
+        for (const common::Ray& ray : rays) {
+            float t = ray.tmax;
+            bool hit = false;
+            for (size_t i = 0; i < v.size(); i += 3)
+                hit |= intersect_vec(ray, v[i], v[i + 1], v[i + 2], t, t);
+            hits += hit;
+        }
+        return hits;
+    });
+    report("intersect_triangle", [&]() {
+        std::vector<common::Vec3f> edges;
+        for (size_t i = 0; i < v.size(); i += 3)
+            edges.insert(edges.end(),
+                         {v[i], v[i + 1] - v[i], v[i + 2] - v[i]});
+        size_t hits = 0;
+        for (const common::Ray& ray : rays) {
+            float t = ray.tmax, a, b;
+            bool hit = false;
+            for (size_t i = 0; i < edges.size(); i += 3)
+                hit |= common::intersect_triangle(ray, edges[i], edges[i + 1],
+                                                  edges[i + 2], t, t, a, b);
+            hits += hit;
+        }
+        return hits;
+    });
+    report("1 ray x 4 triangles",
+           [&]() { return triangle_packets<4>(rays, v); });
+    report("1 ray x 8 triangles",
+           [&]() { return triangle_packets<8>(rays, v); });
+    report("4 rays x 1 triangle", [&]() { return ray_packets<4>(rays, v); });
+    report("8 rays x 1 triangle", [&]() { return ray_packets<8>(rays, v); });
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "libcpp-common/mesh.h"
+
+// Loads a multi-million face OBJ file with load_mesh, and with the
+// line-by-line stream parsing that simple OBJ loaders use, as a reference.
+// Pass a filename to load your own file instead of the generated one
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Positions and fan-triangulated faces, read with std::istringstream
+common::Mesh load_obj_stream(const std::string& filename) {
+    common::Mesh mesh;
+    std::ifstream file(filename);
+    std::string line, keyword, corner;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        stream >> keyword;
+        if (keyword == "v") {
+            common::Vec4f v(0, 0, 0, 1);
+            stream >> v[0] >> v[1] >> v[2];
+            mesh.vertices.push_back(v);
+        } else if (keyword == "f") {
+            std::vector<unsigned int> face;
+            while (stream >> corner) {
+                const int index = std::stoi(corner);
+                face.push_back(index < 0 ? mesh.vertices.size() + index
+                                         : index - 1);
+            }
+            for (size_t k = 1; k + 1 < face.size(); ++k)
+                mesh.faces.push_back(
+                    common::Vec3u(face[0], face[k], face[k + 1]));
+        }
+    }
+    return mesh;
+}
+
+// n x n grid of quads, with texture coordinates and normals
+std::string write_grid(unsigned int n) {
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "mesh_obj_example.obj")
+            .string();
+    std::ofstream file(filename);
+    file << "o grid\n";
+    for (unsigned int y = 0; y < n; ++y)
+        for (unsigned int x = 0; x < n; ++x)
+            file << "v " << x * 0.01f << " " << y * 0.01f << " "
+                 << ((x ^ y) & 7) * 0.1f << "\nvt " << float(x) / n << " "
+                 << float(y) / n << "\n";
+    file << "vn 0 0 1\n";
+    for (unsigned int y = 0; y + 1 < n; ++y)
+        for (unsigned int x = 0; x + 1 < n; ++x) {
+            const unsigned int i = y * n + x + 1;
+            file << "f";
+            for (unsigned int v : {i, i + 1, i + n + 1, i + n})
+                file << " " << v << "/" << v << "/1";
+            file << "\n";
+        }
+    return filename;
+}
+
+int main(int argc, char** argv) {
+    const std::string filename = argc > 1 ? argv[1] : write_grid(1500);
+
+    common::Mesh stream_mesh, mesh, full_mesh;
+    const double t_stream =
+        seconds([&]() { stream_mesh = load_obj_stream(filename); });
+    const double t_load =
+        seconds([&]() { mesh = common::load_mesh(filename.c_str()); });
+    const double t_full = seconds([&]() {
+        full_mesh = common::load_mesh(filename.c_str(),
+                                      common::AttributeMask::everything());
+    });
+
+    std::printf("%zu vertices, %zu triangles (%s)\n", mesh.vertices.size(),
+                mesh.faces.size(),
+                mesh.vertices == stream_mesh.vertices &&
+                        mesh.faces.size() == stream_mesh.faces.size()
+                    ? "ok"
+                    : "error");
+    std::printf("  istringstream loader         %8.1f ms\n", t_stream * 1e3);
+    std::printf("  load_mesh                    %8.1f ms\n", t_load * 1e3);
+    std::printf("  load_mesh (uv, normals)      %8.1f ms  (%zu vertices)\n",
+                t_full * 1e3, full_mesh.vertices.size());
+    if (argc <= 1) std::filesystem::remove(filename);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "libcpp-common/mesh.h"
+
+// Vertex cache and vertex fetch metrics of a mesh before and after each of
+// the optimization passes. Pass a filename to use your own mesh instead of
+// the generated one (a grid with its faces and vertices shuffled)
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+common::Mesh shuffled_grid(unsigned int n) {
+    common::Mesh mesh;
+    std::mt19937 rng(0);
+    std::vector<unsigned int> ids((n + 1) * (n + 1));
+    for (unsigned int i = 0; i < ids.size(); ++i) ids[i] = i;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    mesh.vertices.resize(ids.size());
+    for (unsigned int y = 0; y <= n; ++y)
+        for (unsigned int x = 0; x <= n; ++x)
+            mesh.vertices[ids[y * (n + 1) + x]] = common::Vec4f(x, y, 0, 1);
+    for (unsigned int y = 0; y < n; ++y)
+        for (unsigned int x = 0; x < n; ++x) {
+            const unsigned int v = y * (n + 1) + x;
+            mesh.faces.push_back(
+                common::Vec3u(ids[v], ids[v + 1], ids[v + n + 2]));
+            mesh.faces.push_back(
+                common::Vec3u(ids[v], ids[v + n + 2], ids[v + n + 1]));
+        }
+    std::shuffle(mesh.faces.begin(), mesh.faces.end(), rng);
+    return mesh;
+}
+
+void report(const char* name, const common::Mesh& mesh, double t) {
+    const common::VertexCacheStats fifo = common::analyze_vertex_cache(mesh);
+    const common::VertexCacheStats fifo32 =
+        common::analyze_vertex_cache(mesh, 32);
+    const common::VertexFetchStats fetch = common::analyze_vertex_fetch(mesh);
+    std::printf("  %-22s %8.1f ms  ACMR %.3f (%.3f)  ATVR %.3f  overfetch "
+                "%.2f\n",
+                name, t * 1e3, fifo.acmr, fifo32.acmr, fifo.atvr,
+                fetch.overfetch);
+}
+
+int main(int argc, char** argv) {
+    const common::Mesh original =
+        argc > 1 ? common::load_mesh(argv[1]) : shuffled_grid(1000);
+    std::printf("%zu vertices, %zu triangles. ACMR for FIFO caches of 16 "
+                "(and 32) vertices\n",
+                original.vertices.size(), original.faces.size());
+    report("original", original, 0);
+
+    for (auto method : {common::VertexCacheMethod::Tipsify,
+                        common::VertexCacheMethod::Forsyth}) {
+        const bool tipsify = method == common::VertexCacheMethod::Tipsify;
+        common::Mesh mesh = original;
+        double t = seconds(
+            [&]() { common::optimize_vertex_cache(mesh, method); });
+        report(tipsify ? "tipsify" : "forsyth", mesh, t);
+        t = seconds([&]() { common::optimize_vertex_fetch(mesh); });
+        report("  + vertex fetch", mesh, t);
+    }
+
+    common::Mesh mesh = original;
+    const double t = seconds([&]() { common::sort_vertices_morton(mesh); });
+    report("morton vertices", mesh, t);
+    return 0;
+}
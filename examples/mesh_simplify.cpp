@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/mesh.h"
+
+// Simplifies a bumpy sphere of 4M triangles to 1% of its faces with edge
+// collapses, and with vertex clustering at a few grid resolutions. Pass a
+// filename to simplify your own mesh instead
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Latitude-longitude sphere of 4 n^2 triangles with bumps of 2% its radius
+common::Mesh bumpy_sphere(unsigned int n) {
+    common::Mesh mesh;
+    const float pi = 3.14159265f;
+    mesh.vertices.push_back(common::Vec4f(0, 0, 1, 1));
+    for (unsigned int i = 1; i < n; ++i)
+        for (unsigned int j = 0; j < 2 * n; ++j) {
+            const float theta = pi * i / n, phi = pi * j / n;
+            const float r =
+                1 + 0.02f * std::sin(7 * theta) * std::cos(5 * phi);
+            mesh.vertices.push_back(common::Vec4f(
+                r * std::sin(theta) * std::cos(phi),
+                r * std::sin(theta) * std::sin(phi), r * std::cos(theta), 1));
+        }
+    mesh.vertices.push_back(common::Vec4f(0, 0, -1, 1));
+    const unsigned int last = mesh.vertices.size() - 1;
+    for (unsigned int j = 0; j < 2 * n; ++j) {
+        const unsigned int a = 1 + j, b = 1 + (j + 1) % (2 * n);
+        mesh.faces.push_back(common::Vec3u(0, a, b));
+        mesh.faces.push_back(common::Vec3u(last, b + (n - 2) * 2 * n,
+                                           a + (n - 2) * 2 * n));
+        for (unsigned int i = 0; i + 2 < n; ++i) {
+            const unsigned int c = a + i * 2 * n, d = b + i * 2 * n;
+            mesh.faces.push_back(common::Vec3u(c, c + 2 * n, d + 2 * n));
+            mesh.faces.push_back(common::Vec3u(c, d + 2 * n, d));
+        }
+    }
+    return mesh;
+}
+
+int main(int argc, char** argv) {
+    const common::Mesh original =
+        argc > 1 ? common::load_mesh(argv[1]) : bumpy_sphere(1000);
+    std::printf("%zu vertices, %zu triangles, %zu threads\n",
+                original.vertices.size(), original.faces.size(),
+                common::detail::num_threads());
+
+    common::Mesh mesh = original;
+    float error = 0;
+    double t = seconds([&]() {
+        error = common::simplify_mesh(mesh, original.faces.size() / 100);
+    });
+    std::printf("  edge collapse: %zu triangles, error %g, %.1f ms (%.2f "
+                "Mtriangles/s)\n",
+                mesh.faces.size(), error, t * 1e3,
+                original.faces.size() / t * 1e-6);
+
+    // cell sizes relative to the largest side of the bounding box
+    float extent = 0;
+    for (unsigned int k = 0; k < 3; ++k) {
+        float lower = original.vertices[0][k], upper = lower;
+        for (const common::Vec4f& p : original.vertices) {
+            lower = std::min(lower, p[k]);
+            upper = std::max(upper, p[k]);
+        }
+        extent = std::max(extent, upper - lower);
+    }
+    for (float cells : {64.0f, 256.0f, 1024.0f}) {
+        mesh = original;
+        t = seconds([&]() {
+            common::simplify_mesh_clustering(mesh, extent / cells);
+        });
+        std::printf("  clustering, %4.0f cells: %zu triangles, %.1f ms "
+                    "(%.2f Mtriangles/s)\n",
+                    cells, mesh.faces.size(), t * 1e3,
+                    original.faces.size() / t * 1e-6);
+    }
+    return 0;
+}
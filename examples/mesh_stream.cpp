@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "libcpp-common/mesh.h"
+
+// Bounding box and histogram of heights of a large binary PLY, read in
+// batches with stream_ply so that the mesh is never fully in memory, against
+// loading all of it with load_mesh. Pass a filename to use your own mesh
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    std::string filename;
+    if (argc > 1) {
+        filename = argv[1];
+    } else {
+        // n x n grid of vertices, two triangles per cell
+        const unsigned int n = 2048;
+        common::Mesh mesh;
+        mesh.vertices.resize(n * n);
+        for (unsigned int y = 0; y < n; ++y)
+            for (unsigned int x = 0; x < n; ++x)
+                mesh.vertices[y * n + x] =
+                    common::Vec4f(x, y, (x * y) % 97, 1);
+        for (unsigned int y = 0; y + 1 < n; ++y)
+            for (unsigned int x = 0; x + 1 < n; ++x) {
+                const unsigned int i = y * n + x;
+                mesh.faces.push_back(common::Vec3u(i, i + 1, i + n));
+                mesh.faces.push_back(common::Vec3u(i + 1, i + n + 1, i + n));
+            }
+        filename = (std::filesystem::temp_directory_path() /
+                    "mesh_stream_example.ply")
+                       .string();
+        common::save_mesh(filename.c_str(), mesh);
+    }
+
+    // first pass for the bounds, second one for the histogram
+    common::Vec4f lower(1e30f, 1e30f, 1e30f, 1);
+    common::Vec4f upper(-1e30f, -1e30f, -1e30f, 1);
+    size_t triangles = 0;
+    const double t_bounds = seconds([&]() {
+        std::ifstream file(filename, std::ios::binary);
+        common::stream_ply(
+            file,
+            [&](const common::PlyVertexBatch& batch) {
+                for (const common::Vec4f& p : batch.vertices)
+                    for (unsigned int k = 0; k < 3; ++k) {
+                        lower[k] = std::min(lower[k], p[k]);
+                        upper[k] = std::max(upper[k], p[k]);
+                    }
+            },
+            [&](const common::PlyFaceBatch& batch) {
+                triangles += batch.faces.size();
+            });
+    });
+    constexpr size_t BINS = 16;
+    size_t histogram[BINS] = {};
+    const double t_histogram = seconds([&]() {
+        std::ifstream file(filename, std::ios::binary);
+        common::PlyStreamReader reader(file);
+        const float scale = BINS / std::max(upper[2] - lower[2], 1e-30f);
+        while (reader.next()) {
+            if (!reader.has_vertices()) continue;
+            for (const common::Vec4f& p : reader.vertex_batch().vertices)
+                ++histogram[std::min<size_t>((p[2] - lower[2]) * scale,
+                                             BINS - 1)];
+        }
+    });
+
+    size_t loaded = 0;
+    const double t_load = seconds([&]() {
+        loaded = common::load_mesh(filename.c_str()).faces.size();
+    });
+
+    std::printf("%zu triangles (%zu loaded), bounds (%g %g %g) - (%g %g %g)\n",
+                triangles, loaded, lower[0], lower[1], lower[2], upper[0],
+                upper[1], upper[2]);
+    std::printf("heights:");
+    for (size_t count : histogram) std::printf(" %zu", count);
+    std::printf("\n");
+    std::printf("stream_ply (bounds): %.1f ms\n", t_bounds * 1e3);
+    std::printf("PlyStreamReader (histogram): %.1f ms\n", t_histogram * 1e3);
+    std::printf("load_mesh: %.1f ms\n", t_load * 1e3);
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cstdio>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/mesh.h"
+
+// Welds the vertices of a triangle soup (each face with its own three
+// vertices, as in STL files) of 2M triangles, with and without a tolerance.
+// Pass a filename to weld your own mesh instead
+
+template <typename Func>
+double seconds(const Func& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Grid of n x n quads with some noise in z
+common::Mesh triangle_soup(unsigned int n) {
+    common::Mesh mesh;
+    auto vertex = [](unsigned int x, unsigned int y) {
+        const float z = 0.01f * ((x * 7919 + y * 104729) % 101);
+        return common::Vec4f(x, y, z, 1);
+    };
+    for (unsigned int y = 0; y < n; ++y)
+        for (unsigned int x = 0; x < n; ++x)
+            for (const common::Vec4f& v :
+                 {vertex(x, y), vertex(x + 1, y), vertex(x + 1, y + 1),
+                  vertex(x, y), vertex(x + 1, y + 1), vertex(x, y + 1)})
+                mesh.vertices.push_back(v);
+    for (unsigned int i = 0; i < mesh.vertices.size(); i += 3)
+        mesh.faces.push_back(common::Vec3u(i, i + 1, i + 2));
+    return mesh;
+}
+
+int main(int argc, char** argv) {
+    const common::Mesh original =
+        argc > 1 ? common::load_mesh(argv[1]) : triangle_soup(1000);
+    std::printf("%zu vertices, %zu triangles, %zu threads\n",
+                original.vertices.size(), original.faces.size(),
+                common::detail::num_threads());
+    for (float epsilon : {0.0f, 1e-4f}) {
+        common::Mesh mesh = original;
+        const double t =
+            seconds([&]() { common::weld_vertices(mesh, epsilon); });
+        std::printf("  epsilon %g: %zu vertices left, %.1f ms (%.1f "
+                    "Mvertices/s)\n",
+                    epsilon, mesh.vertices.size(), t * 1e3,
+                    original.vertices.size() / t * 1e-6);
+    }
+    return 0;
+}
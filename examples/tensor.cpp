@@ -10,5 +10,11 @@ int main() {
     std::cout << test(1, 2) << std::endl;
     std::cout << test << std::endl;
     std::cout << test + 3 << std::endl;
+
+    // zero-copy views
+    auto view = test2.view();
+    std::cout << view.transpose() << std::endl;
+    std::cout << view.slice(common::Slice(1), common::all) << std::endl;
+    std::cout << view[0] + view.slice(common::all, 2) << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "libcpp-common/tensor.h"
+
+// Matrix multiplication benchmark, reports GFLOP/s for the naive triple loop
+// and for common::gemm (which Tensor::operator* uses) across sizes
+
+template <typename Func>
+double seconds(const Func& f, int repetitions) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < repetitions; ++i) f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count() / repetitions;
+}
+
+template <typename T>
+void naive(size_t n, const T* a, const T* b, T* c) {
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j) {
+            T sum = 0;
+            for (size_t k = 0; k < n; ++k) sum += a[i * n + k] * b[k * n + j];
+            c[i * n + j] = sum;
+        }
+}
+
+template <typename T>
+void benchmark(const char* name) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<T> dist(-1, 1);
+
+    std::cout << name << std::endl;
+    std::cout << "    size      naive GFLOP/s   gemm GFLOP/s   max error"
+              << std::endl;
+    for (size_t n : {32, 64, 128, 256, 512, 1024, 2048}) {
+        std::vector<T> a(n * n), b(n * n), c_naive(n * n), c_gemm(n * n);
+        for (auto& x : a) x = dist(rng);
+        for (auto& x : b) x = dist(rng);
+
+        const double flops = 2.0 * n * n * n;
+        const int repetitions = std::max<int>(1, int(2e9 / flops));
+        double t_naive = 0;
+        if (n <= 1024)  // too slow above that
+            t_naive = seconds(
+                [&]() { naive(n, a.data(), b.data(), c_naive.data()); },
+                std::max(1, repetitions / 4));
+        double t_gemm = seconds(
+            [&]() {
+                common::gemm<T>(n, n, n, a.data(), n, 1, b.data(), n, 1,
+                                c_gemm.data(), n, 1);
+            },
+            repetitions);
+
+        T error = 0;
+        if (t_naive > 0)
+            for (size_t i = 0; i < n * n; ++i)
+                error = std::max(error, std::abs(c_naive[i] - c_gemm[i]));
+
+        std::cout << "    " << n << "\t\t"
+                  << (t_naive > 0 ? flops / t_naive * 1e-9 : 0) << "\t\t"
+                  << flops / t_gemm * 1e-9 << "\t\t" << error << std::endl;
+    }
+}
+
+int main() {
+    benchmark<float>("float");
+    benchmark<double>("double");
+
+    // static sizes through Tensor::operator* (heap allocated, they are big)
+    using Mat = common::Tensor<float, 512, 512>;
+    auto a = std::make_unique<Mat>(1.0f);
+    auto b = std::make_unique<Mat>(2.0f);
+    auto c = std::make_unique<Mat>();
+    double t = seconds([&]() { *c = (*a) * (*b); }, 10);
+    std::cout << "Tensor<float, 512, 512> * Tensor<float, 512, 512>: "
+              << 2.0 * 512 * 512 * 512 / t * 1e-9 << " GFLOP/s" << std::endl;
+
+    // tiny sizes are fully unrolled
+    auto m4 = common::Tensor<float, 4, 4>::ones();
+    float checksum = 0;
+    t = seconds(
+        [&]() {
+            m4.at(0) += 1e-6f;
+            checksum += (m4 * m4).at(5);
+        },
+        1000000);
+    std::cout << "Tensor<float, 4, 4> * Tensor<float, 4, 4>: " << t * 1e9
+              << " ns (checksum " << checksum << ")" << std::endl;
+    return 0;
+}
@@ -212,6 +212,8 @@ class Grid2D : protected std::vector<T> {
 
     inline size_t width() const { return m_width; }
     inline size_t height() const { return m_height; }
+    inline bool flip_y() const { return m_flip_y; }
+    inline void* data() { return &Base::operator[](0); }
     inline const void* data() const { return &Base::operator[](0); }
     inline Vec2u size() const { return Vec2u(m_width, m_height); }
 
@@ -0,0 +1,34 @@
+/*
+ * check_faces.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Validation of the vertex indices of the faces, shared by the mesh
+ * algorithms
+ */
+
+#pragma once
+
+#include <string>
+
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/geometry.h"
+
+namespace common {
+namespace detail {
+
+// Throws CommonMeshException if a face references a vertex that does not
+// exist
+inline void check_faces(const VecList3u& faces, size_t num_vertices) {
+    parallel_for(0, faces.size(), 1 << 14, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i)
+            for (unsigned int k = 0; k < 3; ++k)
+                if (faces[i][k] >= num_vertices)
+                    throw CommonMeshException(
+                        "Face " + std::to_string(i) +
+                        " references a vertex that does not exist");
+    });
+}
+
+};  // namespace detail
+};  // namespace common
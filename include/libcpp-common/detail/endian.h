@@ -0,0 +1,22 @@
+/*
+ * endian.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Byte order of the machine, shared by the readers and writers of binary
+ * files
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace common {
+namespace detail {
+
+inline bool machine_is_little_endian() {
+    const uint16_t one = 1;
+    return *reinterpret_cast<const uint8_t*>(&one) == 1;
+}
+
+};  // namespace detail
+};  // namespace common
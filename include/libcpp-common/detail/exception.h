@@ -23,6 +23,11 @@ class CommonException : public std::exception {
     std::string m_msg;
 };
 
+class CommonGeometryException : public CommonException {
+   public:
+    CommonGeometryException(const std::string& msg) : CommonException(msg) {}
+};
+
 class CommonMeshException : public CommonException {
    public:
     CommonMeshException(const std::string& msg) : CommonException(msg) {}
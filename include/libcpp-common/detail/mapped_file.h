@@ -0,0 +1,48 @@
+/*
+ * mapped_file.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Read-only memory mapping of whole files
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace common {
+namespace detail {
+
+// Maps a file in memory (mmap) so that it can be parsed in place, without
+// copying it through a stream. On systems without mmap the file is read
+// into a buffer instead
+class MappedFile {
+   public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false if the file could not be opened or mapped
+    bool open(const std::string& filename);
+    void close();
+
+    bool is_open() const { return m_open; }
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+   private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+    std::vector<uint8_t> m_buffer;  // only used without mmap
+};
+
+};  // namespace detail
+};  // namespace common
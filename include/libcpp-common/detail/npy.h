@@ -0,0 +1,69 @@
+/*
+ * npy.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Header of NumPy's .npy files (format version 1.0), shared by the bitmap and
+ * tensor savers/loaders
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "libcpp-common/detail/endian.h"
+
+namespace common {
+namespace detail {
+
+// NumPy type string (e.g. "<f4") of T, or an empty string if it has none
+template <typename T>
+std::string npy_descr() {
+    // multi-byte types are stored in the byte order of the machine
+    const char order =
+        sizeof(T) == 1 ? '|' : (machine_is_little_endian() ? '<' : '>');
+    const std::string size = std::to_string(sizeof(T));
+    if constexpr (std::is_same_v<T, bool>) {
+        return "|b1";
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        return order + ("i" + size);
+    } else if constexpr (std::is_integral_v<T>) {
+        return order + ("u" + size);
+    } else if constexpr (std::is_same_v<T, float> ||
+                         std::is_same_v<T, double>) {
+        return order + ("f" + size);
+    } else if constexpr (std::is_same_v<T, std::complex<float>> ||
+                         std::is_same_v<T, std::complex<double>>) {
+        return order + ("c" + size);
+    } else {
+        return "";
+    }
+}
+
+struct NpyHeader {
+    std::string descr;
+    bool fortran_order;
+    std::vector<size_t> shape;
+    size_t size() const {
+        size_t result = 1;
+        for (size_t n : shape) result *= n;
+        return result;
+    }
+};
+
+// Complete header (magic string, length and dictionary), padded with spaces
+// so that the data that follows is 64-byte aligned. The header is padded to
+// at least min_length bytes, which leaves room to rewrite it later with a
+// longer shape
+std::string npy_header(const NpyHeader& header, size_t min_length = 0);
+
+// Parses the header at the current position of the stream, leaving it at the
+// start of the data. Throws CommonException if it is not a valid .npy file
+NpyHeader read_npy_header(std::istream& file);
+
+};  // namespace detail
+};  // namespace common
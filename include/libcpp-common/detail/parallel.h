@@ -0,0 +1,104 @@
+/*
+ * parallel.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Minimal fork-join helpers used by the heavier algorithms of the library
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace common {
+namespace detail {
+
+// Number of worker threads used by the library. Defaults to the number of
+// hardware threads, and can be overriden with the COMMON_NUM_THREADS
+// environment variable (e.g. COMMON_NUM_THREADS=1 for serial execution)
+inline size_t num_threads() {
+    static const size_t n = []() -> size_t {
+        const char* env = std::getenv("COMMON_NUM_THREADS");
+        if (env != nullptr) {
+            long value = std::strtol(env, nullptr, 10);
+            if (value > 0) return static_cast<size_t>(value);
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }();
+    return n;
+}
+
+// Number of chunks in which parallel_chunks splits a range of n elements,
+// each chunk having at least min_chunk elements
+inline size_t num_chunks(size_t n, size_t min_chunk) {
+    min_chunk = std::max<size_t>(min_chunk, 1);
+    return std::max<size_t>(1, std::min(num_threads(), n / min_chunk));
+}
+
+// Split [begin, end) in num_chunks(end - begin, min_chunk) contiguous chunks
+// and call f(chunk_index, chunk_begin, chunk_end) once per chunk, each one in
+// its own thread. The first chunk runs on the calling thread. Any exception
+// thrown by f is rethrown here after all threads have finished
+template <typename ChunkFunc>
+void parallel_chunks(size_t begin, size_t end, size_t min_chunk,
+                     const ChunkFunc& f) {
+    if (end <= begin) return;
+    const size_t n = end - begin;
+    const size_t chunks = num_chunks(n, min_chunk);
+    if (chunks == 1) {
+        f(size_t(0), begin, end);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(chunks);
+    auto run = [&](size_t c) {
+        const size_t b = begin + n * c / chunks;
+        const size_t e = begin + n * (c + 1) / chunks;
+        try {
+            f(c, b, e);
+        } catch (...) {
+            errors[c] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+    for (size_t c = 1; c < chunks; ++c) threads.emplace_back(run, c);
+    run(0);
+    for (auto& thread : threads) thread.join();
+
+    for (const auto& error : errors)
+        if (error) std::rethrow_exception(error);
+}
+
+// Same as parallel_chunks, but f(chunk_begin, chunk_end) does not need to
+// know the index of its chunk
+template <typename RangeFunc>
+void parallel_for(size_t begin, size_t end, size_t min_chunk,
+                  const RangeFunc& f) {
+    parallel_chunks(begin, end, min_chunk,
+                    [&f](size_t, size_t b, size_t e) { f(b, e); });
+}
+
+// Bounds of the num_chunks(end - begin, min_chunk) chunks in which a text
+// is split to be parsed in parallel, moved forward to the start of a line
+inline std::vector<const char*> line_chunks(const char* begin,
+                                            const char* end,
+                                            size_t min_chunk) {
+    const size_t size = static_cast<size_t>(end - begin);
+    const size_t chunks = num_chunks(size, min_chunk);
+    std::vector<const char*> bounds(chunks + 1, end);
+    bounds[0] = begin;
+    for (size_t c = 1; c < chunks; ++c) {
+        const char* p = std::find(begin + size * c / chunks, end, '\n');
+        bounds[c] = std::max(bounds[c - 1], p == end ? end : p + 1);
+    }
+    return bounds;
+}
+
+};  // namespace detail
+};  // namespace common
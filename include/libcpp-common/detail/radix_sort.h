@@ -0,0 +1,81 @@
+/*
+ * radix_sort.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Parallel LSD radix sort, used to build the flat arrays of the mesh
+ * algorithms
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "libcpp-common/detail/parallel.h"
+
+namespace common {
+namespace detail {
+
+constexpr unsigned int RADIX_BITS = 8;
+constexpr size_t RADIX_BUCKETS = size_t(1) << RADIX_BITS;
+// Smaller arrays are sorted in a single thread
+constexpr size_t RADIX_PARALLEL_MIN = 1 << 16;
+
+// Stable sort of values by the lowest key_bits bits of key(value) (a
+// uint64_t), one pass per 8 bits. Each pass counts the digits of each chunk
+// of the array in its thread, and then scatters the chunk to the offsets
+// of its digits. Passes in which all the values have the same digit are
+// skipped, so that small keys are cheap
+template <typename T, typename Key>
+void radix_sort(std::vector<T>& values, unsigned int key_bits,
+                const Key& key) {
+    const size_t n = values.size();
+    if (n < 2) return;
+    const size_t chunks = num_chunks(n, RADIX_PARALLEL_MIN);
+    std::vector<size_t> offsets(chunks * RADIX_BUCKETS);
+    std::vector<T> sorted(n);
+    for (unsigned int shift = 0; shift < key_bits; shift += RADIX_BITS) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        parallel_chunks(0, n, RADIX_PARALLEL_MIN,
+                        [&](size_t c, size_t b, size_t e) {
+                            size_t* count = &offsets[c * RADIX_BUCKETS];
+                            for (size_t i = b; i < e; ++i)
+                                ++count[(key(values[i]) >> shift) &
+                                        (RADIX_BUCKETS - 1)];
+                        });
+        bool skip = false;
+        size_t offset = 0;
+        for (size_t d = 0; d < RADIX_BUCKETS; ++d) {
+            size_t total = 0;
+            for (size_t c = 0; c < chunks; ++c) {
+                const size_t count = offsets[c * RADIX_BUCKETS + d];
+                offsets[c * RADIX_BUCKETS + d] = offset;
+                offset += count;
+                total += count;
+            }
+            skip |= total == n;
+        }
+        if (skip) continue;
+        parallel_chunks(0, n, RADIX_PARALLEL_MIN,
+                        [&](size_t c, size_t b, size_t e) {
+                            size_t* next = &offsets[c * RADIX_BUCKETS];
+                            for (size_t i = b; i < e; ++i)
+                                sorted[next[(key(values[i]) >> shift) &
+                                            (RADIX_BUCKETS - 1)]++] =
+                                    std::move(values[i]);
+                        });
+        std::swap(values, sorted);
+    }
+}
+
+// Bits needed to store the values 0 to n - 1
+inline unsigned int bit_width(size_t n) {
+    unsigned int bits = 0;
+    while (bits < 64 && (size_t(1) << bits) < n) ++bits;
+    return bits;
+}
+
+};  // namespace detail
+};  // namespace common
@@ -0,0 +1,103 @@
+/*
+ * simd.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Portable SIMD packs based on GCC/Clang vector extensions
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Width of the widest vector registers available for the target, in bytes
+// Compile with e.g. -march=native (see LIBCPP_COMMON_NATIVE in CMakeLists.txt)
+// so that the compiler can use the AVX/AVX-512 registers
+#if defined(__AVX512F__)
+#define COMMON_SIMD_BYTES 64
+#elif defined(__AVX__)
+#define COMMON_SIMD_BYTES 32
+#else
+#define COMMON_SIMD_BYTES 16
+#endif
+
+namespace common {
+namespace detail {
+
+// Types that can be packed in vector registers
+template <typename T>
+static constexpr bool simd_supported =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+    !std::is_same_v<T, long double>;
+
+template <typename T>
+struct SimdPack {
+    typedef T type __attribute__((vector_size(COMMON_SIMD_BYTES)));
+};
+
+// Pack of simd_width<T> elements of type T, supports the usual arithmetic
+// operators (element-wise) and operations with scalars
+template <typename T>
+using simd_t = typename SimdPack<T>::type;
+
+template <typename T>
+static constexpr size_t simd_width = COMMON_SIMD_BYTES / sizeof(T);
+
+template <typename T>
+inline simd_t<T> simd_load(const T* p) {
+    simd_t<T> result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+template <typename T>
+inline void simd_store(T* p, const simd_t<T>& v) {
+    std::memcpy(p, &v, sizeof(v));
+}
+
+template <typename T>
+inline simd_t<T> simd_broadcast(const T& x) {
+    return simd_t<T>{} + x;
+}
+
+template <typename T, size_t W>
+struct SimdFixedPack {
+    typedef T type __attribute__((vector_size(W * sizeof(T))));
+};
+
+// Pack of exactly W elements (W * sizeof(T) must be a power of two), for
+// kernels whose width is fixed by the layout of their data. Packs wider than
+// the registers are split by the compiler. They are only passed by reference,
+// as passing them by value changes the ABI depending on the target (e.g. with
+// or without AVX for 8 floats)
+template <typename T, size_t W>
+using simd_n_t = typename SimdFixedPack<T, W>::type;
+
+template <size_t W, typename T>
+inline void simd_load_n(const T* p, simd_n_t<T, W>& result) {
+    std::memcpy(&result, p, sizeof(result));
+}
+
+template <size_t W, typename T>
+inline void simd_store_n(T* p, const simd_n_t<T, W>& v) {
+    std::memcpy(p, &v, sizeof(v));
+}
+
+template <size_t W, typename T>
+inline void simd_broadcast_n(const T& x, simd_n_t<T, W>& result) {
+    result = simd_n_t<T, W>{} + x;
+}
+
+template <typename T>
+inline simd_t<T> simd_min(const simd_t<T>& a, const simd_t<T>& b) {
+    return a < b ? a : b;
+}
+
+template <typename T>
+inline simd_t<T> simd_max(const simd_t<T>& a, const simd_t<T>& b) {
+    return a > b ? a : b;
+}
+
+};  // namespace detail
+};  // namespace common
@@ -534,14 +534,17 @@ class Mat : public std::array<Vec<T, N>, M> {
     template <unsigned int N2 = N, unsigned int M2 = M,
               typename = std::enable_if_t<N2 == 4 && M2 == 4>>
     static inline Mat<T, 4> rotation_axis_angle(Vec4f axis, float rad) {
-        float c = cosf(rad), mc = 1 - c;
-        float s = sinf(rad), ms = 1 - s;
-        float x = axis.x(), y = axis.y(), z = axis.z();
+        const T c = cosf(rad), s = sinf(rad), mc = 1 - c;
+        const T x = axis.x(), y = axis.y(), z = axis.z();
         // https://en.wikipedia.org/wiki/Rotation_matrix
-        return Mat(c + x * x * mc, x * y * mc - z * s, x * z * mc + y * s, 0,
-                   y * x * mc + z * s, c + y * y * mc, y * z * mc - x * s, 0,
-                   z * x * mc - y * s, z * y * mc + x * s, c + z * z * mc, 0, 0,
-                   0, 0, 1);
+        // (built by columns, see geometry/transform.h for cheaper rotations)
+        return Mat<T, 4>(Vec<T, 4>(c + x * x * mc, y * x * mc + z * s,
+                                   z * x * mc - y * s, 0),
+                         Vec<T, 4>(x * y * mc - z * s, c + y * y * mc,
+                                   z * y * mc + x * s, 0),
+                         Vec<T, 4>(x * z * mc + y * s, y * z * mc - x * s,
+                                   c + z * z * mc, 0),
+                         Vec<T, 4>(0, 0, 0, 1));
     }
     template <unsigned int N2 = N, unsigned int M2 = M,
               typename = std::enable_if_t<N2 == 4 && M2 == 4>>
@@ -0,0 +1,174 @@
+/*
+ * aabb.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Axis-aligned bounding boxes, and the bounds of a VecList
+ */
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "libcpp-common/geometry.h"
+
+namespace common {
+
+// Box [min, max] in N dimensions. Default constructed boxes are empty
+// (min = +inf, max = -inf), so that extending them with anything gives that
+//   AABB3f box;
+//   for (const Vec3f& p : points) box.extend(p);
+template <typename T, unsigned int N>
+struct AABB {
+    using Vec = common::Vec<T, N>;
+
+    static constexpr T highest() {
+        return std::numeric_limits<T>::has_infinity
+                   ? std::numeric_limits<T>::infinity()
+                   : std::numeric_limits<T>::max();
+    }
+    static constexpr T lowest() {
+        return std::numeric_limits<T>::has_infinity
+                   ? -std::numeric_limits<T>::infinity()
+                   : std::numeric_limits<T>::lowest();
+    }
+
+    Vec min = Vec(highest());
+    Vec max = Vec(lowest());
+
+    constexpr AABB() = default;
+    constexpr AABB(const Vec& min, const Vec& max) : min(min), max(max) {}
+
+    constexpr bool empty() const {
+        for (unsigned int k = 0; k < N; ++k)
+            if (!(min[k] <= max[k])) return true;
+        return false;
+    }
+    constexpr Vec extent() const { return max - min; }
+    constexpr Vec center() const { return (min + max) / T(2); }
+
+    // Axis with the largest extent
+    constexpr unsigned int largest_axis() const {
+        const Vec d = extent();
+        unsigned int largest = 0;
+        for (unsigned int k = 1; k < N; ++k)
+            if (d[k] > d[largest]) largest = k;
+        return largest;
+    }
+
+    constexpr void extend(const Vec& p) {
+        for (unsigned int k = 0; k < N; ++k) {
+            min[k] = std::min(min[k], p[k]);
+            max[k] = std::max(max[k], p[k]);
+        }
+    }
+    constexpr void extend(const AABB& b) {
+        for (unsigned int k = 0; k < N; ++k) {
+            min[k] = std::min(min[k], b.min[k]);
+            max[k] = std::max(max[k], b.max[k]);
+        }
+    }
+
+    constexpr bool contains(const Vec& p) const {
+        for (unsigned int k = 0; k < N; ++k)
+            if (!(min[k] <= p[k] && p[k] <= max[k])) return false;
+        return true;
+    }
+    constexpr bool overlaps(const AABB& b) const {
+        for (unsigned int k = 0; k < N; ++k)
+            if (!(min[k] <= b.max[k] && b.min[k] <= max[k])) return false;
+        return true;
+    }
+
+    // Squared distance from p to the box, 0 inside
+    constexpr T distance2(const Vec& p) const {
+        T d2 = 0;
+        for (unsigned int k = 0; k < N; ++k) {
+            const T d = std::max(std::max(min[k] - p[k], p[k] - max[k]), T(0));
+            d2 += d * d;
+        }
+        return d2;
+    }
+
+    // Area of the sides of a 3D box (0 if empty), for surface area heuristics
+    template <unsigned int M = N, typename = std::enable_if_t<M == 3>>
+    constexpr T surface_area() const {
+        if (empty()) return 0;
+        const Vec d = extent();
+        return 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+    }
+    constexpr T volume() const {
+        if (empty()) return 0;
+        T result = 1;
+        for (unsigned int k = 0; k < N; ++k) result *= max[k] - min[k];
+        return result;
+    }
+
+    // Slab test of the ray origin + t * direction, given inverse = 1 /
+    // direction (component-wise, infinite for directions parallel to an
+    // axis). Returns whether it enters the box with tmin <= t <= tmax, and
+    // its entry and exit clipped to [tmin, tmax] in tmin and tmax. Components
+    // with NaN values (0 * inf, a ray parallel to a slab and on its border)
+    // are ignored
+    template <unsigned int M = N, typename = std::enable_if_t<M == 3>>
+    constexpr bool intersect(const Vec& origin, const Vec& inverse, T& tmin,
+                             T& tmax) const {
+        for (unsigned int k = 0; k < 3; ++k) {
+            T t0 = (min[k] - origin[k]) * inverse[k];
+            T t1 = (max[k] - origin[k]) * inverse[k];
+            if (t0 > t1) std::swap(t0, t1);
+            tmin = std::max(tmin, t0);
+            tmax = std::min(tmax, t1);
+        }
+        return tmin <= tmax;
+    }
+
+    // From a box of Vec4 points, e.g. bounds(mesh.vertices).xyz()
+    template <unsigned int M = N, typename = std::enable_if_t<M == 4>>
+    constexpr AABB<T, 3> xyz() const {
+        return AABB<T, 3>(min.xyz(), max.xyz());
+    }
+
+    constexpr bool operator==(const AABB& b) const {
+        return min == b.min && max == b.max;
+    }
+
+    friend std::ostream& operator<<(std::ostream& s, const AABB& b) {
+        return s << "[" << b.min << ", " << b.max << "]";
+    }
+};
+
+// Smallest box that contains both
+template <typename T, unsigned int N>
+constexpr AABB<T, N> merge(const AABB<T, N>& a, const AABB<T, N>& b) {
+    AABB<T, N> result = a;
+    result.extend(b);
+    return result;
+}
+
+// Box of the points in both, empty if they do not overlap
+template <typename T, unsigned int N>
+constexpr AABB<T, N> intersection(const AABB<T, N>& a, const AABB<T, N>& b) {
+    AABB<T, N> result;
+    for (unsigned int k = 0; k < N; ++k) {
+        result.min[k] = std::max(a.min[k], b.min[k]);
+        result.max[k] = std::min(a.max[k], b.max[k]);
+    }
+    return result;
+}
+
+using AABB2f = AABB<float, 2>;
+using AABB2i = AABB<int, 2>;
+using AABB3f = AABB<float, 3>;
+using AABB3i = AABB<int, 3>;
+using AABB4f = AABB<float, 4>;
+
+// Bounds of the points of a list (empty for an empty list), as SIMD min/max
+// over data_flat() split between threads for large lists. NaN components
+// are ignored
+template <typename T, unsigned int N>
+AABB<T, N> bounds(const VecList<T, N>& points);
+
+};  // namespace common
+
+#include "geometry/aabb.tpp"
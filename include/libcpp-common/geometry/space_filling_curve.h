@@ -0,0 +1,65 @@
+/*
+ * space_filling_curve.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Morton (Z-order) and Hilbert codes of 3D points, and parallel sorting of
+ * a VecList (and the arrays attached to it) along them
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "libcpp-common/geometry.h"
+#include "libcpp-common/geometry/aabb.h"
+
+namespace common {
+
+enum class Curve : char { Morton, Hilbert };
+
+// Codes of a cell (x, y, z) of a grid of 2^10 (Code = uint32_t, 30-bit
+// codes) or 2^21 (Code = uint64_t, 63-bit codes) cells per axis. Morton codes
+// interleave the bits of the coordinates, x in the lowest bit, with BMI2
+// pdep when the target has it (e.g. with LIBCPP_COMMON_NATIVE) and with
+// magic-number shifts otherwise. Hilbert codes (Skilling 2004) are
+// interleaved in the same way after transforming the coordinates, and
+// consecutive codes are always neighbouring cells
+template <typename Code>
+inline Code morton_encode(uint32_t x, uint32_t y, uint32_t z);
+template <typename Code>
+inline Code hilbert_encode(uint32_t x, uint32_t y, uint32_t z);
+
+// Codes of the first 3 components of the points, quantized in a grid over
+// box (by default, the bounds of the points). Computed in parallel
+template <typename Code = uint64_t, typename T, unsigned int N>
+std::vector<Code> curve_codes(const VecList<T, N>& points, Curve curve,
+                              const AABB<T, 3>& box);
+template <typename Code = uint64_t, typename T, unsigned int N>
+std::vector<Code> curve_codes(const VecList<T, N>& points,
+                              Curve curve = Curve::Morton);
+
+// Order in which the codes are sorted (order[i] is the index of the i-th
+// smallest, ties in the order of their indices), with a parallel LSD radix
+// sort of the lowest key_bits bits
+template <typename Code>
+std::vector<uint32_t> sort_order(const std::vector<Code>& codes,
+                                 unsigned int key_bits = 8 * sizeof(Code));
+
+// values[i] = old values[order[i]], in parallel. order may be shorter than
+// values, to keep only some of them
+template <typename List>
+void reorder(List& values, const std::vector<uint32_t>& order);
+
+// Sorts the points along a curve with 63-bit codes, and reorders the arrays
+// attached to them (of the same length, e.g. normals or colors) in the same
+// way. Returns the order, to reorder other data or remap indices
+//   std::vector<uint32_t> order =
+//       sort_along_curve(points, Curve::Hilbert, normals, colors);
+template <typename T, unsigned int N, typename... Attached>
+std::vector<uint32_t> sort_along_curve(VecList<T, N>& points, Curve curve,
+                                       Attached&... attached);
+
+};  // namespace common
+
+#include "geometry/space_filling_curve.tpp"
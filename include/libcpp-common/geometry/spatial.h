@@ -0,0 +1,208 @@
+/*
+ * spatial.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Spatial indices over the points of a VecList for nearest neighbour and
+ * radius queries: a k-d tree and a uniform hash grid
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "libcpp-common/geometry.h"
+#include "libcpp-common/geometry/aabb.h"
+
+namespace common {
+
+// Point found by a query, with its squared distance to the query point
+template <typename T>
+struct Neighbor {
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = NONE;
+    T distance2 = std::numeric_limits<T>::infinity();
+
+    bool found() const { return index != NONE; }
+};
+
+// Neighbours of many query points in compressed rows: those of query i are
+// neighbors[j] for offsets[i] <= j < offsets[i + 1]
+//   for (const Neighbor<float>& n : results[i]) ...
+template <typename T>
+struct NeighborRows {
+    struct Row {
+        const Neighbor<T>* first;
+        const Neighbor<T>* last;
+
+        const Neighbor<T>* begin() const { return first; }
+        const Neighbor<T>* end() const { return last; }
+        size_t size() const { return last - first; }
+    };
+
+    std::vector<size_t> offsets = {0};
+    std::vector<Neighbor<T>> neighbors;
+
+    size_t size() const { return offsets.size() - 1; }
+    Row operator[](size_t i) const {
+        return {neighbors.data() + offsets[i],
+                neighbors.data() + offsets[i + 1]};
+    }
+};
+
+// Balanced k-d tree stored implicitly in an array of point indices: the
+// node of the range [b, e) splits it at its median m = (b + e) / 2, so only
+// the axis and split value of each median are stored, next to each other in
+// the order of the traversal. Built with nth_element, partitioning the first
+// levels in parallel and then building subtrees in different threads.
+// It references the points of the list (which must outlive it and not
+// change) and does not copy them. Lists of Vec4 (e.g. mesh vertices) are
+// indexed by their xyz components, and queries can be any Vec with at least
+// D components
+//   KDTree3f tree(points);
+//   Neighbor<float> n = tree.nearest(Vec3f(0, 0, 0));
+//   if (n.found()) points[n.index] ...
+template <typename T, unsigned int N>
+class KDTree {
+   public:
+    static_assert(std::is_floating_point_v<T>,
+                  "KDTree needs floating point coordinates");
+    static constexpr unsigned int D = N < 3 ? N : 3;  // indexed components
+
+    KDTree() = default;
+    explicit KDTree(const VecList<T, N>& points, size_t leaf_size = 8) {
+        build(points, leaf_size);
+    }
+    // The points are referenced, so they cannot be a temporary
+    explicit KDTree(VecList<T, N>&&, size_t = 8) = delete;
+
+    // Leaves have up to leaf_size points, which are tested one by one
+    void build(const VecList<T, N>& points, size_t leaf_size = 8);
+    void build(VecList<T, N>&&, size_t = 8) = delete;
+
+    size_t size() const { return m_indices.size(); }
+    // Indices of the points in the order of the tree
+    const std::vector<uint32_t>& indices() const { return m_indices; }
+
+    // Closest point at a distance of max_distance or less
+    template <unsigned int M>
+    Neighbor<T> nearest(
+        const Vec<T, M>& p,
+        T max_distance = std::numeric_limits<T>::infinity()) const;
+
+    // The k closest points at a distance of max_distance or less, from the
+    // closest to the farthest, written to result[0:k]. Returns how many were
+    // found, the rest of result is set to Neighbor<T>()
+    template <unsigned int M>
+    size_t knn(const Vec<T, M>& p, size_t k, Neighbor<T>* result,
+               T max_distance = std::numeric_limits<T>::infinity()) const;
+
+    // Points at a distance of r or less, in no particular order
+    template <unsigned int M>
+    void radius(const Vec<T, M>& p, T r,
+                std::vector<Neighbor<T>>& result) const;
+
+    // Same queries for many points, split between threads. knn writes k
+    // neighbours per point in results[0:n * k]
+    template <unsigned int M>
+    void knn(const Vec<T, M>* points, size_t n, size_t k,
+             Neighbor<T>* results,
+             T max_distance = std::numeric_limits<T>::infinity()) const;
+    template <unsigned int M>
+    NeighborRows<T> radius(const Vec<T, M>* points, size_t n, T r) const;
+
+   private:
+    const VecList<T, N>* m_points = nullptr;
+    std::vector<uint32_t> m_indices;
+    std::vector<T> m_split;  // of the node of each median, in m_indices order
+    std::vector<uint8_t> m_axis;
+    size_t m_leaf_size = 8;
+
+    T coordinate(uint32_t i, unsigned int axis) const {
+        return (*m_points)[i][axis];
+    }
+    template <unsigned int M>
+    T distance2(uint32_t i, const Vec<T, M>& p) const;
+    void build(size_t begin, size_t end, size_t depth,
+               const AABB<T, D>& cell);
+    // Calls visit(index, distance2) for the points of [begin, end) whose
+    // nodes are closer than bound2, which visit may shrink
+    template <unsigned int M, typename Visit>
+    void traverse(const Vec<T, M>& p, size_t begin, size_t end, T& bound2,
+                  const Visit& visit) const;
+};
+
+using KDTree2f = KDTree<float, 2>;
+using KDTree3f = KDTree<float, 3>;
+using KDTree4f = KDTree<float, 4>;
+
+// Uniform grid of cells of size cell_size, of which only the non-empty ones
+// are stored, hashed (Teschner et al. 2003) into 2 to 4 buckets per point.
+// The points are sorted by bucket with a parallel radix sort, so each bucket
+// is a contiguous range of indices, and the cells of each row along x are in
+// consecutive buckets. Best for radius queries of about cell_size, which
+// read the 3^(D - 1) rows of 3 cells around the query point. As KDTree,
+// it references the points of the list without copying them, and lists of
+// Vec4 are indexed by their xyz components
+//   HashGrid3f grid(points, r);
+//   std::vector<Neighbor<float>> neighbors;
+//   grid.radius(p, r, neighbors);
+template <typename T, unsigned int N>
+class HashGrid {
+   public:
+    static_assert(std::is_floating_point_v<T>,
+                  "HashGrid needs floating point coordinates");
+    static constexpr unsigned int D = N < 3 ? N : 3;
+
+    HashGrid() = default;
+    HashGrid(const VecList<T, N>& points, T cell_size) {
+        build(points, cell_size);
+    }
+    HashGrid(VecList<T, N>&&, T) = delete;
+
+    // Throws CommonGeometryException if cell_size is not positive
+    void build(const VecList<T, N>& points, T cell_size);
+    void build(VecList<T, N>&&, T) = delete;
+
+    size_t size() const { return m_indices.size(); }
+    T cell_size() const { return m_cell_size; }
+
+    // Closest point at a distance of max_distance or less (cell_size if
+    // negative)
+    template <unsigned int M>
+    Neighbor<T> nearest(const Vec<T, M>& p, T max_distance = -1) const;
+
+    // Points at a distance of r or less, in no particular order
+    template <unsigned int M>
+    void radius(const Vec<T, M>& p, T r,
+                std::vector<Neighbor<T>>& result) const;
+
+    // Same query for many points, split between threads
+    template <unsigned int M>
+    NeighborRows<T> radius(const Vec<T, M>* points, size_t n, T r) const;
+
+   private:
+    const VecList<T, N>* m_points = nullptr;
+    T m_cell_size = 1;
+    std::vector<uint32_t> m_indices;  // sorted by bucket
+    std::vector<uint32_t> m_buckets;  // first index of each, and the end
+    unsigned int m_shift = 64;  // of the hashes of the rows, to keep bits
+    uint64_t m_mask = 0;        // number of buckets - 1
+    Vec<int64_t, D> m_lower, m_upper;  // bounds of the non-empty cells
+
+    uint64_t bucket(const Vec<int64_t, D>& cell) const;
+    // Calls visit(index, distance2) for the points within r of p, each once
+    template <unsigned int M, typename Visit>
+    void for_each_within(const Vec<T, M>& p, T r, const Visit& visit) const;
+};
+
+using HashGrid2f = HashGrid<float, 2>;
+using HashGrid3f = HashGrid<float, 3>;
+using HashGrid4f = HashGrid<float, 4>;
+
+};  // namespace common
+
+#include "geometry/spatial.tpp"
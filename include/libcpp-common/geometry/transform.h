@@ -0,0 +1,201 @@
+/*
+ * transform.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Quaternions and compact 3x4 affine transforms, cheaper to compose and to
+ * invert than 4x4 matrices, applied to whole VecLists with SIMD
+ */
+#pragma once
+
+#include <cmath>
+#include <ostream>
+#include <type_traits>
+
+#include "libcpp-common/geometry.h"
+
+namespace common {
+
+/// QUATERNION ///
+
+// Quaternion xi + yj + zk + w, which represents a rotation when it has unit
+// norm. q * p rotates by p and then by q
+//   Quatf q = Quatf::axis_angle(Vec3f(0, 0, 1), M_PI / 2);
+//   Vec3f v = q * Vec3f(1, 0, 0);  // (0, 1, 0)
+template <typename T>
+struct Quat {
+    static_assert(std::is_floating_point_v<T>,
+                  "Quat needs floating point components");
+
+    T x = 0, y = 0, z = 0, w = 1;
+
+    constexpr Quat() = default;
+    constexpr Quat(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+    constexpr Quat(const Vec<T, 3>& v, T w)
+        : x(v.x()), y(v.y()), z(v.z()), w(w) {}
+
+    // Rotation of rad radians around axis (which does not need to be unit)
+    static Quat axis_angle(const Vec<T, 3>& axis, T rad);
+    // Rotation of an orthonormal matrix (Shepperd's method)
+    static Quat from_matrix(const Mat<T, 3>& m);
+
+    constexpr Vec<T, 3> vec() const { return Vec<T, 3>(x, y, z); }
+    constexpr T norm2() const { return x * x + y * y + z * z + w * w; }
+    Quat normalized() const {
+        const T s = 1 / std::sqrt(norm2());
+        return Quat(x * s, y * s, z * s, w * s);
+    }
+    constexpr Quat conjugate() const { return Quat(-x, -y, -z, w); }
+    constexpr Quat inverse() const {
+        const T s = 1 / norm2();
+        return Quat(-x * s, -y * s, -z * s, w * s);
+    }
+
+    constexpr Quat operator*(const Quat& o) const {
+        return Quat(w * o.x + x * o.w + y * o.z - z * o.y,
+                    w * o.y - x * o.z + y * o.w + z * o.x,
+                    w * o.z + x * o.y - y * o.x + z * o.w,
+                    w * o.w - x * o.x - y * o.y - z * o.z);
+    }
+    constexpr Quat operator*(T s) const {
+        return Quat(x * s, y * s, z * s, w * s);
+    }
+    constexpr Quat operator+(const Quat& o) const {
+        return Quat(x + o.x, y + o.y, z + o.z, w + o.w);
+    }
+    constexpr Quat operator-() const { return Quat(-x, -y, -z, -w); }
+
+    // Rotates v (for unit quaternions), with two cross products instead of
+    // the full q v q^-1 product
+    constexpr Vec<T, 3> operator*(const Vec<T, 3>& v) const {
+        const Vec<T, 3> q = vec();
+        const Vec<T, 3> t = cross(q, v) * T(2);
+        return v + t * w + cross(q, t);
+    }
+
+    // Rotation matrix (for unit quaternions)
+    constexpr Mat<T, 3> matrix() const;
+
+    constexpr bool operator==(const Quat& o) const {
+        return x == o.x && y == o.y && z == o.z && w == o.w;
+    }
+
+    friend std::ostream& operator<<(std::ostream& s, const Quat& q) {
+        return s << "(" << q.x << ", " << q.y << ", " << q.z << "; " << q.w
+                 << ")";
+    }
+};
+
+template <typename T>
+constexpr T dot(const Quat<T>& a, const Quat<T>& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+// Interpolation between two rotations by the shortest path, at constant
+// angular speed (slerp) or normalizing the linear interpolation (nlerp,
+// cheaper, and slerp falls back to it for very close rotations)
+template <typename T>
+Quat<T> slerp(const Quat<T>& a, const Quat<T>& b, T t);
+template <typename T>
+Quat<T> nlerp(const Quat<T>& a, const Quat<T>& b, T t);
+
+using Quatf = Quat<float>;
+using Quatd = Quat<double>;
+
+/// AFFINE TRANSFORM ///
+
+// Transform p -> L p + t, stored as the 3 rows of the 3x4 matrix [L | t]
+// (the last row of the 4x4 matrix is always (0, 0, 0, 1), so it is not
+// stored). a * b applies b and then a, with 36 multiplications instead of
+// the 64 of a Mat4 product. Lists of Vec3 are transformed as points, and
+// lists of Vec4 as homogeneous coordinates (points with w = 1, vectors with
+// w = 0)
+//   Affinef pose(Quatf::axis_angle(axis, angle), Vec3f(0, 1, 0));
+//   VecList3f world = parent * pose * local;
+template <typename T>
+struct Affine {
+    static_assert(std::is_floating_point_v<T>,
+                  "Affine needs floating point components");
+
+    Vec<T, 4> rows[3] = {Vec<T, 4>(1, 0, 0, 0), Vec<T, 4>(0, 1, 0, 0),
+                         Vec<T, 4>(0, 0, 1, 0)};
+
+    constexpr Affine() = default;
+    constexpr Affine(const Vec<T, 4>& r0, const Vec<T, 4>& r1,
+                     const Vec<T, 4>& r2)
+        : rows{r0, r1, r2} {}
+    constexpr Affine(const Mat<T, 3>& linear,
+                     const Vec<T, 3>& translation = Vec<T, 3>());
+    constexpr Affine(const Quat<T>& rotation,
+                     const Vec<T, 3>& translation = Vec<T, 3>())
+        : Affine(rotation.matrix(), translation) {}
+    // Top 3 rows of m, whose last row must be (0, 0, 0, 1)
+    constexpr explicit Affine(const Mat<T, 4>& m);
+
+    static constexpr Affine translation(const Vec<T, 3>& t) {
+        return Affine(Mat<T, 3>::identity(), t);
+    }
+    static constexpr Affine scale(const Vec<T, 3>& s) {
+        return Affine(Vec<T, 4>(s.x(), 0, 0, 0), Vec<T, 4>(0, s.y(), 0, 0),
+                      Vec<T, 4>(0, 0, s.z(), 0));
+    }
+
+    constexpr T operator()(size_t i, size_t j) const { return rows[i][j]; }
+    constexpr T& operator()(size_t i, size_t j) { return rows[i][j]; }
+    constexpr Mat<T, 3> linear() const;
+    constexpr Vec<T, 3> translation() const {
+        return Vec<T, 3>(rows[0].w(), rows[1].w(), rows[2].w());
+    }
+    constexpr Mat<T, 4> matrix() const;
+
+    // Each row of the result is a combination of the rows of o
+    constexpr Affine operator*(const Affine& o) const {
+        Affine result;
+        for (unsigned int i = 0; i < 3; ++i) {
+            result.rows[i] = o.rows[0] * rows[i][0] + o.rows[1] * rows[i][1] +
+                             o.rows[2] * rows[i][2];
+            result.rows[i].w() += rows[i].w();
+        }
+        return result;
+    }
+
+    // Point p (Vec3), homogeneous coordinates (Vec4) and vector v (without
+    // the translation)
+    constexpr Vec<T, 3> operator*(const Vec<T, 3>& p) const {
+        return apply_vector(p) + translation();
+    }
+    constexpr Vec<T, 4> operator*(const Vec<T, 4>& p) const {
+        return Vec<T, 4>(dot(rows[0], p), dot(rows[1], p), dot(rows[2], p),
+                         p.w());
+    }
+    constexpr Vec<T, 3> apply_vector(const Vec<T, 3>& v) const {
+        return Vec<T, 3>(dot(rows[0].xyz(), v), dot(rows[1].xyz(), v),
+                         dot(rows[2].xyz(), v));
+    }
+
+    // Same for whole lists, with SIMD and split between threads
+    template <unsigned int N>
+    VecList<T, N> operator*(const VecList<T, N>& points) const;
+    template <unsigned int N>
+    VecList<T, N> apply_vectors(const VecList<T, N>& vectors) const;
+
+    // Inverse of any invertible transform, with the 3x3 adjugate of L
+    constexpr Affine inverse() const;
+    // Inverse of a rotation and translation: (R^T, -R^T t)
+    constexpr Affine rigid_inverse() const;
+
+    constexpr bool operator==(const Affine& o) const {
+        return rows[0] == o.rows[0] && rows[1] == o.rows[1] &&
+               rows[2] == o.rows[2];
+    }
+
+    friend std::ostream& operator<<(std::ostream& s, const Affine& a) {
+        return s << a.matrix();
+    }
+};
+
+using Affinef = Affine<float>;
+using Affined = Affine<double>;
+
+};  // namespace common
+
+#include "geometry/transform.tpp"
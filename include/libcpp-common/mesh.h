@@ -2,25 +2,90 @@
  * mesh.h
  * Diego Royo Meneses - Dec. 2023
  *
- * 3D model loader
+ * 3D model loader and saver
  */
 
 #pragma once
 
+#include <cstdint>
 #include <fstream>
 #include <string>
 
 #include "libcpp-common/detail/exception.h"
 #include "libcpp-common/geometry.h"
+#include "libcpp-common/geometry/aabb.h"
+#include "libcpp-common/mesh/adjacency.h"
+#include "libcpp-common/mesh/attributes.h"
+#include "libcpp-common/mesh/bvh.h"
+#include "libcpp-common/mesh/cache.h"
+#include "libcpp-common/mesh/intersect.h"
+#include "libcpp-common/mesh/normals.h"
+#include "libcpp-common/mesh/obj.h"
+#include "libcpp-common/mesh/optimize.h"
 #include "libcpp-common/mesh/ply.h"
+#include "libcpp-common/mesh/simplify.h"
+#include "libcpp-common/mesh/triangulate.h"
+#include "libcpp-common/mesh/weld.h"
 
 namespace common {
 
 struct Mesh {
     VecList4f vertices;
     VecList3u faces;
+    // other per-vertex/per-face properties of the file, see AttributeMask
+    MeshAttributes vertex_attributes;
+    MeshAttributes face_attributes;
 };
 
-Mesh load_mesh(const char* filename);
+// Mesh with packed (x, y, z) positions, and 16-bit vertex indices when
+// there are few enough vertices. Only one of faces16/faces32 is used
+// (see fits_16bit), the other one is empty
+struct CompactMesh {
+    VecList3f vertices;
+    VecList<uint16_t, 3> faces16;
+    VecList3u faces32;
+    MeshAttributes vertex_attributes;
+    MeshAttributes face_attributes;
+
+    static constexpr bool fits_16bit(size_t num_vertices) {
+        return num_vertices <= 65536;
+    }
+    bool has_16bit_indices() const { return fits_16bit(vertices.size()); }
+
+    size_t num_faces() const {
+        return has_16bit_indices() ? faces16.size() : faces32.size();
+    }
+    Vec3u face(size_t i) const {
+        if (has_16bit_indices())
+            return Vec3u(faces16[i][0], faces16[i][1], faces16[i][2]);
+        return faces32[i];
+    }
+
+    // Calls f(faces) with the list of faces that is in use, so that loops
+    // over the faces are compiled once for each index type, e.g.
+    //   mesh.visit_faces([&](const auto& faces) { for (auto& f : faces) ...
+    template <typename Func>
+    decltype(auto) visit_faces(Func&& f) const {
+        if (has_16bit_indices()) return f(faces16);
+        return f(faces32);
+    }
+
+    // Vertices with w = 1, e.g. to apply a Mat4f
+    VecList4f homogeneous() const;
+    Mesh to_mesh() const;
+};
+
+// Drops the w coordinate (w = 1 is assumed) and narrows the indices
+CompactMesh compact(const Mesh& mesh);
+
+// Only the attributes selected by mask are loaded (none by default)
+Mesh load_mesh(const char* filename, const AttributeMask& mask = {});
+CompactMesh load_compact_mesh(const char* filename,
+                              const AttributeMask& mask = {});
+
+// Saves a mesh cache for filenames ending in .cmesh (see mesh/cache.h), and
+// a binary PLY file otherwise
+void save_mesh(const char* filename, const Mesh& mesh);
+void save_mesh(const char* filename, const CompactMesh& mesh);
 
 };  // namespace common
\ No newline at end of file
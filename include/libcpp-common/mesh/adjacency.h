@@ -0,0 +1,133 @@
+/*
+ * adjacency.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Neighbourhoods of the vertices of a mesh in flat arrays: compressed rows
+ * of vertex-face and vertex-vertex adjacency, and implicit half-edges
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "libcpp-common/geometry.h"
+
+namespace common {
+
+struct Mesh;
+
+// Rows of indices in compressed sparse row layout: row i is indices()[j]
+// for offsets()[i] <= j < offsets()[i + 1]
+//   for (uint32_t face : adjacency[v]) ...
+class Adjacency {
+   public:
+    // Indices of a row, iterable
+    struct Row {
+        const uint32_t* first;
+        const uint32_t* last;
+
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+        uint32_t operator[](size_t i) const { return first[i]; }
+    };
+
+    Adjacency() : m_offsets(1, 0) {}
+    Adjacency(std::vector<uint32_t> offsets, std::vector<uint32_t> indices)
+        : m_offsets(std::move(offsets)), m_indices(std::move(indices)) {}
+
+    size_t size() const { return m_offsets.size() - 1; }
+    uint32_t degree(size_t i) const {
+        return m_offsets[i + 1] - m_offsets[i];
+    }
+    Row operator[](size_t i) const {
+        return {m_indices.data() + m_offsets[i],
+                m_indices.data() + m_offsets[i + 1]};
+    }
+
+    const std::vector<uint32_t>& offsets() const { return m_offsets; }
+    const std::vector<uint32_t>& indices() const { return m_indices; }
+
+   private:
+    std::vector<uint32_t> m_offsets;  // size() + 1 of them
+    std::vector<uint32_t> m_indices;
+};
+
+// Faces around each vertex, in increasing order. A face with a repeated
+// vertex appears once per corner. Built with a parallel radix sort of the
+// corners, as all the functions of this file. Throws CommonMeshException if
+// a face references a vertex that does not exist
+Adjacency vertex_face_adjacency(const Mesh& mesh);
+
+// Vertices connected to each vertex by an edge (its one-ring), in
+// increasing order and without repetitions
+Adjacency vertex_vertex_adjacency(const Mesh& mesh);
+
+// Half-edges of a triangle mesh, implicit in the order of the faces: half-edge
+// h = 3 * f + k goes from corner k of face f to corner (k + 1) % 3, so that
+// only their twins (the opposite half-edge of the neighbouring face) and one
+// outgoing half-edge per vertex are stored. Edges with a single face are on
+// the boundary, and so are non-manifold edges (of 3 or more faces, or with 2
+// faces with inconsistent orientations), which are counted apart
+//   half_edges.for_each_outgoing(v, [&](uint32_t h) {
+//       uint32_t neighbour = half_edges.target(h); ...
+class HalfEdgeMesh {
+   public:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    HalfEdgeMesh() = default;
+    explicit HalfEdgeMesh(const Mesh& mesh) { build(mesh); }
+
+    void build(const Mesh& mesh);
+
+    size_t num_vertices() const { return m_vertex_half_edge.size(); }
+    size_t num_faces() const { return m_origin.size() / 3; }
+    size_t num_half_edges() const { return m_origin.size(); }
+    size_t num_non_manifold_edges() const { return m_non_manifold; }
+
+    static uint32_t face(uint32_t h) { return h / 3; }
+    static uint32_t next(uint32_t h) { return h % 3 == 2 ? h - 2 : h + 1; }
+    static uint32_t prev(uint32_t h) { return h % 3 == 0 ? h + 2 : h - 1; }
+    uint32_t origin(uint32_t h) const { return m_origin[h]; }
+    uint32_t target(uint32_t h) const { return m_origin[next(h)]; }
+    uint32_t twin(uint32_t h) const { return m_twin[h]; }
+    bool is_boundary(uint32_t h) const { return m_twin[h] == NONE; }
+
+    // A half-edge going out of v, NONE if it has no faces. For vertices on
+    // the boundary, the one on the boundary, so that the rotation of
+    // for_each_outgoing goes through all their faces
+    uint32_t half_edge(uint32_t v) const { return m_vertex_half_edge[v]; }
+    bool is_boundary_vertex(uint32_t v) const {
+        const uint32_t h = m_vertex_half_edge[v];
+        return h != NONE && m_twin[h] == NONE;
+    }
+
+    // Calls f(h) for the half-edges going out of v, one per face around it,
+    // in O(degree). Only the faces of one fan of a non-manifold vertex are
+    // visited
+    template <typename Func>
+    void for_each_outgoing(uint32_t v, const Func& f) const {
+        const uint32_t first = m_vertex_half_edge[v];
+        if (first == NONE) return;
+        uint32_t h = first;
+        do {
+            f(h);
+            h = m_twin[prev(h)];
+        } while (h != NONE && h != first);
+    }
+
+    // Each edge once, as the vertices of one of its half-edges
+    VecList2u edges() const;
+
+   private:
+    std::vector<uint32_t> m_origin;  // vertex of each half-edge
+    std::vector<uint32_t> m_twin;
+    std::vector<uint32_t> m_vertex_half_edge;
+    size_t m_non_manifold = 0;
+};
+
+};  // namespace common
@@ -0,0 +1,166 @@
+/*
+ * attributes.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Named per-vertex/per-face data of a mesh (normals, colors, UVs...)
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "libcpp-common/detail/exception.h"
+
+namespace common {
+
+// Values of one attribute for every vertex (or face), with the type of the
+// file they were loaded from
+using AttributeData =
+    std::variant<std::vector<int8_t>, std::vector<uint8_t>,
+                 std::vector<int16_t>, std::vector<uint16_t>,
+                 std::vector<int32_t>, std::vector<uint32_t>,
+                 std::vector<float>, std::vector<double>>;
+
+// Attributes stored as one array per name (structure of arrays), e.g.
+//   const std::vector<float>& nx = mesh.vertex_attributes.get<float>("nx");
+//   std::vector<float> red = mesh.vertex_attributes.get_as<float>("red");
+class MeshAttributes {
+   public:
+    bool empty() const { return m_channels.empty(); }
+    size_t num_channels() const { return m_channels.size(); }
+    bool has(const std::string& name) const { return find(name) != nullptr; }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> result;
+        for (const auto& channel : m_channels) result.push_back(channel.first);
+        return result;
+    }
+
+    // Values of an attribute with its original type, throws
+    // CommonMeshException if it does not exist or has another type
+    template <typename T>
+    std::vector<T>& get(const std::string& name) {
+        return get_impl<T>(find(name), name);
+    }
+    template <typename T>
+    const std::vector<T>& get(const std::string& name) const {
+        return get_impl<T>(find(name), name);
+    }
+
+    // Copy of the values of an attribute, converted to T
+    template <typename T>
+    std::vector<T> get_as(const std::string& name) const {
+        const AttributeData* data = find(name);
+        if (data == nullptr)
+            throw detail::CommonMeshException("Attribute not found: " + name);
+        return std::visit(
+            [](const auto& values) {
+                return std::vector<T>(values.begin(), values.end());
+            },
+            *data);
+    }
+
+    AttributeData& data(const std::string& name) {
+        AttributeData* result = find(name);
+        if (result == nullptr)
+            throw detail::CommonMeshException("Attribute not found: " + name);
+        return *result;
+    }
+
+    // Add an attribute (or replace the one with the same name)
+    template <typename T>
+    std::vector<T>& set(const std::string& name, std::vector<T> values) {
+        AttributeData* data = find(name);
+        if (data == nullptr) {
+            m_channels.emplace_back(name, std::move(values));
+            return std::get<std::vector<T>>(m_channels.back().second);
+        }
+        *data = std::move(values);
+        return std::get<std::vector<T>>(*data);
+    }
+
+    void erase(const std::string& name) {
+        m_channels.erase(
+            std::remove_if(m_channels.begin(), m_channels.end(),
+                           [&](const auto& c) { return c.first == name; }),
+            m_channels.end());
+    }
+    void clear() { m_channels.clear(); }
+
+    // Replaces the values of every attribute by values[order[0]],
+    // values[order[1]]... Used when the vertices or faces of a mesh are
+    // reordered, order can be shorter to drop some of them
+    void reorder(const std::vector<uint32_t>& order) {
+        for (auto& channel : m_channels)
+            std::visit(
+                [&](auto& values) {
+                    std::decay_t<decltype(values)> result(order.size());
+                    for (size_t i = 0; i < order.size(); ++i)
+                        result[i] = values[order[i]];
+                    values = std::move(result);
+                },
+                channel.second);
+    }
+
+    // Attributes in the order they were added
+    auto begin() { return m_channels.begin(); }
+    auto end() { return m_channels.end(); }
+    auto begin() const { return m_channels.begin(); }
+    auto end() const { return m_channels.end(); }
+
+   private:
+    // a handful of channels at most, linear search is fastest
+    std::vector<std::pair<std::string, AttributeData>> m_channels;
+
+    AttributeData* find(const std::string& name) {
+        for (auto& channel : m_channels)
+            if (channel.first == name) return &channel.second;
+        return nullptr;
+    }
+    const AttributeData* find(const std::string& name) const {
+        for (const auto& channel : m_channels)
+            if (channel.first == name) return &channel.second;
+        return nullptr;
+    }
+
+    template <typename T, typename Data>
+    static auto& get_impl(Data* data, const std::string& name) {
+        if (data == nullptr)
+            throw detail::CommonMeshException("Attribute not found: " + name);
+        auto* values = std::get_if<std::vector<T>>(data);
+        if (values == nullptr)
+            throw detail::CommonMeshException(
+                "Attribute " + name + " has a different type");
+        return *values;
+    }
+};
+
+// Which attributes are loaded with the mesh, by property name. Decoding
+// is skipped for all the others, e.g.
+//   load_mesh("scan.ply", AttributeMask{{"nx", "ny", "nz"}, {}})
+struct AttributeMask {
+    std::vector<std::string> vertex;
+    std::vector<std::string> face;
+    bool all = false;  // load every attribute in the file
+
+    static AttributeMask everything() {
+        AttributeMask mask;
+        mask.all = true;
+        return mask;
+    }
+
+    bool vertex_contains(const std::string& name) const {
+        return all || std::find(vertex.begin(), vertex.end(), name) !=
+                          vertex.end();
+    }
+    bool face_contains(const std::string& name) const {
+        return all || std::find(face.begin(), face.end(), name) != face.end();
+    }
+};
+
+};  // namespace common
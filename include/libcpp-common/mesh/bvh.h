@@ -0,0 +1,110 @@
+/*
+ * bvh.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Bounding volume hierarchy over the triangles of a mesh, for ray casting
+ * and closest point queries
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "libcpp-common/geometry.h"
+#include "libcpp-common/geometry/aabb.h"
+#include "libcpp-common/mesh/intersect.h"
+
+namespace common {
+
+struct Mesh;
+struct CompactMesh;
+
+struct ClosestPoint {
+    Vec3f point;
+    float distance2 = std::numeric_limits<float>::infinity();  // squared
+    uint32_t face = NO_FACE;
+
+    bool found() const { return face != NO_FACE; }
+};
+
+struct BVHOptions {
+    // Candidate splits evaluated per axis with the surface area heuristic
+    unsigned int bins = 16;
+    // Nodes with this many faces or less are not split
+    unsigned int max_leaf_faces = 4;
+    // Cost of visiting a node relative to intersecting one triangle
+    float traversal_cost = 1.0f;
+};
+
+// Binary BVH built with the binned surface area heuristic. Nodes are stored
+// in depth-first order (the left child of an inner node follows it), and the
+// triangles of the leaves are copied contiguously so that traversal does not
+// go through the index buffer
+//   BVH bvh(mesh);
+//   RayHit hit = bvh.intersect(Ray(origin, direction));
+//   if (hit.hit()) mesh.faces[hit.face] ...
+class BVH {
+   public:
+    // 32 bytes, two nodes per cache line
+    struct Node {
+        AABB3f box;
+        uint32_t index;  // first triangle (leaf) or right child (inner node)
+        uint32_t count;  // number of triangles, 0 for inner nodes
+
+        bool is_leaf() const { return count > 0; }
+    };
+
+    // Precomputed for the intersection tests
+    struct Triangle {
+        Vec3f v0, e1, e2;  // e1 = v1 - v0, e2 = v2 - v0
+    };
+
+    BVH() = default;
+    explicit BVH(const Mesh& mesh, const BVHOptions& options = {}) {
+        build(mesh, options);
+    }
+    explicit BVH(const CompactMesh& mesh, const BVHOptions& options = {}) {
+        build(mesh, options);
+    }
+
+    // Subtrees are built in parallel, throws CommonMeshException if a face
+    // references a vertex that does not exist
+    void build(const Mesh& mesh, const BVHOptions& options = {});
+    void build(const CompactMesh& mesh, const BVHOptions& options = {});
+
+    bool empty() const { return m_nodes.empty(); }
+    size_t num_nodes() const { return m_nodes.size(); }
+    size_t num_faces() const { return m_faces.size(); }
+    size_t depth() const;
+    const std::vector<Node>& nodes() const { return m_nodes; }
+
+    // Closest intersection with tmin <= t <= tmax
+    RayHit intersect(const Ray& ray) const;
+    // Whether there is any intersection with tmin <= t <= tmax, which stops
+    // at the first one found (e.g. for shadow rays)
+    bool occluded(const Ray& ray) const;
+    // Closest point of the surface at a distance of max_distance or less
+    ClosestPoint closest_point(
+        const Vec3f& p,
+        float max_distance = std::numeric_limits<float>::infinity()) const;
+
+    // Same queries for many rays/points, split between threads
+    void intersect(const Ray* rays, size_t n, RayHit* hits) const;
+    void occluded(const Ray* rays, size_t n, bool* occluded) const;
+    void closest_point(
+        const Vec3f* points, size_t n, ClosestPoint* closest,
+        float max_distance = std::numeric_limits<float>::infinity()) const;
+
+   private:
+    std::vector<Node> m_nodes;
+    std::vector<Triangle> m_triangles;  // in the order of the leaves
+    std::vector<uint32_t> m_faces;      // face of each triangle in the mesh
+
+    void build(std::vector<Triangle>&& triangles, const BVHOptions& options);
+};
+
+static_assert(sizeof(BVH::Node) == 32, "BVH nodes must take 32 bytes");
+
+};  // namespace common
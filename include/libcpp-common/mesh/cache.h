@@ -0,0 +1,153 @@
+/*
+ * cache.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Native mesh format, to open preprocessed meshes without parsing them
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/mapped_file.h"
+#include "libcpp-common/geometry.h"
+#include "libcpp-common/mesh/attributes.h"
+
+namespace common {
+
+struct Mesh;
+struct CompactMesh;
+
+// Mesh cache files (.cmesh) contain a fixed header, a table with the
+// attributes and then the raw arrays of a CompactMesh (Vec3f positions,
+// 16/32-bit indices, and the values of each attribute), each one aligned to
+// MESH_CACHE_ALIGNMENT bytes. Values are stored in little-endian order
+constexpr uint32_t MESH_CACHE_VERSION = 1;
+constexpr size_t MESH_CACHE_ALIGNMENT = 64;
+
+namespace detail {
+
+// Type of the values of an attribute in a mesh cache file. They are stored
+// in the files, so they must not change, and new ones must be added at the
+// end
+enum class MeshCacheType : uint32_t {
+    Int8 = 0,
+    UInt8 = 1,
+    Int16 = 2,
+    UInt16 = 3,
+    Int32 = 4,
+    UInt32 = 5,
+    Float32 = 6,
+    Float64 = 7,
+};
+
+// Mesh cache type of a C++ type, the inverse of mesh_cache_dispatch
+template <typename T>
+constexpr MeshCacheType mesh_cache_type_of() {
+    if constexpr (std::is_same_v<T, int8_t>) return MeshCacheType::Int8;
+    else if constexpr (std::is_same_v<T, uint8_t>) return MeshCacheType::UInt8;
+    else if constexpr (std::is_same_v<T, int16_t>) return MeshCacheType::Int16;
+    else if constexpr (std::is_same_v<T, uint16_t>)
+        return MeshCacheType::UInt16;
+    else if constexpr (std::is_same_v<T, int32_t>) return MeshCacheType::Int32;
+    else if constexpr (std::is_same_v<T, uint32_t>)
+        return MeshCacheType::UInt32;
+    else if constexpr (std::is_same_v<T, float>) return MeshCacheType::Float32;
+    else {
+        static_assert(std::is_same_v<T, double>,
+                      "Type without a mesh cache type");
+        return MeshCacheType::Float64;
+    }
+}
+
+// Location of the arrays of a mesh cache file in memory
+struct MeshCacheLayout {
+    struct Channel {
+        std::string name;
+        MeshCacheType type;
+        const void* data;
+    };
+
+    size_t num_vertices = 0;
+    size_t num_faces = 0;
+    const Vec3f* vertices = nullptr;
+    const void* faces = nullptr;  // Vec<uint16_t, 3> or Vec3u
+    std::vector<Channel> vertex_attributes;
+    std::vector<Channel> face_attributes;
+};
+
+// Checks the header and that all the arrays fit in the file, throws
+// CommonMeshException if not
+MeshCacheLayout read_mesh_cache(const uint8_t* data, size_t size);
+
+};  // namespace detail
+
+bool test_mesh_cache(const uint8_t* data, size_t size);
+// Copy the arrays of a mesh cache that is already in memory
+Mesh load_mesh_cache(const uint8_t* data, size_t size,
+                     const AttributeMask& mask = {});
+CompactMesh load_compact_mesh_cache(const uint8_t* data, size_t size,
+                                    const AttributeMask& mask = {});
+// Every attribute is saved
+void save_mesh_cache(const char* filename, const CompactMesh& mesh);
+void save_mesh_cache(const char* filename, const Mesh& mesh);
+
+// Read-only mesh cache that is used in place, memory-mapped, so opening it
+// takes the same time for any size
+//   MappedMesh mesh("bunny.cmesh");
+//   const Vec3f* v = mesh.vertices();
+class MappedMesh {
+   public:
+    MappedMesh() = default;
+    explicit MappedMesh(const char* filename) { open(filename); }
+
+    // Throws CommonMeshException if it is not a valid mesh cache
+    void open(const char* filename);
+    void close();
+    bool is_open() const { return m_file.is_open(); }
+
+    size_t num_vertices() const { return m_layout.num_vertices; }
+    size_t num_faces() const { return m_layout.num_faces; }
+    bool has_16bit_indices() const;
+
+    const Vec3f* vertices() const { return m_layout.vertices; }
+    // nullptr unless the mesh uses that type of indices
+    const Vec<uint16_t, 3>* faces16() const;
+    const Vec3u* faces32() const;
+    Vec3u face(size_t i) const;
+
+    // Values of an attribute, throws CommonMeshException if it does not
+    // exist or has another type
+    template <typename T>
+    const T* vertex_attribute(const std::string& name) const {
+        return static_cast<const T*>(
+            attribute(m_layout.vertex_attributes, name,
+                      detail::mesh_cache_type_of<T>()));
+    }
+    template <typename T>
+    const T* face_attribute(const std::string& name) const {
+        return static_cast<const T*>(
+            attribute(m_layout.face_attributes, name,
+                      detail::mesh_cache_type_of<T>()));
+    }
+    bool has_vertex_attribute(const std::string& name) const;
+    bool has_face_attribute(const std::string& name) const;
+
+    // Copies of the mesh
+    CompactMesh to_compact_mesh(const AttributeMask& mask = {}) const;
+    Mesh to_mesh(const AttributeMask& mask = {}) const;
+
+   private:
+    detail::MappedFile m_file;
+    detail::MeshCacheLayout m_layout;
+
+    static const void* attribute(
+        const std::vector<detail::MeshCacheLayout::Channel>& channels,
+        const std::string& name, detail::MeshCacheType type);
+};
+
+};  // namespace common
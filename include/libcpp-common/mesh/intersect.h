@@ -0,0 +1,119 @@
+/*
+ * intersect.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Ray-triangle intersection kernels, for one ray and one triangle, and SIMD
+ * versions for one ray and a packet of triangles or a packet of rays and
+ * one triangle
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "libcpp-common/detail/simd.h"
+#include "libcpp-common/geometry.h"
+
+namespace common {
+
+// Points origin + t * direction with tmin <= t <= tmax. The direction does
+// not need to be normalized (t is measured in units of its length)
+struct Ray {
+    Vec3f origin;
+    Vec3f direction;
+    float tmin = 0;
+    float tmax = std::numeric_limits<float>::infinity();
+
+    Ray() = default;
+    Ray(const Vec3f& origin, const Vec3f& direction, float tmin = 0,
+        float tmax = std::numeric_limits<float>::infinity())
+        : origin(origin), direction(direction), tmin(tmin), tmax(tmax) {}
+
+    Vec3f at(float t) const { return origin + direction * t; }
+};
+
+constexpr uint32_t NO_FACE = std::numeric_limits<uint32_t>::max();
+
+// First intersection of a ray, at origin + t * direction, which is also
+// (1 - u - v) * v0 + u * v1 + v * v2 for the vertices of the face
+struct RayHit {
+    float t = std::numeric_limits<float>::infinity();
+    float u = 0, v = 0;
+    uint32_t face = NO_FACE;
+
+    bool hit() const { return face != NO_FACE; }
+};
+
+// Möller-Trumbore test of a ray against the triangle (v0, v0 + e1, v0 + e2),
+// counting hits on the edges. t, u and v are only written if there is an
+// intersection with ray.tmin <= t <= tmax
+inline bool intersect_triangle(const Ray& ray, const Vec3f& v0,
+                               const Vec3f& e1, const Vec3f& e2, float tmax,
+                               float& t, float& u, float& v);
+
+// Widest packets that fit in the vector registers of the target. 8-wide
+// packets are emulated with two registers without AVX, and are slower than
+// 4-wide ones then
+constexpr size_t PACKET_WIDTH = COMMON_SIMD_BYTES >= 32 ? 8 : 4;
+
+// W triangles (W = 4 or 8) in SoA layout, one coordinate per row, so that
+// each row is loaded in one SIMD register. Lanes that are not set hold
+// degenerate triangles, which are never hit
+template <size_t W>
+struct alignas(W * sizeof(float)) TrianglePacket {
+    float v0[3][W];
+    float e1[3][W];  // v1 - v0
+    float e2[3][W];  // v2 - v0
+
+    TrianglePacket();
+    void set(size_t lane, const Vec3f& v0, const Vec3f& v1, const Vec3f& v2);
+};
+
+// W rays in SoA layout. Lanes that are not set never hit anything
+template <size_t W>
+struct alignas(W * sizeof(float)) RayPacket {
+    float origin[3][W];
+    float direction[3][W];
+    float tmin[W];
+    float tmax[W];
+
+    RayPacket();
+    void set(size_t lane, const Ray& ray);
+};
+
+// Closest hits of a RayPacket, t starts at infinity
+template <size_t W>
+struct alignas(W * sizeof(float)) HitPacket {
+    float t[W];
+    float u[W];
+    float v[W];
+    uint32_t face[W];
+
+    HitPacket();
+    RayHit get(size_t lane) const {
+        return {t[lane], u[lane], v[lane], face[lane]};
+    }
+};
+
+// Closest intersection of one ray with the triangles of a packet. The face
+// of the hit is the lane of the triangle
+template <size_t W>
+RayHit intersect(const Ray& ray, const TrianglePacket<W>& triangles);
+
+// Bit i is set if the ray intersects the triangle of lane i, for any-hit
+// queries
+template <size_t W>
+uint32_t intersect_mask(const Ray& ray, const TrianglePacket<W>& triangles);
+
+// Intersects W rays with one triangle, and updates the lanes of hits for
+// which it is closer than their current hit, setting their face. Returns the
+// mask of updated lanes. Meant for coherent rays (e.g. neighbouring pixels)
+// traversing the same triangles
+template <size_t W>
+uint32_t intersect(const RayPacket<W>& rays, const Vec3f& v0, const Vec3f& v1,
+                   const Vec3f& v2, uint32_t face, HitPacket<W>& hits);
+
+};  // namespace common
+
+#include "mesh/intersect.tpp"
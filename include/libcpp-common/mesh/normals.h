@@ -0,0 +1,46 @@
+/*
+ * normals.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Face normals, and vertex normals and tangents averaged from the faces
+ */
+#pragma once
+
+#include "libcpp-common/geometry.h"
+
+namespace common {
+
+struct Mesh;
+
+// How much each face around a vertex contributes to its normal
+enum class NormalWeighting {
+    Uniform,  // all of them the same
+    Area,     // by the area of the face
+    // By the angle of the corner of the face at the vertex (Thürmer and
+    // Wüthrich 1998), so that the result does not depend on how the
+    // surface is triangulated
+    Angle,
+};
+
+// Unit normal of each face, counter-clockwise from the order of its
+// vertices, or 0 for degenerate faces. Computed with SIMD packs, and split
+// between threads
+VecList3f compute_face_normals(const Mesh& mesh);
+
+// Unit normals of the vertices, stored in the float vertex attributes nx,
+// ny and nz (vertices without faces get 0). Channels that are already there
+// are overwritten in place if they have float values for every vertex.
+// Faces are gathered per vertex in parallel without atomics. Throws
+// CommonMeshException if a face references a vertex that does not exist
+void compute_vertex_normals(
+    Mesh& mesh, NormalWeighting weighting = NormalWeighting::Angle);
+
+// Unit tangents of the vertices along the direction of increasing u of the
+// texture coordinates (vertex attributes u and v), orthogonal to the normals
+// (nx, ny, nz, computed with compute_vertex_normals if missing). Stored in
+// tx, ty, tz, and in tw the handedness of the bitangent, which is
+// tw * cross(normal, tangent) with tw = 1 or -1. Throws CommonMeshException
+// if there are no texture coordinates
+void compute_vertex_tangents(Mesh& mesh);
+
+};  // namespace common
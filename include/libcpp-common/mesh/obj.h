@@ -0,0 +1,31 @@
+/*
+ * obj.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Wavefront OBJ loader
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libcpp-common/mesh/attributes.h"
+
+namespace common {
+
+struct Mesh;
+struct CompactMesh;
+
+// OBJ files have no signature: they are recognized by their first keyword
+bool test_obj(const uint8_t* data, size_t size);
+
+// Faces are triangulated, and each distinct v/vt/vn combination becomes a
+// vertex. Texture coordinates and normals are loaded as the "u", "v" and
+// "nx", "ny", "nz" vertex attributes when selected by mask. Without them,
+// vertices are the positions of the file, in order
+Mesh load_obj(const uint8_t* data, size_t size,
+              const AttributeMask& mask = {});
+CompactMesh load_compact_obj(const uint8_t* data, size_t size,
+                             const AttributeMask& mask = {});
+
+};  // namespace common
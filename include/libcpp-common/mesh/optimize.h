@@ -0,0 +1,67 @@
+/*
+ * optimize.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Reordering of the faces and vertices of a mesh for the vertex caches of
+ * the GPU and the memory caches of the CPU
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace common {
+
+struct Mesh;
+
+// Post-transform vertex cache simulated over the faces, in order
+struct VertexCacheStats {
+    size_t vertices_transformed = 0;  // cache misses
+    // Average cache miss ratio, vertices transformed per triangle. From 3
+    // (no reuse) down to ~0.5 for large regular meshes
+    double acmr = 0;
+    // Average transformed vertex ratio, vertices transformed per vertex
+    // used, 1 is optimal
+    double atvr = 0;
+};
+
+// Cache lines of vertex data read while iterating the faces, in order
+struct VertexFetchStats {
+    size_t bytes_fetched = 0;
+    // bytes_fetched over the size of the vertices used, 1 is optimal
+    double overfetch = 0;
+};
+
+enum class VertexCacheMethod {
+    // Sander et al. 2007, for a FIFO cache of a given size. Fastest
+    Tipsify,
+    // Forsyth 2006, scores the vertices of an LRU cache of up to 32
+    // entries. Slower, but somewhat better and less sensitive to the size
+    Forsyth,
+};
+
+// FIFO cache of cache_size vertices. Throws CommonMeshException if a face
+// references a vertex that does not exist, as all the passes of this file
+VertexCacheStats analyze_vertex_cache(const Mesh& mesh,
+                                      unsigned int cache_size = 16);
+// 64 byte lines in a direct-mapped cache of 16 KB, with the 16 bytes of each
+// vertex of Mesh::vertices
+VertexFetchStats analyze_vertex_fetch(const Mesh& mesh);
+
+// Reorders the faces (and their attributes) so that consecutive faces share
+// vertices. Runs in linear time on the number of faces
+void optimize_vertex_cache(
+    Mesh& mesh, VertexCacheMethod method = VertexCacheMethod::Tipsify,
+    unsigned int cache_size = 16);
+
+// Renumbers the vertices (and their attributes) in the order in which they
+// are first used by the faces, so that they are read mostly sequentially.
+// Unused vertices are moved to the end. Run after optimize_vertex_cache
+void optimize_vertex_fetch(Mesh& mesh);
+
+// Renumbers the vertices (and their attributes) along a Morton (Z-order)
+// curve of their positions, so that vertices close in space are close in
+// memory. Meant for point clouds and spatial queries, for rendering
+// optimize_vertex_fetch gives a better order
+void sort_vertices_morton(Mesh& mesh);
+
+};  // namespace common
@@ -2,16 +2,106 @@
  * ply.h
  * Diego Royo Meneses - Dec. 2023
  *
- * Polygon File Format loader
+ * Polygon File Format loader and saver
  */
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+
+#include "libcpp-common/geometry.h"
+#include "libcpp-common/mesh/attributes.h"
 
 namespace common {
 
 struct Mesh;
+struct CompactMesh;
 bool test_ply(std::ifstream& file);
-Mesh load_ply(std::ifstream& file);
+Mesh load_ply(std::ifstream& file, const AttributeMask& mask = {});
+bool test_ply(const uint8_t* data, size_t size);
+// Parse a PLY file that is already in memory (e.g. memory-mapped)
+Mesh load_ply(const uint8_t* data, size_t size,
+              const AttributeMask& mask = {});
+CompactMesh load_compact_ply(const uint8_t* data, size_t size,
+                             const AttributeMask& mask = {});
+// Binary little-endian PLY with float positions, uint indices and every
+// attribute (with its type) as an extra property
+void save_ply(std::ostream& file, const Mesh& mesh);
+void save_ply(std::ostream& file, const CompactMesh& mesh);
+
+/// STREAMING ///
+
+// Consecutive vertices of a PLY file, see PlyStreamReader
+struct PlyVertexBatch {
+    size_t first = 0;  // index of the first one in the file
+    VecList4f vertices;
+    MeshAttributes attributes;  // the ones selected by the mask
+};
+
+// Consecutive faces of a PLY file, split in triangles as fans around their
+// first corner (the vertices may not be in memory to do better), with their
+// attributes copied to each triangle
+struct PlyFaceBatch {
+    size_t first = 0;           // index of the first face in the file
+    size_t first_triangle = 0;  // among all the triangles of the file
+    VecList3u faces;
+    MeshAttributes attributes;
+};
+
+namespace detail {
+struct PlyStreamState;
+};
+
+constexpr size_t PLY_BATCH_SIZE = 1 << 16;
+
+// Reads a PLY file (ASCII or binary) from a stream in batches of up to
+// batch_size vertices or faces, in the order of the file, so that meshes
+// that do not fit in memory can be processed on the fly. Only the current
+// batch and the bytes of its records are kept in memory. Each batch is
+// decoded in parallel like load_ply. Throws CommonMeshException if the file
+// is malformed or ends early
+//   PlyStreamReader reader(file);
+//   while (reader.next())
+//       if (reader.has_vertices()) use(reader.vertex_batch()); ...
+class PlyStreamReader {
+   public:
+    // Reads the header, leaving the stream at the start of the body
+    explicit PlyStreamReader(std::istream& file, const AttributeMask& mask = {},
+                             size_t batch_size = PLY_BATCH_SIZE);
+    ~PlyStreamReader();
+
+    size_t num_vertices() const;
+    size_t num_faces() const;
+
+    // Reads the next batch, false at the end of the file. Other elements of
+    // the file are skipped
+    bool next();
+    bool has_vertices() const;
+    bool has_faces() const;
+    const PlyVertexBatch& vertex_batch() const;
+    const PlyFaceBatch& face_batch() const;
+
+   private:
+    std::unique_ptr<detail::PlyStreamState> m_state;
+};
+
+// Calls on_vertices(const PlyVertexBatch&) and on_faces(const
+// PlyFaceBatch&) with each batch of a PLY file, see PlyStreamReader
+template <typename VertexFunc, typename FaceFunc>
+void stream_ply(std::istream& file, const VertexFunc& on_vertices,
+                const FaceFunc& on_faces, const AttributeMask& mask = {},
+                size_t batch_size = PLY_BATCH_SIZE) {
+    PlyStreamReader reader(file, mask, batch_size);
+    while (reader.next()) {
+        if (reader.has_vertices())
+            on_vertices(reader.vertex_batch());
+        else
+            on_faces(reader.face_batch());
+    }
+}
 
 };  // namespace common
\ No newline at end of file
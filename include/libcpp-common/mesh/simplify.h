@@ -0,0 +1,43 @@
+/*
+ * simplify.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Reduction of the number of faces of a mesh, by edge collapses driven by
+ * quadric error metrics or by clustering its vertices in a grid
+ */
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+namespace common {
+
+struct Mesh;
+
+// Collapses edges (Garland and Heckbert 1997) until there are target_faces
+// faces or less, or until the next collapse would move the surface further
+// than max_error. The error of a vertex is the square root of the sum of its
+// squared distances to the planes of the original faces merged into it, and
+// boundaries are kept in place by planes orthogonal to them. Collapses that
+// would flip a face or make the mesh non-manifold are skipped. The vertices
+// left keep their attributes, and faces are kept in their order with their
+// attributes; vertices without faces are removed. Returns the error of the
+// costliest collapse done.
+// The cheapest collapse of each vertex is kept in an indexed binary heap,
+// over flat arrays of corners allocated once. Throws CommonMeshException if
+// a face references a vertex that does not exist
+float simplify_mesh(
+    Mesh& mesh, size_t target_faces,
+    float max_error = std::numeric_limits<float>::infinity());
+
+// Merges the vertices in each cell of a grid with cells of size cell_size
+// (Rossignac and Borrel 1993) into the point that minimizes the quadric
+// error of their faces (Lindstrom 2000), and removes the faces that become
+// degenerate or repeated. Each vertex left gets the attributes of the
+// lowest vertex of its cell. Lower quality than simplify_mesh, but in
+// parallel and O(n), for very large meshes or as a first pass before it.
+// Throws CommonMeshException if a face references a vertex that does not
+// exist or cell_size is not positive
+void simplify_mesh_clustering(Mesh& mesh, float cell_size);
+
+};  // namespace common
@@ -0,0 +1,29 @@
+/*
+ * triangulate.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Triangulation of polygonal faces
+ */
+#pragma once
+
+#include <cstddef>
+
+#include "libcpp-common/geometry.h"
+
+namespace common {
+
+// Number of triangles of a face with n corners (degenerate faces have none)
+constexpr size_t polygon_triangles(size_t n) { return n < 3 ? 0 : n - 2; }
+
+// True if all the corners of the (roughly planar) polygon turn the same way.
+// Collinear corners are allowed
+bool is_convex_polygon(const Vec3f* points, size_t n);
+
+// Splits the polygon in polygon_triangles(n) triangles with its same
+// winding, writing the corners of each one (indices in [0, n)) to
+// triangles. Convex polygons are split as a fan around the first corner,
+// and the rest by ear clipping
+void triangulate_polygon(const Vec3f* points, size_t n,
+                         unsigned int* triangles);
+
+};  // namespace common
@@ -0,0 +1,28 @@
+/*
+ * weld.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Merging of duplicated vertices, e.g. of STL-like meshes in which each face
+ * has its own three vertices
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace common {
+
+struct Mesh;
+
+// Merges the vertices at a distance of epsilon or less (only the ones with
+// the same x, y, z for epsilon = 0), keeping the one with the lowest index
+// and its attributes. Merges are chained, if b is close to a and c to b all
+// of them become one vertex even if c is far from a (whatever their order).
+// Faces are remapped in place and kept even if two of their corners are
+// merged. Returns the number of vertices removed.
+// Uses a spatial hash with cells of 4 * epsilon, built and queried in
+// parallel in O(n) expected time and ~40 bytes of memory per vertex. The
+// result does not depend on the number of threads. Throws
+// CommonMeshException if a face references a vertex that does not exist
+size_t weld_vertices(Mesh& mesh, float epsilon = 0);
+
+};  // namespace common
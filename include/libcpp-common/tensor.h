@@ -4,6 +4,7 @@
  *
  * NumPy-like tensor type
  */
+#pragma once
 
 #include <array>
 #include <cstring>
@@ -15,6 +16,11 @@
 #include "libcpp-common/bitmap.h"
 #include "libcpp-common/detail/exception.h"
 #include "libcpp-common/geometry.h"
+#include "libcpp-common/tensor/einsum.h"
+#include "libcpp-common/tensor/gemm.h"
+#include "libcpp-common/tensor/npy.h"
+#include "libcpp-common/tensor/reduce.h"
+#include "libcpp-common/tensor/view.h"
 
 namespace common {
 
@@ -179,6 +185,16 @@ class Tensor {
     T& at(size_t i) { return m_data[i]; }
     const T& at(size_t i) const { return m_data[i]; }
 
+    T* data() { return m_data; }
+    const T* data() const { return m_data; }
+
+    // Zero-copy view of the tensor, see tensor/view.h for slicing, lazy
+    // transposes and broadcasting
+    TensorView<T, ndim> view() { return TensorView<T, ndim>(m_data, shape); }
+    TensorView<const T, ndim> view() const {
+        return TensorView<const T, ndim>(m_data, shape);
+    }
+
     /* Pretty print */
    public:
     friend std::ostream& operator<<(std::ostream& s,
@@ -268,25 +284,40 @@ class Tensor {
     }
 
     // Matrix-matrix multiplication
+    // Tiny matrices (e.g. 4x4) are fully unrolled, the rest go through the
+    // blocked GEMM engine in tensor/gemm.h
     template <size_t U,  //
               size_t N = get_dim<0>(), size_t M = get_dim<1>()>
-    constexpr inline std::enable_if_t<ndim == 2, Tensor<T, N, U>> operator*(
+    inline std::enable_if_t<ndim == 2, Tensor<T, N, U>> operator*(
         const Tensor<T, M, U>& mat) const {
         auto result = Tensor<T, N, U>::zeros();
-        for (size_t i = 0; i < N; ++i)
-            for (size_t j = 0; j < U; ++j)
+        if constexpr (N * M * U <= 512) {
+            common::gemm_small<N, M, U>(data(), mat.data(), result.data());
+        } else if constexpr (detail::simd_supported<T>) {
+            common::gemm<T>(N, U, M, data(), M, 1, mat.data(), U, 1,
+                            result.data(), U, 1);
+        } else {
+            // i-k-j order so that the inner loop is unit-stride
+            for (size_t i = 0; i < N; ++i)
                 for (size_t k = 0; k < M; ++k)
-                    result(i, j) += (*this)(i, k) * mat(k, j);
+                    for (size_t j = 0; j < U; ++j)
+                        result.at(i * U + j) +=
+                            at(i * M + k) * mat.at(k * U + j);
+        }
         return result;
     }
 
     // Matrix-vector multiplication
     template <size_t N = get_dim<0>(), size_t M = get_dim<1>()>
-    constexpr inline std::enable_if_t<ndim == 2, Tensor<T, N>> operator*(
+    inline std::enable_if_t<ndim == 2, Tensor<T, N>> operator*(
         const Tensor<T, M>& vec) const {
         auto result = Tensor<T, N>::zeros();
-        for (size_t i = 0; i < N; ++i)
-            for (size_t j = 0; j < M; ++j) result(i) += (*this)(i, j) * vec(j);
+        for (size_t i = 0; i < N; ++i) {
+            const T* row = data() + i * M;
+            T sum = 0;
+            for (size_t j = 0; j < M; ++j) sum += row[j] * vec.at(j);
+            result.at(i) = sum;
+        }
         return result;
     }
 
@@ -300,9 +331,80 @@ class Tensor {
         return result;
     }
 
-    constexpr inline T sum() const {
-        T result = 0;
-        for (size_t i = 0; i < size; ++i) result += (*this).at(i);
+    // Reductions over all the elements (e.g. t.sum()) or over some axes
+    // (e.g. t.sum(axes<1>) or t.max(axes<0, 2>, keepdims)). Reducing all the
+    // axes without keepdims returns a T. See tensor/reduce.h for the
+    // accumulation options of floating point sums
+   private:
+    template <typename Op, bool KeepDims, size_t... A>
+    inline auto reduce(AxesTag<A...>, Accumulation accumulation) const {
+        using Plan = detail::ReducePlan<AxesTag<A...>, Shape...>;
+        detail::reduced_t<T, Plan, KeepDims> result;
+        T* out;
+        if constexpr (std::is_same_v<decltype(result), T>)
+            out = &result;
+        else
+            out = result.data();
+        detail::run_reduce_plan<Op, Plan>(m_data, out, accumulation);
+        return result;
+    }
+
+   public:
+#define COMMON_tensor_reduction(name, Op)                                     \
+    inline T name(Accumulation accumulation = Accumulation::Pairwise) const { \
+        T result;                                                             \
+        detail::reduce_axis<Op, 1, size, 1>(m_data, &result, accumulation);   \
+        return result;                                                        \
+    }                                                                         \
+    template <size_t... A>                                                    \
+    inline auto name(AxesTag<A...> a, Accumulation accumulation =             \
+                                          Accumulation::Pairwise) const {     \
+        return reduce<Op, false>(a, accumulation);                            \
+    }                                                                         \
+    template <size_t... A>                                                    \
+    inline auto name(AxesTag<A...> a, KeepDimsTag,                            \
+                     Accumulation accumulation = Accumulation::Pairwise)      \
+        const {                                                               \
+        return reduce<Op, true>(a, accumulation);                             \
+    }
+
+    COMMON_tensor_reduction(sum, detail::SumOp);
+    COMMON_tensor_reduction(prod, detail::ProdOp);
+    COMMON_tensor_reduction(min, detail::MinOp);
+    COMMON_tensor_reduction(max, detail::MaxOp);
+#undef COMMON_tensor_reduction
+
+    // Note that for integer types the mean is rounded as the division of T
+    inline T mean(Accumulation accumulation = Accumulation::Pairwise) const {
+        return sum(accumulation) / static_cast<T>(size);
+    }
+    template <size_t... A, typename... KeepDims>
+    inline auto mean(AxesTag<A...> a, KeepDims... keep) const {
+        constexpr size_t count =
+            detail::ReducePlan<AxesTag<A...>, Shape...>::count;
+        auto result = sum(a, keep...);
+        result /= static_cast<T>(count);
+        return result;
+    }
+
+    // Flat index of the (first) maximum element
+    inline size_t argmax() const {
+        size_t result;
+        detail::argmax_axis<1, size, 1>(m_data, &result);
+        return result;
+    }
+    // Index of the maximum along a single axis, as a tensor of size_t
+    template <size_t A, typename... KeepDims>
+    inline auto argmax(AxesTag<A>, KeepDims...) const {
+        static_assert(A < ndim, "argmax axis out of range");
+        using Plan = detail::ReducePlan<AxesTag<A>, Shape...>;
+        constexpr bool keep = (std::is_same_v<KeepDims, KeepDimsTag> || ...);
+        detail::reduced_t<size_t, Plan, keep> result;
+        constexpr detail::ReduceStep s = Plan::steps[0];
+        if constexpr (std::is_same_v<decltype(result), size_t>)
+            detail::argmax_axis<s.outer, s.r, s.inner>(m_data, &result);
+        else
+            detail::argmax_axis<s.outer, s.r, s.inner>(m_data, result.data());
         return result;
     }
 
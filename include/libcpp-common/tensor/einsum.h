@@ -0,0 +1,34 @@
+/*
+ * einsum.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Einstein summation over tensors with static shapes, resolved at compile time
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace common {
+
+// Labels of the axes of an einsum operand, e.g. Idx<'i', 'j'> for a matrix
+template <char... Labels>
+struct Idx {
+    static constexpr size_t size = sizeof...(Labels);
+    static constexpr std::array<char, sizeof...(Labels)> labels = {Labels...};
+};
+
+// Einstein summation, with one Idx per operand followed by the Idx of the
+// result. e.g. NumPy's np.einsum("ij,jk->ik", a, b) is written as
+//   common::einsum<Idx<'i', 'j'>, Idx<'j', 'k'>, Idx<'i', 'k'>>(a, b)
+// Labels that are not in the result are summed over, and repeated labels in
+// an operand take its diagonal (e.g. Idx<'i', 'i'>, Idx<> is the trace).
+// Shapes are checked at compile time, the loops are ordered so that the
+// innermost one is unit-stride, and matrix products are computed with gemm.
+// Returns a Tensor, or a scalar if the result has no labels
+template <typename... Specs, typename... Tensors>
+auto einsum(const Tensors&... tensors);
+
+};  // namespace common
+
+#include "tensor/einsum.tpp"
@@ -0,0 +1,31 @@
+/*
+ * gemm.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Cache-blocked, multithreaded general matrix-matrix multiplication
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace common {
+
+// C = A * B (or C += A * B if accumulate is true), where A is m x k, B is
+// k x n and C is m x n. Matrices are given by a pointer to their first element
+// plus their row (rs) and column (cs) strides in elements, so transposed or
+// strided operands do not need to be copied (e.g. rs = 1, cs = m for a
+// column-major matrix). T must be an arithmetic type
+template <typename T>
+void gemm(size_t m, size_t n, size_t k,             //
+          const T* a, ptrdiff_t rs_a, ptrdiff_t cs_a,  //
+          const T* b, ptrdiff_t rs_b, ptrdiff_t cs_b,  //
+          T* c, ptrdiff_t rs_c, ptrdiff_t cs_c, bool accumulate = false);
+
+// Same as gemm but for row-major matrices with compile-time sizes, fully
+// unrolled. Intended for tiny matrices (e.g. 4x4) where packing is overkill
+template <size_t M, size_t K, size_t N, typename T>
+void gemm_small(const T* a, const T* b, T* c);
+
+};  // namespace common
+
+#include "tensor/gemm.tpp"
@@ -0,0 +1,99 @@
+/*
+ * npy.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Tensor saver/loader with a format compatible with numpy's np.save/np.load
+ */
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <string>
+
+#include "libcpp-common/detail/npy.h"
+
+namespace common {
+
+template <typename T, size_t... Shape>
+class Tensor;
+template <typename T, size_t N>
+class TensorView;
+template <typename T, size_t N>
+class DynamicTensor;
+
+// Write the elements of the view (in row-major order) as a .npy file, in a
+// single write if the view is contiguous
+template <typename T, size_t N>
+void save_npy(std::ostream& file, const TensorView<T, N>& view);
+template <typename T, size_t N>
+void save_npy(const std::string& filename, const TensorView<T, N>& view);
+
+template <typename T, size_t... Shape>
+void save_npy(std::ostream& file, const Tensor<T, Shape...>& tensor);
+template <typename T, size_t... Shape>
+void save_npy(const std::string& filename, const Tensor<T, Shape...>& tensor);
+
+template <typename T, size_t N>
+void save_npy(std::ostream& file, const DynamicTensor<T, N>& tensor);
+template <typename T, size_t N>
+void save_npy(const std::string& filename, const DynamicTensor<T, N>& tensor);
+
+// Read a .npy file into a tensor of the same shape and type. Throws
+// CommonTensorException if the file stores a different shape or type (types
+// are not converted, and Fortran order is not supported)
+template <typename T, size_t... Shape>
+void load_npy(std::istream& file, Tensor<T, Shape...>& tensor);
+template <typename T, size_t... Shape>
+void load_npy(const std::string& filename, Tensor<T, Shape...>& tensor);
+
+// Read a .npy file of rank N with any shape, e.g. load_npy<float, 3>(file)
+template <typename T, size_t N>
+DynamicTensor<T, N> load_npy(std::istream& file);
+template <typename T, size_t N>
+DynamicTensor<T, N> load_npy(const std::string& filename);
+
+// Writes a .npy file incrementally along its first axis, so that arrays that
+// do not fit in memory can be saved by blocks of rows. The shape of the file
+// is updated when the writer is closed (or destroyed), e.g.
+//   NpyWriter<float, 3> writer("out.npy", {480, 640});  // [?, 480, 640]
+//   for (...) writer.append(frame);  // [480, 640] or [k, 480, 640] blocks
+template <typename T, size_t N>
+class NpyWriter {
+    static_assert(N >= 1, "NpyWriter needs at least one axis");
+
+   public:
+    NpyWriter(const std::string& filename,
+              const std::array<size_t, N - 1>& row_shape = {});
+    ~NpyWriter();
+
+    NpyWriter(const NpyWriter&) = delete;
+    NpyWriter& operator=(const NpyWriter&) = delete;
+
+    // Append rows (contiguous, row_size() elements each)
+    void append(const T* data, size_t rows);
+    // Append a single row (M = N - 1) or a block of rows (M = N)
+    template <typename U, size_t M>
+    void append(const TensorView<U, M>& view);
+    template <size_t... Shape>
+    void append(const Tensor<T, Shape...>& tensor);
+
+    // Write the final shape to the header and close the file
+    void close();
+
+    size_t rows() const { return m_rows; }
+    size_t row_size() const { return m_row_size; }
+    const std::array<size_t, N - 1>& row_shape() const { return m_row_shape; }
+
+   private:
+    std::ofstream m_file;
+    std::array<size_t, N - 1> m_row_shape;
+    size_t m_row_size;
+    size_t m_rows;
+    size_t m_header_length;
+
+    detail::NpyHeader header() const;
+};
+
+};  // namespace common
+
+#include "tensor/npy.tpp"
@@ -0,0 +1,56 @@
+/*
+ * reduce.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Parallel reductions (sum, mean, min, max, prod, argmax) over tensor axes
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace common {
+
+// Selects the axes that are reduced, e.g. t.sum(common::axes<0, 2>)
+template <size_t... Axes>
+struct AxesTag {};
+template <size_t... Axes>
+static constexpr AxesTag<Axes...> axes{};
+
+// Keep the reduced axes with length one, e.g. t.sum(axes<1>, keepdims)
+struct KeepDimsTag {};
+static constexpr KeepDimsTag keepdims{};
+
+// How floating point sums are accumulated:
+// * Naive: in order, using several SIMD accumulators (fastest)
+// * Pairwise: in blocks that are added as a binary tree, as NumPy does
+//   (error grows with log(n) instead of n, almost as fast as Naive)
+// * Kahan: compensated summation (error independent of n, slowest)
+enum class Accumulation : char { Naive, Pairwise, Kahan };
+
+namespace detail {
+
+struct SumOp;
+struct ProdOp;
+struct MinOp;
+struct MaxOp;
+
+// Reduce the contiguous array p[0:n] with Op
+template <typename Op, typename T>
+T reduce_contiguous(const T* p, size_t n,
+                    Accumulation accumulation = Accumulation::Pairwise);
+
+// Reduce a row-major [Outer, R, Inner] array over its R axis, writing the
+// [Outer, Inner] result to out. Sizes are compile-time constants so that the
+// loops can be specialized (e.g. Inner == 1 is a contiguous reduction)
+template <typename Op, size_t Outer, size_t R, size_t Inner, typename T>
+void reduce_axis(const T* in, T* out, Accumulation accumulation);
+
+// Same as reduce_axis, but writes the index (in [0, R)) of the maximum
+template <size_t Outer, size_t R, size_t Inner, typename T>
+void argmax_axis(const T* in, size_t* out);
+
+};  // namespace detail
+
+};  // namespace common
+
+#include "tensor/reduce.tpp"
@@ -0,0 +1,519 @@
+/*
+ * view.h
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Zero-copy strided views over tensor data, with NumPy-like slicing and
+ * broadcasting, plus a dynamically shaped tensor to hold their results
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "libcpp-common/bitmap.h"
+#include "libcpp-common/detail/exception.h"
+
+namespace common {
+
+/// SLICE ///
+
+// Python-like start:stop:step slice, e.g. Slice(1, -1) is 1:-1 and
+// Slice(Slice::none, Slice::none, -1) is ::-1
+struct Slice {
+    static constexpr ptrdiff_t none = PTRDIFF_MIN;
+    ptrdiff_t start, stop, step;
+
+    constexpr Slice(ptrdiff_t start = none, ptrdiff_t stop = none,
+                    ptrdiff_t step = 1)
+        : start(start), stop(stop), step(step) {}
+
+    // First index and number of elements selected in an axis of length n
+    // (same rules as Python's slice.indices)
+    std::pair<ptrdiff_t, size_t> resolve(size_t n) const {
+        if (step == 0)
+            throw detail::CommonTensorException("Slice step cannot be zero");
+        const ptrdiff_t len = static_cast<ptrdiff_t>(n);
+        auto adjust = [len, this](ptrdiff_t i, ptrdiff_t default_value) {
+            if (i == none) return default_value;
+            if (i < 0) i += len;
+            const ptrdiff_t lower = step < 0 ? -1 : 0;
+            const ptrdiff_t upper = step < 0 ? len - 1 : len;
+            return std::clamp(i, lower, upper);
+        };
+        const ptrdiff_t first = adjust(start, step < 0 ? len - 1 : 0);
+        const ptrdiff_t last = adjust(stop, step < 0 ? -1 : len);
+        ptrdiff_t count = 0;
+        if (step > 0 && last > first)
+            count = (last - first + step - 1) / step;
+        else if (step < 0 && first > last)
+            count = (first - last - step - 1) / (-step);
+        return {first, static_cast<size_t>(count)};
+    }
+};
+
+// Selects a whole axis, like ":" in NumPy
+static constexpr Slice all{};
+
+template <typename T, size_t N>
+class DynamicTensor;
+
+namespace detail {
+
+// Calls f(*ptrs...) for every index of shape, advancing each pointer by its
+// own strides (in elements)
+template <size_t Axis, size_t N, size_t K, typename Func, size_t... I,
+          typename... Ptrs>
+inline void strided_loop(const std::array<size_t, N>& shape,
+                         const std::array<std::array<ptrdiff_t, N>, K>& strides,
+                         const Func& f, std::index_sequence<I...> seq,
+                         Ptrs... ptrs) {
+    if constexpr (N == 0) {
+        f(*ptrs...);
+    } else if constexpr (Axis + 1 == N) {
+        const std::array<ptrdiff_t, K> inner = {strides[I][Axis]...};
+        for (size_t i = 0; i < shape[Axis]; ++i)
+            f(ptrs[static_cast<ptrdiff_t>(i) * inner[I]]...);
+    } else {
+        for (size_t i = 0; i < shape[Axis]; ++i)
+            strided_loop<Axis + 1>(
+                shape, strides, f, seq,
+                (ptrs + static_cast<ptrdiff_t>(i) * strides[I][Axis])...);
+    }
+}
+
+inline std::string shape_to_string(const size_t* shape, size_t n) {
+    std::string result = "(";
+    for (size_t i = 0; i < n; ++i)
+        result += std::to_string(shape[i]) + (i + 1 < n ? ", " : "");
+    return result + ")";
+}
+
+};  // namespace detail
+
+/// TENSOR VIEW ///
+
+// Non-owning view of N-dimensional data with arbitrary strides and offset.
+// Like std::span, copying a view is cheap and does not copy its elements, and
+// a const view can still modify them (use TensorView<const T, N> otherwise)
+template <typename T, size_t N>
+class TensorView {
+   public:
+    using type = std::remove_const_t<T>;
+    static constexpr size_t ndim = N;
+
+   private:
+    T* m_data;
+    std::array<size_t, N> m_shape;
+    std::array<ptrdiff_t, N> m_strides;
+
+   public:
+    TensorView(T* data, const std::array<size_t, N>& shape,
+               const std::array<ptrdiff_t, N>& strides)
+        : m_data(data), m_shape(shape), m_strides(strides) {}
+
+    // Contiguous (row-major) data
+    TensorView(T* data, const std::array<size_t, N>& shape)
+        : m_data(data), m_shape(shape) {
+        ptrdiff_t stride = 1;
+        for (size_t i = N; i-- > 0;) {
+            m_strides[i] = stride;
+            stride *= static_cast<ptrdiff_t>(shape[i]);
+        }
+    }
+
+    // Views of T are also views of const T
+    template <typename U, typename = std::enable_if_t<
+                              std::is_same_v<const U, T> &&
+                              !std::is_same_v<U, T>>>
+    TensorView(const TensorView<U, N>& other)
+        : TensorView(other.data(), other.shape(), other.strides()) {}
+
+    T* data() const { return m_data; }
+    const std::array<size_t, N>& shape() const { return m_shape; }
+    const std::array<ptrdiff_t, N>& strides() const { return m_strides; }
+    size_t shape(size_t axis) const { return m_shape[axis]; }
+    ptrdiff_t stride(size_t axis) const { return m_strides[axis]; }
+    size_t size() const {
+        size_t result = 1;
+        for (size_t n : m_shape) result *= n;
+        return result;
+    }
+
+    bool is_contiguous() const {
+        ptrdiff_t stride = 1;
+        for (size_t i = N; i-- > 0;) {
+            if (m_shape[i] != 1 && m_strides[i] != stride) return false;
+            stride *= static_cast<ptrdiff_t>(m_shape[i]);
+        }
+        return true;
+    }
+
+    /* Access operators */
+   public:
+    template <typename... Indices,
+              typename = std::enable_if_t<
+                  (sizeof...(Indices) == N) &&
+                  (std::is_convertible_v<Indices, ptrdiff_t> && ...)>>
+    T& operator()(Indices... indices) const {
+        const std::array<ptrdiff_t, N> idx = {
+            static_cast<ptrdiff_t>(indices)...};
+        ptrdiff_t offset = 0;
+        for (size_t i = 0; i < N; ++i) offset += idx[i] * m_strides[i];
+        return m_data[offset];
+    }
+
+    // NumPy-like indexing of the first axis, e.g. view[2] is view[2, ...]
+    template <size_t M = N, typename = std::enable_if_t<M >= 1>>
+    TensorView<T, N - 1> operator[](ptrdiff_t i) const {
+        return slice(i);
+    }
+
+    /* Slicing */
+   public:
+    // Each argument indexes one axis, starting from the first one. Integers
+    // select a single element (and remove the axis from the result, negative
+    // values count from the end) and Slice objects select a range. Missing
+    // trailing axes are kept whole. e.g. for a 3D view v, v[1:, 2] in NumPy is
+    // v.slice(Slice(1), 2) and v[::-1, :, 0] is v.slice(Slice(none, none, -1),
+    // all, 0)
+    template <typename... Args>
+    auto slice(const Args&... args) const {
+        static_assert(sizeof...(Args) <= N, "Too many indices for slice");
+        static_assert(((std::is_integral_v<Args> ||
+                        std::is_same_v<Args, Slice>)&&...),
+                      "Slice arguments must be integers or Slice objects");
+        constexpr size_t M =
+            N - (size_t(0) + ... + (std::is_integral_v<Args> ? 1 : 0));
+
+        T* data = m_data;
+        std::array<size_t, M> shape;
+        std::array<ptrdiff_t, M> strides;
+        size_t in_axis = 0, out_axis = 0;
+        auto apply = [&](const auto& arg) {
+            using Arg = std::decay_t<decltype(arg)>;
+            const size_t len = m_shape[in_axis];
+            if constexpr (std::is_integral_v<Arg>) {
+                ptrdiff_t i = static_cast<ptrdiff_t>(arg);
+                if (i < 0) i += static_cast<ptrdiff_t>(len);
+                if (i < 0 || i >= static_cast<ptrdiff_t>(len))
+                    throw detail::CommonTensorException(
+                        "Index " + std::to_string(arg) +
+                        " is out of bounds for axis " +
+                        std::to_string(in_axis) + " with size " +
+                        std::to_string(len));
+                data += i * m_strides[in_axis];
+            } else {
+                const auto [first, count] = arg.resolve(len);
+                data += first * m_strides[in_axis];
+                shape[out_axis] = count;
+                strides[out_axis] = arg.step * m_strides[in_axis];
+                ++out_axis;
+            }
+            ++in_axis;
+        };
+        (apply(args), ...);
+        for (; in_axis < N; ++in_axis, ++out_axis) {
+            shape[out_axis] = m_shape[in_axis];
+            strides[out_axis] = m_strides[in_axis];
+        }
+        return TensorView<T, M>(data, shape, strides);
+    }
+
+    /* Lazy axis manipulation */
+   public:
+    // Reverse the order of the axes (for matrices, the usual transpose)
+    TensorView<T, N> transpose() const {
+        std::array<size_t, N> axes;
+        for (size_t i = 0; i < N; ++i) axes[i] = N - 1 - i;
+        return permute(axes);
+    }
+
+    // Axis i of the result is axis axes[i] of this view
+    TensorView<T, N> permute(const std::array<size_t, N>& axes) const {
+        std::array<size_t, N> shape;
+        std::array<ptrdiff_t, N> strides;
+        std::array<bool, N> used = {};
+        for (size_t i = 0; i < N; ++i) {
+            if (axes[i] >= N || used[axes[i]])
+                throw detail::CommonTensorException(
+                    "Invalid permutation of axes " +
+                    detail::shape_to_string(axes.data(), N));
+            used[axes[i]] = true;
+            shape[i] = m_shape[axes[i]];
+            strides[i] = m_strides[axes[i]];
+        }
+        return TensorView<T, N>(m_data, shape, strides);
+    }
+
+    TensorView<T, N> swap_axes(size_t a, size_t b) const {
+        std::array<size_t, N> axes;
+        for (size_t i = 0; i < N; ++i) axes[i] = i;
+        std::swap(axes.at(a), axes.at(b));
+        return permute(axes);
+    }
+
+    // Repeat the data to the given shape without copying it, following
+    // NumPy's broadcasting rules (missing leading axes and axes of length 1
+    // get a zero stride)
+    template <size_t M>
+    TensorView<T, M> broadcast_to(const std::array<size_t, M>& shape) const {
+        static_assert(M >= N, "Cannot broadcast to a lower dimension");
+        std::array<ptrdiff_t, M> strides = {};
+        for (size_t i = 0; i < N; ++i) {
+            const size_t j = M - N + i;
+            if (m_shape[i] == shape[j])
+                strides[j] = m_strides[i];
+            else if (m_shape[i] != 1)
+                throw detail::CommonTensorException(
+                    "Cannot broadcast shape " +
+                    detail::shape_to_string(m_shape.data(), N) + " to " +
+                    detail::shape_to_string(shape.data(), M));
+        }
+        return TensorView<T, M>(m_data, shape, strides);
+    }
+
+    /* Element-wise operations */
+   public:
+    // Call f(element) for every element, in row-major order
+    template <typename Func>
+    void for_each(const Func& f) const {
+        detail::strided_loop<0>(
+            m_shape, std::array<std::array<ptrdiff_t, N>, 1>{m_strides}, f,
+            std::index_sequence<0>{}, m_data);
+    }
+
+    // Copy (broadcasting if needed) the elements of other into this view
+    template <typename U, size_t M>
+    const TensorView<T, N>& assign(const TensorView<U, M>& other) const {
+        const auto src = other.broadcast_to(m_shape);
+        detail::strided_loop<0>(
+            m_shape,
+            std::array<std::array<ptrdiff_t, N>, 2>{m_strides, src.strides()},
+            [](T& a, const U& b) { a = b; }, std::index_sequence<0, 1>{},
+            m_data, src.data());
+        return *this;
+    }
+
+    const TensorView<T, N>& fill(const type& value) const {
+        for_each([&value](T& x) { x = value; });
+        return *this;
+    }
+
+#define COMMON_view_op_impl(op)                                             \
+    template <typename U, size_t M>                                         \
+    const TensorView<T, N>& operator op##=(const TensorView<U, M>& other)   \
+        const {                                                             \
+        const auto src = other.broadcast_to(m_shape);                       \
+        detail::strided_loop<0>(                                            \
+            m_shape,                                                        \
+            std::array<std::array<ptrdiff_t, N>, 2>{m_strides,              \
+                                                    src.strides()},         \
+            [](T& a, const U& b) { a op## = b; },                           \
+            std::index_sequence<0, 1>{}, m_data, src.data());               \
+        return *this;                                                       \
+    }                                                                       \
+    const TensorView<T, N>& operator op##=(const type& scalar) const {      \
+        for_each([&scalar](T& a) { a op## = scalar; });                     \
+        return *this;                                                       \
+    }
+    COMMON_view_op_impl(+);
+    COMMON_view_op_impl(-);
+    COMMON_view_op_impl(*);
+    COMMON_view_op_impl(/);
+#undef COMMON_view_op_impl
+
+    // Copy of the viewed elements, in a new contiguous tensor
+    DynamicTensor<type, N> copy() const {
+        DynamicTensor<type, N> result(m_shape);
+        result.view().assign(*this);
+        return result;
+    }
+
+    friend std::ostream& operator<<(std::ostream& s, const TensorView& v) {
+        return s << v.copy();
+    }
+};
+
+/// DYNAMIC TENSOR ///
+
+// Contiguous N-dimensional tensor whose shape is only known at runtime,
+// e.g. the result of operating with views
+template <typename T, size_t N>
+class DynamicTensor {
+   public:
+    using type = T;
+    static constexpr size_t ndim = N;
+
+   private:
+    std::vector<T> m_data;
+    std::array<size_t, N> m_shape;
+
+   public:
+    DynamicTensor() : m_data(), m_shape() {}
+    DynamicTensor(const std::array<size_t, N>& shape, const T& value = 0)
+        : m_shape(shape) {
+        size_t size = 1;
+        for (size_t n : shape) size *= n;
+        m_data.resize(size, value);
+    }
+
+    const std::array<size_t, N>& shape() const { return m_shape; }
+    size_t shape(size_t axis) const { return m_shape[axis]; }
+    size_t size() const { return m_data.size(); }
+    T* data() { return m_data.data(); }
+    const T* data() const { return m_data.data(); }
+    T& at(size_t i) { return m_data[i]; }
+    const T& at(size_t i) const { return m_data[i]; }
+
+    TensorView<T, N> view() { return TensorView<T, N>(data(), m_shape); }
+    TensorView<const T, N> view() const {
+        return TensorView<const T, N>(data(), m_shape);
+    }
+
+    template <typename... Indices>
+    T& operator()(Indices... indices) {
+        return view()(indices...);
+    }
+    template <typename... Indices>
+    const T& operator()(Indices... indices) const {
+        return view()(indices...);
+    }
+
+    friend std::ostream& operator<<(std::ostream& s, const DynamicTensor& t) {
+        std::array<size_t, N> strides;
+        size_t stride = 1;
+        for (size_t i = N; i-- > 0;) {
+            strides[i] = stride;
+            stride *= t.m_shape[i];
+        }
+        for (size_t i = 0; i < N; ++i) s << "[ ";
+        for (size_t i = 0; i < t.size(); ++i) {
+            s << t.at(i) << " ";
+            if (i == t.size() - 1) continue;
+            for (size_t j = 0; j + 1 < N; ++j)
+                if ((i + 1) % strides[j] == 0) s << "] [ ";
+        }
+        for (size_t i = 0; i + 1 < N; ++i) s << "] ";
+        if (N > 0) s << "]";
+        return s;
+    }
+};
+
+/// BROADCASTING ///
+
+// Shape that results from broadcasting a and b together, following NumPy's
+// rules (shapes are aligned to the right, and each pair of lengths must be
+// equal or one of them must be 1)
+template <size_t N, size_t M>
+std::array<size_t, std::max(N, M)> broadcast_shape(
+    const std::array<size_t, N>& a, const std::array<size_t, M>& b) {
+    constexpr size_t R = std::max(N, M);
+    std::array<size_t, R> result;
+    for (size_t i = 0; i < R; ++i) {
+        const size_t da = i < R - N ? 1 : a[i - (R - N)];
+        const size_t db = i < R - M ? 1 : b[i - (R - M)];
+        if (da != db && da != 1 && db != 1)
+            throw detail::CommonTensorException(
+                "Shapes " + detail::shape_to_string(a.data(), N) + " and " +
+                detail::shape_to_string(b.data(), M) +
+                " cannot be broadcast together");
+        result[i] = da == 1 ? db : da;
+    }
+    return result;
+}
+
+// out(idx) = f(a(idx), b(idx)) for every index of out, broadcasting a and b
+// to the shape of out
+template <typename R, size_t N, typename A, size_t NA, typename B, size_t NB,
+          typename Func>
+void broadcast_apply(const TensorView<R, N>& out, const TensorView<A, NA>& a,
+                     const TensorView<B, NB>& b, const Func& f) {
+    const auto va = a.broadcast_to(out.shape());
+    const auto vb = b.broadcast_to(out.shape());
+    detail::strided_loop<0>(
+        out.shape(),
+        std::array<std::array<ptrdiff_t, N>, 3>{out.strides(), va.strides(),
+                                                vb.strides()},
+        [&f](R& r, const A& x, const B& y) { r = f(x, y); },
+        std::index_sequence<0, 1, 2>{}, out.data(), va.data(), vb.data());
+}
+
+#define COMMON_view_op_impl(op)                                               \
+    template <typename A, size_t NA, typename B, size_t NB>                   \
+    auto operator op(const TensorView<A, NA>& a, const TensorView<B, NB>& b) { \
+        using R = std::remove_const_t<decltype(std::declval<A>()              \
+                                                   op std::declval<B>())>;    \
+        DynamicTensor<R, std::max(NA, NB)> result(                            \
+            broadcast_shape(a.shape(), b.shape()));                           \
+        broadcast_apply(result.view(), a, b,                                  \
+                        [](const A& x, const B& y) { return x op y; });       \
+        return result;                                                        \
+    }                                                                         \
+    template <typename A, size_t NA>                                          \
+    auto operator op(const TensorView<A, NA>& a,                              \
+                     const std::remove_const_t<A>& scalar) {                  \
+        auto result = a.copy();                                               \
+        result.view() op## = scalar;                                          \
+        return result;                                                        \
+    }
+COMMON_view_op_impl(+);
+COMMON_view_op_impl(-);
+COMMON_view_op_impl(*);
+COMMON_view_op_impl(/);
+#undef COMMON_view_op_impl
+
+/// VIEWS OF OTHER TYPES ///
+
+namespace detail {
+
+template <typename T, typename = void>
+struct grid_element {
+    using type = T;
+};
+template <typename T>
+struct grid_element<T, std::void_t<typename T::type>> {
+    using type = typename T::type;
+};
+
+};  // namespace detail
+
+// (height, width, channels) view of an image, without copying it. Row 0 is
+// the row returned by image(x, 0), taking flip_y into account
+template <typename T>
+auto make_view(Grid2D<T>& image) {
+    using U = typename detail::grid_element<T>::type;
+    constexpr size_t channels = bitmap_channels<T>::value;
+    static_assert(sizeof(T) == channels * sizeof(U),
+                  "Grid2D elements must be tightly packed to be viewed");
+    const ptrdiff_t row = static_cast<ptrdiff_t>(image.width() * channels);
+    U* data = static_cast<U*>(image.data());
+    if (image.flip_y() && image.height() > 0)
+        data += row * static_cast<ptrdiff_t>(image.height() - 1);
+    return TensorView<U, 3>(
+        data, {image.height(), image.width(), channels},
+        {image.flip_y() ? -row : row, static_cast<ptrdiff_t>(channels), 1});
+}
+
+template <typename T>
+auto make_view(const Grid2D<T>& image) {
+    using U = typename detail::grid_element<T>::type;
+    return TensorView<const U, 3>(make_view(const_cast<Grid2D<T>&>(image)));
+}
+
+// Grid3D frames are stored in separate buffers, so they are viewed one by one
+template <typename T>
+auto make_view(Grid3D<T>& video, size_t t) {
+    return make_view(video.at(t));
+}
+
+template <typename T>
+auto make_view(const Grid3D<T>& video, size_t t) {
+    return make_view(video.at(t));
+}
+
+};  // namespace common
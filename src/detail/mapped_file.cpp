@@ -0,0 +1,105 @@
+/*
+ * mapped_file.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Read-only memory mapping of whole files
+ */
+
+#include "libcpp-common/detail/mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define COMMON_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace common {
+namespace detail {
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    m_buffer = std::move(other.m_buffer);
+    m_data = m_buffer.empty() ? other.m_data : m_buffer.data();
+    m_size = other.m_size;
+    m_open = other.m_open;
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_open = false;
+    return *this;
+}
+
+#ifdef COMMON_HAS_MMAP
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size > 0) {
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        // the whole file is going to be read, possibly by several threads
+        madvise(p, m_size, MADV_WILLNEED);
+        m_data = static_cast<const uint8_t*>(p);
+    }
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data != nullptr && m_buffer.empty())
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    m_size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+    m_buffer.resize(m_size);
+    file.read(reinterpret_cast<char*>(m_buffer.data()), m_size);
+    if (!file) {
+        close();
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#endif
+
+#undef COMMON_HAS_MMAP
+
+};  // namespace detail
+};  // namespace common
@@ -0,0 +1,105 @@
+/*
+ * npy.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Header of NumPy's .npy files (format version 1.0), shared by the bitmap and
+ * tensor savers/loaders
+ */
+
+#include "libcpp-common/detail/npy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "libcpp-common/detail/exception.h"
+
+namespace common {
+namespace detail {
+
+static const char npy_magic[] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+
+std::string npy_header(const NpyHeader& header, size_t min_length) {
+    std::string dict = "{'descr': '" + header.descr + "', " +
+                       "'fortran_order': " +
+                       (header.fortran_order ? "True" : "False") +
+                       ", 'shape': (";
+    for (size_t i = 0; i < header.shape.size(); ++i)
+        dict += (i > 0 ? ", " : "") + std::to_string(header.shape[i]);
+    // one-element tuples need a trailing comma, as in Python
+    dict += header.shape.size() == 1 ? ",), }" : "), }";
+
+    // magic, version, length, dictionary and newline, to multiple of 64
+    const size_t content_len = sizeof(npy_magic) + 2 + 2 + dict.size() + 1;
+    size_t padded_len = std::max(content_len, min_length);
+    padded_len = (padded_len + 63) / 64 * 64;
+    if (padded_len - sizeof(npy_magic) - 4 > UINT16_MAX)
+        throw CommonException("NPY header is too long");
+
+    std::string result(npy_magic, sizeof(npy_magic));
+    result += '\x01';
+    result += '\x00';
+    // header length, in little endian
+    const uint16_t len = padded_len - sizeof(npy_magic) - 4;
+    result += static_cast<char>(len & 0xFF);
+    result += static_cast<char>(len >> 8);
+    result += dict;
+    result.append(padded_len - content_len, ' ');
+    result += '\n';
+    return result;
+}
+
+// Value of key in the header dictionary, up to (and not including) any of
+// the characters in end
+static std::string npy_dict_value(const std::string& dict,
+                                  const std::string& key, const char* end) {
+    const size_t key_pos = dict.find("'" + key + "'");
+    if (key_pos == std::string::npos)
+        throw CommonException("NPY header has no " + key + " key");
+    size_t start = dict.find(':', key_pos);
+    if (start == std::string::npos)
+        throw CommonException("NPY header is malformed");
+    start = dict.find_first_not_of(' ', start + 1);
+    const size_t stop = dict.find_first_of(end, start + 1);
+    if (start == std::string::npos || stop == std::string::npos)
+        throw CommonException("NPY header is malformed");
+    return dict.substr(start, stop - start + 1);
+}
+
+NpyHeader read_npy_header(std::istream& file) {
+    char magic[sizeof(npy_magic) + 2];
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, npy_magic, sizeof(npy_magic)) != 0)
+        throw CommonException("Not a NPY file");
+
+    // version 1.0 has a 2-byte length, versions 2.0 and 3.0 have 4 bytes
+    const uint8_t major = static_cast<uint8_t>(magic[sizeof(npy_magic)]);
+    const size_t len_bytes = major == 1 ? 2 : 4;
+    uint8_t len_le[4] = {0, 0, 0, 0};
+    file.read(reinterpret_cast<char*>(len_le), len_bytes);
+    const size_t len = len_le[0] | (len_le[1] << 8) | (len_le[2] << 16) |
+                       (size_t(len_le[3]) << 24);
+    std::string dict(len, '\0');
+    file.read(&dict[0], len);
+    if (!file) throw CommonException("NPY header is truncated");
+
+    NpyHeader header;
+    const std::string descr = npy_dict_value(dict, "descr", "'\"");
+    header.descr = descr.substr(1, descr.size() - 2);
+    header.fortran_order =
+        npy_dict_value(dict, "fortran_order", ",}").find("True") == 0;
+    const std::string shape = npy_dict_value(dict, "shape", ")");
+    for (size_t i = 1; i < shape.size();) {
+        if (shape[i] < '0' || shape[i] > '9') {
+            ++i;
+            continue;
+        }
+        size_t n = 0;
+        for (; shape[i] >= '0' && shape[i] <= '9'; ++i)
+            n = n * 10 + size_t(shape[i] - '0');
+        header.shape.push_back(n);
+    }
+    return header;
+}
+
+};  // namespace detail
+};  // namespace common
@@ -0,0 +1,83 @@
+/*
+ * aabb.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Axis-aligned bounding boxes, and the bounds of a VecList
+ */
+#include <cstddef>
+#include <vector>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/simd.h"
+
+namespace common {
+
+namespace detail {
+
+// Lists with more points are split between threads
+static constexpr size_t AABB_PARALLEL_MIN = 1 << 16;
+
+static constexpr size_t aabb_gcd(size_t a, size_t b) {
+    return b == 0 ? a : aabb_gcd(b, a % b);
+}
+
+// Bounds of the points p[0:n] of N components. The flat array is read in
+// groups of P packs, P * W being a multiple of N, so that lane l of pack j
+// always holds component (j * W + l) % N and the packs can be reduced
+// independently, without shuffles
+template <typename T, unsigned int N>
+AABB<T, N> aabb_block(const T* p, size_t n) {
+    AABB<T, N> result;
+    const size_t size = n * N;
+    size_t i = 0;
+    if constexpr (simd_supported<T>) {
+        constexpr size_t W = simd_width<T>;
+        constexpr size_t P = N / aabb_gcd(N, W);
+        if (size >= P * W) {
+            simd_t<T> lower[P], upper[P];
+            for (size_t j = 0; j < P; ++j) {
+                lower[j] = simd_broadcast(result.min[0]);
+                upper[j] = simd_broadcast(result.max[0]);
+            }
+            for (; i + P * W <= size; i += P * W)
+#pragma GCC unroll 4
+                for (size_t j = 0; j < P; ++j) {
+                    const simd_t<T> x = simd_load(p + i + j * W);
+                    lower[j] = x < lower[j] ? x : lower[j];
+                    upper[j] = x > upper[j] ? x : upper[j];
+                }
+            for (size_t j = 0; j < P; ++j)
+                for (size_t l = 0; l < W; ++l) {
+                    const unsigned int k = (j * W + l) % N;
+                    result.min[k] = std::min(result.min[k], T(lower[j][l]));
+                    result.max[k] = std::max(result.max[k], T(upper[j][l]));
+                }
+        }
+    }
+    // i is a multiple of N
+    for (; i < size; i += N)
+        for (unsigned int k = 0; k < N; ++k) {
+            result.min[k] = std::min(result.min[k], p[i + k]);
+            result.max[k] = std::max(result.max[k], p[i + k]);
+        }
+    return result;
+}
+
+};  // namespace detail
+
+template <typename T, unsigned int N>
+AABB<T, N> bounds(const VecList<T, N>& points) {
+    const T* p = points.data_flat();
+    std::vector<AABB<T, N>> partial(
+        detail::num_chunks(points.size(), detail::AABB_PARALLEL_MIN));
+    detail::parallel_chunks(0, points.size(), detail::AABB_PARALLEL_MIN,
+                            [&](size_t c, size_t b, size_t e) {
+                                partial[c] = detail::aabb_block<T, N>(
+                                    p + b * N, e - b);
+                            });
+    AABB<T, N> result;
+    for (const AABB<T, N>& b : partial) result.extend(b);
+    return result;
+}
+
+};  // namespace common
@@ -0,0 +1,195 @@
+/*
+ * space_filling_curve.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Morton (Z-order) and Hilbert codes of 3D points, and parallel sorting of
+ * a VecList (and the arrays attached to it) along them
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/radix_sort.h"
+
+namespace common {
+
+namespace detail {
+
+// Lists with more points are split between threads
+static constexpr size_t CURVE_PARALLEL_MIN = 1 << 14;
+
+// Bits per axis of the codes of each type
+template <typename Code>
+static constexpr unsigned int curve_bits() {
+    static_assert(std::is_same_v<Code, uint32_t> ||
+                      std::is_same_v<Code, uint64_t>,
+                  "Curve codes are uint32_t (30 bits) or uint64_t (63 bits)");
+    return std::is_same_v<Code, uint32_t> ? 10 : 21;
+}
+
+// Spreads the lowest 10 (21) bits of x to every third bit
+static inline uint32_t spread_bits(uint32_t x) {
+#if defined(__BMI2__)
+    return _pdep_u32(x, 0x09249249);
+#else
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+#endif
+}
+
+static inline uint64_t spread_bits(uint64_t x) {
+#if defined(__BMI2__)
+    return _pdep_u64(x, 0x1249249249249249);
+#else
+    x &= 0x1fffff;
+    x = (x | (x << 32)) & 0x001f00000000ffff;
+    x = (x | (x << 16)) & 0x001f0000ff0000ff;
+    x = (x | (x << 8)) & 0x100f00f00f00f00f;
+    x = (x | (x << 4)) & 0x10c30c30c30c30c3;
+    x = (x | (x << 2)) & 0x1249249249249249;
+    return x;
+#endif
+}
+
+};  // namespace detail
+
+template <typename Code>
+inline Code morton_encode(uint32_t x, uint32_t y, uint32_t z) {
+    static_assert(detail::curve_bits<Code>() > 0);
+    return detail::spread_bits(Code(x)) | (detail::spread_bits(Code(y)) << 1) |
+           (detail::spread_bits(Code(z)) << 2);
+}
+
+template <typename Code>
+inline Code hilbert_encode(uint32_t x, uint32_t y, uint32_t z) {
+    constexpr unsigned int BITS = detail::curve_bits<Code>();
+    constexpr uint32_t M = uint32_t(1) << (BITS - 1);
+    uint32_t X[3] = {x & (2 * M - 1), y & (2 * M - 1), z & (2 * M - 1)};
+    // Inverse undo of the rotations and reflections of each level
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        const uint32_t P = Q - 1;
+        for (unsigned int i = 0; i < 3; ++i) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                const uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+    // Gray encoding
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1)
+        if (X[2] & Q) t ^= Q - 1;
+    for (unsigned int i = 0; i < 3; ++i) X[i] ^= t;
+    // The index has the bits of X[0] in the highest position of each triple
+    return morton_encode<Code>(X[2], X[1], X[0]);
+}
+
+template <typename Code, typename T, unsigned int N>
+std::vector<Code> curve_codes(const VecList<T, N>& points, Curve curve,
+                              const AABB<T, 3>& box) {
+    static_assert(N >= 3, "Curve codes need points with 3 components");
+    constexpr uint32_t CELLS = uint32_t(1) << detail::curve_bits<Code>();
+    Vec<T, 3> scale;
+    for (unsigned int k = 0; k < 3; ++k) {
+        const T extent = box.max[k] - box.min[k];
+        scale[k] = extent > 0 ? T(CELLS - 1) / extent : T(0);
+    }
+    std::vector<Code> codes(points.size());
+    detail::parallel_for(
+        0, points.size(), detail::CURVE_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                uint32_t cell[3];
+                for (unsigned int k = 0; k < 3; ++k) {
+                    // clamped before the conversion, for the points out of
+                    // the box (NaN goes to cell 0)
+                    const T t = std::min(
+                        (points[i][k] - box.min[k]) * scale[k] + T(0.5),
+                        T(CELLS - 1));
+                    cell[k] = t > 0 ? uint32_t(t) : 0;
+                }
+                codes[i] =
+                    curve == Curve::Morton
+                        ? morton_encode<Code>(cell[0], cell[1], cell[2])
+                        : hilbert_encode<Code>(cell[0], cell[1], cell[2]);
+            }
+        });
+    return codes;
+}
+
+template <typename Code, typename T, unsigned int N>
+std::vector<Code> curve_codes(const VecList<T, N>& points, Curve curve) {
+    const AABB<T, N> box = bounds(points);
+    AABB<T, 3> box3;
+    for (unsigned int k = 0; k < 3; ++k) {
+        box3.min[k] = box.min[k];
+        box3.max[k] = box.max[k];
+    }
+    return curve_codes<Code>(points, curve, box3);
+}
+
+template <typename Code>
+std::vector<uint32_t> sort_order(const std::vector<Code>& codes,
+                                 unsigned int key_bits) {
+    const size_t n = codes.size();
+    std::vector<std::pair<Code, uint32_t>> sorted(n);
+    detail::parallel_for(0, n, detail::CURVE_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 sorted[i] = {codes[i], uint32_t(i)};
+                         });
+    detail::radix_sort(sorted, key_bits,
+                       [](const std::pair<Code, uint32_t>& c) {
+                           return uint64_t(c.first);
+                       });
+    std::vector<uint32_t> order(n);
+    detail::parallel_for(0, n, detail::CURVE_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 order[i] = sorted[i].second;
+                         });
+    return order;
+}
+
+template <typename List>
+void reorder(List& values, const std::vector<uint32_t>& order) {
+    List result(order.size());
+    detail::parallel_for(0, order.size(), detail::CURVE_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 result[i] = values[order[i]];
+                         });
+    values = std::move(result);
+}
+
+template <typename T, unsigned int N, typename... Attached>
+std::vector<uint32_t> sort_along_curve(VecList<T, N>& points, Curve curve,
+                                       Attached&... attached) {
+    if (((attached.size() != points.size()) || ...))
+        throw detail::CommonGeometryException(
+            "Attached arrays must have as many elements as points");
+    const std::vector<uint32_t> order =
+        sort_order(curve_codes<uint64_t>(points, curve), 63);
+    reorder(points, order);
+    (reorder(attached, order), ...);
+    return order;
+}
+
+};  // namespace common
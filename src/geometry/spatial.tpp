@@ -0,0 +1,498 @@
+/*
+ * spatial.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Spatial indices over the points of a VecList for nearest neighbour and
+ * radius queries: a k-d tree and a uniform hash grid
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/radix_sort.h"
+
+namespace common {
+
+namespace detail {
+
+// Ranges with less points are partitioned and built in a single thread
+static constexpr size_t SPATIAL_PARALLEL_MIN = 1 << 15;
+// Queries are split between threads in chunks of at least this size
+static constexpr size_t SPATIAL_QUERY_CHUNK = 256;
+// Keys sampled to choose the pivots of the parallel nth_element
+static constexpr size_t SPATIAL_PIVOT_SAMPLES = 255;
+
+// Cell of coordinate x in a grid of cells of size cell_size. Huge and
+// non-finite coordinates are clamped to the last cell, so that the
+// conversion to int64_t is defined (NaN to cell 0)
+template <typename T>
+int64_t grid_cell(T x, T cell_size) {
+    constexpr int64_t LIMIT = int64_t(1) << 62;
+    const T c = std::floor(x / cell_size);
+    if (std::abs(c) < T(LIMIT)) return int64_t(c);
+    return c > 0 ? LIMIT : c < 0 ? -LIMIT : 0;
+}
+
+// Partitions values[begin:end) as std::nth_element does around mid, with
+// key(value) as the order. While the range is long enough, it is partitioned
+// in parallel around a pivot of the rank of mid in a sample of the keys:
+// each chunk counts its keys less than and equal to the pivot, and scatters
+// them to their offsets in a buffer. Each round leaves a few percent of the
+// range around mid, which is finished by std::nth_element
+template <typename Key>
+void parallel_nth_element(uint32_t* values, size_t begin, size_t mid,
+                          size_t end, const Key& key) {
+    using K = decltype(key(values[0]));
+    std::vector<uint32_t> buffer;
+    while (num_chunks(end - begin, SPATIAL_PARALLEL_MIN) > 1) {
+        const size_t n = end - begin;
+        K sample[SPATIAL_PIVOT_SAMPLES];
+        for (size_t s = 0; s < SPATIAL_PIVOT_SAMPLES; ++s)
+            sample[s] = key(values[begin + n * s / SPATIAL_PIVOT_SAMPLES]);
+        const size_t rank = (mid - begin) * SPATIAL_PIVOT_SAMPLES / n;
+        std::nth_element(sample, sample + rank,
+                         sample + SPATIAL_PIVOT_SAMPLES);
+        const K pivot = sample[rank];
+
+        const size_t chunks = num_chunks(n, SPATIAL_PARALLEL_MIN);
+        std::vector<size_t> less(chunks + 1, 0), equal(chunks + 1, 0);
+        parallel_chunks(begin, end, SPATIAL_PARALLEL_MIN,
+                        [&](size_t c, size_t b, size_t e) {
+                            for (size_t i = b; i < e; ++i) {
+                                const K k = key(values[i]);
+                                less[c + 1] += k < pivot;
+                                equal[c + 1] += k == pivot;
+                            }
+                        });
+        for (size_t c = 1; c <= chunks; ++c) {
+            less[c] += less[c - 1];
+            equal[c] += equal[c - 1];
+        }
+        const size_t num_less = less[chunks], num_equal = equal[chunks];
+        buffer.resize(n);
+        parallel_chunks(
+            begin, end, SPATIAL_PARALLEL_MIN,
+            [&](size_t c, size_t b, size_t e) {
+                size_t next_less = less[c];
+                size_t next_equal = num_less + equal[c];
+                size_t next_greater =
+                    num_less + num_equal + (b - begin) - less[c] - equal[c];
+                for (size_t i = b; i < e; ++i) {
+                    const K k = key(values[i]);
+                    const size_t target = k < pivot    ? next_less++
+                                          : k == pivot ? next_equal++
+                                                       : next_greater++;
+                    buffer[target] = values[i];
+                }
+            });
+        parallel_for(0, n, SPATIAL_PARALLEL_MIN, [&](size_t b, size_t e) {
+            std::copy(buffer.begin() + b, buffer.begin() + e,
+                      values + begin + b);
+        });
+
+        if (mid < begin + num_less) {
+            end = begin + num_less;
+        } else if (mid < begin + num_less + num_equal) {
+            return;  // the keys of the pivot are already in place
+        } else if (num_less + num_equal > 0) {
+            begin += num_less + num_equal;
+        } else {
+            break;  // NaN pivot, nothing was partitioned
+        }
+    }
+    std::nth_element(values + begin, values + mid, values + end,
+                     [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+}
+
+// Runs query(i, found) for each of n query points in parallel, appending
+// their neighbours to found, and gathers them in compressed rows
+template <typename T, typename Query>
+NeighborRows<T> neighbor_rows(size_t n, const Query& query) {
+    NeighborRows<T> rows;
+    rows.offsets.assign(n + 1, 0);
+    std::vector<std::vector<Neighbor<T>>> found(
+        num_chunks(n, SPATIAL_QUERY_CHUNK));
+    parallel_chunks(0, n, SPATIAL_QUERY_CHUNK,
+                    [&](size_t c, size_t b, size_t e) {
+                        for (size_t i = b; i < e; ++i) {
+                            const size_t before = found[c].size();
+                            query(i, found[c]);
+                            rows.offsets[i + 1] = found[c].size() - before;
+                        }
+                    });
+    for (size_t i = 0; i < n; ++i) rows.offsets[i + 1] += rows.offsets[i];
+    rows.neighbors.resize(rows.offsets[n]);
+    parallel_chunks(0, n, SPATIAL_QUERY_CHUNK,
+                    [&](size_t c, size_t b, size_t) {
+                        std::copy(found[c].begin(), found[c].end(),
+                                  rows.neighbors.begin() + rows.offsets[b]);
+                    });
+    return rows;
+}
+
+};  // namespace detail
+
+/// K-D TREE ///
+
+template <typename T, unsigned int N>
+void KDTree<T, N>::build(const VecList<T, N>& points, size_t leaf_size) {
+    const size_t n = points.size();
+    m_points = &points;
+    m_leaf_size = std::max<size_t>(leaf_size, 1);
+    m_indices.resize(n);
+    detail::parallel_for(0, n, detail::SPATIAL_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             std::iota(m_indices.begin() + b,
+                                       m_indices.begin() + e, uint32_t(b));
+                         });
+    m_split.assign(n, T(0));
+    m_axis.assign(n, 0);
+
+    const AABB<T, N> box = bounds(points);
+    AABB<T, D> cell;
+    for (unsigned int k = 0; k < D; ++k) {
+        cell.min[k] = box.min[k];
+        cell.max[k] = box.max[k];
+    }
+    build(0, n, 0, cell);
+}
+
+template <typename T, unsigned int N>
+void KDTree<T, N>::build(size_t begin, size_t end, size_t depth,
+                         const AABB<T, D>& cell) {
+    if (end - begin <= m_leaf_size) return;
+    // split the cell of the node, rather than the bounds of its points,
+    // which would need another pass over them
+    const unsigned int axis = cell.largest_axis();
+    const size_t mid = begin + (end - begin) / 2;
+    detail::parallel_nth_element(
+        m_indices.data(), begin, mid, end,
+        [&](uint32_t i) { return coordinate(i, axis); });
+    const T split = coordinate(m_indices[mid], axis);
+    m_axis[mid] = uint8_t(axis);
+    m_split[mid] = split;
+
+    AABB<T, D> left = cell, right = cell;
+    left.max[axis] = split;
+    right.min[axis] = split;
+    if ((size_t(1) << depth) < detail::num_threads() &&
+        end - begin >= detail::SPATIAL_PARALLEL_MIN) {
+        detail::parallel_for(0, 2, 1, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; ++c) {
+                if (c == 0)
+                    build(begin, mid, depth + 1, left);
+                else
+                    build(mid + 1, end, depth + 1, right);
+            }
+        });
+    } else {
+        build(begin, mid, depth + 1, left);
+        build(mid + 1, end, depth + 1, right);
+    }
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+T KDTree<T, N>::distance2(uint32_t i, const Vec<T, M>& p) const {
+    static_assert(M >= D, "The query points need more components");
+    T d2 = 0;
+    for (unsigned int k = 0; k < D; ++k) {
+        const T d = coordinate(i, k) - p[k];
+        d2 += d * d;
+    }
+    return d2;
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M, typename Visit>
+void KDTree<T, N>::traverse(const Vec<T, M>& p, size_t begin, size_t end,
+                            T& bound2, const Visit& visit) const {
+    if (end - begin <= m_leaf_size) {
+        for (size_t i = begin; i < end; ++i) {
+            const T d2 = distance2(m_indices[i], p);
+            if (d2 <= bound2) visit(m_indices[i], d2);
+        }
+        return;
+    }
+    const size_t mid = begin + (end - begin) / 2;
+    // the points on the other side of the split are at least d away
+    const T d = p[m_axis[mid]] - m_split[mid];
+    if (d < 0)
+        traverse(p, begin, mid, bound2, visit);
+    else
+        traverse(p, mid + 1, end, bound2, visit);
+    const T d2 = distance2(m_indices[mid], p);
+    if (d2 <= bound2) visit(m_indices[mid], d2);
+    if (d * d > bound2) return;
+    if (d < 0)
+        traverse(p, mid + 1, end, bound2, visit);
+    else
+        traverse(p, begin, mid, bound2, visit);
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+Neighbor<T> KDTree<T, N>::nearest(const Vec<T, M>& p, T max_distance) const {
+    Neighbor<T> best;
+    if (m_indices.empty()) return best;
+    T bound2 = max_distance * max_distance;
+    traverse(p, 0, m_indices.size(), bound2, [&](uint32_t i, T d2) {
+        if (d2 < best.distance2) {
+            best = {i, d2};
+            bound2 = d2;
+        }
+    });
+    return best;
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+size_t KDTree<T, N>::knn(const Vec<T, M>& p, size_t k, Neighbor<T>* result,
+                         T max_distance) const {
+    // max-heap of the closest ones found so far
+    auto farther = [](const Neighbor<T>& a, const Neighbor<T>& b) {
+        return a.distance2 < b.distance2;
+    };
+    size_t count = 0;
+    if (k > 0 && !m_indices.empty()) {
+        T bound2 = max_distance * max_distance;
+        traverse(p, 0, m_indices.size(), bound2, [&](uint32_t i, T d2) {
+            if (count < k) {
+                result[count++] = {i, d2};
+                std::push_heap(result, result + count, farther);
+                if (count == k) bound2 = result[0].distance2;
+            } else if (d2 < result[0].distance2) {
+                std::pop_heap(result, result + k, farther);
+                result[k - 1] = {i, d2};
+                std::push_heap(result, result + k, farther);
+                bound2 = result[0].distance2;
+            }
+        });
+        std::sort_heap(result, result + count, farther);
+    }
+    std::fill(result + count, result + k, Neighbor<T>());
+    return count;
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+void KDTree<T, N>::radius(const Vec<T, M>& p, T r,
+                          std::vector<Neighbor<T>>& result) const {
+    result.clear();
+    if (m_indices.empty()) return;
+    T bound2 = r * r;
+    traverse(p, 0, m_indices.size(), bound2,
+             [&](uint32_t i, T d2) { result.push_back({i, d2}); });
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+void KDTree<T, N>::knn(const Vec<T, M>* points, size_t n, size_t k,
+                       Neighbor<T>* results, T max_distance) const {
+    detail::parallel_for(0, n, detail::SPATIAL_QUERY_CHUNK,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 knn(points[i], k, results + i * k,
+                                     max_distance);
+                         });
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+NeighborRows<T> KDTree<T, N>::radius(const Vec<T, M>* points, size_t n,
+                                     T r) const {
+    return detail::neighbor_rows<T>(
+        n, [&](size_t i, std::vector<Neighbor<T>>& found) {
+            if (m_indices.empty()) return;
+            T bound2 = r * r;
+            traverse(points[i], 0, m_indices.size(), bound2,
+                     [&](uint32_t j, T d2) { found.push_back({j, d2}); });
+        });
+}
+
+/// HASH GRID ///
+
+template <typename T, unsigned int N>
+void HashGrid<T, N>::build(const VecList<T, N>& points, T cell_size) {
+    if (!(cell_size > 0))
+        throw detail::CommonGeometryException(
+            "The cell size has to be positive");
+    const size_t n = points.size();
+    m_points = &points;
+    m_cell_size = cell_size;
+    const unsigned int bits = detail::bit_width(n) + 1;
+    m_shift = 64 - bits;
+    m_mask = (uint64_t(1) << bits) - 1;
+
+    // (bucket << 32) | index of each point, sorted by bucket, and the
+    // bounds of the cells of each chunk
+    std::vector<uint64_t> keys(n);
+    const size_t chunks = detail::num_chunks(n, detail::SPATIAL_PARALLEL_MIN);
+    std::vector<Vec<int64_t, D>> lower(
+        chunks, Vec<int64_t, D>(std::numeric_limits<int64_t>::max()));
+    std::vector<Vec<int64_t, D>> upper(
+        chunks, Vec<int64_t, D>(std::numeric_limits<int64_t>::min()));
+    detail::parallel_chunks(
+        0, n, detail::SPATIAL_PARALLEL_MIN,
+        [&](size_t c, size_t b, size_t e) {
+            Vec<int64_t, D> cell;
+            for (size_t i = b; i < e; ++i) {
+                for (unsigned int k = 0; k < D; ++k) {
+                    cell[k] = detail::grid_cell(points[i][k], m_cell_size);
+                    lower[c][k] = std::min(lower[c][k], cell[k]);
+                    upper[c][k] = std::max(upper[c][k], cell[k]);
+                }
+                keys[i] = bucket(cell) << 32 | i;
+            }
+        });
+    m_lower = Vec<int64_t, D>(std::numeric_limits<int64_t>::max());
+    m_upper = Vec<int64_t, D>(std::numeric_limits<int64_t>::min());
+    for (size_t c = 0; c < chunks; ++c)
+        for (unsigned int k = 0; k < D; ++k) {
+            m_lower[k] = std::min(m_lower[k], lower[c][k]);
+            m_upper[k] = std::max(m_upper[k], upper[c][k]);
+        }
+    detail::radix_sort(keys, bits, [](uint64_t key) { return key >> 32; });
+
+    m_indices.resize(n);
+    const size_t buckets = size_t(1) << bits;
+    m_buckets.resize(buckets + 1);
+    detail::parallel_for(0, n, detail::SPATIAL_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i) {
+                                 m_indices[i] = uint32_t(keys[i]);
+                                 // the buckets after the one of i - 1
+                                 // start at i
+                                 const size_t first =
+                                     i == 0 ? 0 : (keys[i - 1] >> 32) + 1;
+                                 for (size_t r = first; r <= keys[i] >> 32;
+                                      ++r)
+                                     m_buckets[r] = uint32_t(i);
+                             }
+                         });
+    for (size_t r = n == 0 ? 0 : (keys[n - 1] >> 32) + 1; r <= buckets; ++r)
+        m_buckets[r] = uint32_t(n);
+}
+
+template <typename T, unsigned int N>
+uint64_t HashGrid<T, N>::bucket(const Vec<int64_t, D>& cell) const {
+    // the highest bits of a Fibonacci hash of the row of the cell (all but
+    // its x), plus its x, so that the cells of a row are in consecutive
+    // buckets and a query reads a few contiguous ranges of m_indices
+    constexpr uint64_t primes[3] = {73856093, 19349663, 83492791};
+    uint64_t hash = 0;
+    for (unsigned int k = 1; k < D; ++k) hash ^= uint64_t(cell[k]) * primes[k];
+    const uint64_t row = (hash * 0x9e3779b97f4a7c15ull) >> m_shift;
+    return (row + uint64_t(cell[0])) & m_mask;
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M, typename Visit>
+void HashGrid<T, N>::for_each_within(const Vec<T, M>& p, T r,
+                                     const Visit& visit) const {
+    static_assert(M >= D, "The query points need more components");
+    if (m_indices.empty() || !(r >= 0)) return;
+    const T r2 = r * r;
+    auto test = [&](uint32_t i) {
+        T d2 = 0;
+        for (unsigned int k = 0; k < D; ++k) {
+            const T d = (*m_points)[i][k] - p[k];
+            d2 += d * d;
+        }
+        if (d2 <= r2) visit(i, d2);
+    };
+
+    // cells around p, only up to the non-empty ones (e.g. for an infinite r)
+    Vec<int64_t, D> lower, upper;
+    double rows = 1;
+    for (unsigned int k = 0; k < D; ++k) {
+        lower[k] =
+            std::max(detail::grid_cell(p[k] - r, m_cell_size), m_lower[k]);
+        upper[k] =
+            std::min(detail::grid_cell(p[k] + r, m_cell_size), m_upper[k]);
+        if (lower[k] > upper[k]) return;
+        if (k > 0) rows *= double(upper[k]) - double(lower[k]) + 1;
+    }
+    const size_t buckets = m_buckets.size() - 1;
+    const uint64_t length = uint64_t(upper[0]) - uint64_t(lower[0]) + 1;
+    if (length >= buckets || rows * length >= buckets) {
+        for (uint32_t i : m_indices) test(i);
+        return;
+    }
+
+    // ranges of buckets of each row, split in two where they wrap around
+    constexpr size_t LOCAL = 2 * 27;
+    std::pair<uint64_t, uint64_t> local[LOCAL];
+    std::vector<std::pair<uint64_t, uint64_t>> allocated;
+    std::pair<uint64_t, uint64_t>* ranges = local;
+    if (2 * rows > LOCAL) {
+        allocated.resize(size_t(2 * rows));
+        ranges = allocated.data();
+    }
+    size_t count = 0;
+    for (Vec<int64_t, D> cell = lower;;) {
+        const uint64_t first = bucket(cell);
+        if (first + length <= buckets) {
+            ranges[count++] = {first, first + length};
+        } else {
+            ranges[count++] = {first, buckets};
+            ranges[count++] = {0, first + length - buckets};
+        }
+        unsigned int k = 1;
+        for (; k < D; ++k) {
+            if (++cell[k] <= upper[k]) break;
+            cell[k] = lower[k];
+        }
+        if (k >= D) break;
+    }
+    // each bucket once, even if several rows share it
+    std::sort(ranges, ranges + count);
+    uint64_t next = 0;
+    for (size_t c = 0; c < count; ++c) {
+        const uint64_t first = std::max(ranges[c].first, next);
+        if (first >= ranges[c].second) continue;
+        for (uint32_t j = m_buckets[first]; j < m_buckets[ranges[c].second];
+             ++j)
+            test(m_indices[j]);
+        next = ranges[c].second;
+    }
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+Neighbor<T> HashGrid<T, N>::nearest(const Vec<T, M>& p,
+                                    T max_distance) const {
+    Neighbor<T> best;
+    for_each_within(p, max_distance < 0 ? m_cell_size : max_distance,
+                    [&](uint32_t i, T d2) {
+                        if (d2 < best.distance2) best = {i, d2};
+                    });
+    return best;
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+void HashGrid<T, N>::radius(const Vec<T, M>& p, T r,
+                            std::vector<Neighbor<T>>& result) const {
+    result.clear();
+    for_each_within(p, r,
+                    [&](uint32_t i, T d2) { result.push_back({i, d2}); });
+}
+
+template <typename T, unsigned int N>
+template <unsigned int M>
+NeighborRows<T> HashGrid<T, N>::radius(const Vec<T, M>* points, size_t n,
+                                       T r) const {
+    return detail::neighbor_rows<T>(
+        n, [&](size_t i, std::vector<Neighbor<T>>& found) {
+            for_each_within(points[i], r, [&](uint32_t j, T d2) {
+                found.push_back({j, d2});
+            });
+        });
+}
+
+};  // namespace common
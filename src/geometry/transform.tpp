@@ -0,0 +1,231 @@
+/*
+ * transform.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Quaternions and compact 3x4 affine transforms, cheaper to compose and to
+ * invert than 4x4 matrices, applied to whole VecLists with SIMD
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/simd.h"
+
+namespace common {
+
+/// QUATERNION ///
+
+template <typename T>
+Quat<T> Quat<T>::axis_angle(const Vec<T, 3>& axis, T rad) {
+    const T s = std::sin(rad / 2) / std::sqrt(dot(axis, axis));
+    return Quat(axis.x() * s, axis.y() * s, axis.z() * s, std::cos(rad / 2));
+}
+
+template <typename T>
+Quat<T> Quat<T>::from_matrix(const Mat<T, 3>& m) {
+    // the largest of w, x, y, z is computed from the diagonal, and the rest
+    // from the sums or differences of opposite elements
+    const T trace = m(0, 0) + m(1, 1) + m(2, 2);
+    if (trace > 0) {
+        const T s = std::sqrt(trace + 1) * 2;
+        return Quat((m(2, 1) - m(1, 2)) / s, (m(0, 2) - m(2, 0)) / s,
+                    (m(1, 0) - m(0, 1)) / s, s / 4);
+    } else if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2)) {
+        const T s = std::sqrt(1 + m(0, 0) - m(1, 1) - m(2, 2)) * 2;
+        return Quat(s / 4, (m(0, 1) + m(1, 0)) / s, (m(0, 2) + m(2, 0)) / s,
+                    (m(2, 1) - m(1, 2)) / s);
+    } else if (m(1, 1) > m(2, 2)) {
+        const T s = std::sqrt(1 + m(1, 1) - m(0, 0) - m(2, 2)) * 2;
+        return Quat((m(0, 1) + m(1, 0)) / s, s / 4, (m(1, 2) + m(2, 1)) / s,
+                    (m(0, 2) - m(2, 0)) / s);
+    } else {
+        const T s = std::sqrt(1 + m(2, 2) - m(0, 0) - m(1, 1)) * 2;
+        return Quat((m(0, 2) + m(2, 0)) / s, (m(1, 2) + m(2, 1)) / s, s / 4,
+                    (m(1, 0) - m(0, 1)) / s);
+    }
+}
+
+template <typename T>
+constexpr Mat<T, 3> Quat<T>::matrix() const {
+    const T xx = x * x, yy = y * y, zz = z * z;
+    const T xy = x * y, xz = x * z, yz = y * z;
+    const T wx = w * x, wy = w * y, wz = w * z;
+    // by columns
+    return Mat<T, 3>(
+        Vec<T, 3>(1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy)),
+        Vec<T, 3>(2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx)),
+        Vec<T, 3>(2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy)));
+}
+
+template <typename T>
+Quat<T> nlerp(const Quat<T>& a, const Quat<T>& b, T t) {
+    const Quat<T> c = dot(a, b) < 0 ? -b : b;
+    return (a * (1 - t) + c * t).normalized();
+}
+
+template <typename T>
+Quat<T> slerp(const Quat<T>& a, const Quat<T>& b, T t) {
+    T d = dot(a, b);
+    const Quat<T> c = d < 0 ? -b : b;
+    d = std::abs(d);
+    // sin(angle) is too small to divide by it
+    if (d > T(0.9995)) return nlerp(a, c, t);
+    const T angle = std::acos(d);
+    const T s = 1 / std::sin(angle);
+    return a * (std::sin((1 - t) * angle) * s) + c * (std::sin(t * angle) * s);
+}
+
+/// AFFINE TRANSFORM ///
+
+template <typename T>
+constexpr Affine<T>::Affine(const Mat<T, 3>& linear,
+                            const Vec<T, 3>& translation) {
+    for (unsigned int i = 0; i < 3; ++i)
+        rows[i] = Vec<T, 4>(linear(i, 0), linear(i, 1), linear(i, 2),
+                            translation[i]);
+}
+
+template <typename T>
+constexpr Affine<T>::Affine(const Mat<T, 4>& m) {
+    for (unsigned int i = 0; i < 3; ++i)
+        rows[i] = Vec<T, 4>(m(i, 0), m(i, 1), m(i, 2), m(i, 3));
+}
+
+template <typename T>
+constexpr Mat<T, 3> Affine<T>::linear() const {
+    return Mat<T, 3>(rows[0].xyz(), rows[1].xyz(), rows[2].xyz()).transpose();
+}
+
+template <typename T>
+constexpr Mat<T, 4> Affine<T>::matrix() const {
+    return Mat<T, 4>(rows[0], rows[1], rows[2], Vec<T, 4>(0, 0, 0, 1))
+        .transpose();
+}
+
+template <typename T>
+constexpr Affine<T> Affine<T>::inverse() const {
+    const Vec<T, 3> r0 = rows[0].xyz(), r1 = rows[1].xyz(),
+                    r2 = rows[2].xyz();
+    // the columns of the adjugate are the cross products of the rows
+    const Vec<T, 3> c0 = cross(r1, r2), c1 = cross(r2, r0), c2 = cross(r0, r1);
+    const T inv_det = 1 / dot(r0, c0);
+    Affine result(Mat<T, 3>(c0 * inv_det, c1 * inv_det, c2 * inv_det));
+    const Vec<T, 3> t = -result.apply_vector(translation());
+    for (unsigned int i = 0; i < 3; ++i) result.rows[i].w() = t[i];
+    return result;
+}
+
+template <typename T>
+constexpr Affine<T> Affine<T>::rigid_inverse() const {
+    Affine result(Mat<T, 3>(rows[0].xyz(), rows[1].xyz(), rows[2].xyz()));
+    const Vec<T, 3> t = -result.apply_vector(translation());
+    for (unsigned int i = 0; i < 3; ++i) result.rows[i].w() = t[i];
+    return result;
+}
+
+namespace detail {
+
+// Lists with more points are split between threads
+static constexpr size_t AFFINE_PARALLEL_MIN = 1 << 15;
+
+static constexpr size_t affine_gcd(size_t a, size_t b) {
+    return b == 0 ? a : affine_gcd(b, a % b);
+}
+
+template <typename T, unsigned int N>
+inline void affine_point(const T* p, T* q, const T (&C)[N][N],
+                         const T (&c)[N]) {
+    for (unsigned int k = 0; k < N; ++k) {
+        T sum = c[k];
+        for (unsigned int col = 0; col < N; ++col) sum += C[k][col] * p[col];
+        q[k] = sum;
+    }
+}
+
+// out = C p + c for the points [b, e) of in (n points of N components).
+// Lane l of the pack at flat index i holds component k = i % N of its point,
+// and its result is the sum over d of C[k][k + d] * in[i + d], so the flat
+// array is transformed with 2N - 1 shifted loads per pack and without
+// shuffles. The coefficients repeat every P packs (P * W a multiple of N)
+template <typename T, unsigned int N>
+void affine_block(const T* in, T* out, size_t n, size_t b, size_t e,
+                  const T (&C)[N][N], const T (&c)[N]) {
+    const size_t size = n * N;
+    size_t i = b * N;
+    if constexpr (simd_supported<T>) {
+        constexpr size_t W = simd_width<T>;
+        constexpr size_t P = N / affine_gcd(N, W);
+        constexpr int D = 2 * int(N) - 1;
+        // loads start N - 1 components before the first point of the pack
+        // and end N - 1 after the last one
+        const size_t first = std::max(i, size_t(N));
+        if (first + P * W <= e * N && first + P * W + N - 1 <= size) {
+            simd_t<T> coef[D][P], add[P];
+            for (size_t j = 0; j < P; ++j)
+                for (size_t l = 0; l < W; ++l) {
+                    const int k = int((j * W + l) % N);
+                    for (int d = 0; d < D; ++d) {
+                        const int col = k + d - int(N - 1);
+                        coef[d][j][l] =
+                            col >= 0 && col < int(N) ? C[k][col] : T(0);
+                    }
+                    add[j][l] = c[k];
+                }
+            for (; i < first; i += N) affine_point(in + i, out + i, C, c);
+            for (; i + P * W <= e * N && i + P * W + N - 1 <= size;
+                 i += P * W)
+                for (size_t j = 0; j < P; ++j) {
+                    const T* p = in + i + j * W - (N - 1);
+                    simd_t<T> sum = add[j];
+#pragma GCC unroll 8
+                    for (int d = 0; d < D; ++d)
+                        sum += coef[d][j] * simd_load(p + d);
+                    simd_store(out + i + j * W, sum);
+                }
+        }
+    }
+    // i is a multiple of N
+    for (; i < e * N; i += N) affine_point(in + i, out + i, C, c);
+}
+
+// Applies the affine transform (with or without its translation) to a list,
+// as the N x N matrix C and the constant c
+template <typename T, unsigned int N>
+VecList<T, N> affine_apply(const Affine<T>& a, const VecList<T, N>& in,
+                           bool translate) {
+    static_assert(N == 3 || N == 4, "Affine transforms lists of Vec3 or Vec4");
+    T C[N][N] = {}, c[N] = {};
+    for (unsigned int k = 0; k < 3; ++k) {
+        for (unsigned int col = 0; col < 3; ++col) C[k][col] = a(k, col);
+        if constexpr (N == 3) {
+            c[k] = translate ? a(k, 3) : T(0);
+        } else {
+            C[k][3] = translate ? a(k, 3) : T(0);
+        }
+    }
+    if constexpr (N == 4) C[3][3] = 1;
+    VecList<T, N> result(in.size());
+    const T* p = in.data_flat();
+    T* q = result.data_flat();
+    parallel_for(0, in.size(), AFFINE_PARALLEL_MIN, [&](size_t b, size_t e) {
+        affine_block<T, N>(p, q, in.size(), b, e, C, c);
+    });
+    return result;
+}
+
+};  // namespace detail
+
+template <typename T>
+template <unsigned int N>
+VecList<T, N> Affine<T>::operator*(const VecList<T, N>& points) const {
+    return detail::affine_apply(*this, points, true);
+}
+
+template <typename T>
+template <unsigned int N>
+VecList<T, N> Affine<T>::apply_vectors(const VecList<T, N>& vectors) const {
+    return detail::affine_apply(*this, vectors, false);
+}
+
+};  // namespace common
@@ -2,25 +2,121 @@
  * mesh.cpp
  * Diego Royo Meneses - Dec. 2023
  *
- * 3D model loader
+ * 3D model loader and saver
  */
 
 #include "libcpp-common/mesh.h"
 
+#include "libcpp-common/detail/mapped_file.h"
+
 namespace common {
 
-Mesh load_mesh(const char* filename) {
-    std::ifstream file(filename);
+VecList4f CompactMesh::homogeneous() const {
+    VecList4f result(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        result[i] = Vec4f(vertices[i].x(), vertices[i].y(), vertices[i].z(), 1);
+    return result;
+}
 
-    if (!file.is_open())
+Mesh CompactMesh::to_mesh() const {
+    Mesh mesh;
+    mesh.vertices = homogeneous();
+    mesh.vertex_attributes = vertex_attributes;
+    mesh.face_attributes = face_attributes;
+    if (!has_16bit_indices()) {
+        mesh.faces = faces32;
+        return mesh;
+    }
+    mesh.faces.resize(faces16.size());
+    for (size_t i = 0; i < faces16.size(); ++i)
+        mesh.faces[i] = Vec3u(faces16[i][0], faces16[i][1], faces16[i][2]);
+    return mesh;
+}
+
+CompactMesh compact(const Mesh& mesh) {
+    CompactMesh result;
+    result.vertex_attributes = mesh.vertex_attributes;
+    result.face_attributes = mesh.face_attributes;
+    result.vertices.resize(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+        result.vertices[i] = Vec3f(mesh.vertices[i].x(), mesh.vertices[i].y(),
+                                   mesh.vertices[i].z());
+    if (!result.has_16bit_indices()) {
+        result.faces32 = mesh.faces;
+        return result;
+    }
+    result.faces16.resize(mesh.faces.size());
+    for (size_t i = 0; i < mesh.faces.size(); ++i)
+        for (size_t j = 0; j < 3; ++j)
+            result.faces16[i][j] = static_cast<uint16_t>(mesh.faces[i][j]);
+    return result;
+}
+
+// The loaders parse the file in place, and can split it among threads
+static detail::MappedFile open_mesh_file(const char* filename) {
+    detail::MappedFile file;
+    if (!file.open(filename))
         throw detail::CommonMeshException("Could not open file " +
                                           std::string(filename));
+    return file;
+}
+
+Mesh load_mesh(const char* filename, const AttributeMask& mask) {
+    const detail::MappedFile file = open_mesh_file(filename);
 
     // Write here all the loaders
-    if (test_ply(file)) return load_ply(file);
+    if (test_mesh_cache(file.data(), file.size()))
+        return load_mesh_cache(file.data(), file.size(), mask);
+    if (test_ply(file.data(), file.size()))
+        return load_ply(file.data(), file.size(), mask);
+    if (test_obj(file.data(), file.size()))
+        return load_obj(file.data(), file.size(), mask);
+
+    throw detail::CommonMeshException("No mesh loader found for file " +
+                                      std::string(filename));
+}
+
+CompactMesh load_compact_mesh(const char* filename,
+                              const AttributeMask& mask) {
+    const detail::MappedFile file = open_mesh_file(filename);
+
+    if (test_mesh_cache(file.data(), file.size()))
+        return load_compact_mesh_cache(file.data(), file.size(), mask);
+    if (test_ply(file.data(), file.size()))
+        return load_compact_ply(file.data(), file.size(), mask);
+    if (test_obj(file.data(), file.size()))
+        return load_compact_obj(file.data(), file.size(), mask);
 
     throw detail::CommonMeshException("No mesh loader found for file " +
                                       std::string(filename));
 }
 
-};  // namespace common
\ No newline at end of file
+static bool is_mesh_cache_filename(const std::string& filename) {
+    const std::string extension = ".cmesh";
+    return filename.size() >= extension.size() &&
+           filename.compare(filename.size() - extension.size(),
+                            extension.size(), extension) == 0;
+}
+
+template <typename MeshType>
+static void save_mesh_as(const char* filename, const MeshType& mesh) {
+    if (is_mesh_cache_filename(filename)) {
+        save_mesh_cache(filename, mesh);
+        return;
+    }
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        throw detail::CommonMeshException("Could not open file " +
+                                          std::string(filename));
+    save_ply(file, mesh);
+}
+
+void save_mesh(const char* filename, const Mesh& mesh) {
+    save_mesh_as(filename, mesh);
+}
+
+void save_mesh(const char* filename, const CompactMesh& mesh) {
+    save_mesh_as(filename, mesh);
+}
+
+};  // namespace common
@@ -0,0 +1,206 @@
+/*
+ * adjacency.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Neighbourhoods of the vertices of a mesh in flat arrays: compressed rows
+ * of vertex-face and vertex-vertex adjacency, and implicit half-edges
+ */
+
+#include "libcpp-common/mesh/adjacency.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "libcpp-common/detail/check_faces.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/radix_sort.h"
+#include "libcpp-common/mesh.h"
+
+namespace common {
+
+namespace detail {
+
+constexpr size_t ADJACENCY_PARALLEL_MIN = 1 << 14;
+
+// Offsets of the rows of n values sorted by row(i), rows without values
+// included
+template <typename Row>
+static std::vector<uint32_t> row_offsets(size_t n, size_t rows,
+                                         const Row& row) {
+    std::vector<uint32_t> offsets(rows + 1);
+    parallel_for(0, n, ADJACENCY_PARALLEL_MIN, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            // the rows after the one of i - 1 start at i
+            const size_t first = i == 0 ? 0 : row(i - 1) + 1;
+            for (size_t r = first; r <= row(i); ++r) offsets[r] = uint32_t(i);
+        }
+    });
+    for (size_t r = n == 0 ? 0 : row(n - 1) + 1; r <= rows; ++r)
+        offsets[r] = uint32_t(n);
+    return offsets;
+}
+
+// Values for which keep(i) is true, in order, counted and copied by chunks
+template <typename T, typename Keep>
+static std::vector<T> filter(const std::vector<T>& values, const Keep& keep) {
+    const size_t n = values.size();
+    std::vector<size_t> first(num_chunks(n, ADJACENCY_PARALLEL_MIN) + 1, 0);
+    parallel_chunks(0, n, ADJACENCY_PARALLEL_MIN,
+                    [&](size_t c, size_t b, size_t e) {
+                        for (size_t i = b; i < e; ++i) first[c + 1] += keep(i);
+                    });
+    for (size_t c = 1; c < first.size(); ++c) first[c] += first[c - 1];
+    std::vector<T> result(first.back());
+    parallel_chunks(0, n, ADJACENCY_PARALLEL_MIN,
+                    [&](size_t c, size_t b, size_t e) {
+                        size_t next = first[c];
+                        for (size_t i = b; i < e; ++i)
+                            if (keep(i)) result[next++] = values[i];
+                    });
+    return result;
+}
+
+// Corners 3 * f + k of the faces as (vertex << 32) | corner, sorted by
+// vertex and then by corner
+static std::vector<uint64_t> corners_by_vertex(const Mesh& mesh) {
+    check_faces(mesh.faces, mesh.vertices.size());
+    std::vector<uint64_t> corners(3 * mesh.faces.size());
+    parallel_for(0, mesh.faces.size(), ADJACENCY_PARALLEL_MIN,
+                 [&](size_t b, size_t e) {
+                     for (size_t i = b; i < e; ++i)
+                         for (unsigned int k = 0; k < 3; ++k)
+                             corners[3 * i + k] =
+                                 uint64_t(mesh.faces[i][k]) << 32 | (3 * i + k);
+                 });
+    radix_sort(corners, bit_width(mesh.vertices.size()),
+               [](uint64_t corner) { return corner >> 32; });
+    return corners;
+}
+
+// Half-edge with the key of its edge, (min << bits) | max of its vertices
+struct EdgeKey {
+    uint64_t key;
+    uint32_t half_edge;
+};
+
+};  // namespace detail
+
+Adjacency vertex_face_adjacency(const Mesh& mesh) {
+    const std::vector<uint64_t> corners = detail::corners_by_vertex(mesh);
+    std::vector<uint32_t> faces(corners.size());
+    detail::parallel_for(0, corners.size(), detail::ADJACENCY_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 faces[i] = uint32_t(corners[i]) / 3;
+                         });
+    return Adjacency(
+        detail::row_offsets(corners.size(), mesh.vertices.size(),
+                            [&](size_t i) { return corners[i] >> 32; }),
+        std::move(faces));
+}
+
+Adjacency vertex_vertex_adjacency(const Mesh& mesh) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    // both directions of every half-edge, as (from << 32) | to
+    std::vector<uint64_t> edges(6 * mesh.faces.size());
+    detail::parallel_for(
+        0, mesh.faces.size(), detail::ADJACENCY_PARALLEL_MIN,
+        [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                for (unsigned int k = 0; k < 3; ++k) {
+                    const uint64_t from = mesh.faces[i][k];
+                    const uint64_t to = mesh.faces[i][(k + 1) % 3];
+                    edges[6 * i + 2 * k] = from << 32 | to;
+                    edges[6 * i + 2 * k + 1] = to << 32 | from;
+                }
+        });
+    const unsigned int bits = detail::bit_width(mesh.vertices.size());
+    detail::radix_sort(edges, 2 * bits, [bits](uint64_t edge) {
+        return (edge >> 32) << bits | (edge & 0xffffffff);
+    });
+    // without repetitions, or edges of faces with a repeated vertex
+    edges = detail::filter(edges, [&](size_t i) {
+        return (edges[i] >> 32) != (edges[i] & 0xffffffff) &&
+               (i == 0 || edges[i] != edges[i - 1]);
+    });
+
+    std::vector<uint32_t> neighbours(edges.size());
+    detail::parallel_for(0, edges.size(), detail::ADJACENCY_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 neighbours[i] = uint32_t(edges[i]);
+                         });
+    return Adjacency(
+        detail::row_offsets(edges.size(), mesh.vertices.size(),
+                            [&](size_t i) { return edges[i] >> 32; }),
+        std::move(neighbours));
+}
+
+void HalfEdgeMesh::build(const Mesh& mesh) {
+    using detail::ADJACENCY_PARALLEL_MIN;
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    const size_t n = 3 * mesh.faces.size();
+    m_origin.resize(n);
+    detail::parallel_for(0, mesh.faces.size(), ADJACENCY_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 for (unsigned int k = 0; k < 3; ++k)
+                                     m_origin[3 * i + k] = mesh.faces[i][k];
+                         });
+
+    // half-edges of the same edge end up next to each other
+    const unsigned int bits = detail::bit_width(mesh.vertices.size());
+    std::vector<detail::EdgeKey> keys(n);
+    detail::parallel_for(0, n, ADJACENCY_PARALLEL_MIN, [&](size_t b,
+                                                          size_t e) {
+        for (size_t h = b; h < e; ++h) {
+            const uint64_t from = origin(h), to = target(h);
+            keys[h] = {std::min(from, to) << bits | std::max(from, to),
+                       uint32_t(h)};
+        }
+    });
+    detail::radix_sort(keys, 2 * bits,
+                       [](const detail::EdgeKey& k) { return k.key; });
+
+    m_twin.assign(n, NONE);
+    std::vector<size_t> non_manifold(
+        detail::num_chunks(n, ADJACENCY_PARALLEL_MIN), 0);
+    detail::parallel_chunks(
+        0, n, ADJACENCY_PARALLEL_MIN, [&](size_t c, size_t b, size_t e) {
+            // edges that start in this chunk
+            for (size_t i = b; i < e; ++i) {
+                if (i > 0 && keys[i - 1].key == keys[i].key) continue;
+                size_t last = i + 1;
+                while (last < n && keys[last].key == keys[i].key) ++last;
+                const uint32_t h = keys[i].half_edge;
+                if (last - i == 1 || origin(h) == target(h)) continue;
+                const uint32_t other = keys[i + 1].half_edge;
+                if (last - i == 2 && origin(h) == target(other)) {
+                    m_twin[h] = other;
+                    m_twin[other] = h;
+                } else {
+                    ++non_manifold[c];
+                }
+            }
+        });
+    m_non_manifold = 0;
+    for (size_t count : non_manifold) m_non_manifold += count;
+
+    // the first half-edge of each vertex, or the first one on the boundary
+    m_vertex_half_edge.assign(mesh.vertices.size(), NONE);
+    for (uint32_t h = 0; h < n; ++h) {
+        uint32_t& current = m_vertex_half_edge[m_origin[h]];
+        if (current == NONE || (m_twin[current] != NONE && m_twin[h] == NONE))
+            current = h;
+    }
+}
+
+VecList2u HalfEdgeMesh::edges() const {
+    VecList2u result;
+    for (uint32_t h = 0; h < m_origin.size(); ++h)
+        if ((m_twin[h] == NONE || h < m_twin[h]) && origin(h) != target(h))
+            result.push_back(Vec2u(origin(h), target(h)));
+    return result;
+}
+
+};  // namespace common
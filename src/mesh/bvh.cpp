@@ -0,0 +1,541 @@
+/*
+ * bvh.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Bounding volume hierarchy over the triangles of a mesh, for ray casting
+ * and closest point queries
+ */
+
+#include "libcpp-common/mesh/bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <utility>
+
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/geometry/aabb.h"
+#include "libcpp-common/mesh.h"
+
+namespace common {
+
+namespace detail {
+
+constexpr float BVH_INFINITY = std::numeric_limits<float>::infinity();
+// Ranges with less faces are binned/partitioned in a single thread
+constexpr size_t BVH_PARALLEL_MIN = 1 << 15;
+// Past this depth nodes are split in half, so that the depth of the tree (and
+// the traversal stacks) can not go over 2 * BVH_MAX_SAH_DEPTH
+constexpr size_t BVH_MAX_SAH_DEPTH = 32;
+constexpr size_t BVH_STACK_SIZE = 2 * BVH_MAX_SAH_DEPTH + 1;
+// Leaves with more faces are split even if the heuristic says otherwise
+constexpr size_t BVH_MAX_SAH_LEAF = 32;
+
+/// BUILD ///
+
+struct BVHBin {
+    AABB3f bounds;
+    size_t count = 0;
+};
+
+// Face with its bounds, the array of references is partitioned in place
+struct BVHReference {
+    AABB3f bounds;
+    uint32_t face;
+
+    float centroid(unsigned int k) const {
+        return (bounds.min[k] + bounds.max[k]) * 0.5f;
+    }
+};
+
+struct BVHBuildNode {
+    AABB3f bounds;
+    uint32_t left = 0;  // the children are left and left + 1
+    uint32_t first = 0, count = 0;
+};
+
+// Builds the tree over an array of face references that is partitioned in
+// place, so that each node reads a contiguous range of it. Both children of a
+// node are allocated at once, and the subtrees of the first levels are built
+// by different threads
+class BVHBuilder {
+   public:
+    BVHBuilder(const std::vector<BVH::Triangle>& triangles,
+               const BVHOptions& options)
+        : m_options(options),
+          m_refs(triangles.size()),
+          m_nodes(2 * triangles.size() - 1),
+          m_next(1) {
+        m_options.bins = std::max(m_options.bins, 2u);
+        m_options.max_leaf_faces = std::max(m_options.max_leaf_faces, 1u);
+        parallel_for(0, triangles.size(), 4096, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                const BVH::Triangle& tri = triangles[i];
+                AABB3f bounds;
+                bounds.extend(tri.v0);
+                bounds.extend(tri.v0 + tri.e1);
+                bounds.extend(tri.v0 + tri.e2);
+                m_refs[i] = {bounds, static_cast<uint32_t>(i)};
+            }
+        });
+    }
+
+    void build() { build(0, 0, m_refs.size(), 0, bounds(0, m_refs.size())); }
+
+    // Depth-first order, so that the left child follows its parent
+    void flatten(std::vector<BVH::Node>& nodes) const {
+        nodes.clear();
+        nodes.reserve(m_next);
+        flatten(0, nodes);
+    }
+
+    const std::vector<BVHReference>& refs() const { return m_refs; }
+
+   private:
+    BVHOptions m_options;
+    std::vector<BVHReference> m_refs;
+    std::vector<BVHBuildNode> m_nodes;
+    std::atomic<uint32_t> m_next;
+
+    // Of the faces of a node, and of their centroids
+    struct RangeBounds {
+        AABB3f faces, centroids;
+
+        void extend(const BVHReference& r) {
+            faces.extend(r.bounds);
+            centroids.extend(
+                Vec3f(r.centroid(0), r.centroid(1), r.centroid(2)));
+        }
+    };
+
+    // f(partial, ref) for the references in [begin, end), in parallel for
+    // long ranges, then merge(result, partial) for each thread
+    template <typename T, typename Func, typename Merge>
+    T reduce(size_t begin, size_t end, const T& init, const Func& f,
+             const Merge& merge) const {
+        std::vector<T> partial(num_chunks(end - begin, BVH_PARALLEL_MIN),
+                               init);
+        parallel_chunks(begin, end, BVH_PARALLEL_MIN,
+                        [&](size_t c, size_t b, size_t e) {
+                            for (size_t i = b; i < e; ++i)
+                                f(partial[c], m_refs[i]);
+                        });
+        for (size_t c = 1; c < partial.size(); ++c)
+            merge(partial[0], partial[c]);
+        return partial[0];
+    }
+
+    RangeBounds bounds(size_t begin, size_t end) const {
+        return reduce(
+            begin, end, RangeBounds(),
+            [](RangeBounds& b, const BVHReference& r) { b.extend(r); },
+            [](RangeBounds& a, const RangeBounds& b) {
+                a.faces.extend(b.faces);
+                a.centroids.extend(b.centroids);
+            });
+    }
+
+    void build(size_t index, size_t begin, size_t end, size_t depth,
+               const RangeBounds& bounds) {
+        const size_t count = end - begin;
+        BVHBuildNode& node = m_nodes[index];
+        node.bounds = bounds.faces;
+        node.first = begin;
+        node.count = count;
+        if (count <= m_options.max_leaf_faces) return;
+
+        RangeBounds children[2];
+        const size_t mid = split(begin, end, depth, bounds, children);
+        if (mid == begin || mid == end) return;  // keep as a leaf
+
+        const uint32_t left = m_next.fetch_add(2);
+        node.left = left;
+        node.count = 0;
+        auto child = [&](size_t c) {
+            if (c == 0)
+                build(left, begin, mid, depth + 1, children[0]);
+            else
+                build(left + 1, mid, end, depth + 1, children[1]);
+        };
+        if ((size_t(1) << depth) < num_threads() &&
+            count >= BVH_PARALLEL_MIN) {
+            parallel_for(0, 2, 1, [&](size_t b, size_t e) {
+                for (size_t c = b; c < e; ++c) child(c);
+            });
+        } else {
+            child(0);
+            child(1);
+        }
+    }
+
+    // Partitions the references and returns the first one of the right
+    // child, or begin/end if the node should be a leaf
+    size_t split(size_t begin, size_t end, size_t depth,
+                 const RangeBounds& bounds, RangeBounds children[2]) {
+        const size_t count = end - begin;
+        const AABB3f& centroids = bounds.centroids;
+        const Vec3f extent = centroids.max - centroids.min;
+        unsigned int largest = 0;
+        for (unsigned int k = 1; k < 3; ++k)
+            if (extent[k] > extent[largest]) largest = k;
+        if (extent[largest] <= 0) {
+            // all the centroids are the same, any split is as good
+            if (count <= BVH_MAX_SAH_LEAF) return begin;
+            return halves(begin, begin + count / 2, end, children);
+        }
+        if (depth >= BVH_MAX_SAH_DEPTH)
+            return median(begin, end, largest, children);
+
+        // small nodes do not need more bins than faces
+        const size_t bins = std::min<size_t>(m_options.bins, count);
+        Vec3f scale;
+        for (unsigned int k = 0; k < 3; ++k)
+            scale[k] = extent[k] > 0 ? bins / extent[k] : 0;
+        auto bin = [&](const BVHReference& r, unsigned int k) {
+            const float x = (r.centroid(k) - centroids.min[k]) * scale[k];
+            return std::min(static_cast<size_t>(x), bins - 1);
+        };
+
+        std::vector<BVHBin> binned = reduce(
+            begin, end, std::vector<BVHBin>(3 * bins),
+            [&](std::vector<BVHBin>& b, const BVHReference& r) {
+                for (unsigned int k = 0; k < 3; ++k) {
+                    BVHBin& target = b[k * bins + bin(r, k)];
+                    target.bounds.extend(r.bounds);
+                    target.count++;
+                }
+            },
+            [](std::vector<BVHBin>& a, const std::vector<BVHBin>& b) {
+                for (size_t i = 0; i < a.size(); ++i) {
+                    a[i].bounds.extend(b[i].bounds);
+                    a[i].count += b[i].count;
+                }
+            });
+
+        // cost of splitting after bin i, relative to intersecting a triangle
+        float best_cost = BVH_INFINITY;
+        unsigned int best_axis = 0;
+        size_t best_bin = 0;
+        std::vector<float> right_cost(bins);
+        for (unsigned int k = 0; k < 3; ++k) {
+            if (extent[k] <= 0) continue;
+            const BVHBin* axis = &binned[k * bins];
+            AABB3f right;
+            size_t right_count = 0;
+            for (size_t i = bins - 1; i > 0; --i) {
+                right.extend(axis[i].bounds);
+                right_count += axis[i].count;
+                right_cost[i - 1] = right_count * right.surface_area();
+            }
+            AABB3f left;
+            size_t left_count = 0;
+            for (size_t i = 0; i + 1 < bins; ++i) {
+                left.extend(axis[i].bounds);
+                left_count += axis[i].count;
+                if (left_count == 0 || left_count == count) continue;
+                const float cost =
+                    left_count * left.surface_area() + right_cost[i];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = k;
+                    best_bin = i;
+                }
+            }
+        }
+        best_cost = m_options.traversal_cost +
+                    best_cost / bounds.faces.surface_area();
+        if (best_cost >= count && count <= BVH_MAX_SAH_LEAF) return begin;
+        if (best_cost == BVH_INFINITY)
+            return median(begin, end, largest, children);
+
+        // partition, computing the bounds of the children on the way
+        auto left = [&](const BVHReference& r) {
+            return bin(r, best_axis) <= best_bin;
+        };
+        size_t i = begin, j = end;
+        while (true) {
+            for (; i < j && left(m_refs[i]); ++i) children[0].extend(m_refs[i]);
+            for (; i < j && !left(m_refs[j - 1]); --j)
+                children[1].extend(m_refs[j - 1]);
+            if (i == j) return i;
+            std::swap(m_refs[i], m_refs[j - 1]);
+        }
+    }
+
+    size_t median(size_t begin, size_t end, unsigned int axis,
+                  RangeBounds children[2]) {
+        const size_t mid = begin + (end - begin) / 2;
+        auto first = m_refs.begin();
+        std::nth_element(first + begin, first + mid, first + end,
+                         [&](const BVHReference& a, const BVHReference& b) {
+                             return a.centroid(axis) < b.centroid(axis);
+                         });
+        return halves(begin, mid, end, children);
+    }
+
+    size_t halves(size_t begin, size_t mid, size_t end,
+                  RangeBounds children[2]) const {
+        children[0] = bounds(begin, mid);
+        children[1] = bounds(mid, end);
+        return mid;
+    }
+
+    void flatten(size_t index, std::vector<BVH::Node>& nodes) const {
+        const BVHBuildNode& node = m_nodes[index];
+        const size_t i = nodes.size();
+        nodes.push_back({node.bounds, node.first, node.count});
+        if (node.count > 0) return;
+        flatten(node.left, nodes);
+        nodes[i].index = nodes.size();
+        flatten(node.left + 1, nodes);
+    }
+};
+
+template <typename Vertices, typename Faces>
+static std::vector<BVH::Triangle> bvh_triangles(const Vertices& vertices,
+                                                const Faces& faces) {
+    std::vector<BVH::Triangle> triangles(faces.size());
+    parallel_for(0, faces.size(), 4096, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            Vec3f v[3];
+            for (unsigned int k = 0; k < 3; ++k) {
+                const size_t j = faces[i][k];
+                if (j >= vertices.size())
+                    throw CommonMeshException(
+                        "BVH Face " + std::to_string(i) +
+                        " references a vertex that does not exist");
+                v[k] = Vec3f(vertices[j][0], vertices[j][1], vertices[j][2]);
+            }
+            triangles[i] = {v[0], v[1] - v[0], v[2] - v[0]};
+        }
+    });
+    return triangles;
+}
+
+/// QUERIES ///
+
+// Entry of the ray in the box (see AABB::intersect), or infinity if it does
+// not intersect it within [tmin, tmax]
+static inline float bvh_slab(const BVH::Node& node, const Vec3f& origin,
+                             const Vec3f& inverse, float tmin, float tmax) {
+    return node.box.intersect(origin, inverse, tmin, tmax) ? tmin
+                                                             : BVH_INFINITY;
+}
+
+// Ericson, Real-Time Collision Detection, 5.1.5
+static Vec3f bvh_closest_point(const BVH::Triangle& tri, const Vec3f& p) {
+    const Vec3f& a = tri.v0;
+    const Vec3f &ab = tri.e1, &ac = tri.e2;
+    const Vec3f ap = p - a;
+    const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) return a;
+    const Vec3f b = a + ab;
+    const Vec3f bp = p - b;
+    const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) return b;
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+    const Vec3f c = a + ac;
+    const Vec3f cp = p - c;
+    const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) return c;
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    const float sum = va + vb + vc;
+    if (sum == 0) return a;  // degenerate triangle
+    return a + ab * (vb / sum) + ac * (vc / sum);
+}
+
+static inline Vec3f bvh_inverse(const Vec3f& direction) {
+    return Vec3f(1 / direction.x(), 1 / direction.y(), 1 / direction.z());
+}
+
+// Node to visit, and the distance (t or squared distance) at which it starts
+struct BVHStackEntry {
+    uint32_t node;
+    float distance;
+};
+
+};  // namespace detail
+
+void BVH::build(const Mesh& mesh, const BVHOptions& options) {
+    build(detail::bvh_triangles(mesh.vertices, mesh.faces), options);
+}
+
+void BVH::build(const CompactMesh& mesh, const BVHOptions& options) {
+    build(mesh.visit_faces([&](const auto& faces) {
+              return detail::bvh_triangles(mesh.vertices, faces);
+          }),
+          options);
+}
+
+void BVH::build(std::vector<Triangle>&& triangles,
+                const BVHOptions& options) {
+    m_nodes.clear();
+    m_triangles.clear();
+    m_faces.clear();
+    if (triangles.empty()) return;
+
+    detail::BVHBuilder builder(triangles, options);
+    builder.build();
+    builder.flatten(m_nodes);
+
+    const std::vector<detail::BVHReference>& refs = builder.refs();
+    m_faces.resize(refs.size());
+    m_triangles.resize(refs.size());
+    detail::parallel_for(0, refs.size(), 4096, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            m_faces[i] = refs[i].face;
+            m_triangles[i] = triangles[refs[i].face];
+        }
+    });
+}
+
+size_t BVH::depth() const {
+    if (m_nodes.empty()) return 0;
+    size_t result = 0;
+    std::vector<std::pair<uint32_t, size_t>> stack = {{0, 1}};
+    while (!stack.empty()) {
+        const auto [i, d] = stack.back();
+        stack.pop_back();
+        result = std::max(result, d);
+        if (m_nodes[i].is_leaf()) continue;
+        stack.push_back({i + 1, d + 1});
+        stack.push_back({m_nodes[i].index, d + 1});
+    }
+    return result;
+}
+
+RayHit BVH::intersect(const Ray& ray) const {
+    using namespace detail;
+    RayHit hit;
+    if (m_nodes.empty()) return hit;
+    const Vec3f inverse = bvh_inverse(ray.direction);
+    float tmax = ray.tmax;
+
+    BVHStackEntry stack[BVH_STACK_SIZE];
+    size_t top = 0;
+    const float t = bvh_slab(m_nodes[0], ray.origin, inverse, ray.tmin, tmax);
+    if (t != BVH_INFINITY) stack[top++] = {0, t};
+    while (top > 0) {
+        const BVHStackEntry entry = stack[--top];
+        if (entry.distance > tmax) continue;
+        uint32_t i = entry.node;
+        while (!m_nodes[i].is_leaf()) {
+            uint32_t near = i + 1, far = m_nodes[i].index;
+            float t_near = bvh_slab(m_nodes[near], ray.origin, inverse,
+                                    ray.tmin, tmax);
+            float t_far = bvh_slab(m_nodes[far], ray.origin, inverse,
+                                   ray.tmin, tmax);
+            if (t_far < t_near) {
+                std::swap(near, far);
+                std::swap(t_near, t_far);
+            }
+            if (t_near == BVH_INFINITY) break;
+            if (t_far != BVH_INFINITY) stack[top++] = {far, t_far};
+            i = near;
+        }
+        const Node& node = m_nodes[i];
+        if (!node.is_leaf()) continue;
+        for (uint32_t j = node.index; j < node.index + node.count; ++j) {
+            const Triangle& tri = m_triangles[j];
+            if (intersect_triangle(ray, tri.v0, tri.e1, tri.e2, tmax, hit.t,
+                                   hit.u, hit.v)) {
+                tmax = hit.t;
+                hit.face = m_faces[j];
+            }
+        }
+    }
+    return hit;
+}
+
+bool BVH::occluded(const Ray& ray) const {
+    using namespace detail;
+    if (m_nodes.empty()) return false;
+    const Vec3f inverse = bvh_inverse(ray.direction);
+
+    uint32_t stack[BVH_STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+        if (bvh_slab(node, ray.origin, inverse, ray.tmin, ray.tmax) ==
+            BVH_INFINITY)
+            continue;
+        if (!node.is_leaf()) {
+            stack[top++] = node.index;
+            stack[top++] = &node - m_nodes.data() + 1;
+            continue;
+        }
+        float t, u, v;
+        for (uint32_t j = node.index; j < node.index + node.count; ++j) {
+            const Triangle& tri = m_triangles[j];
+            if (intersect_triangle(ray, tri.v0, tri.e1, tri.e2, ray.tmax, t,
+                                   u, v))
+                return true;
+        }
+    }
+    return false;
+}
+
+ClosestPoint BVH::closest_point(const Vec3f& p, float max_distance) const {
+    using namespace detail;
+    ClosestPoint closest;
+    if (m_nodes.empty()) return closest;
+    float best = max_distance * max_distance;
+
+    BVHStackEntry stack[BVH_STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = {0, m_nodes[0].box.distance2(p)};
+    while (top > 0) {
+        const BVHStackEntry entry = stack[--top];
+        if (entry.distance > best) continue;
+        const Node& node = m_nodes[entry.node];
+        if (!node.is_leaf()) {
+            BVHStackEntry near = {entry.node + 1,
+                                  m_nodes[entry.node + 1].box.distance2(p)};
+            BVHStackEntry far = {node.index,
+                                 m_nodes[node.index].box.distance2(p)};
+            if (far.distance < near.distance) std::swap(near, far);
+            if (far.distance <= best) stack[top++] = far;
+            if (near.distance <= best) stack[top++] = near;
+            continue;
+        }
+        for (uint32_t j = node.index; j < node.index + node.count; ++j) {
+            const Vec3f q = bvh_closest_point(m_triangles[j], p);
+            const float d2 = (q - p).module2();
+            if (d2 <= best) {
+                best = d2;
+                closest = {q, d2, m_faces[j]};
+            }
+        }
+    }
+    return closest;
+}
+
+void BVH::intersect(const Ray* rays, size_t n, RayHit* hits) const {
+    detail::parallel_for(0, n, 256, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) hits[i] = intersect(rays[i]);
+    });
+}
+
+void BVH::occluded(const Ray* rays, size_t n, bool* occluded) const {
+    detail::parallel_for(0, n, 256, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) occluded[i] = this->occluded(rays[i]);
+    });
+}
+
+void BVH::closest_point(const Vec3f* points, size_t n, ClosestPoint* closest,
+                        float max_distance) const {
+    detail::parallel_for(0, n, 256, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i)
+            closest[i] = closest_point(points[i], max_distance);
+    });
+}
+
+};  // namespace common
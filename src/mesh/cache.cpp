@@ -0,0 +1,406 @@
+/*
+ * cache.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Native mesh format, to open preprocessed meshes without parsing them
+ */
+
+#include "libcpp-common/mesh/cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <variant>
+
+#include "libcpp-common/detail/endian.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/mesh.h"
+
+namespace common {
+
+namespace detail {
+
+static_assert(sizeof(Vec3f) == 3 * sizeof(float) &&
+                  sizeof(Vec<uint16_t, 3>) == 3 * sizeof(uint16_t) &&
+                  sizeof(Vec3u) == 3 * sizeof(unsigned int),
+              "Vec must not have padding to be stored in a mesh cache");
+
+static constexpr char MESH_CACHE_MAGIC[8] = {'C',  'M',    'E',  'S',
+                                             'H', '\r', '\n', '\x1a'};
+
+// Both 64 bytes, so that all the arrays stay aligned
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t index_size;  // 2 or 4 bytes
+    uint32_t num_vertex_attributes;
+    uint32_t num_face_attributes;
+    uint64_t num_vertices;
+    uint64_t num_faces;
+    uint64_t vertices_offset;
+    uint64_t faces_offset;
+    uint64_t reserved;
+};
+
+struct MeshCacheChannel {
+    uint64_t offset;
+    uint32_t type;
+    uint32_t name_length;
+    char name[48];
+};
+
+static_assert(sizeof(MeshCacheHeader) == 64 && sizeof(MeshCacheChannel) == 64,
+              "Unexpected mesh cache header size");
+
+// Calls f(value) with a value of the C++ type of a mesh cache type
+template <typename Func>
+static void mesh_cache_dispatch(MeshCacheType type, const Func& f) {
+    switch (type) {
+        case MeshCacheType::Int8: return f(int8_t());
+        case MeshCacheType::UInt8: return f(uint8_t());
+        case MeshCacheType::Int16: return f(int16_t());
+        case MeshCacheType::UInt16: return f(uint16_t());
+        case MeshCacheType::Int32: return f(int32_t());
+        case MeshCacheType::UInt32: return f(uint32_t());
+        case MeshCacheType::Float32: return f(float());
+        case MeshCacheType::Float64: return f(double());
+    }
+    throw CommonMeshException("Mesh cache has an unknown attribute type " +
+                              std::to_string(static_cast<uint32_t>(type)));
+}
+
+static size_t attribute_type_size(MeshCacheType type) {
+    size_t result = 0;
+    mesh_cache_dispatch(type, [&](auto value) { result = sizeof(value); });
+    return result;
+}
+
+MeshCacheLayout read_mesh_cache(const uint8_t* data, size_t size) {
+    if (!test_mesh_cache(data, size))
+        throw CommonMeshException("Not a mesh cache file");
+    if (!machine_is_little_endian())
+        throw CommonMeshException(
+            "Mesh cache files are only supported on little-endian machines");
+    MeshCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != MESH_CACHE_VERSION)
+        throw CommonMeshException("Mesh cache has version " +
+                                  std::to_string(header.version) +
+                                  ", expected " +
+                                  std::to_string(MESH_CACHE_VERSION));
+
+    // all sizes are checked, so that corrupted files cannot read outside
+    auto check = [&](uint64_t offset, uint64_t count, size_t item_size) {
+        if (offset % MESH_CACHE_ALIGNMENT != 0 || offset > size ||
+            count > (size - offset) / item_size)
+            throw CommonMeshException("Mesh cache file is truncated");
+        return data + offset;
+    };
+    const size_t index_size = CompactMesh::fits_16bit(header.num_vertices)
+                                  ? sizeof(uint16_t)
+                                  : sizeof(unsigned int);
+    if (header.index_size != index_size)
+        throw CommonMeshException("Mesh cache has invalid indices");
+
+    MeshCacheLayout layout;
+    layout.num_vertices = header.num_vertices;
+    layout.num_faces = header.num_faces;
+    layout.vertices = reinterpret_cast<const Vec3f*>(
+        check(header.vertices_offset, header.num_vertices, sizeof(Vec3f)));
+    layout.faces =
+        check(header.faces_offset, header.num_faces, 3 * index_size);
+
+    const uint64_t num_channels = uint64_t(header.num_vertex_attributes) +
+                                  header.num_face_attributes;
+    check(sizeof(header), num_channels, sizeof(MeshCacheChannel));
+    for (uint64_t i = 0; i < num_channels; ++i) {
+        MeshCacheChannel channel;
+        std::memcpy(&channel, data + sizeof(header) + i * sizeof(channel),
+                    sizeof(channel));
+        const bool is_vertex = i < header.num_vertex_attributes;
+        if (channel.name_length > sizeof(channel.name))
+            throw CommonMeshException("Mesh cache has an invalid attribute");
+        MeshCacheLayout::Channel result;
+        result.name = std::string(channel.name, channel.name_length);
+        result.type = static_cast<MeshCacheType>(channel.type);
+        result.data = check(
+            channel.offset, is_vertex ? header.num_vertices : header.num_faces,
+            attribute_type_size(result.type));
+        (is_vertex ? layout.vertex_attributes : layout.face_attributes)
+            .push_back(result);
+    }
+    return layout;
+}
+
+// Copies in parallel, so that the pages of the mapped file are read by
+// several threads
+static constexpr size_t MESH_CACHE_COPY_CHUNK = 1 << 22;
+
+static void parallel_copy(void* dst, const void* src, size_t bytes) {
+    parallel_for(0, bytes, MESH_CACHE_COPY_CHUNK, [&](size_t b, size_t e) {
+        std::memcpy(static_cast<uint8_t*>(dst) + b,
+                    static_cast<const uint8_t*>(src) + b, e - b);
+    });
+}
+
+static void copy_attributes(
+    const std::vector<MeshCacheLayout::Channel>& channels, size_t count,
+    const AttributeMask& mask, bool is_vertex, MeshAttributes& attributes) {
+    for (const auto& channel : channels) {
+        if (is_vertex ? !mask.vertex_contains(channel.name)
+                      : !mask.face_contains(channel.name))
+            continue;
+        mesh_cache_dispatch(channel.type, [&](auto value) {
+            using T = decltype(value);
+            auto& values = attributes.set(channel.name, std::vector<T>(count));
+            parallel_copy(values.data(), channel.data, count * sizeof(T));
+        });
+    }
+}
+
+static CompactMesh compact_mesh_from(const MeshCacheLayout& layout,
+                                     const AttributeMask& mask) {
+    CompactMesh mesh;
+    mesh.vertices.resize(layout.num_vertices);
+    parallel_copy(mesh.vertices.data(), layout.vertices,
+                  layout.num_vertices * sizeof(Vec3f));
+    if (mesh.has_16bit_indices()) {
+        mesh.faces16.resize(layout.num_faces);
+        parallel_copy(mesh.faces16.data(), layout.faces,
+                      layout.num_faces * sizeof(mesh.faces16[0]));
+    } else {
+        mesh.faces32.resize(layout.num_faces);
+        parallel_copy(mesh.faces32.data(), layout.faces,
+                      layout.num_faces * sizeof(Vec3u));
+    }
+    copy_attributes(layout.vertex_attributes, layout.num_vertices, mask, true,
+                    mesh.vertex_attributes);
+    copy_attributes(layout.face_attributes, layout.num_faces, mask, false,
+                    mesh.face_attributes);
+    return mesh;
+}
+
+static Mesh mesh_from(const MeshCacheLayout& layout,
+                      const AttributeMask& mask) {
+    Mesh mesh;
+    mesh.vertices.resize(layout.num_vertices);
+    parallel_for(0, layout.num_vertices, MESH_CACHE_COPY_CHUNK / sizeof(Vec4f),
+                 [&](size_t b, size_t e) {
+                     for (size_t i = b; i < e; ++i) {
+                         const Vec3f& v = layout.vertices[i];
+                         mesh.vertices[i] = Vec4f(v.x(), v.y(), v.z(), 1);
+                     }
+                 });
+    mesh.faces.resize(layout.num_faces);
+    if (CompactMesh::fits_16bit(layout.num_vertices)) {
+        const uint16_t* faces = static_cast<const uint16_t*>(layout.faces);
+        unsigned int* out = mesh.faces.data_flat();
+        parallel_for(0, 3 * layout.num_faces, MESH_CACHE_COPY_CHUNK / 4,
+                     [&](size_t b, size_t e) {
+                         std::copy(faces + b, faces + e, out + b);
+                     });
+    } else {
+        parallel_copy(mesh.faces.data(), layout.faces,
+                      layout.num_faces * sizeof(Vec3u));
+    }
+    copy_attributes(layout.vertex_attributes, layout.num_vertices, mask, true,
+                    mesh.vertex_attributes);
+    copy_attributes(layout.face_attributes, layout.num_faces, mask, false,
+                    mesh.face_attributes);
+    return mesh;
+}
+
+static size_t mesh_cache_align(size_t offset) {
+    return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT *
+           MESH_CACHE_ALIGNMENT;
+}
+
+};  // namespace detail
+
+bool test_mesh_cache(const uint8_t* data, size_t size) {
+    return size >= sizeof(detail::MeshCacheHeader) &&
+           std::memcmp(data, detail::MESH_CACHE_MAGIC,
+                       sizeof(detail::MESH_CACHE_MAGIC)) == 0;
+}
+
+Mesh load_mesh_cache(const uint8_t* data, size_t size,
+                     const AttributeMask& mask) {
+    return detail::mesh_from(detail::read_mesh_cache(data, size), mask);
+}
+
+CompactMesh load_compact_mesh_cache(const uint8_t* data, size_t size,
+                                    const AttributeMask& mask) {
+    return detail::compact_mesh_from(detail::read_mesh_cache(data, size),
+                                     mask);
+}
+
+void save_mesh_cache(const char* filename, const CompactMesh& mesh) {
+    using namespace detail;
+    if (!machine_is_little_endian())
+        throw CommonMeshException(
+            "Mesh cache files are only supported on little-endian machines");
+
+    // arrays to write, in order
+    std::vector<std::pair<const void*, size_t>> blobs;
+    const size_t index_size =
+        mesh.has_16bit_indices() ? sizeof(uint16_t) : sizeof(unsigned int);
+    blobs.emplace_back(mesh.vertices.data(),
+                       mesh.vertices.size() * sizeof(Vec3f));
+    blobs.emplace_back(mesh.has_16bit_indices()
+                           ? static_cast<const void*>(mesh.faces16.data())
+                           : static_cast<const void*>(mesh.faces32.data()),
+                       mesh.num_faces() * 3 * index_size);
+    std::vector<MeshCacheChannel> channels;
+    for (const MeshAttributes* attributes :
+         {&mesh.vertex_attributes, &mesh.face_attributes}) {
+        const size_t count = attributes == &mesh.vertex_attributes
+                                 ? mesh.vertices.size()
+                                 : mesh.num_faces();
+        for (const auto& attribute : *attributes) {
+            const std::string& name = attribute.first;
+            MeshCacheChannel channel = {};
+            if (name.size() > sizeof(channel.name))
+                throw CommonMeshException("Attribute name is too long: " +
+                                          name);
+            channel.type = static_cast<uint32_t>(std::visit(
+                [](const auto& values) {
+                    using T =
+                        typename std::decay_t<decltype(values)>::value_type;
+                    return mesh_cache_type_of<T>();
+                },
+                attribute.second));
+            channel.name_length = static_cast<uint32_t>(name.size());
+            std::memcpy(channel.name, name.data(), name.size());
+            std::visit(
+                [&](const auto& values) {
+                    if (values.size() != count)
+                        throw CommonMeshException(
+                            "Attribute " + name + " has " +
+                            std::to_string(values.size()) +
+                            " values, expected " + std::to_string(count));
+                    blobs.emplace_back(values.data(),
+                                       values.size() * sizeof(values[0]));
+                },
+                attribute.second);
+            channels.push_back(channel);
+        }
+    }
+
+    // offsets of every array
+    std::vector<size_t> offsets;
+    size_t offset =
+        sizeof(MeshCacheHeader) + channels.size() * sizeof(MeshCacheChannel);
+    for (const auto& blob : blobs) {
+        offset = mesh_cache_align(offset);
+        offsets.push_back(offset);
+        offset += blob.second;
+    }
+    for (size_t i = 0; i < channels.size(); ++i)
+        channels[i].offset = offsets[2 + i];
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.index_size = static_cast<uint32_t>(index_size);
+    header.num_vertex_attributes =
+        static_cast<uint32_t>(mesh.vertex_attributes.num_channels());
+    header.num_face_attributes =
+        static_cast<uint32_t>(mesh.face_attributes.num_channels());
+    header.num_vertices = mesh.vertices.size();
+    header.num_faces = mesh.num_faces();
+    header.vertices_offset = offsets[0];
+    header.faces_offset = offsets[1];
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        throw CommonMeshException("Could not open file " +
+                                  std::string(filename));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(channels.data()),
+               channels.size() * sizeof(MeshCacheChannel));
+    size_t position =
+        sizeof(MeshCacheHeader) + channels.size() * sizeof(MeshCacheChannel);
+    const char padding[MESH_CACHE_ALIGNMENT] = {};
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        file.write(padding, offsets[i] - position);
+        file.write(static_cast<const char*>(blobs[i].first), blobs[i].second);
+        position = offsets[i] + blobs[i].second;
+    }
+    if (!file) throw CommonMeshException("Could not write mesh cache");
+}
+
+void save_mesh_cache(const char* filename, const Mesh& mesh) {
+    save_mesh_cache(filename, compact(mesh));
+}
+
+/// MAPPED MESH ///
+
+void MappedMesh::open(const char* filename) {
+    close();
+    detail::MappedFile file;
+    if (!file.open(filename))
+        throw detail::CommonMeshException("Could not open file " +
+                                          std::string(filename));
+    m_layout = detail::read_mesh_cache(file.data(), file.size());
+    m_file = std::move(file);
+}
+
+void MappedMesh::close() {
+    m_file.close();
+    m_layout = detail::MeshCacheLayout();
+}
+
+bool MappedMesh::has_16bit_indices() const {
+    return CompactMesh::fits_16bit(num_vertices());
+}
+
+const Vec<uint16_t, 3>* MappedMesh::faces16() const {
+    if (!has_16bit_indices()) return nullptr;
+    return static_cast<const Vec<uint16_t, 3>*>(m_layout.faces);
+}
+
+const Vec3u* MappedMesh::faces32() const {
+    if (has_16bit_indices()) return nullptr;
+    return static_cast<const Vec3u*>(m_layout.faces);
+}
+
+Vec3u MappedMesh::face(size_t i) const {
+    if (has_16bit_indices())
+        return Vec3u(faces16()[i][0], faces16()[i][1], faces16()[i][2]);
+    return faces32()[i];
+}
+
+bool MappedMesh::has_vertex_attribute(const std::string& name) const {
+    return std::any_of(m_layout.vertex_attributes.begin(),
+                       m_layout.vertex_attributes.end(),
+                       [&](const auto& c) { return c.name == name; });
+}
+
+bool MappedMesh::has_face_attribute(const std::string& name) const {
+    return std::any_of(m_layout.face_attributes.begin(),
+                       m_layout.face_attributes.end(),
+                       [&](const auto& c) { return c.name == name; });
+}
+
+const void* MappedMesh::attribute(
+    const std::vector<detail::MeshCacheLayout::Channel>& channels,
+    const std::string& name, detail::MeshCacheType type) {
+    for (const auto& channel : channels) {
+        if (channel.name != name) continue;
+        if (channel.type != type)
+            throw detail::CommonMeshException(
+                "Attribute " + name + " has a different type");
+        return channel.data;
+    }
+    throw detail::CommonMeshException("Attribute not found: " + name);
+}
+
+CompactMesh MappedMesh::to_compact_mesh(const AttributeMask& mask) const {
+    return detail::compact_mesh_from(m_layout, mask);
+}
+
+Mesh MappedMesh::to_mesh(const AttributeMask& mask) const {
+    return detail::mesh_from(m_layout, mask);
+}
+
+};  // namespace common
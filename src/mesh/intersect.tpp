@@ -0,0 +1,209 @@
+/*
+ * intersect.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Ray-triangle intersection kernels, for one ray and one triangle, and SIMD
+ * versions for one ray and a packet of triangles or a packet of rays and
+ * one triangle
+ */
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "libcpp-common/detail/simd.h"
+
+namespace common {
+
+namespace detail {
+
+template <size_t W>
+using simd_mask_n_t = simd_n_t<int32_t, W>;
+
+// Möller-Trumbore test for W lanes, each one with its ray and triangle (one
+// of the two being broadcast). hit is the mask of lanes with a hit with
+// tmin <= t <= tmax. Lanes with NaN values (degenerate triangles, for which
+// det = 0) never hit
+template <size_t W, typename V = simd_n_t<float, W>>
+inline void intersect_lanes(const V (&o)[3], const V (&d)[3],
+                            const V (&v0)[3], const V (&e1)[3],
+                            const V (&e2)[3], const V& tmin, const V& tmax,
+                            V& t, V& u, V& v, simd_mask_n_t<W>& hit) {
+    // p = d x e2
+    const V px = d[1] * e2[2] - d[2] * e2[1];
+    const V py = d[2] * e2[0] - d[0] * e2[2];
+    const V pz = d[0] * e2[1] - d[1] * e2[0];
+    const V inv_det = 1.0f / (e1[0] * px + e1[1] * py + e1[2] * pz);
+    const V sx = o[0] - v0[0], sy = o[1] - v0[1], sz = o[2] - v0[2];
+    u = (sx * px + sy * py + sz * pz) * inv_det;
+    // q = s x e1
+    const V qx = sy * e1[2] - sz * e1[1];
+    const V qy = sz * e1[0] - sx * e1[2];
+    const V qz = sx * e1[1] - sy * e1[0];
+    v = (d[0] * qx + d[1] * qy + d[2] * qz) * inv_det;
+    t = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * inv_det;
+    hit = (u >= 0) & (v >= 0) & (u + v <= 1) & (t >= tmin) & (t <= tmax);
+}
+
+template <size_t W>
+inline uint32_t lane_bits(const simd_mask_n_t<W>& mask) {
+    uint32_t bits = 0;
+    for (size_t i = 0; i < W; ++i) bits |= uint32_t(mask[i] != 0) << i;
+    return bits;
+}
+
+template <size_t W>
+inline void load_rows(const float (&rows)[3][W],
+                      simd_n_t<float, W> (&result)[3]) {
+    for (unsigned int k = 0; k < 3; ++k) simd_load_n<W>(rows[k], result[k]);
+}
+
+template <size_t W>
+inline void broadcast(const Vec3f& p, simd_n_t<float, W> (&result)[3]) {
+    for (unsigned int k = 0; k < 3; ++k) simd_broadcast_n<W>(p[k], result[k]);
+}
+
+// Intersection of a ray with all the lanes of a packet
+template <size_t W, typename V = simd_n_t<float, W>>
+inline void intersect_packet(const Ray& ray, const TrianglePacket<W>& tris,
+                             V& t, V& u, V& v, simd_mask_n_t<W>& hit) {
+    V o[3], d[3], v0[3], e1[3], e2[3], tmin, tmax;
+    broadcast<W>(ray.origin, o);
+    broadcast<W>(ray.direction, d);
+    load_rows<W>(tris.v0, v0);
+    load_rows<W>(tris.e1, e1);
+    load_rows<W>(tris.e2, e2);
+    simd_broadcast_n<W>(ray.tmin, tmin);
+    simd_broadcast_n<W>(ray.tmax, tmax);
+    intersect_lanes<W>(o, d, v0, e1, e2, tmin, tmax, t, u, v, hit);
+}
+
+};  // namespace detail
+
+inline bool intersect_triangle(const Ray& ray, const Vec3f& v0,
+                               const Vec3f& e1, const Vec3f& e2, float tmax,
+                               float& t, float& u, float& v) {
+    const Vec3f& d = ray.direction;
+    const float px = d[1] * e2[2] - d[2] * e2[1];
+    const float py = d[2] * e2[0] - d[0] * e2[2];
+    const float pz = d[0] * e2[1] - d[1] * e2[0];
+    const float det = e1[0] * px + e1[1] * py + e1[2] * pz;
+    if (det == 0) return false;
+    const float inv_det = 1 / det;
+    const float sx = ray.origin[0] - v0[0];
+    const float sy = ray.origin[1] - v0[1];
+    const float sz = ray.origin[2] - v0[2];
+    const float bu = (sx * px + sy * py + sz * pz) * inv_det;
+    if (bu < 0 || bu > 1) return false;
+    const float qx = sy * e1[2] - sz * e1[1];
+    const float qy = sz * e1[0] - sx * e1[2];
+    const float qz = sx * e1[1] - sy * e1[0];
+    const float bv = (d[0] * qx + d[1] * qy + d[2] * qz) * inv_det;
+    if (bv < 0 || bu + bv > 1) return false;
+    const float bt = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * inv_det;
+    if (bt < ray.tmin || bt > tmax) return false;
+    t = bt;
+    u = bu;
+    v = bv;
+    return true;
+}
+
+template <size_t W>
+TrianglePacket<W>::TrianglePacket() {
+    static_assert(W == 4 || W == 8, "Packets have 4 or 8 lanes");
+    std::memset(this, 0, sizeof(*this));
+}
+
+template <size_t W>
+void TrianglePacket<W>::set(size_t lane, const Vec3f& p0, const Vec3f& p1,
+                            const Vec3f& p2) {
+    for (unsigned int k = 0; k < 3; ++k) {
+        v0[k][lane] = p0[k];
+        e1[k][lane] = p1[k] - p0[k];
+        e2[k][lane] = p2[k] - p0[k];
+    }
+}
+
+template <size_t W>
+RayPacket<W>::RayPacket() {
+    static_assert(W == 4 || W == 8, "Packets have 4 or 8 lanes");
+    std::memset(this, 0, sizeof(*this));
+    for (size_t i = 0; i < W; ++i) {
+        tmin[i] = std::numeric_limits<float>::infinity();
+        tmax[i] = -std::numeric_limits<float>::infinity();
+    }
+}
+
+template <size_t W>
+void RayPacket<W>::set(size_t lane, const Ray& ray) {
+    for (unsigned int k = 0; k < 3; ++k) {
+        origin[k][lane] = ray.origin[k];
+        direction[k][lane] = ray.direction[k];
+    }
+    tmin[lane] = ray.tmin;
+    tmax[lane] = ray.tmax;
+}
+
+template <size_t W>
+HitPacket<W>::HitPacket() {
+    for (size_t i = 0; i < W; ++i) {
+        t[i] = std::numeric_limits<float>::infinity();
+        u[i] = v[i] = 0;
+        face[i] = NO_FACE;
+    }
+}
+
+template <size_t W>
+RayHit intersect(const Ray& ray, const TrianglePacket<W>& triangles) {
+    detail::simd_n_t<float, W> t, u, v;
+    detail::simd_mask_n_t<W> mask;
+    detail::intersect_packet<W>(ray, triangles, t, u, v, mask);
+    RayHit hit;
+    for (size_t i = 0; i < W; ++i)
+        if (mask[i] && t[i] <= hit.t) hit = {t[i], u[i], v[i], uint32_t(i)};
+    return hit;
+}
+
+template <size_t W>
+uint32_t intersect_mask(const Ray& ray, const TrianglePacket<W>& triangles) {
+    detail::simd_n_t<float, W> t, u, v;
+    detail::simd_mask_n_t<W> mask;
+    detail::intersect_packet<W>(ray, triangles, t, u, v, mask);
+    return detail::lane_bits<W>(mask);
+}
+
+template <size_t W>
+uint32_t intersect(const RayPacket<W>& rays, const Vec3f& v0, const Vec3f& v1,
+                   const Vec3f& v2, uint32_t face, HitPacket<W>& hits) {
+    using V = detail::simd_n_t<float, W>;
+    V o[3], d[3], p0[3], e1[3], e2[3], tmin, tmax, closest;
+    detail::load_rows<W>(rays.origin, o);
+    detail::load_rows<W>(rays.direction, d);
+    detail::broadcast<W>(v0, p0);
+    detail::broadcast<W>(v1 - v0, e1);
+    detail::broadcast<W>(v2 - v0, e2);
+    detail::simd_load_n<W>(rays.tmin, tmin);
+    detail::simd_load_n<W>(rays.tmax, tmax);
+    detail::simd_load_n<W>(hits.t, closest);
+    tmax = tmax < closest ? tmax : closest;
+    V t, u, v;
+    detail::simd_mask_n_t<W> mask;
+    detail::intersect_lanes<W>(o, d, p0, e1, e2, tmin, tmax, t, u, v, mask);
+
+    // keep the current values of the lanes that were not hit
+    auto update = [&](auto* target, const auto& values) {
+        std::decay_t<decltype(values)> current;
+        detail::simd_load_n<W>(target, current);
+        current = mask ? values : current;
+        detail::simd_store_n<W>(target, current);
+    };
+    update(hits.t, t);
+    update(hits.u, u);
+    update(hits.v, v);
+    detail::simd_n_t<uint32_t, W> faces;
+    detail::simd_broadcast_n<W>(face, faces);
+    update(hits.face, faces);
+    return detail::lane_bits<W>(mask);
+}
+
+};  // namespace common
@@ -0,0 +1,272 @@
+/*
+ * normals.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Face normals, and vertex normals and tangents averaged from the faces
+ */
+
+#include "libcpp-common/mesh/normals.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "libcpp-common/detail/check_faces.h"
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/simd.h"
+#include "libcpp-common/mesh.h"
+
+namespace common {
+
+namespace detail {
+
+constexpr size_t NORMALS_PARALLEL_MIN = 1 << 13;
+constexpr size_t NORMALS_BLOCK = simd_width<float>;
+
+// Cross product of the edges of a block of NORMALS_BLOCK faces (its length
+// is twice the area of the face), and the dot products of the two edges of
+// each corner, which give its angle with it. Lanes past count are 0
+struct FaceBlock {
+    float cross[3][NORMALS_BLOCK];
+    float dot[3][NORMALS_BLOCK];
+
+    FaceBlock(const Mesh& mesh, size_t first, size_t count) {
+        using V = simd_t<float>;
+        float p[3][3][NORMALS_BLOCK] = {};  // corner, axis, lane
+        for (size_t i = 0; i < count; ++i) {
+            const Vec3u& f = mesh.faces[first + i];
+            for (unsigned int c = 0; c < 3; ++c)
+                for (unsigned int k = 0; k < 3; ++k)
+                    p[c][k][i] = mesh.vertices[f[c]][k];
+        }
+        V e1[3], e2[3];
+        for (unsigned int k = 0; k < 3; ++k) {
+            const V a = simd_load(p[0][k]);
+            e1[k] = simd_load(p[1][k]) - a;
+            e2[k] = simd_load(p[2][k]) - a;
+        }
+        simd_store(cross[0], e1[1] * e2[2] - e1[2] * e2[1]);
+        simd_store(cross[1], e1[2] * e2[0] - e1[0] * e2[2]);
+        simd_store(cross[2], e1[0] * e2[1] - e1[1] * e2[0]);
+        // corners 1 and 2 have edges (-e1, e2 - e1) and (-e2, e1 - e2)
+        V d[3] = {V{}, V{}, V{}};
+        for (unsigned int k = 0; k < 3; ++k) {
+            d[0] += e1[k] * e2[k];
+            d[1] += e1[k] * (e1[k] - e2[k]);
+            d[2] += e2[k] * (e2[k] - e1[k]);
+        }
+        for (unsigned int c = 0; c < 3; ++c) simd_store(dot[c], d[c]);
+    }
+
+    float length(size_t i) const {
+        return std::sqrt(cross[0][i] * cross[0][i] +
+                         cross[1][i] * cross[1][i] +
+                         cross[2][i] * cross[2][i]);
+    }
+};
+
+// Calls f(first_face, block) for consecutive blocks of faces, in parallel
+template <typename Func>
+void for_face_blocks(const Mesh& mesh, const Func& f) {
+    const size_t blocks =
+        (mesh.faces.size() + NORMALS_BLOCK - 1) / NORMALS_BLOCK;
+    parallel_for(0, blocks, NORMALS_PARALLEL_MIN / NORMALS_BLOCK,
+                 [&](size_t b, size_t e) {
+                     for (size_t i = b; i < e; ++i) {
+                         const size_t first = i * NORMALS_BLOCK;
+                         const FaceBlock block(
+                             mesh, first,
+                             std::min(NORMALS_BLOCK,
+                                      mesh.faces.size() - first));
+                         f(first, block);
+                     }
+                 });
+}
+
+// Sums f(face, corner) over the corners of each vertex, calling
+// store(vertex, sum) with the result. Each vertex is gathered by one thread
+template <typename T, typename Func, typename Store>
+void gather_corners(const Mesh& mesh, const Adjacency& adjacency,
+                    const Func& f, const Store& store) {
+    parallel_for(0, mesh.vertices.size(), NORMALS_PARALLEL_MIN,
+                 [&](size_t b, size_t e) {
+                     for (size_t v = b; v < e; ++v) {
+                         T sum = T();
+                         for (uint32_t face : adjacency[v]) {
+                             const Vec3u& corners = mesh.faces[face];
+                             const unsigned int c = corners[0] == v   ? 0
+                                                    : corners[1] == v ? 1
+                                                                      : 2;
+                             sum += f(face, c);
+                         }
+                         store(v, sum);
+                     }
+                 });
+}
+
+// Float vertex attributes, reusing the storage of the ones that are there.
+// They are all added before taking references to them, as adding one may
+// move the others
+template <size_t N>
+static std::array<std::vector<float>*, N> float_channels(
+    Mesh& mesh, const char* const (&names)[N]) {
+    MeshAttributes& attributes = mesh.vertex_attributes;
+    const size_t n = mesh.vertices.size();
+    for (const char* name : names) {
+        if (attributes.has(name)) {
+            const auto* values =
+                std::get_if<std::vector<float>>(&attributes.data(name));
+            if (values != nullptr && values->size() == n) continue;
+        }
+        attributes.set(name, std::vector<float>(n));
+    }
+    std::array<std::vector<float>*, N> result;
+    for (size_t i = 0; i < N; ++i) result[i] = &attributes.get<float>(names[i]);
+    return result;
+}
+
+struct TangentFrame {
+    Vec3f tangent, bitangent;
+
+    TangentFrame& operator+=(const TangentFrame& other) {
+        tangent += other.tangent;
+        bitangent += other.bitangent;
+        return *this;
+    }
+};
+
+static inline Vec3f normalized_or_zero(const Vec3f& v) {
+    const float length = v.module();
+    return length > 0 ? v / length : Vec3f(0);
+}
+
+};  // namespace detail
+
+VecList3f compute_face_normals(const Mesh& mesh) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    VecList3f normals(mesh.faces.size());
+    detail::for_face_blocks(
+        mesh, [&](size_t first, const detail::FaceBlock& block) {
+            const size_t count =
+                std::min(detail::NORMALS_BLOCK, normals.size() - first);
+            for (size_t i = 0; i < count; ++i) {
+                const float length = block.length(i);
+                const float scale = length > 0 ? 1 / length : 0;
+                normals[first + i] =
+                    Vec3f(block.cross[0][i] * scale,
+                          block.cross[1][i] * scale,
+                          block.cross[2][i] * scale);
+            }
+        });
+    return normals;
+}
+
+void compute_vertex_normals(Mesh& mesh, NormalWeighting weighting) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    // unit normal and weight of each corner
+    const size_t n = mesh.faces.size();
+    VecList3f normals(n);
+    std::vector<float> weights(3 * n);
+    detail::for_face_blocks(mesh, [&](size_t first,
+                                      const detail::FaceBlock& block) {
+        const size_t count = std::min(detail::NORMALS_BLOCK, n - first);
+        for (size_t i = 0; i < count; ++i) {
+            const float length = block.length(i);
+            const float scale = length > 0 ? 1 / length : 0;
+            normals[first + i] =
+                Vec3f(block.cross[0][i] * scale, block.cross[1][i] * scale,
+                      block.cross[2][i] * scale);
+            for (unsigned int c = 0; c < 3; ++c) {
+                float& w = weights[3 * (first + i) + c];
+                if (weighting == NormalWeighting::Uniform)
+                    w = 1;
+                else if (weighting == NormalWeighting::Area)
+                    w = length;
+                else  // |e1 x e2| = |e1| |e2| sin, for every corner
+                    w = std::atan2(length, block.dot[c][i]);
+            }
+        }
+    });
+
+    const Adjacency adjacency = vertex_face_adjacency(mesh);
+    const auto channels = detail::float_channels(mesh, {"nx", "ny", "nz"});
+    std::vector<float>& nx = *channels[0];
+    std::vector<float>& ny = *channels[1];
+    std::vector<float>& nz = *channels[2];
+    detail::gather_corners<Vec3f>(
+        mesh, adjacency,
+        [&](uint32_t face, unsigned int c) {
+            return normals[face] * weights[3 * face + c];
+        },
+        [&](size_t v, const Vec3f& sum) {
+            const Vec3f normal = detail::normalized_or_zero(sum);
+            nx[v] = normal[0];
+            ny[v] = normal[1];
+            nz[v] = normal[2];
+        });
+}
+
+void compute_vertex_tangents(Mesh& mesh) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    const MeshAttributes& attributes = mesh.vertex_attributes;
+    if (!attributes.has("u") || !attributes.has("v"))
+        throw detail::CommonMeshException(
+            "Tangents need the texture coordinates u, v");
+    if (!attributes.has("nx") || !attributes.has("ny") ||
+        !attributes.has("nz"))
+        compute_vertex_normals(mesh);
+    const std::vector<float> u = attributes.get_as<float>("u");
+    const std::vector<float> v = attributes.get_as<float>("v");
+    const std::vector<float> nx = attributes.get_as<float>("nx");
+    const std::vector<float> ny = attributes.get_as<float>("ny");
+    const std::vector<float> nz = attributes.get_as<float>("nz");
+
+    // directions of increasing u and v of each face (Lengyel 2001), scaled
+    // by its area so that larger faces contribute more
+    const size_t n = mesh.faces.size();
+    std::vector<detail::TangentFrame> frames(n);
+    auto face_frame = [&](size_t i) {
+        const Vec3u& f = mesh.faces[i];
+        const Vec3f p0 = mesh.vertices[f[0]].xyz();
+        const Vec3f e1 = mesh.vertices[f[1]].xyz() - p0;
+        const Vec3f e2 = mesh.vertices[f[2]].xyz() - p0;
+        const float du1 = u[f[1]] - u[f[0]], dv1 = v[f[1]] - v[f[0]];
+        const float du2 = u[f[2]] - u[f[0]], dv2 = v[f[2]] - v[f[0]];
+        const float det = du1 * dv2 - du2 * dv1;
+        // 0 for degenerate texture coordinates
+        const float scale = det != 0 ? cross(e1, e2).module() / det : 0;
+        frames[i] = {(e1 * dv2 - e2 * dv1) * scale,
+                     (e2 * du1 - e1 * du2) * scale};
+    };
+    detail::parallel_for(0, n, detail::NORMALS_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i) face_frame(i);
+                         });
+
+    const Adjacency adjacency = vertex_face_adjacency(mesh);
+    const auto channels =
+        detail::float_channels(mesh, {"tx", "ty", "tz", "tw"});
+    std::vector<float>& tx = *channels[0];
+    std::vector<float>& ty = *channels[1];
+    std::vector<float>& tz = *channels[2];
+    std::vector<float>& tw = *channels[3];
+    detail::gather_corners<detail::TangentFrame>(
+        mesh, adjacency,
+        [&](uint32_t face, unsigned int) { return frames[face]; },
+        [&](size_t i, const detail::TangentFrame& sum) {
+            // Gram-Schmidt, against the normal
+            const Vec3f normal(nx[i], ny[i], nz[i]);
+            const Vec3f t = detail::normalized_or_zero(
+                sum.tangent - normal * dot(normal, sum.tangent));
+            tx[i] = t[0];
+            ty[i] = t[1];
+            tz[i] = t[2];
+            tw[i] = dot(cross(normal, t), sum.bitangent) < 0 ? -1.0f : 1.0f;
+        });
+}
+
+};  // namespace common
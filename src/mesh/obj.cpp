@@ -0,0 +1,524 @@
+/*
+ * obj.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Wavefront OBJ loader
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/mesh.h"
+#include "libcpp-common/mesh/triangulate.h"
+
+namespace common {
+
+namespace detail {
+
+// Minimum number of bytes parsed by each thread
+static constexpr size_t OBJ_CHUNK = 1 << 20;
+// Minimum number of corners/faces processed by each thread
+static constexpr size_t OBJ_PARALLEL_CHUNK = 1 << 16;
+// Corner without texture coordinates or normal
+static constexpr uint32_t OBJ_MISSING = std::numeric_limits<uint32_t>::max();
+
+static inline bool obj_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* obj_skip_spaces(const char* p, const char* end) {
+    while (p < end && obj_is_space(*p)) ++p;
+    return p;
+}
+
+template <typename T>
+static inline const char* obj_parse(const char* p, const char* end,
+                                    T& value) {
+    p = obj_skip_spaces(p, end);
+    if (p < end && *p == '+') ++p;
+    const auto [next, error] = std::from_chars(p, end, value);
+    if (error != std::errc())
+        throw CommonMeshException("OBJ Unexpected value: " +
+                                  std::string(p, std::find(p, end, '\n')));
+    return next;
+}
+
+enum class ObjLine { Other, Position, TexCoord, Normal, Face };
+
+// Type of the line at p, which is moved after its keyword
+static ObjLine obj_line_type(const char*& p, const char* eol) {
+    const char* q = p;
+    while (q < eol && !obj_is_space(*q)) ++q;
+    const size_t length = static_cast<size_t>(q - p);
+    ObjLine result = ObjLine::Other;
+    if (length == 1 && p[0] == 'v') result = ObjLine::Position;
+    if (length == 1 && p[0] == 'f') result = ObjLine::Face;
+    if (length == 2 && p[0] == 'v' && p[1] == 't') result = ObjLine::TexCoord;
+    if (length == 2 && p[0] == 'v' && p[1] == 'n') result = ObjLine::Normal;
+    p = q;
+    return result;
+}
+
+// Number of corners of the face line at p, up to a comment
+static size_t obj_face_corners(const char* p, const char* eol) {
+    size_t count = 0;
+    while (true) {
+        p = obj_skip_spaces(p, eol);
+        if (p == eol || *p == '#') return count;
+        ++count;
+        while (p < eol && !obj_is_space(*p)) ++p;
+    }
+}
+
+// Calls f(type, p, eol) for each line of [begin, end), with p after the
+// keyword
+template <typename LineFunc>
+static void obj_for_each_line(const char* begin, const char* end,
+                              const LineFunc& f) {
+    for (const char* p = begin; p < end;) {
+        const char* eol = std::find(p, end, '\n');
+        const char* q = obj_skip_spaces(p, eol);
+        const ObjLine type = obj_line_type(q, eol);
+        if (type != ObjLine::Other) f(type, q, eol);
+        p = eol + 1;
+    }
+}
+
+struct ObjCounts {
+    size_t positions = 0, texcoords = 0, normals = 0, faces = 0, corners = 0;
+
+    void operator+=(const ObjCounts& o) {
+        positions += o.positions;
+        texcoords += o.texcoords;
+        normals += o.normals;
+        faces += o.faces;
+        corners += o.corners;
+    }
+};
+
+// Contents of the file, with the corners of the faces resolved to
+// zero-based indices
+struct ObjData {
+    std::vector<Vec3f> positions;
+    std::vector<Vec2f> texcoords;
+    std::vector<Vec3f> normals;
+    std::vector<uint32_t> corner_v, corner_t, corner_n;  // _t, _n if needed
+    std::vector<size_t> face_first;  // first corner of each face, and end
+};
+
+// Index of an element (1-based, or negative to count back from the last
+// one that was defined) to zero-based
+static inline uint32_t obj_resolve(long long index, size_t defined,
+                                   size_t total) {
+    const long long result =
+        index < 0 ? static_cast<long long>(defined) + index : index - 1;
+    if (index == 0 || result < 0 || static_cast<size_t>(result) >= total)
+        throw CommonMeshException("OBJ Invalid index: " +
+                                  std::to_string(index));
+    return static_cast<uint32_t>(result);
+}
+
+// Parses the v, v/vt, v//vn or v/vt/vn corners of a face line to
+// zero-based (v, vt, vn) indices
+static void obj_parse_face(const char* p, const char* eol, const ObjCounts& at,
+                           const ObjCounts& total, bool with_texcoords,
+                           bool with_normals, std::vector<Vec3u>& corners) {
+    corners.clear();
+    while (true) {
+        p = obj_skip_spaces(p, eol);
+        if (p == eol || *p == '#') return;
+        long long index;
+        p = obj_parse(p, eol, index);
+        Vec3u corner(obj_resolve(index, at.positions, total.positions),
+                     OBJ_MISSING, OBJ_MISSING);
+        if (p < eol && *p == '/') {
+            ++p;
+            if (p < eol && *p != '/') {
+                p = obj_parse(p, eol, index);
+                if (with_texcoords)
+                    corner[1] = obj_resolve(index, at.texcoords,
+                                            total.texcoords);
+            }
+            if (p < eol && *p == '/') {
+                p = obj_parse(p + 1, eol, index);
+                if (with_normals)
+                    corner[2] = obj_resolve(index, at.normals, total.normals);
+            }
+        }
+        corners.push_back(corner);
+    }
+}
+
+// Parses the file in line-aligned chunks: a first pass counts the items of
+// each chunk, so that in the second one each chunk knows where its items go
+static ObjData obj_parse_file(const char* begin, const char* end,
+                              bool with_texcoords, bool with_normals) {
+    const std::vector<const char*> bounds = line_chunks(begin, end, OBJ_CHUNK);
+    const size_t chunks = bounds.size() - 1;
+
+    std::vector<ObjCounts> first(chunks + 1);  // items before each chunk
+    parallel_chunks(0, chunks, 1, [&](size_t, size_t b, size_t e) {
+        for (size_t c = b; c < e; ++c) {
+            ObjCounts& counts = first[c + 1];
+            obj_for_each_line(
+                bounds[c], bounds[c + 1],
+                [&](ObjLine type, const char* p, const char* eol) {
+                    if (type == ObjLine::Position) ++counts.positions;
+                    if (type == ObjLine::TexCoord) ++counts.texcoords;
+                    if (type == ObjLine::Normal) ++counts.normals;
+                    // faces with less than 3 corners are ignored
+                    const size_t n = type == ObjLine::Face
+                                         ? obj_face_corners(p, eol)
+                                         : 0;
+                    if (n >= 3) {
+                        ++counts.faces;
+                        counts.corners += n;
+                    }
+                });
+        }
+    });
+    for (size_t c = 0; c < chunks; ++c) first[c + 1] += first[c];
+    const ObjCounts total = first[chunks];
+    if (total.corners >= OBJ_MISSING)
+        throw CommonMeshException("OBJ Too many faces");
+
+    ObjData data;
+    data.positions.resize(total.positions);
+    data.texcoords.resize(total.texcoords);
+    data.normals.resize(total.normals);
+    data.corner_v.resize(total.corners);
+    if (with_texcoords) data.corner_t.resize(total.corners);
+    if (with_normals) data.corner_n.resize(total.corners);
+    data.face_first.resize(total.faces + 1);
+    data.face_first[total.faces] = total.corners;
+
+    parallel_chunks(0, chunks, 1, [&](size_t, size_t b, size_t e) {
+        std::vector<Vec3u> corners;
+        for (size_t c = b; c < e; ++c) {
+            ObjCounts at = first[c];
+            obj_for_each_line(
+                bounds[c], bounds[c + 1],
+                [&](ObjLine type, const char* p, const char* eol) {
+                    switch (type) {
+                        case ObjLine::Position: {
+                            Vec3f& v = data.positions[at.positions++];
+                            for (unsigned int i = 0; i < 3; ++i)
+                                p = obj_parse(p, eol, v[i]);
+                            break;
+                        }
+                        case ObjLine::TexCoord: {
+                            // v is optional
+                            Vec2f& t = data.texcoords[at.texcoords++];
+                            p = obj_parse(p, eol, t[0]);
+                            p = obj_skip_spaces(p, eol);
+                            t[1] = 0;
+                            if (p < eol && *p != '#') obj_parse(p, eol, t[1]);
+                            break;
+                        }
+                        case ObjLine::Normal: {
+                            Vec3f& n = data.normals[at.normals++];
+                            for (unsigned int i = 0; i < 3; ++i)
+                                p = obj_parse(p, eol, n[i]);
+                            break;
+                        }
+                        case ObjLine::Face: {
+                            obj_parse_face(p, eol, at, total, with_texcoords,
+                                           with_normals, corners);
+                            if (corners.size() < 3) break;
+                            data.face_first[at.faces++] = at.corners;
+                            for (const Vec3u& corner : corners) {
+                                data.corner_v[at.corners] = corner[0];
+                                if (with_texcoords)
+                                    data.corner_t[at.corners] = corner[1];
+                                if (with_normals)
+                                    data.corner_n[at.corners] = corner[2];
+                                ++at.corners;
+                            }
+                            break;
+                        }
+                        case ObjLine::Other: break;
+                    }
+                });
+        }
+    });
+    return data;
+}
+
+// Lock-free hash set of the corners with distinct (v, vt, vn), filled in
+// parallel. Slots store the first corner (lowest index) with each key, so
+// that the result does not depend on the order of the insertions
+class ObjCornerSet {
+   public:
+    explicit ObjCornerSet(const ObjData& data) : m_data(data) {
+        const size_t corners = data.corner_v.size();
+        size_t capacity = 1;
+        while (capacity < corners + corners / 4 + 1) capacity *= 2;
+        m_mask = capacity - 1;
+        m_slots = std::vector<std::atomic<uint32_t>>(capacity);
+        parallel_for(0, capacity, OBJ_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                m_slots[i].store(OBJ_MISSING, std::memory_order_relaxed);
+        });
+    }
+
+    void insert(uint32_t c) {
+        for (size_t i = hash(c) & m_mask;; i = (i + 1) & m_mask) {
+            uint32_t current = m_slots[i].load(std::memory_order_relaxed);
+            if (current == OBJ_MISSING &&
+                m_slots[i].compare_exchange_strong(current, c))
+                return;
+            // current is the corner in the slot, which only changes to
+            // another corner with the same key
+            if (!same_key(current, c)) continue;
+            while (c < current &&
+                   !m_slots[i].compare_exchange_weak(current, c)) {
+            }
+            return;
+        }
+    }
+
+    // First corner with the key of c, after all the insertions
+    uint32_t find(uint32_t c) const {
+        for (size_t i = hash(c) & m_mask;; i = (i + 1) & m_mask) {
+            const uint32_t current =
+                m_slots[i].load(std::memory_order_relaxed);
+            if (same_key(current, c)) return current;
+        }
+    }
+
+   private:
+    const ObjData& m_data;
+    std::vector<std::atomic<uint32_t>> m_slots;
+    size_t m_mask;
+
+    uint32_t key(const std::vector<uint32_t>& v, uint32_t c) const {
+        return v.empty() ? 0 : v[c];
+    }
+    bool same_key(uint32_t a, uint32_t b) const {
+        return m_data.corner_v[a] == m_data.corner_v[b] &&
+               key(m_data.corner_t, a) == key(m_data.corner_t, b) &&
+               key(m_data.corner_n, a) == key(m_data.corner_n, b);
+    }
+    size_t hash(uint32_t c) const {
+        uint64_t h = m_data.corner_v[c] * 0x9E3779B97F4A7C15ull;
+        h ^= key(m_data.corner_t, c) * 0xC2B2AE3D27D4EB4Full;
+        h ^= key(m_data.corner_n, c) * 0x165667B19E3779F9ull;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+// Vertex of each corner, numbering the distinct (v, vt, vn) in the order in
+// which they are first used. first_corners gets the first corner of each
+// vertex
+static std::vector<uint32_t> obj_unique_vertices(
+    const ObjData& data, std::vector<uint32_t>& first_corners) {
+    const size_t corners = data.corner_v.size();
+    ObjCornerSet set(data);
+    parallel_for(0, corners, OBJ_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+        for (size_t c = b; c < e; ++c) set.insert(static_cast<uint32_t>(c));
+    });
+
+    std::vector<uint32_t> vertex(corners);  // first corner, then vertex
+    std::vector<size_t> chunk_vertices(
+        num_chunks(corners, OBJ_PARALLEL_CHUNK) + 1, 0);
+    parallel_chunks(0, corners, OBJ_PARALLEL_CHUNK,
+                    [&](size_t chunk, size_t b, size_t e) {
+                        for (size_t c = b; c < e; ++c) {
+                            vertex[c] = set.find(static_cast<uint32_t>(c));
+                            chunk_vertices[chunk + 1] += vertex[c] == c;
+                        }
+                    });
+    for (size_t i = 1; i < chunk_vertices.size(); ++i)
+        chunk_vertices[i] += chunk_vertices[i - 1];
+
+    first_corners.resize(chunk_vertices.back());
+    std::vector<uint32_t> first_vertex(corners);  // of the first corners
+    parallel_chunks(0, corners, OBJ_PARALLEL_CHUNK,
+                    [&](size_t chunk, size_t b, size_t e) {
+                        size_t next = chunk_vertices[chunk];
+                        for (size_t c = b; c < e; ++c) {
+                            if (vertex[c] != c) continue;
+                            first_vertex[c] = static_cast<uint32_t>(next);
+                            first_corners[next++] = static_cast<uint32_t>(c);
+                        }
+                    });
+    parallel_for(0, corners, OBJ_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+        for (size_t c = b; c < e; ++c) vertex[c] = first_vertex[vertex[c]];
+    });
+    return vertex;
+}
+
+// Where the mesh is stored (see PlyOutput), positions with a stride of 3 or
+// 4 floats and 16 or 32-bit indices
+struct ObjOutput {
+    float* vertices = nullptr;
+    size_t vertex_stride = 0;
+    uint16_t* faces16 = nullptr;
+    unsigned int* faces32 = nullptr;
+
+    void set_vertex(size_t i, const Vec3f& v) const {
+        std::memcpy(vertices + i * vertex_stride, v.data(), 3 * sizeof(float));
+    }
+    void set_index(size_t k, uint32_t index) const {
+        if (faces16 != nullptr)
+            faces16[k] = static_cast<uint16_t>(index);
+        else
+            faces32[k] = index;
+    }
+};
+
+static ObjOutput obj_allocate(size_t num_vertices, size_t num_triangles,
+                              Mesh& mesh) {
+    mesh.vertices.assign(num_vertices, Vec4f(0, 0, 0, 1));
+    mesh.faces.resize(num_triangles);
+    ObjOutput out;
+    out.vertices = mesh.vertices.data_flat();
+    out.vertex_stride = 4;
+    out.faces32 = mesh.faces.data_flat();
+    return out;
+}
+
+static ObjOutput obj_allocate(size_t num_vertices, size_t num_triangles,
+                              CompactMesh& mesh) {
+    mesh.vertices.resize(num_vertices);
+    ObjOutput out;
+    out.vertices = mesh.vertices.data_flat();
+    out.vertex_stride = 3;
+    if (CompactMesh::fits_16bit(num_vertices)) {
+        mesh.faces16.resize(num_triangles);
+        out.faces16 = mesh.faces16.data_flat();
+    } else {
+        mesh.faces32.resize(num_triangles);
+        out.faces32 = mesh.faces32.data_flat();
+    }
+    return out;
+}
+
+// Copies a component of the texture coordinates/normals of the first corner
+// of each vertex as an attribute
+template <typename Item>
+static void obj_copy_attribute(const std::vector<Item>& items,
+                               const std::vector<uint32_t>& corner_items,
+                               const std::vector<uint32_t>& first_corners,
+                               unsigned int component, const std::string& name,
+                               MeshAttributes& attributes) {
+    auto& values =
+        attributes.set(name, std::vector<float>(first_corners.size()));
+    parallel_for(0, values.size(), OBJ_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            const uint32_t item = corner_items[first_corners[i]];
+            values[i] = item == OBJ_MISSING ? 0.f : items[item][component];
+        }
+    });
+}
+
+template <typename MeshType>
+static MeshType load_obj_as(const uint8_t* data, size_t size,
+                            const AttributeMask& mask) {
+    const bool with_texcoords =
+        mask.vertex_contains("u") || mask.vertex_contains("v");
+    const bool with_normals = mask.vertex_contains("nx") ||
+                              mask.vertex_contains("ny") ||
+                              mask.vertex_contains("nz");
+    const char* text = reinterpret_cast<const char*>(data);
+    ObjData obj =
+        obj_parse_file(text, text + size, with_texcoords, with_normals);
+    if (obj.texcoords.empty()) obj.corner_t.clear();
+    if (obj.normals.empty()) obj.corner_n.clear();
+    const bool with_attributes =
+        !obj.corner_t.empty() || !obj.corner_n.empty();
+
+    // vertices are the positions unless they have different attributes in
+    // different faces
+    std::vector<uint32_t> first_corners, vertex;
+    if (with_attributes) vertex = obj_unique_vertices(obj, first_corners);
+    const std::vector<uint32_t>& corner_vertex =
+        with_attributes ? vertex : obj.corner_v;
+    const size_t num_vertices =
+        with_attributes ? first_corners.size() : obj.positions.size();
+
+    MeshType mesh;
+    const size_t num_faces = obj.face_first.size() - 1;
+    const size_t num_corners = obj.corner_v.size();
+    const ObjOutput out =
+        obj_allocate(num_vertices, num_corners - 2 * num_faces, mesh);
+    parallel_for(0, num_vertices, OBJ_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i)
+            out.set_vertex(i, obj.positions[with_attributes
+                                                ? obj.corner_v[first_corners[i]]
+                                                : i]);
+    });
+    const char* uv_names[] = {"u", "v"};
+    const char* normal_names[] = {"nx", "ny", "nz"};
+    for (unsigned int k = 0; k < 2 && !obj.corner_t.empty(); ++k)
+        if (mask.vertex_contains(uv_names[k]))
+            obj_copy_attribute(obj.texcoords, obj.corner_t, first_corners, k,
+                               uv_names[k], mesh.vertex_attributes);
+    for (unsigned int k = 0; k < 3 && !obj.corner_n.empty(); ++k)
+        if (mask.vertex_contains(normal_names[k]))
+            obj_copy_attribute(obj.normals, obj.corner_n, first_corners, k,
+                               normal_names[k], mesh.vertex_attributes);
+
+    // faces with n corners have n - 2 triangles, so the triangles of face f
+    // start at face_first[f] - 2 f
+    parallel_for(0, num_faces, OBJ_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+        std::vector<Vec3f> points;
+        std::vector<unsigned int> split;
+        for (size_t f = b; f < e; ++f) {
+            const size_t c0 = obj.face_first[f];
+            const size_t n = obj.face_first[f + 1] - c0;
+            const size_t t0 = c0 - 2 * f;
+            if (n == 3) {
+                for (size_t k = 0; k < 3; ++k)
+                    out.set_index(3 * t0 + k, corner_vertex[c0 + k]);
+                continue;
+            }
+            points.resize(n);
+            for (size_t k = 0; k < n; ++k)
+                points[k] = obj.positions[obj.corner_v[c0 + k]];
+            split.resize(3 * (n - 2));
+            triangulate_polygon(points.data(), n, split.data());
+            for (size_t k = 0; k < split.size(); ++k)
+                out.set_index(3 * t0 + k, corner_vertex[c0 + split[k]]);
+        }
+    });
+    return mesh;
+}
+
+};  // namespace detail
+
+bool test_obj(const uint8_t* data, size_t size) {
+    const char* p = reinterpret_cast<const char*>(data);
+    const char* end = p + std::min<size_t>(size, 4096);
+    // skip empty and comment lines
+    while (p < end) {
+        p = detail::obj_skip_spaces(p, end);
+        if (p < end && *p == '#') p = std::find(p, end, '\n');
+        if (p == end || *p != '\n') break;
+        ++p;
+    }
+    const char* q = p;
+    while (q < end && !detail::obj_is_space(*q) && *q != '\n') ++q;
+    const std::string keyword(p, q);
+    for (const char* k : {"v", "vt", "vn", "vp", "f", "l", "p", "o", "g", "s",
+                          "mtllib", "usemtl"})
+        if (keyword == k) return q < end;
+    return false;
+}
+
+Mesh load_obj(const uint8_t* data, size_t size, const AttributeMask& mask) {
+    return detail::load_obj_as<Mesh>(data, size, mask);
+}
+
+CompactMesh load_compact_obj(const uint8_t* data, size_t size,
+                             const AttributeMask& mask) {
+    return detail::load_obj_as<CompactMesh>(data, size, mask);
+}
+
+};  // namespace common
@@ -0,0 +1,385 @@
+/*
+ * optimize.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Reordering of the faces and vertices of a mesh for the vertex caches of
+ * the GPU and the memory caches of the CPU
+ */
+
+#include "libcpp-common/mesh/optimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "libcpp-common/detail/check_faces.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/geometry/space_filling_curve.h"
+#include "libcpp-common/mesh.h"
+
+namespace common {
+
+namespace detail {
+
+constexpr uint32_t OPTIMIZE_NONE = std::numeric_limits<uint32_t>::max();
+
+// Forsyth's scoring: vertices in the cache score by their position, and
+// vertices with few faces left are favoured so that they do not become
+// isolated faces to be rendered later
+constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+constexpr unsigned int FORSYTH_MAX_CACHE = 32;
+// Valences with a precomputed score
+constexpr unsigned int FORSYTH_MAX_VALENCE = 32;
+
+constexpr size_t FETCH_LINE_BYTES = 64;
+constexpr size_t FETCH_CACHE_LINES = 16384 / FETCH_LINE_BYTES;
+
+/// TIPSIFY ///
+
+// Sander, Nehab and Barczak. Fast triangle reordering for vertex locality
+// and reduced overdraw (2007). Emits the faces around a fanning vertex, and
+// moves to the neighbour that is still in the cache and has the most faces
+// left that will fit in it, or to the most recent vertex with faces left
+class Tipsify {
+   public:
+    Tipsify(const Mesh& mesh, unsigned int cache_size)
+        : m_faces(mesh.faces),
+          m_adjacency(vertex_face_adjacency(mesh)),
+          m_live(mesh.vertices.size()),
+          m_cache_time(mesh.vertices.size(), 0),
+          m_emitted(mesh.faces.size(), false),
+          m_cache_size(cache_size) {
+        for (size_t v = 0; v < m_live.size(); ++v)
+            m_live[v] = m_adjacency.degree(v);
+    }
+
+    std::vector<uint32_t> run() {
+        std::vector<uint32_t> order;
+        order.reserve(m_faces.size());
+        // timestamps start past the cache size, so every vertex misses once
+        m_time = m_cache_size + 1;
+        uint32_t fan = skip_dead_end();
+        while (fan != OPTIMIZE_NONE) {
+            m_candidates.clear();
+            for (uint32_t face : m_adjacency[fan]) {
+                if (m_emitted[face]) continue;
+                m_emitted[face] = true;
+                order.push_back(face);
+                for (unsigned int k = 0; k < 3; ++k) {
+                    const uint32_t v = m_faces[face][k];
+                    m_dead_end.push_back(v);
+                    m_candidates.push_back(v);
+                    --m_live[v];
+                    if (m_time - m_cache_time[v] > m_cache_size)
+                        m_cache_time[v] = m_time++;
+                }
+            }
+            fan = next_vertex();
+        }
+        return order;
+    }
+
+   private:
+    const VecList3u& m_faces;
+    const Adjacency m_adjacency;
+    std::vector<uint32_t> m_live;  // faces of each vertex not emitted yet
+    std::vector<size_t> m_cache_time;
+    std::vector<bool> m_emitted;
+    std::vector<uint32_t> m_dead_end;  // recently used vertices
+    std::vector<uint32_t> m_candidates;
+    const size_t m_cache_size;
+    size_t m_time = 0;
+    size_t m_cursor = 0;  // vertices before it have no faces left
+
+    uint32_t next_vertex() {
+        uint32_t best = OPTIMIZE_NONE;
+        size_t best_priority = 0;
+        for (uint32_t v : m_candidates) {
+            if (m_live[v] == 0) continue;
+            // in the cache after emitting all its faces (each one adding two
+            // vertices at most), the oldest one first. 1 otherwise
+            size_t priority = 1;
+            const size_t age = m_time - m_cache_time[v];
+            if (age + 2 * size_t(m_live[v]) <= m_cache_size) priority += age;
+            if (priority > best_priority) {
+                best = v;
+                best_priority = priority;
+            }
+        }
+        return best == OPTIMIZE_NONE ? skip_dead_end() : best;
+    }
+
+    uint32_t skip_dead_end() {
+        while (!m_dead_end.empty()) {
+            const uint32_t v = m_dead_end.back();
+            m_dead_end.pop_back();
+            if (m_live[v] > 0) return v;
+        }
+        while (m_cursor < m_live.size() && m_live[m_cursor] == 0) ++m_cursor;
+        return m_cursor < m_live.size() ? uint32_t(m_cursor) : OPTIMIZE_NONE;
+    }
+};
+
+/// FORSYTH ///
+
+// Forsyth. Linear-speed vertex cache optimisation (2006). Greedily emits the
+// face with the highest score (the sum of the scores of its vertices) among
+// the ones of the vertices in a simulated LRU cache, updating only the
+// scores of those vertices after each face
+class Forsyth {
+   public:
+    Forsyth(const Mesh& mesh, unsigned int cache_size)
+        : m_faces(mesh.faces),
+          m_adjacency(vertex_face_adjacency(mesh)),
+          m_live_faces(m_adjacency.indices()),
+          m_live(mesh.vertices.size()),
+          m_score(mesh.vertices.size()),
+          m_face_score(mesh.faces.size(), 0),
+          m_emitted(mesh.faces.size(), false),
+          m_cache_size(std::clamp(cache_size, 4u, FORSYTH_MAX_CACHE)) {
+        for (unsigned int i = 0; i < m_cache_size; ++i)
+            m_cache_score[i] =
+                i < 3 ? FORSYTH_LAST_TRIANGLE_SCORE
+                      : std::pow(1.0f - float(i - 3) / float(m_cache_size - 3),
+                                 FORSYTH_CACHE_DECAY_POWER);
+        for (unsigned int i = 1; i < FORSYTH_MAX_VALENCE; ++i)
+            m_valence_score[i] = valence_score(i);
+        for (size_t v = 0; v < m_live.size(); ++v) {
+            m_live[v] = m_adjacency.degree(v);
+            m_score[v] = score(-1, m_live[v]);
+        }
+    }
+
+    std::vector<uint32_t> run() {
+        const size_t n = m_faces.size();
+        uint32_t best = OPTIMIZE_NONE;
+        float best_score = -1;
+        for (size_t i = 0; i < n; ++i) {
+            const Vec3u& f = m_faces[i];
+            m_face_score[i] = m_score[f[0]] + m_score[f[1]] + m_score[f[2]];
+            if (m_face_score[i] > best_score) {
+                best = uint32_t(i);
+                best_score = m_face_score[i];
+            }
+        }
+
+        std::vector<uint32_t> order;
+        order.reserve(n);
+        std::vector<uint32_t> cache, next_cache;
+        size_t cursor = 0;  // faces before it have been emitted
+        while (order.size() < n) {
+            if (best == OPTIMIZE_NONE) {
+                // none of the faces of the cache is left, start elsewhere
+                while (m_emitted[cursor]) ++cursor;
+                best = uint32_t(cursor);
+            }
+            order.push_back(best);
+            m_emitted[best] = true;
+            const Vec3u& face = m_faces[best];
+
+            next_cache.clear();
+            for (unsigned int k = 0; k < 3; ++k) {
+                remove_face(face[k], best);
+                if (std::find(next_cache.begin(), next_cache.end(), face[k]) ==
+                    next_cache.end())
+                    next_cache.push_back(face[k]);
+            }
+            for (uint32_t v : cache)
+                if (v != face[0] && v != face[1] && v != face[2])
+                    next_cache.push_back(v);
+
+            // vertices that have just been pushed out of the cache are
+            // updated too, as their faces lose the score of being cached
+            for (size_t i = 0; i < next_cache.size(); ++i) {
+                const uint32_t v = next_cache[i];
+                m_score[v] =
+                    score(i < m_cache_size ? int(i) : -1, m_live[v]);
+            }
+            best = OPTIMIZE_NONE;
+            best_score = -1;
+            for (uint32_t v : next_cache) {
+                const uint32_t first = m_adjacency.offsets()[v];
+                for (uint32_t j = first; j < first + m_live[v]; ++j) {
+                    const uint32_t i = m_live_faces[j];
+                    const Vec3u& f = m_faces[i];
+                    m_face_score[i] =
+                        m_score[f[0]] + m_score[f[1]] + m_score[f[2]];
+                    if (m_face_score[i] > best_score) {
+                        best = i;
+                        best_score = m_face_score[i];
+                    }
+                }
+            }
+            if (next_cache.size() > m_cache_size)
+                next_cache.resize(m_cache_size);
+            std::swap(cache, next_cache);
+        }
+        return order;
+    }
+
+   private:
+    const VecList3u& m_faces;
+    const Adjacency m_adjacency;
+    // rows of m_adjacency, where the first m_live[v] faces of each vertex
+    // are the ones not emitted
+    std::vector<uint32_t> m_live_faces;
+    std::vector<uint32_t> m_live;
+    std::vector<float> m_score;
+    std::vector<float> m_face_score;
+    std::vector<bool> m_emitted;
+    const unsigned int m_cache_size;
+
+    float m_cache_score[FORSYTH_MAX_CACHE];
+    float m_valence_score[FORSYTH_MAX_VALENCE];
+
+    static float valence_score(uint32_t live) {
+        return FORSYTH_VALENCE_BOOST_SCALE *
+               std::pow(float(live), -FORSYTH_VALENCE_BOOST_POWER);
+    }
+
+    // The last face gets a fixed score (vertices in positions 0 to 2), so
+    // that the next one is not chosen only because of it
+    float score(int position, uint32_t live) const {
+        if (live == 0) return -1;  // never chosen again
+        return (position >= 0 ? m_cache_score[position] : 0) +
+               (live < FORSYTH_MAX_VALENCE ? m_valence_score[live]
+                                           : valence_score(live));
+    }
+
+    void remove_face(uint32_t v, uint32_t face) {
+        uint32_t* begin = m_live_faces.data() + m_adjacency.offsets()[v];
+        uint32_t* end = begin + m_live[v];
+        std::iter_swap(std::find(begin, end, face), end - 1);
+        --m_live[v];
+    }
+};
+
+/// REORDERING ///
+
+static void reorder_faces(Mesh& mesh, const std::vector<uint32_t>& order) {
+    VecList3u faces(order.size());
+    parallel_for(0, order.size(), 1 << 14, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) faces[i] = mesh.faces[order[i]];
+    });
+    mesh.faces = std::move(faces);
+    mesh.face_attributes.reorder(order);
+}
+
+// order[i] is the previous index of the new vertex i
+static void reorder_vertices(Mesh& mesh, const std::vector<uint32_t>& order) {
+    std::vector<uint32_t> remap(order.size());
+    VecList4f vertices(order.size());
+    parallel_for(0, order.size(), 1 << 14, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            remap[order[i]] = uint32_t(i);
+            vertices[i] = mesh.vertices[order[i]];
+        }
+    });
+    parallel_for(0, mesh.faces.size(), 1 << 14, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i)
+            for (unsigned int k = 0; k < 3; ++k)
+                mesh.faces[i][k] = remap[mesh.faces[i][k]];
+    });
+    mesh.vertices = std::move(vertices);
+    mesh.vertex_attributes.reorder(order);
+}
+
+};  // namespace detail
+
+VertexCacheStats analyze_vertex_cache(const Mesh& mesh,
+                                      unsigned int cache_size) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    VertexCacheStats stats;
+    if (mesh.faces.empty()) return stats;
+    // time at which each vertex was added to the FIFO, 0 if never. It is
+    // still in the cache while less than cache_size misses happen after it
+    std::vector<size_t> inserted(mesh.vertices.size(), 0);
+    size_t used = 0;
+    for (const Vec3u& f : mesh.faces) {
+        for (unsigned int k = 0; k < 3; ++k) {
+            size_t& time = inserted[f[k]];
+            if (time == 0) ++used;
+            if (time == 0 || stats.vertices_transformed - time >= cache_size)
+                time = ++stats.vertices_transformed;
+        }
+    }
+    stats.acmr = double(stats.vertices_transformed) / mesh.faces.size();
+    stats.atvr = double(stats.vertices_transformed) / used;
+    return stats;
+}
+
+VertexFetchStats analyze_vertex_fetch(const Mesh& mesh) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    VertexFetchStats stats;
+    if (mesh.faces.empty()) return stats;
+    constexpr size_t vertex_bytes = sizeof(Vec4f);
+    std::vector<size_t> lines(detail::FETCH_CACHE_LINES,
+                              std::numeric_limits<size_t>::max());
+    std::vector<bool> used(mesh.vertices.size(), false);
+    size_t num_used = 0;
+    for (const Vec3u& f : mesh.faces) {
+        for (unsigned int k = 0; k < 3; ++k) {
+            if (!used[f[k]]) {
+                used[f[k]] = true;
+                ++num_used;
+            }
+            // vertices do not straddle lines, as 64 is a multiple of 16
+            const size_t line = f[k] * vertex_bytes / detail::FETCH_LINE_BYTES;
+            size_t& slot = lines[line % detail::FETCH_CACHE_LINES];
+            if (slot != line) {
+                slot = line;
+                stats.bytes_fetched += detail::FETCH_LINE_BYTES;
+            }
+        }
+    }
+    stats.overfetch = double(stats.bytes_fetched) / (num_used * vertex_bytes);
+    return stats;
+}
+
+void optimize_vertex_cache(Mesh& mesh, VertexCacheMethod method,
+                           unsigned int cache_size) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    if (mesh.faces.empty()) return;
+    std::vector<uint32_t> order;
+    if (method == VertexCacheMethod::Tipsify)
+        order = detail::Tipsify(mesh, std::max(cache_size, 3u)).run();
+    else
+        order = detail::Forsyth(mesh, cache_size).run();
+    detail::reorder_faces(mesh, order);
+}
+
+void optimize_vertex_fetch(Mesh& mesh) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    const size_t n = mesh.vertices.size();
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<bool> added(n, false);
+    for (const Vec3u& f : mesh.faces) {
+        for (unsigned int k = 0; k < 3; ++k) {
+            if (added[f[k]]) continue;
+            added[f[k]] = true;
+            order.push_back(f[k]);
+        }
+    }
+    for (size_t v = 0; v < n; ++v)
+        if (!added[v]) order.push_back(uint32_t(v));
+    detail::reorder_vertices(mesh, order);
+}
+
+void sort_vertices_morton(Mesh& mesh) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    const size_t n = mesh.vertices.size();
+    if (n == 0) return;
+    // 10 bits per axis, over the bounds of the vertices
+    const std::vector<uint32_t> codes =
+        curve_codes<uint32_t>(mesh.vertices, Curve::Morton);
+    const std::vector<uint32_t> order = sort_order(codes, 30);
+    detail::reorder_vertices(mesh, order);
+}
+
+};  // namespace common
@@ -2,17 +2,22 @@
  * ply.cpp
  * Diego Royo Meneses - Dec. 2023
  *
- * Polygon File Format loader
+ * Polygon File Format loader and saver
  */
 
 #include <algorithm>
+#include <charconv>
 #include <cstdint>
-#include <functional>
-#include <memory>
+#include <cstring>
 #include <sstream>
-#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
 
+#include "libcpp-common/detail/endian.h"
+#include "libcpp-common/detail/parallel.h"
 #include "libcpp-common/mesh.h"
+#include "libcpp-common/mesh/triangulate.h"
 
 namespace common {
 
@@ -27,267 +32,1371 @@ bool test_ply(std::ifstream& file) {
     return is_ply;
 }
 
-template <typename T>
-uint64_t read_ascii(std::istream& line) {
-    T res;
-    line >> res;
-    return *((uint64_t*)&res);
+bool test_ply(const uint8_t* data, size_t size) {
+    return size >= 4 && std::memcmp(data, "ply", 3) == 0 &&
+           (data[3] == '\n' || data[3] == '\r');
+}
+
+namespace detail {
+
+/// HEADER ///
+
+enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+enum class PlyType : uint8_t {
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64
+};
+
+static PlyType ply_parse_type(const std::string& type) {
+    if (type == "char" || type == "int8") return PlyType::Int8;
+    if (type == "uchar" || type == "uint8") return PlyType::UInt8;
+    if (type == "short" || type == "int16") return PlyType::Int16;
+    if (type == "ushort" || type == "uint16") return PlyType::UInt16;
+    if (type == "int" || type == "int32") return PlyType::Int32;
+    if (type == "uint" || type == "uint32") return PlyType::UInt32;
+    if (type == "float" || type == "float32") return PlyType::Float32;
+    if (type == "double" || type == "float64") return PlyType::Float64;
+    throw CommonMeshException("PLY Unsupported type: " + type);
+}
+
+static size_t ply_type_size(PlyType type) {
+    constexpr size_t sizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+    return sizes[static_cast<size_t>(type)];
 }
 
 template <typename T>
-uint64_t read_little_endian(std::istream& line) {
-    size_t n = sizeof(T);
-    uint64_t res = 0;
-    for (int i = 0; i < n; ++i) {
-        uint8_t byte;
-        line.read(reinterpret_cast<char*>(&byte), sizeof(byte));
-        res |= byte << (i * 8);
+struct PlyTypeTag {
+    using type = T;
+};
+
+// Calls f(PlyTypeTag<T>()) with the C++ type of a PLY type, so that the
+// type is resolved once per property instead of once per value
+template <typename Func>
+inline void ply_dispatch(PlyType type, const Func& f) {
+    switch (type) {
+        case PlyType::Int8: return f(PlyTypeTag<int8_t>());
+        case PlyType::UInt8: return f(PlyTypeTag<uint8_t>());
+        case PlyType::Int16: return f(PlyTypeTag<int16_t>());
+        case PlyType::UInt16: return f(PlyTypeTag<uint16_t>());
+        case PlyType::Int32: return f(PlyTypeTag<int32_t>());
+        case PlyType::UInt32: return f(PlyTypeTag<uint32_t>());
+        case PlyType::Float32: return f(PlyTypeTag<float>());
+        case PlyType::Float64: return f(PlyTypeTag<double>());
     }
-    return res;
 }
 
+// PLY type of a C++ type, the inverse of ply_dispatch
 template <typename T>
-uint64_t read_big_endian(std::istream& line) {
-    size_t n = sizeof(T);
-    uint64_t res = 0;
-    for (int i = 0; i < n; ++i) {
-        uint8_t byte;
-        line.read(reinterpret_cast<char*>(&byte), sizeof(byte));
-        res |= byte << ((n - i - 1) * 8);
+constexpr PlyType ply_type_of() {
+    if constexpr (std::is_same_v<T, int8_t>) return PlyType::Int8;
+    else if constexpr (std::is_same_v<T, uint8_t>) return PlyType::UInt8;
+    else if constexpr (std::is_same_v<T, int16_t>) return PlyType::Int16;
+    else if constexpr (std::is_same_v<T, uint16_t>) return PlyType::UInt16;
+    else if constexpr (std::is_same_v<T, int32_t>) return PlyType::Int32;
+    else if constexpr (std::is_same_v<T, uint32_t>) return PlyType::UInt32;
+    else if constexpr (std::is_same_v<T, float>) return PlyType::Float32;
+    else {
+        static_assert(std::is_same_v<T, double>, "Type without a PLY type");
+        return PlyType::Float64;
     }
-    return res;
 }
 
-class Property {
-   public:
-    Property(const std::string& type) : m_type(type) {}
-    virtual ~Property() = default;
-    virtual void write(Mesh& mesh, const size_t idx, uint64_t value) const {};
-    std::string type() const { return m_type; }
-    virtual bool is_list() const { return false; }
-
-   private:
-    std::string m_type;
+struct PlyProperty {
+    std::string name;
+    PlyType type;  // type of the value, or of the list items
+    bool is_list;
+    PlyType count_type;
+    size_t offset;  // in bytes from the start of the record, if fixed size
 };
 
-class VertexXProperty : public Property {
-   public:
-    VertexXProperty(const std::string& type) : Property(type) {}
-    void write(Mesh& mesh, const size_t idx, uint64_t value) const override {
-        mesh.vertices[idx].x() = *((float*)&value);
+// Elements without list properties have records of a fixed size, so the
+// position of each property is known in advance
+struct PlyElement {
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+    bool fixed_size;
+    size_t record_size;
+
+    const PlyProperty* find(const std::string& property_name) const {
+        for (const auto& property : properties)
+            if (property.name == property_name) return &property;
+        return nullptr;
     }
 };
 
-class VertexYProperty : public Property {
-   public:
-    VertexYProperty(const std::string& type) : Property(type) {}
-    void write(Mesh& mesh, const size_t idx, uint64_t value) const override {
-        mesh.vertices[idx].y() = *((float*)&value);
-    }
+struct PlyHeader {
+    PlyFormat format;
+    std::vector<PlyElement> elements;
 };
 
-class VertexZProperty : public Property {
-   public:
-    VertexZProperty(const std::string& type) : Property(type) {}
-    void write(Mesh& mesh, const size_t idx, uint64_t value) const override {
-        mesh.vertices[idx].z() = *((float*)&value);
+static PlyHeader read_ply_header(std::istream& file) {
+    std::string line;
+    std::getline(file, line);
+    if (line != "ply")
+        throw CommonMeshException(
+            "PLY Unexpected error: file is not a ply file?");
+
+    PlyHeader header;
+    std::getline(file, line);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line == "format ascii 1.0") {
+        header.format = PlyFormat::Ascii;
+    } else if (line == "format binary_little_endian 1.0") {
+        header.format = PlyFormat::BinaryLittleEndian;
+    } else if (line == "format binary_big_endian 1.0") {
+        header.format = PlyFormat::BinaryBigEndian;
+    } else {
+        throw CommonMeshException("PLY Unsupported ply format: " + line);
     }
-};
 
-class IgnoreProperty : public Property {
-   public:
-    IgnoreProperty(const std::string& type) : Property(type) {}
-};
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::stringstream ss(line);
+        std::string keyword;
+        ss >> keyword;
+        if (keyword == "end_header") {
+            for (auto& element : header.elements) {
+                element.fixed_size = true;
+                element.record_size = 0;
+                for (auto& property : element.properties) {
+                    property.offset = element.record_size;
+                    element.record_size += ply_type_size(property.type);
+                    element.fixed_size =
+                        element.fixed_size && !property.is_list;
+                }
+            }
+            return header;
+        } else if (keyword == "element") {
+            PlyElement element = {};
+            ss >> element.name >> element.count;
+            if (!ss)
+                throw CommonMeshException("PLY Malformed element: " + line);
+            header.elements.push_back(element);
+        } else if (keyword == "property") {
+            if (header.elements.empty())
+                throw CommonMeshException("PLY Property without element");
+            PlyProperty property = {};
+            std::string type;
+            ss >> type;
+            if (type == "list") {
+                std::string count_type;
+                ss >> count_type >> type;
+                property.is_list = true;
+                property.count_type = ply_parse_type(count_type);
+            }
+            property.type = ply_parse_type(type);
+            ss >> property.name;
+            header.elements.back().properties.push_back(property);
+        }
+        // comment, obj_info and unknown lines are ignored
+    }
+    throw CommonMeshException("PLY Unexpected end of file in header");
+}
 
-class ListProperty : public Property {
-   public:
-    ListProperty(const std::string& length_type, const std::string& type)
-        : m_length_type(length_type), Property(type) {}
-    std::string length_type() const { return m_length_type; }
-    bool is_list() const override { return true; }
-    void write(Mesh& mesh, const size_t idx, uint64_t value) const override{};
-
-   protected:
-    std::string m_length_type;
+// Number of bytes up to the end of the "end_header" line
+static size_t ply_header_size(const uint8_t* data, size_t size) {
+    const char* begin = reinterpret_cast<const char*>(data);
+    const char* end = begin + size;
+    const char keyword[] = "\nend_header";
+    const char* p = std::search(begin, end, keyword, keyword + 11);
+    if (p == end)
+        throw CommonMeshException("PLY Unexpected end of file in header");
+    p = std::find(p + 11, end, '\n');
+    if (p == end)
+        throw CommonMeshException("PLY Unexpected end of file in header");
+    return static_cast<size_t>(p + 1 - begin);
+}
+
+/// OUTPUT ///
+
+// List property with the vertex indices of the faces, if any
+static const PlyProperty* ply_face_indices(const PlyElement& element) {
+    const PlyProperty* result = element.find("vertex_indices");
+    if (result == nullptr) result = element.find("vertex_index");
+    return result != nullptr && result->is_list ? result : nullptr;
+}
+
+// Faces with n corners are split in polygon_triangles(n) triangles, stored
+// one after the other in the order of the faces
+struct PlyTriangles {
+    size_t count = 0;
+    // first triangle of each face (and count at the end), empty when every
+    // face is a triangle
+    std::vector<size_t> first;
+
+    size_t begin(size_t face) const {
+        return first.empty() ? face : first[face];
+    }
+    size_t end(size_t face) const {
+        return first.empty() ? face + 1 : first[face + 1];
+    }
+
+    // Prefix sum of the number of triangles of each face, in first[i + 1]
+    void accumulate() {
+        bool only_triangles = true;
+        for (size_t i = 1; i < first.size(); ++i) {
+            only_triangles &= first[i] == 1;
+            first[i] += first[i - 1];
+        }
+        count = first.back();
+        if (only_triangles) first.clear();
+    }
 };
 
-class FaceTriangleProperty : public ListProperty {
-   public:
-    FaceTriangleProperty(const std::string& length_type,
-                         const std::string& type)
-        : ListProperty(length_type, type) {}
+// Where the decoders store the mesh: positions with a stride of 3 or 4
+// floats (so that Mesh and CompactMesh are filled in place), and vertex
+// indices of 16 or 32 bits
+struct PlyOutput {
+    float* vertices = nullptr;
+    size_t vertex_stride = 0;
+    uint16_t* faces16 = nullptr;
+    unsigned int* faces32 = nullptr;
+    // values of each property loaded as an attribute (or nullptr), with the
+    // type of the property
+    std::vector<void*> vertex_attributes;
+    std::vector<void*> face_attributes;
+    const PlyTriangles* triangles = nullptr;
+
+    float* vertex(size_t i) const { return vertices + i * vertex_stride; }
+    void* attribute(const PlyElement& element, size_t property) const {
+        const auto& attributes = element.name == "vertex" ? vertex_attributes
+                                 : element.name == "face" ? face_attributes
+                                                          : no_attributes;
+        return property < attributes.size() ? attributes[property] : nullptr;
+    }
+    static inline const std::vector<void*> no_attributes = {};
+    // Items of the attribute arrays where item i of element goes: the
+    // values of a face are copied to all its triangles
+    std::pair<size_t, size_t> items(const PlyElement& element,
+                                    size_t i) const {
+        if (element.name == "face")
+            return {triangles->begin(i), triangles->end(i)};
+        return {i, i + 1};
+    }
+
+    template <typename T>
+    void set_index(size_t k, T index) const {
+        if (faces16 != nullptr)
+            faces16[k] = static_cast<uint16_t>(index);
+        else
+            faces32[k] = static_cast<unsigned int>(index);
+    }
+    size_t get_index(size_t k) const {
+        return faces16 != nullptr ? faces16[k] : faces32[k];
+    }
 
-    void write_face(Mesh& mesh, const size_t idx, Vec3u face) const {
-        mesh.faces[idx] = face;
+    // Stores face i, with n corners given by corner(k), as a fan of
+    // triangles around its first corner
+    template <typename CornerFunc>
+    void set_face(size_t i, size_t n, const CornerFunc& corner) const {
+        size_t t = triangles->begin(i);
+        if (triangles->end(i) - t != polygon_triangles(n))
+            throw CommonMeshException("PLY Inconsistent face length");
+        for (size_t k = 1; k + 1 < n; ++k, ++t) {
+            set_index(3 * t, corner(0));
+            set_index(3 * t + 1, corner(k));
+            set_index(3 * t + 2, corner(k + 1));
+        }
     }
 };
 
-Mesh load_ply(std::ifstream& file) {
-    std::string ply, format;
-    std::getline(file, ply);
-    std::getline(file, format);
+static size_t ply_num_vertices(const PlyHeader& header) {
+    for (const auto& element : header.elements)
+        if (element.name == "vertex") return element.count;
+    return 0;
+}
 
-    bool is_ascii = false;
-    bool is_binary_little_endian = false;
-    bool is_binary_big_endian = false;
-    if (ply != "ply")
-        throw detail::CommonMeshException(
-            "PLY Unexpected error: file is not a ply file?");
-    if (format == "format ascii 1.0") {
-        is_ascii = true;
-    } else if (format == "format binary_little_endian 1.0") {
-        is_binary_little_endian = true;
-    } else if (format == "format binary_big_endian 1.0") {
-        is_binary_big_endian = true;
+// Adds the attributes selected by mask, and points out to their values.
+// Face attributes have a value per triangle
+static void ply_allocate_attributes(const PlyHeader& header,
+                                    const AttributeMask& mask,
+                                    MeshAttributes& vertex_attributes,
+                                    MeshAttributes& face_attributes,
+                                    PlyOutput& out) {
+    for (const auto& element : header.elements) {
+        const bool is_vertex = element.name == "vertex";
+        if (!is_vertex && element.name != "face") continue;
+        auto& pointers = is_vertex ? out.vertex_attributes : out.face_attributes;
+        auto& attributes = is_vertex ? vertex_attributes : face_attributes;
+        pointers.assign(element.properties.size(), nullptr);
+        for (size_t k = 0; k < element.properties.size(); ++k) {
+            const PlyProperty& property = element.properties[k];
+            if (property.is_list) continue;
+            if (is_vertex && (property.name == "x" || property.name == "y" ||
+                              property.name == "z"))
+                continue;
+            if (is_vertex ? !mask.vertex_contains(property.name)
+                          : !mask.face_contains(property.name))
+                continue;
+            ply_dispatch(property.type, [&](auto tag) {
+                using T = typename decltype(tag)::type;
+                const size_t count =
+                    is_vertex ? element.count : out.triangles->count;
+                pointers[k] =
+                    attributes.set(property.name, std::vector<T>(count)).data();
+            });
+        }
+    }
+}
+
+static PlyOutput ply_allocate(const PlyHeader& header,
+                              const PlyTriangles& triangles,
+                              const AttributeMask& mask, Mesh& mesh) {
+    mesh.vertices.assign(ply_num_vertices(header), Vec4f(0, 0, 0, 1));
+    mesh.faces.resize(triangles.count);
+    PlyOutput out;
+    out.triangles = &triangles;
+    out.vertices = mesh.vertices.data_flat();
+    out.vertex_stride = 4;
+    out.faces32 = mesh.faces.data_flat();
+    ply_allocate_attributes(header, mask, mesh.vertex_attributes,
+                            mesh.face_attributes, out);
+    return out;
+}
+
+static PlyOutput ply_allocate(const PlyHeader& header,
+                              const PlyTriangles& triangles,
+                              const AttributeMask& mask, CompactMesh& mesh) {
+    const size_t num_vertices = ply_num_vertices(header);
+    mesh.vertices.assign(num_vertices, Vec3f(0, 0, 0));
+    PlyOutput out;
+    out.triangles = &triangles;
+    out.vertices = mesh.vertices.data_flat();
+    out.vertex_stride = 3;
+    if (CompactMesh::fits_16bit(num_vertices)) {
+        mesh.faces16.resize(triangles.count);
+        out.faces16 = mesh.faces16.data_flat();
     } else {
-        throw detail::CommonMeshException("PLY Unsupported ply format: " +
-                                          format);
+        mesh.faces32.resize(triangles.count);
+        out.faces32 = mesh.faces32.data_flat();
     }
+    ply_allocate_attributes(header, mask, mesh.vertex_attributes,
+                            mesh.face_attributes, out);
+    return out;
+}
 
-    common::Mesh mesh;
-    bool end_header = false;
-    std::vector<std::tuple<size_t, std::vector<std::shared_ptr<Property>>>>
-        all_properties;
+/// BINARY DECODING ///
 
-    std::string line;
-    std::getline(file, line);
-    while (!file.eof()) {
-        if (line == "end_header") {
-            end_header = true;
-            break;
-        } else if (line.substr(0, 7) == "comment") {
-            // Ignore the line and read next one
-            std::getline(file, line);
-        } else if (line.substr(0, 7) == "element") {
-            size_t num_elements;
-            if (line.substr(8, 6) == "vertex") {
-                num_elements = std::stoi(line.substr(15));
-                mesh.vertices.resize(num_elements);
-                std::fill(mesh.vertices.begin(), mesh.vertices.end(),
-                          Vec4f(0, 0, 0, 1));
-            } else if (line.substr(8, 4) == "face") {
-                num_elements = std::stoi(line.substr(13));
-                mesh.faces.resize(num_elements);
-                std::fill(mesh.faces.begin(), mesh.faces.end(), Vec3u(0, 0, 0));
+// Minimum number of records decoded by each thread
+static constexpr size_t PLY_PARALLEL_CHUNK = 1 << 16;
+
+template <typename T, bool Swap>
+inline T ply_load(const uint8_t* p) {
+    T value;
+    if constexpr (Swap && sizeof(T) > 1) {
+        uint8_t bytes[sizeof(T)];
+        for (size_t i = 0; i < sizeof(T); ++i)
+            bytes[i] = p[sizeof(T) - 1 - i];
+        std::memcpy(&value, bytes, sizeof(T));
+    } else {
+        std::memcpy(&value, p, sizeof(T));
+    }
+    return value;
+}
+
+template <bool Swap>
+static size_t ply_load_count(PlyType type, const uint8_t* p) {
+    size_t result = 0;
+    ply_dispatch(type, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        result = static_cast<size_t>(ply_load<T, Swap>(p));
+    });
+    return result;
+}
+
+// Binary body of a PLY file, decoded from memory
+template <bool Swap>
+class PlyBinaryDecoder {
+   public:
+    PlyBinaryDecoder(const uint8_t* data, size_t size)
+        : m_p(data), m_end(data + size) {}
+
+    // Counting pass over the faces, before decoding, so that their
+    // triangles can be stored in place
+    PlyTriangles count_triangles(const PlyHeader& header) const {
+        PlyBinaryDecoder walker = *this;
+        PlyTriangles result;
+        for (const auto& element : header.elements) {
+            const PlyProperty* indices =
+                element.name == "face" ? ply_face_indices(element) : nullptr;
+            if (indices == nullptr) {
+                walker.skip(element);
+                continue;
+            }
+            if (walker.all_triangles(element, *indices)) {
+                result.count = element.count;
+                walker.skip_triangles(element, *indices);
+                continue;
+            }
+            result.first.assign(element.count + 1, 0);
+            for (size_t i = 0; i < element.count; ++i) {
+                const uint8_t* record = walker.m_p;
+                walker.take(walker.record_size(element, record));
+                result.first[i + 1] =
+                    polygon_triangles(face_length(element, indices, record));
+            }
+            result.accumulate();
+        }
+        return result;
+    }
+
+    void decode(const PlyHeader& header, const PlyOutput& out) {
+        for (const auto& element : header.elements) {
+            if (element.name == "vertex") {
+                decode_vertices(element, out);
+            } else if (element.name == "face") {
+                decode_faces(element, out);
+            } else {
+                skip(element);
+            }
+        }
+    }
+
+   private:
+    const uint8_t* m_p;
+    const uint8_t* m_end;
+
+    const uint8_t* take(size_t bytes) {
+        if (static_cast<size_t>(m_end - m_p) < bytes)
+            throw CommonMeshException("PLY Unexpected end of file");
+        const uint8_t* result = m_p;
+        m_p += bytes;
+        return result;
+    }
+
+    // Size of the variable-sized record at p
+    size_t record_size(const PlyElement& element, const uint8_t* p) const {
+        size_t size = 0;
+        for (const auto& property : element.properties) {
+            if (!property.is_list) {
+                size += ply_type_size(property.type);
+                continue;
+            }
+            const size_t count_size = ply_type_size(property.count_type);
+            if (static_cast<size_t>(m_end - p) < size + count_size)
+                throw CommonMeshException("PLY Unexpected end of file");
+            const size_t count =
+                ply_load_count<Swap>(property.count_type, p + size);
+            size += count_size + count * ply_type_size(property.type);
+        }
+        return size;
+    }
+
+    // Number of items of the list property in the record at p
+    size_t face_length(const PlyElement& element, const PlyProperty* list,
+                       const uint8_t* p) const {
+        size_t offset = 0;
+        for (const auto& property : element.properties) {
+            if (!property.is_list) {
+                offset += ply_type_size(property.type);
+                continue;
             }
+            const size_t count =
+                ply_load_count<Swap>(property.count_type, p + offset);
+            if (&property == list) return count;
+            offset += ply_type_size(property.count_type) +
+                      count * ply_type_size(property.type);
+        }
+        return 0;
+    }
+
+    // Common layout: only the list, with a one-byte count that is 3 for all
+    // faces. Records then have a fixed size and can be decoded in parallel
+    bool all_triangles(const PlyElement& element,
+                       const PlyProperty& indices) const {
+        if (element.properties.size() != 1 ||
+            ply_type_size(indices.count_type) != 1)
+            return false;
+        const size_t stride = 1 + 3 * ply_type_size(indices.type);
+        if (static_cast<size_t>(m_end - m_p) / stride < element.count)
+            return false;
+        std::vector<char> chunk_ok(num_chunks(element.count, PLY_PARALLEL_CHUNK),
+                                   1);
+        parallel_chunks(0, element.count, PLY_PARALLEL_CHUNK,
+                        [&](size_t c, size_t b, size_t e) {
+                            for (size_t i = b; i < e; ++i)
+                                if (m_p[i * stride] != 3) chunk_ok[c] = 0;
+                        });
+        return std::all_of(chunk_ok.begin(), chunk_ok.end(),
+                           [](char ok) { return ok != 0; });
+    }
+
+    void skip_triangles(const PlyElement& element, const PlyProperty& indices) {
+        take(element.count * (1 + 3 * ply_type_size(indices.type)));
+    }
+
+    void skip(const PlyElement& element) {
+        if (element.fixed_size) {
+            take(element.count * element.record_size);
+            return;
+        }
+        for (size_t i = 0; i < element.count; ++i)
+            take(record_size(element, m_p));
+    }
 
-            std::vector<std::shared_ptr<Property>> properties;
-
-            std::getline(file, line);
-            while (!file.eof() && line.substr(0, 8) == "property") {
-                std::string type, name;
-                std::stringstream ss(line.substr(9));
-                ss >> type >> name;
-                if (type == "float") {
-                    if (name == "x")
-                        properties.push_back(
-                            std::make_unique<VertexXProperty>(type));
-                    else if (name == "y")
-                        properties.push_back(
-                            std::make_unique<VertexYProperty>(type));
-                    else if (name == "z")
-                        properties.push_back(
-                            std::make_unique<VertexZProperty>(type));
-                    else
-                        properties.push_back(
-                            std::make_unique<IgnoreProperty>(type));
-                } else if (type == "list") {
-                    std::string length_type, list_type;
-                    length_type = name;
-                    ss >> list_type >> name;
-                    if (length_type == "uchar" &&
-                        (list_type == "int" or list_type == "uint") &&
-                        name == "vertex_indices") {
-                        properties.push_back(
-                            std::make_unique<FaceTriangleProperty>(length_type,
-                                                                   list_type));
+    void decode_vertices(const PlyElement& element, const PlyOutput& out) {
+        if (!element.fixed_size) {
+            // rare: vertices with list properties, decode record by record
+            for (size_t i = 0; i < element.count; ++i) {
+                const uint8_t* record = m_p;
+                take(record_size(element, record));
+                size_t offset = 0;
+                for (size_t k = 0; k < element.properties.size(); ++k) {
+                    const PlyProperty& property = element.properties[k];
+                    const size_t axis = property.name == "x"   ? 0
+                                        : property.name == "y" ? 1
+                                        : property.name == "z" ? 2
+                                                               : 3;
+                    if (property.is_list) {
+                        const size_t count = ply_load_count<Swap>(
+                            property.count_type, record + offset);
+                        offset += ply_type_size(property.count_type) +
+                                  count * ply_type_size(property.type);
+                        continue;
                     }
+                    if (axis < 3)
+                        ply_dispatch(property.type, [&](auto tag) {
+                            using T = typename decltype(tag)::type;
+                            out.vertex(i)[axis] = static_cast<float>(
+                                ply_load<T, Swap>(record + offset));
+                        });
+                    decode_attribute(property, out.attribute(element, k),
+                                     record + offset, i, i + 1);
+                    offset += ply_type_size(property.type);
                 }
-                std::getline(file, line);
             }
-            all_properties.push_back(std::make_tuple(num_elements, properties));
+            return;
         }
+
+        // fixed-size records: decode ranges of vertices in parallel, straight
+        // from the mapped file into their final position
+        const uint8_t* records = take(element.count * element.record_size);
+        const size_t stride = element.record_size;
+        const PlyProperty* axes[] = {element.find("x"), element.find("y"),
+                                     element.find("z")};
+        parallel_for(0, element.count, PLY_PARALLEL_CHUNK,
+                     [&](size_t b, size_t e) {
+                         for (size_t axis = 0; axis < 3; ++axis) {
+                             if (axes[axis] == nullptr) continue;
+                             decode_column(axes[axis], records, stride, b, e,
+                                           out, axis);
+                         }
+                         for (size_t k = 0; k < element.properties.size();
+                              ++k)
+                             decode_attribute_column(
+                                 element.properties[k],
+                                 out.attribute(element, k), records, stride,
+                                 b, e);
+                     });
+    }
+
+    static void decode_column(const PlyProperty* property,
+                              const uint8_t* records, size_t stride, size_t b,
+                              size_t e, const PlyOutput& out, size_t axis) {
+        const uint8_t* p = records + property->offset;
+        ply_dispatch(property->type, [&](auto tag) {
+            using T = typename decltype(tag)::type;
+            for (size_t i = b; i < e; ++i)
+                out.vertex(i)[axis] =
+                    static_cast<float>(ply_load<T, Swap>(p + i * stride));
+        });
+    }
+
+    // Copy the value of a property to the items [b, e) of its attribute,
+    // if it has one
+    static void decode_attribute(const PlyProperty& property, void* values,
+                                 const uint8_t* p, size_t b, size_t e) {
+        if (values == nullptr) return;
+        ply_dispatch(property.type, [&](auto tag) {
+            using T = typename decltype(tag)::type;
+            std::fill(static_cast<T*>(values) + b, static_cast<T*>(values) + e,
+                      ply_load<T, Swap>(p));
+        });
+    }
+
+    static void decode_attribute_column(const PlyProperty& property,
+                                        void* values, const uint8_t* records,
+                                        size_t stride, size_t b, size_t e) {
+        if (values == nullptr) return;
+        const uint8_t* p = records + property.offset;
+        ply_dispatch(property.type, [&](auto tag) {
+            using T = typename decltype(tag)::type;
+            for (size_t i = b; i < e; ++i)
+                static_cast<T*>(values)[i] = ply_load<T, Swap>(p + i * stride);
+        });
     }
 
-    auto read_value_ascii = [](const std::string& type,
-                               std::istream& is) -> uint64_t {
-        if (type == "float") {
-            return read_ascii<float>(is);
-        } else if (type == "uint" or type == "int" or type == "uchar" or
-                   type == "char") {
-            return read_ascii<int>(is);
+    void decode_faces(const PlyElement& element, const PlyOutput& out) {
+        const PlyProperty* indices = ply_face_indices(element);
+        if (indices == nullptr) {
+            skip(element);
+            return;
+        }
+
+        // every face is a triangle (see count_triangles)
+        if (out.triangles->first.empty() && element.properties.size() == 1 &&
+            ply_type_size(indices->count_type) == 1) {
+            ply_dispatch(indices->type, [&](auto tag) {
+                using T = typename decltype(tag)::type;
+                decode_triangles<T>(element.count, out);
+            });
+            return;
         }
-        throw detail::CommonMeshException("PLY Unsupported type: " + type);
-    };
-
-    auto read_value_binary = [&is_binary_little_endian, &is_binary_big_endian](
-                                 const std::string& type,
-                                 std::istream& is) -> uint64_t {
-        if (type == "float" or type == "uint" or type == "int") {
-            if (is_binary_little_endian) {
-                return read_little_endian<uint32_t>(is);
-            } else if (is_binary_big_endian) {
-                return read_big_endian<uint32_t>(is);
+
+        for (size_t i = 0; i < element.count; ++i) {
+            const uint8_t* record = m_p;
+            take(record_size(element, record));
+            size_t offset = 0;
+            for (size_t k = 0; k < element.properties.size(); ++k) {
+                const PlyProperty& property = element.properties[k];
+                if (!property.is_list) {
+                    const auto items = out.items(element, i);
+                    decode_attribute(property, out.attribute(element, k),
+                                     record + offset, items.first,
+                                     items.second);
+                    offset += ply_type_size(property.type);
+                    continue;
+                }
+                const size_t count =
+                    ply_load_count<Swap>(property.count_type, record + offset);
+                offset += ply_type_size(property.count_type);
+                if (&property == indices) {
+                    ply_dispatch(property.type, [&](auto tag) {
+                        using T = typename decltype(tag)::type;
+                        const uint8_t* p = record + offset;
+                        out.set_face(i, count, [&](size_t k) {
+                            return ply_load<T, Swap>(p + k * sizeof(T));
+                        });
+                    });
+                }
+                offset += count * ply_type_size(property.type);
             }
-        } else if (type == "uchar" or type == "char") {
-            if (is_binary_little_endian) {
-                return read_little_endian<uint8_t>(is);
-            } else if (is_binary_big_endian) {
-                return read_big_endian<uint8_t>(is);
+        }
+    }
+
+    template <typename T>
+    void decode_triangles(size_t count, const PlyOutput& out) {
+        constexpr size_t stride = 1 + 3 * sizeof(T);
+        const uint8_t* records = take(count * stride);
+        parallel_for(0, count, PLY_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                const uint8_t* record = records + i * stride;
+                if (record[0] != 3)
+                    throw CommonMeshException("PLY Unexpected face length: " +
+                                              std::to_string(record[0]));
+                for (size_t j = 0; j < 3; ++j)
+                    out.set_index(3 * i + j, ply_load<T, Swap>(
+                                                 record + 1 + j * sizeof(T)));
             }
+        });
+    }
+};
+
+/// ASCII DECODING ///
+
+// Minimum number of bytes of ASCII body parsed by each thread
+static constexpr size_t PLY_ASCII_CHUNK = 1 << 20;
+
+static inline bool ply_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Parse the next value of the line at p, returning the position after it
+template <typename T>
+static inline const char* ply_parse_ascii(const char* p, const char* end,
+                                          T& value) {
+    while (p < end && ply_is_space(*p)) ++p;
+    if (p < end && *p == '+') ++p;  // accepted by >>, but not by from_chars
+    const auto [next, error] = std::from_chars(p, end, value);
+    if (error != std::errc())
+        throw CommonMeshException("PLY Unexpected value: " +
+                                  std::string(p, std::find(p, end, '\n')));
+    return next;
+}
+
+// What each property of an element is used for
+enum class PlyTarget : uint8_t { Ignore, X, Y, Z, Face, Attribute };
+
+static std::vector<PlyTarget> ply_targets(const PlyElement& element,
+                                          const PlyOutput& out) {
+    std::vector<PlyTarget> result(element.properties.size(), PlyTarget::Ignore);
+    for (size_t i = 0; i < result.size(); ++i) {
+        const PlyProperty& property = element.properties[i];
+        if (out.attribute(element, i) != nullptr) {
+            result[i] = PlyTarget::Attribute;
+        } else if (element.name == "vertex" && !property.is_list) {
+            if (property.name == "x") result[i] = PlyTarget::X;
+            if (property.name == "y") result[i] = PlyTarget::Y;
+            if (property.name == "z") result[i] = PlyTarget::Z;
+        } else if (element.name == "face" &&
+                   &property == ply_face_indices(element)) {
+            result[i] = PlyTarget::Face;
         }
-        throw detail::CommonMeshException("PLY Unsupported type: " + type);
-    };
-
-    auto read_value = [&is_ascii, &read_value_ascii, &read_value_binary](
-                          const std::string& type, std::ifstream& file,
-                          std::stringstream& ss) -> uint64_t {
-        if (is_ascii) {
-            return read_value_ascii(type, ss);
-        } else {
-            return read_value_binary(type, file);
+    }
+    return result;
+}
+
+// Parses a record (one line) of element, storing it as its idx-th item.
+// corners is a buffer for the indices of the face
+static void ply_parse_ascii_record(const char* p, const char* end,
+                                   const PlyElement& element,
+                                   const std::vector<PlyTarget>& targets,
+                                   size_t idx, const PlyOutput& out,
+                                   std::vector<uint32_t>& corners) {
+    for (size_t i = 0; i < element.properties.size(); ++i) {
+        const PlyProperty& property = element.properties[i];
+        if (!property.is_list) {
+            if (targets[i] == PlyTarget::Ignore) {
+                double value;
+                p = ply_parse_ascii(p, end, value);
+            } else if (targets[i] == PlyTarget::Attribute) {
+                ply_dispatch(property.type, [&](auto tag) {
+                    using T = typename decltype(tag)::type;
+                    T value;
+                    p = ply_parse_ascii(p, end, value);
+                    T* values = static_cast<T*>(out.attribute(element, i));
+                    const auto items = out.items(element, idx);
+                    std::fill(values + items.first, values + items.second,
+                              value);
+                });
+            } else {
+                const size_t axis = static_cast<size_t>(targets[i]) - 1;
+                p = ply_parse_ascii(p, end, out.vertex(idx)[axis]);
+            }
+            continue;
+        }
+        size_t count;
+        p = ply_parse_ascii(p, end, count);
+        if (targets[i] == PlyTarget::Face) {
+            corners.resize(count);
+            for (size_t j = 0; j < count; ++j)
+                p = ply_parse_ascii(p, end, corners[j]);
+            out.set_face(idx, count, [&](size_t k) { return corners[k]; });
+            continue;
+        }
+        for (size_t j = 0; j < count; ++j) {
+            double value;
+            p = ply_parse_ascii(p, end, value);
+        }
+    }
+}
+
+// Number of items of the list property in the record (one line) at p
+static size_t ply_ascii_face_length(const char* p, const char* end,
+                                    const PlyElement& element,
+                                    const PlyProperty* list) {
+    for (const auto& property : element.properties) {
+        double value;
+        if (!property.is_list) {
+            p = ply_parse_ascii(p, end, value);
+            continue;
+        }
+        size_t count;
+        p = ply_parse_ascii(p, end, count);
+        if (&property == list) return count;
+        for (size_t j = 0; j < count; ++j) p = ply_parse_ascii(p, end, value);
+    }
+    return 0;
+}
+
+// The body has one record per line. It is split in line-aligned chunks
+// that are parsed in parallel: a first pass counts the records of each
+// chunk, so that each chunk knows where its records go in the mesh
+class PlyAsciiDecoder {
+   public:
+    PlyAsciiDecoder(const char* begin, const char* end,
+                    const PlyHeader& header) {
+        m_first_record = {0};
+        for (const auto& element : header.elements)
+            m_first_record.push_back(m_first_record.back() + element.count);
+        m_num_records = m_first_record.back();
+
+        m_bounds = line_chunks(begin, end, PLY_ASCII_CHUNK);
+        const size_t chunks = this->chunks();
+        m_chunk_records.assign(chunks + 1, 0);
+        parallel_chunks(0, chunks, 1, [&](size_t, size_t b, size_t e) {
+            for (size_t c = b; c < e; ++c)
+                for_each_line(c, [&](const char*, const char*) {
+                    ++m_chunk_records[c + 1];
+                });
+        });
+        for (size_t c = 0; c < chunks; ++c)
+            m_chunk_records[c + 1] += m_chunk_records[c];
+        if (m_chunk_records[chunks] < m_num_records)
+            throw CommonMeshException("PLY Unexpected end of file");
+    }
+
+    // Counting pass over the faces, before decoding, so that their
+    // triangles can be stored in place
+    PlyTriangles count_triangles(const PlyHeader& header) const {
+        PlyTriangles result;
+        for (size_t el = 0; el < header.elements.size(); ++el) {
+            const PlyElement& element = header.elements[el];
+            const PlyProperty* indices =
+                element.name == "face" ? ply_face_indices(element) : nullptr;
+            if (indices == nullptr) continue;
+            result.first.assign(element.count + 1, 0);
+            parallel_chunks(0, chunks(), 1, [&](size_t, size_t b, size_t e) {
+                for (size_t c = b; c < e; ++c)
+                    for_each_record(c, [&](const char* p, const char* eol,
+                                           size_t record_el, size_t i) {
+                        if (record_el != el) return;
+                        result.first[i + 1] = polygon_triangles(
+                            ply_ascii_face_length(p, eol, element, indices));
+                    });
+            });
+            result.accumulate();
+        }
+        return result;
+    }
+
+    void decode(const PlyHeader& header, const PlyOutput& out) const {
+        std::vector<std::vector<PlyTarget>> targets;
+        for (const auto& element : header.elements)
+            targets.push_back(ply_targets(element, out));
+        parallel_chunks(0, chunks(), 1, [&](size_t, size_t b, size_t e) {
+            std::vector<uint32_t> corners;
+            for (size_t c = b; c < e; ++c)
+                for_each_record(c, [&](const char* p, const char* eol,
+                                       size_t el, size_t i) {
+                    ply_parse_ascii_record(p, eol, header.elements[el],
+                                           targets[el], i, out, corners);
+                });
+        });
+    }
+
+   private:
+    std::vector<const char*> m_bounds;       // of each chunk
+    std::vector<size_t> m_chunk_records;     // first record of each chunk
+    std::vector<size_t> m_first_record;      // of each element
+    size_t m_num_records;
+
+    size_t chunks() const { return m_bounds.size() - 1; }
+
+    // lines with anything but spaces are records
+    template <typename LineFunc>
+    void for_each_line(size_t c, const LineFunc& f) const {
+        for (const char* p = m_bounds[c]; p < m_bounds[c + 1];) {
+            const char* eol = std::find(p, m_bounds[c + 1], '\n');
+            const char* q = p;
+            while (q < eol && ply_is_space(*q)) ++q;
+            if (q < eol) f(q, eol);
+            p = eol + 1;
+        }
+    }
+
+    // Calls f(begin, end, element, index) for each record of chunk c
+    template <typename RecordFunc>
+    void for_each_record(size_t c, const RecordFunc& f) const {
+        size_t record = m_chunk_records[c];
+        size_t el = std::upper_bound(m_first_record.begin(),
+                                     m_first_record.end(), record) -
+                    m_first_record.begin() - 1;
+        for_each_line(c, [&](const char* p, const char* eol) {
+            if (record >= m_num_records) return;  // trailing data
+            while (record >= m_first_record[el + 1]) ++el;
+            f(p, eol, el, record - m_first_record[el]);
+            ++record;
+        });
+    }
+};
+
+// Faces were stored as fans, which are only right for convex polygons: the
+// others are split again by ear clipping, into the same number of triangles
+static void ply_triangulate_polygons(const PlyHeader& header,
+                                     const PlyTriangles& triangles,
+                                     const PlyOutput& out) {
+    if (triangles.first.empty()) return;
+    const size_t num_vertices = ply_num_vertices(header);
+    const size_t num_faces = triangles.first.size() - 1;
+    parallel_for(0, num_faces, PLY_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+        std::vector<size_t> corners;
+        std::vector<Vec3f> points;
+        std::vector<unsigned int> split;
+        for (size_t i = b; i < e; ++i) {
+            const size_t t0 = triangles.begin(i), t1 = triangles.end(i);
+            if (t1 - t0 < 2) continue;  // triangles or degenerate
+            corners = {out.get_index(3 * t0), out.get_index(3 * t0 + 1)};
+            for (size_t t = t0; t < t1; ++t)
+                corners.push_back(out.get_index(3 * t + 2));
+            if (std::any_of(corners.begin(), corners.end(),
+                            [&](size_t v) { return v >= num_vertices; }))
+                continue;
+            points.resize(corners.size());
+            for (size_t k = 0; k < corners.size(); ++k) {
+                const float* v = out.vertex(corners[k]);
+                points[k] = Vec3f(v[0], v[1], v[2]);
+            }
+            if (is_convex_polygon(points.data(), points.size())) continue;
+            split.resize(3 * (t1 - t0));
+            triangulate_polygon(points.data(), points.size(), split.data());
+            for (size_t k = 0; k < split.size(); ++k)
+                out.set_index(3 * t0 + k, corners[split[k]]);
+        }
+    });
+}
+
+template <typename MeshType, typename Decoder>
+static MeshType ply_decode(const PlyHeader& header, Decoder&& decoder,
+                           const AttributeMask& mask) {
+    MeshType mesh;
+    const PlyTriangles triangles = decoder.count_triangles(header);
+    const PlyOutput out = ply_allocate(header, triangles, mask, mesh);
+    decoder.decode(header, out);
+    ply_triangulate_polygons(header, triangles, out);
+    return mesh;
+}
+
+template <typename MeshType>
+static MeshType load_ply_as(const uint8_t* data, size_t size,
+                            const AttributeMask& mask) {
+    // the header is small, parse it with the usual stream functions
+    const size_t header_size = ply_header_size(data, size);
+    std::istringstream header_stream(
+        std::string(reinterpret_cast<const char*>(data), header_size));
+    const PlyHeader header = read_ply_header(header_stream);
+    const uint8_t* body = data + header_size;
+    const size_t body_size = size - header_size;
+
+    if (header.format == PlyFormat::Ascii) {
+        const char* text = reinterpret_cast<const char*>(body);
+        return ply_decode<MeshType>(
+            header, PlyAsciiDecoder(text, text + body_size, header), mask);
+    } else if ((header.format == PlyFormat::BinaryLittleEndian) ==
+               machine_is_little_endian()) {
+        return ply_decode<MeshType>(
+            header, PlyBinaryDecoder<false>(body, body_size), mask);
+    } else {
+        return ply_decode<MeshType>(
+            header, PlyBinaryDecoder<true>(body, body_size), mask);
+    }
+}
+
+/// STREAMING ///
+
+// Bytes read from the stream in blocks of at least this size
+static constexpr size_t PLY_STREAM_BLOCK = 1 << 20;
+
+// Body of a PLY file read from a stream as it is needed, so that only the
+// records of the current batch are in memory
+class PlyStreamBuffer {
+   public:
+    explicit PlyStreamBuffer(std::istream& file) : m_file(file) {}
+
+    const uint8_t* data() const { return m_data.data() + m_begin; }
+    size_t size() const { return m_end - m_begin; }
+    void consume(size_t n) { m_begin += n; }
+
+    // Reads until there are n bytes, or until the end of the file, and
+    // returns the number of bytes there are
+    size_t fill(size_t n) {
+        if (size() >= n || !m_file) return size();
+        if (m_begin > 0) {
+            std::memmove(m_data.data(), data(), size());
+            m_end -= m_begin;
+            m_begin = 0;
         }
-    };
-
-    std::stringstream ss;
-    for (const auto& element : all_properties) {
-        const size_t num_elements = std::get<0>(element);
-        const std::vector<std::shared_ptr<Property>>& properties =
-            std::get<1>(element);
-        size_t idx = 0;
-        while (idx < num_elements) {
-            if (is_ascii) {
-                std::getline(file, line);
-                ss = std::stringstream(line);
+        if (m_data.size() < n)
+            m_data.resize(std::max({n, 2 * m_data.size(), PLY_STREAM_BLOCK}));
+        m_file.read(reinterpret_cast<char*>(m_data.data() + m_end),
+                    static_cast<std::streamsize>(m_data.size() - m_end));
+        m_end += static_cast<size_t>(m_file.gcount());
+        return size();
+    }
+
+    // Bytes of the next n records (lines with anything but spaces) of an
+    // ASCII body. Throws CommonMeshException if the file ends before
+    size_t ascii_records(size_t n) {
+        size_t offset = 0;
+        for (size_t records = 0; records < n;) {
+            size_t available = fill(offset + 1);
+            if (available <= offset)
+                throw CommonMeshException("PLY Unexpected end of file");
+            size_t eol = find_newline(offset, available);
+            while (eol == available) {
+                const size_t more = fill(available + 1);
+                if (more == available) break;  // last line, without '\n'
+                eol = find_newline(available, more);
+                available = more;
             }
-            for (const auto& property : properties) {
-                if (!property->is_list()) {
-                    uint64_t value = read_value(property->type(), file, ss);
-                    property->write(mesh, idx, value);
+            const char* text = reinterpret_cast<const char*>(data());
+            records += std::any_of(text + offset, text + eol,
+                                   [](char c) { return !ply_is_space(c); });
+            offset = std::min(eol + 1, available);
+        }
+        return offset;
+    }
+
+    // Bytes of the next n records of element in a binary body. Throws
+    // CommonMeshException if the file ends before
+    template <bool Swap>
+    size_t binary_records(const PlyElement& element, size_t n) {
+        if (element.fixed_size) return require(n * element.record_size);
+        size_t offset = 0;
+        for (size_t i = 0; i < n; ++i)
+            for (const auto& property : element.properties) {
+                if (!property.is_list) {
+                    offset += ply_type_size(property.type);
                     continue;
                 }
+                const size_t count_size = ply_type_size(property.count_type);
+                require(offset + count_size);
+                const size_t count =
+                    ply_load_count<Swap>(property.count_type, data() + offset);
+                offset += count_size + count * ply_type_size(property.type);
+            }
+        return require(offset);
+    }
 
-                const auto fproperty =
-                    std::dynamic_pointer_cast<FaceTriangleProperty>(property);
-                if (fproperty) {
-                    uint8_t length =
-                        read_value(fproperty->length_type(), file, ss);
-                    if (length != 3)
-                        throw detail::CommonMeshException(
-                            "PLY Unexpected face length: " +
-                            std::to_string(length));
-
-                    Vec3u face;
-                    for (size_t i = 0; i < length; ++i) {
-                        face[i] = read_value(fproperty->type(), file, ss);
-                    }
-                    fproperty->write_face(mesh, idx, face);
+   private:
+    std::istream& m_file;
+    std::vector<uint8_t> m_data;
+    size_t m_begin = 0, m_end = 0;
+
+    size_t require(size_t n) {
+        if (fill(n) < n)
+            throw CommonMeshException("PLY Unexpected end of file");
+        return n;
+    }
+
+    size_t find_newline(size_t begin, size_t end) const {
+        const uint8_t* p = std::find(data() + begin, data() + end, '\n');
+        return static_cast<size_t>(p - data());
+    }
+};
+
+struct PlyStreamState {
+    PlyHeader header;
+    AttributeMask mask;
+    size_t batch_size;
+    PlyStreamBuffer buffer;
+    size_t element = 0;  // being read
+    size_t record = 0;   // next one of the element
+    size_t triangles = 0;
+    bool has_vertices = false;
+    bool has_faces = false;
+    PlyVertexBatch vertex_batch;
+    PlyFaceBatch face_batch;
+
+    PlyStreamState(std::istream& file, const AttributeMask& mask,
+                   size_t batch_size)
+        : header(read_ply_header(file)),
+          mask(mask),
+          batch_size(std::max<size_t>(batch_size, 1)),
+          buffer(file) {}
+
+    // Bytes of the next n records of element
+    size_t records_size(const PlyElement& element, size_t n) {
+        if (header.format == PlyFormat::Ascii) return buffer.ascii_records(n);
+        if ((header.format == PlyFormat::BinaryLittleEndian) ==
+            machine_is_little_endian())
+            return buffer.binary_records<false>(element, n);
+        return buffer.binary_records<true>(element, n);
+    }
+
+    // Decodes the records with the same decoders as load_ply, as the body
+    // of a file with only these n records of element
+    Mesh decode(const PlyElement& element, size_t n, size_t size) {
+        PlyHeader batch = {header.format, {element}};
+        batch.elements[0].count = n;
+        const uint8_t* body = buffer.data();
+        if (header.format == PlyFormat::Ascii) {
+            const char* text = reinterpret_cast<const char*>(body);
+            return ply_decode<Mesh>(
+                batch, PlyAsciiDecoder(text, text + size, batch), mask);
+        } else if ((header.format == PlyFormat::BinaryLittleEndian) ==
+                   machine_is_little_endian()) {
+            return ply_decode<Mesh>(
+                batch, PlyBinaryDecoder<false>(body, size), mask);
+        } else {
+            return ply_decode<Mesh>(batch, PlyBinaryDecoder<true>(body, size),
+                                    mask);
+        }
+    }
+
+    bool next() {
+        has_vertices = has_faces = false;
+        while (element < header.elements.size()) {
+            const PlyElement& current = header.elements[element];
+            if (record == current.count) {
+                ++element;
+                record = 0;
+                continue;
+            }
+            const size_t n = std::min(batch_size, current.count - record);
+            const size_t size = records_size(current, n);
+            const bool is_vertex = current.name == "vertex";
+            const bool is_face = current.name == "face" &&
+                                 ply_face_indices(current) != nullptr;
+            if (is_vertex || is_face) {
+                Mesh mesh = decode(current, n, size);
+                if (is_vertex) {
+                    vertex_batch.first = record;
+                    vertex_batch.vertices = std::move(mesh.vertices);
+                    vertex_batch.attributes = std::move(mesh.vertex_attributes);
+                    has_vertices = true;
+                } else {
+                    face_batch.first = record;
+                    face_batch.first_triangle = triangles;
+                    triangles += mesh.faces.size();
+                    face_batch.faces = std::move(mesh.faces);
+                    face_batch.attributes = std::move(mesh.face_attributes);
+                    has_faces = true;
                 }
             }
-            ++idx;
+            buffer.consume(size);
+            record += n;
+            if (is_vertex || is_face) return true;
         }
+        return false;
     }
+};
 
-    return mesh;
+/// WRITER ///
+
+static const char* ply_type_name(PlyType type) {
+    constexpr const char* names[] = {"char", "uchar", "short", "ushort",
+                                     "int",  "uint",  "float", "double"};
+    return names[static_cast<size_t>(type)];
+}
+
+template <typename T, bool Swap>
+inline void ply_store(uint8_t* p, T value) {
+    std::memcpy(p, &value, sizeof(T));
+    if constexpr (Swap && sizeof(T) > 1) std::reverse(p, p + sizeof(T));
+}
+
+// Mesh buffers to write, the counterpart of PlyOutput
+struct PlyInput {
+    const float* vertices = nullptr;
+    size_t vertex_stride = 0;
+    size_t num_vertices = 0;
+    const uint16_t* faces16 = nullptr;
+    const unsigned int* faces32 = nullptr;
+    size_t num_faces = 0;
+    const MeshAttributes* vertex_attributes = nullptr;
+    const MeshAttributes* face_attributes = nullptr;
+};
+
+static PlyInput ply_input(const Mesh& mesh) {
+    PlyInput in;
+    in.vertices = mesh.vertices.data_flat();
+    in.vertex_stride = 4;
+    in.num_vertices = mesh.vertices.size();
+    in.faces32 = mesh.faces.data_flat();
+    in.num_faces = mesh.faces.size();
+    in.vertex_attributes = &mesh.vertex_attributes;
+    in.face_attributes = &mesh.face_attributes;
+    return in;
+}
+
+static PlyInput ply_input(const CompactMesh& mesh) {
+    PlyInput in;
+    in.vertices = mesh.vertices.data_flat();
+    in.vertex_stride = 3;
+    in.num_vertices = mesh.vertices.size();
+    if (mesh.has_16bit_indices())
+        in.faces16 = mesh.faces16.data_flat();
+    else
+        in.faces32 = mesh.faces32.data_flat();
+    in.num_faces = mesh.num_faces();
+    in.vertex_attributes = &mesh.vertex_attributes;
+    in.face_attributes = &mesh.face_attributes;
+    return in;
+}
+
+// Appends the property lines of the attributes, and returns the size of
+// their values in each record
+static size_t ply_write_attribute_properties(std::string& header,
+                                             const MeshAttributes& attributes,
+                                             size_t count) {
+    size_t record_size = 0;
+    for (const auto& channel : attributes) {
+        const std::string& name = channel.first;
+        const size_t size = std::visit(
+            [](const auto& values) { return values.size(); }, channel.second);
+        if (size != count)
+            throw CommonMeshException("PLY Attribute " + name + " has " +
+                                      std::to_string(size) + " values, expected " +
+                                      std::to_string(count));
+        if (name.empty() ||
+            std::any_of(name.begin(), name.end(), ply_is_space))
+            throw CommonMeshException("PLY Invalid attribute name: " + name);
+        const PlyType type = std::visit(
+            [](const auto& values) {
+                using T = typename std::decay_t<decltype(values)>::value_type;
+                return ply_type_of<T>();
+            },
+            channel.second);
+        header += std::string("property ") + ply_type_name(type) + " " +
+                  name + "\n";
+        record_size += ply_type_size(type);
+    }
+    return record_size;
+}
+
+// Records are built by blocks in a buffer, in parallel, and each block is
+// written with a single call
+static constexpr size_t PLY_WRITE_BLOCK = 1 << 18;
+
+template <typename FillFunc>
+static void ply_write_records(std::ostream& file, size_t count,
+                              size_t record_size, const FillFunc& fill) {
+    std::vector<uint8_t> buffer(std::min(count, PLY_WRITE_BLOCK) *
+                                record_size);
+    for (size_t block = 0; block < count; block += PLY_WRITE_BLOCK) {
+        const size_t end = std::min(count, block + PLY_WRITE_BLOCK);
+        parallel_for(block, end, PLY_PARALLEL_CHUNK, [&](size_t b, size_t e) {
+            fill(buffer.data() + (b - block) * record_size, b, e);
+        });
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                   (end - block) * record_size);
+    }
+}
+
+// Writes the values [b, e) of the attributes, starting at p and stride
+// bytes apart
+template <bool Swap>
+static void ply_write_attributes(uint8_t* p, size_t stride,
+                                 const MeshAttributes& attributes, size_t b,
+                                 size_t e) {
+    for (const auto& channel : attributes) {
+        std::visit(
+            [&](const auto& values) {
+                using T = typename std::decay_t<decltype(values)>::value_type;
+                uint8_t* q = p;
+                for (size_t i = b; i < e; ++i, q += stride)
+                    ply_store<T, Swap>(q, values[i]);
+                p += sizeof(T);
+            },
+            channel.second);
+    }
 }
+
+template <bool Swap>
+static void ply_write_body(std::ostream& file, const PlyInput& in,
+                           size_t vertex_size, size_t face_size) {
+    ply_write_records(
+        file, in.num_vertices, vertex_size,
+        [&](uint8_t* p, size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                const float* v = in.vertices + i * in.vertex_stride;
+                uint8_t* record = p + (i - b) * vertex_size;
+                for (size_t axis = 0; axis < 3; ++axis)
+                    ply_store<float, Swap>(record + axis * sizeof(float),
+                                           v[axis]);
+            }
+            ply_write_attributes<Swap>(p + 3 * sizeof(float), vertex_size,
+                                       *in.vertex_attributes, b, e);
+        });
+    ply_write_records(
+        file, in.num_faces, face_size, [&](uint8_t* p, size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                uint8_t* record = p + (i - b) * face_size;
+                record[0] = 3;
+                for (size_t k = 0; k < 3; ++k) {
+                    const uint32_t index =
+                        in.faces16 != nullptr ? in.faces16[3 * i + k]
+                                              : in.faces32[3 * i + k];
+                    ply_store<uint32_t, Swap>(
+                        record + 1 + k * sizeof(uint32_t), index);
+                }
+            }
+            ply_write_attributes<Swap>(p + 1 + 3 * sizeof(uint32_t),
+                                       face_size, *in.face_attributes, b, e);
+        });
+}
+
+static void save_ply_from(std::ostream& file, const PlyInput& in) {
+    std::string header =
+        "ply\nformat binary_little_endian 1.0\n"
+        "comment libcpp-common\n"
+        "element vertex " +
+        std::to_string(in.num_vertices) +
+        "\nproperty float x\nproperty float y\nproperty float z\n";
+    const size_t vertex_size =
+        3 * sizeof(float) + ply_write_attribute_properties(
+                                header, *in.vertex_attributes, in.num_vertices);
+    header += "element face " + std::to_string(in.num_faces) +
+              "\nproperty list uchar uint vertex_indices\n";
+    const size_t face_size =
+        1 + 3 * sizeof(uint32_t) +
+        ply_write_attribute_properties(header, *in.face_attributes,
+                                       in.num_faces);
+    header += "end_header\n";
+    file.write(header.data(), header.size());
+
+    if (machine_is_little_endian())
+        ply_write_body<false>(file, in, vertex_size, face_size);
+    else
+        ply_write_body<true>(file, in, vertex_size, face_size);
+    if (!file) throw CommonMeshException("PLY Could not write file");
+}
+
+};  // namespace detail
+
+Mesh load_ply(const uint8_t* data, size_t size, const AttributeMask& mask) {
+    return detail::load_ply_as<Mesh>(data, size, mask);
+}
+
+CompactMesh load_compact_ply(const uint8_t* data, size_t size,
+                             const AttributeMask& mask) {
+    return detail::load_ply_as<CompactMesh>(data, size, mask);
+}
+
+Mesh load_ply(std::ifstream& file, const AttributeMask& mask) {
+    file.seekg(0, std::ios::end);
+    const size_t size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+    std::vector<uint8_t> data(size);
+    file.read(reinterpret_cast<char*>(data.data()), size);
+    if (!file) throw detail::CommonMeshException("PLY Could not read file");
+    return load_ply(data.data(), size, mask);
+}
+
+PlyStreamReader::PlyStreamReader(std::istream& file, const AttributeMask& mask,
+                                 size_t batch_size)
+    : m_state(std::make_unique<detail::PlyStreamState>(file, mask,
+                                                       batch_size)) {}
+
+PlyStreamReader::~PlyStreamReader() = default;
+
+size_t PlyStreamReader::num_vertices() const {
+    return detail::ply_num_vertices(m_state->header);
+}
+
+size_t PlyStreamReader::num_faces() const {
+    for (const auto& element : m_state->header.elements)
+        if (element.name == "face") return element.count;
+    return 0;
+}
+
+bool PlyStreamReader::next() { return m_state->next(); }
+bool PlyStreamReader::has_vertices() const { return m_state->has_vertices; }
+bool PlyStreamReader::has_faces() const { return m_state->has_faces; }
+
+const PlyVertexBatch& PlyStreamReader::vertex_batch() const {
+    return m_state->vertex_batch;
+}
+
+const PlyFaceBatch& PlyStreamReader::face_batch() const {
+    return m_state->face_batch;
+}
+
+void save_ply(std::ostream& file, const Mesh& mesh) {
+    detail::save_ply_from(file, detail::ply_input(mesh));
+}
+
+void save_ply(std::ostream& file, const CompactMesh& mesh) {
+    detail::save_ply_from(file, detail::ply_input(mesh));
+}
+
 };  // namespace common
@@ -0,0 +1,747 @@
+/*
+ * simplify.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Reduction of the number of faces of a mesh, by edge collapses driven by
+ * quadric error metrics or by clustering its vertices in a grid
+ */
+
+#include "libcpp-common/mesh/simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "libcpp-common/detail/check_faces.h"
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/radix_sort.h"
+#include "libcpp-common/geometry/aabb.h"
+#include "libcpp-common/mesh.h"
+
+namespace common {
+
+namespace detail {
+
+constexpr size_t SIMPLIFY_PARALLEL_MIN = 1 << 13;
+constexpr uint32_t SIMPLIFY_NONE = std::numeric_limits<uint32_t>::max();
+constexpr double SIMPLIFY_INFINITY = std::numeric_limits<double>::infinity();
+// Weight of the planes along the boundary, relative to the ones of the faces
+constexpr double SIMPLIFY_BOUNDARY_WEIGHT = 10;
+// Quadrics with a smaller determinant, relative to the cube of their trace,
+// are minimized along the edge (or replaced by the mean of the cell)
+constexpr double SIMPLIFY_SINGULAR = 1e-6;
+
+using Vec3d = Vec<double, 3>;
+
+static inline Vec3d to_double(const Vec4f& p) {
+    return Vec3d(double(p[0]), double(p[1]), double(p[2]));
+}
+
+// Sum of the squared distances to a set of planes,
+// q(p) = p^T A p + 2 b^T p + c with a symmetric A
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0;
+
+    Quadric() = default;
+    // Plane dot(n, p) + d = 0 with a unit normal, times weight
+    Quadric(const Vec3d& n, double d, double weight)
+        : a00(weight * n[0] * n[0]),
+          a01(weight * n[0] * n[1]),
+          a02(weight * n[0] * n[2]),
+          a11(weight * n[1] * n[1]),
+          a12(weight * n[1] * n[2]),
+          a22(weight * n[2] * n[2]),
+          b0(weight * d * n[0]),
+          b1(weight * d * n[1]),
+          b2(weight * d * n[2]),
+          c(weight * d * d) {}
+
+    Quadric& operator+=(const Quadric& q) {
+        a00 += q.a00, a01 += q.a01, a02 += q.a02;
+        a11 += q.a11, a12 += q.a12, a22 += q.a22;
+        b0 += q.b0, b1 += q.b1, b2 += q.b2;
+        c += q.c;
+        return *this;
+    }
+    Quadric operator+(const Quadric& q) const {
+        Quadric result = *this;
+        return result += q;
+    }
+
+    Vec3d multiply(const Vec3d& p) const {
+        return Vec3d(a00 * p[0] + a01 * p[1] + a02 * p[2],
+                     a01 * p[0] + a11 * p[1] + a12 * p[2],
+                     a02 * p[0] + a12 * p[1] + a22 * p[2]);
+    }
+    // Rounding can make it slightly negative
+    double operator()(const Vec3d& p) const {
+        const double q = dot(p, multiply(p)) +
+                         2 * (b0 * p[0] + b1 * p[1] + b2 * p[2]) + c;
+        return std::max(q, 0.0);
+    }
+
+    // Point where the quadric is minimum, -A^-1 b, or false if A is close
+    // to singular (e.g. all the planes are parallel) and there is no single
+    // minimum
+    bool minimum(Vec3d& p) const {
+        const double c00 = a11 * a22 - a12 * a12;
+        const double c01 = a02 * a12 - a01 * a22;
+        const double c02 = a01 * a12 - a02 * a11;
+        const double det = a00 * c00 + a01 * c01 + a02 * c02;
+        const double trace = a00 + a11 + a22;
+        if (!(std::abs(det) > SIMPLIFY_SINGULAR * trace * trace * trace))
+            return false;
+        const double c11 = a00 * a22 - a02 * a02;
+        const double c12 = a01 * a02 - a00 * a12;
+        const double c22 = a00 * a11 - a01 * a01;
+        p = Vec3d(c00 * b0 + c01 * b1 + c02 * b2,
+                  c01 * b0 + c11 * b1 + c12 * b2,
+                  c02 * b0 + c12 * b1 + c22 * b2) /
+            -det;
+        return true;
+    }
+};
+
+// Quadrics of the planes of the faces around each vertex, gathered per
+// vertex in parallel. Degenerate faces do not add anything
+static std::vector<Quadric> face_quadrics(const Mesh& mesh,
+                                          const Adjacency& adjacency) {
+    std::vector<Quadric> faces(mesh.faces.size());
+    parallel_for(0, mesh.faces.size(), SIMPLIFY_PARALLEL_MIN,
+                 [&](size_t b, size_t e) {
+                     for (size_t i = b; i < e; ++i) {
+                         const Vec3u& f = mesh.faces[i];
+                         const Vec3d p0 = to_double(mesh.vertices[f[0]]);
+                         const Vec3d n =
+                             cross(to_double(mesh.vertices[f[1]]) - p0,
+                                   to_double(mesh.vertices[f[2]]) - p0);
+                         const double length = n.module();
+                         if (length > 0)
+                             faces[i] = Quadric(n / length,
+                                                -dot(n, p0) / length, 1);
+                     }
+                 });
+    std::vector<Quadric> vertices(mesh.vertices.size());
+    parallel_for(0, mesh.vertices.size(), SIMPLIFY_PARALLEL_MIN,
+                 [&](size_t b, size_t e) {
+                     for (size_t v = b; v < e; ++v)
+                         for (uint32_t face : adjacency[v])
+                             vertices[v] += faces[face];
+                 });
+    return vertices;
+}
+
+// First index of each run of equal elements (same(i - 1, i)) of a sorted
+// array of n elements, followed by n
+template <typename Same>
+static std::vector<uint32_t> run_starts(size_t n, const Same& same) {
+    auto starts_run = [&](size_t i) { return i == 0 || !same(i - 1, i); };
+    std::vector<size_t> first(num_chunks(n, SIMPLIFY_PARALLEL_MIN) + 1, 0);
+    parallel_chunks(0, n, SIMPLIFY_PARALLEL_MIN,
+                    [&](size_t c, size_t b, size_t e) {
+                        for (size_t i = b; i < e; ++i)
+                            first[c + 1] += starts_run(i);
+                    });
+    for (size_t c = 1; c < first.size(); ++c) first[c] += first[c - 1];
+    std::vector<uint32_t> starts(first.back() + 1);
+    parallel_chunks(0, n, SIMPLIFY_PARALLEL_MIN,
+                    [&](size_t c, size_t b, size_t e) {
+                        size_t next = first[c];
+                        for (size_t i = b; i < e; ++i)
+                            if (starts_run(i)) starts[next++] = uint32_t(i);
+                    });
+    starts.back() = uint32_t(n);
+    return starts;
+}
+
+// Keeps the faces for which keep[i] is true, in their order, and the
+// vertices they use, with the positions of the new vertices (new_vertices[j]
+// is the position of old vertex j, and vertex_order gives the attributes
+// of each one)
+static void compact_mesh(Mesh& mesh, const std::vector<uint8_t>& keep,
+                         const VecList4f& new_vertices,
+                         const std::vector<uint32_t>& vertex_order) {
+    std::vector<uint32_t> face_order;
+    std::vector<uint32_t> index(new_vertices.size(), SIMPLIFY_NONE);
+    for (size_t i = 0; i < mesh.faces.size(); ++i) {
+        if (!keep[i]) continue;
+        face_order.push_back(uint32_t(i));
+        for (unsigned int k = 0; k < 3; ++k) index[mesh.faces[i][k]] = 0;
+    }
+    std::vector<uint32_t> order;
+    VecList4f vertices;
+    for (size_t v = 0; v < index.size(); ++v) {
+        if (index[v] == SIMPLIFY_NONE) continue;
+        index[v] = uint32_t(order.size());
+        order.push_back(vertex_order[v]);
+        vertices.push_back(new_vertices[v]);
+    }
+    VecList3u faces(face_order.size());
+    parallel_for(0, faces.size(), SIMPLIFY_PARALLEL_MIN,
+                 [&](size_t b, size_t e) {
+                     for (size_t i = b; i < e; ++i) {
+                         const Vec3u& f = mesh.faces[face_order[i]];
+                         faces[i] =
+                             Vec3u(index[f[0]], index[f[1]], index[f[2]]);
+                     }
+                 });
+    mesh.vertices = std::move(vertices);
+    mesh.faces = std::move(faces);
+    mesh.vertex_attributes.reorder(order);
+    mesh.face_attributes.reorder(face_order);
+}
+
+/// EDGE COLLAPSE ///
+
+// Binary min-heap of vertices by the cost of their cheapest collapse, which
+// knows where each vertex is so that its cost can be changed in O(log n).
+// Costs are stored in the heap, so that sifting does not jump to them
+class CollapseHeap {
+   public:
+    // Vertices with a finite cost, heapified in O(n)
+    explicit CollapseHeap(const std::vector<double>& costs)
+        : m_position(costs.size(), SIMPLIFY_NONE) {
+        for (uint32_t v = 0; v < costs.size(); ++v)
+            if (costs[v] != SIMPLIFY_INFINITY) m_heap.push_back({costs[v], v});
+        for (size_t i = m_heap.size(); i-- > 0;) sift_down(i);
+    }
+
+    bool empty() const { return m_heap.empty(); }
+    bool contains(uint32_t v) const { return m_position[v] != SIMPLIFY_NONE; }
+    uint32_t top() const { return m_heap[0].vertex; }
+    double cost(uint32_t v) const { return m_heap[m_position[v]].cost; }
+
+    // Inserts v, or moves it to its new cost
+    void update(uint32_t v, double cost) {
+        if (m_position[v] == SIMPLIFY_NONE) {
+            m_position[v] = uint32_t(m_heap.size());
+            m_heap.push_back({cost, v});
+        }
+        const size_t i = m_position[v];
+        const double old = m_heap[i].cost;
+        m_heap[i].cost = cost;
+        if (cost < old)
+            sift_up(i);
+        else
+            sift_down(i);
+    }
+
+    void remove(uint32_t v) {
+        const uint32_t i = m_position[v];
+        if (i == SIMPLIFY_NONE) return;
+        m_position[v] = SIMPLIFY_NONE;
+        const Entry last = m_heap.back();
+        m_heap.pop_back();
+        if (i == m_heap.size()) return;
+        m_heap[i] = last;
+        m_position[last.vertex] = i;
+        sift_down(sift_up(i));
+    }
+
+   private:
+    struct Entry {
+        double cost;
+        uint32_t vertex;
+    };
+
+    std::vector<Entry> m_heap;
+    std::vector<uint32_t> m_position;  // in m_heap, or SIMPLIFY_NONE
+
+    void place(size_t i, const Entry& entry) {
+        m_heap[i] = entry;
+        m_position[entry.vertex] = uint32_t(i);
+    }
+
+    size_t sift_up(size_t i) {
+        const Entry entry = m_heap[i];
+        while (i > 0 && m_heap[(i - 1) / 2].cost > entry.cost) {
+            place(i, m_heap[(i - 1) / 2]);
+            i = (i - 1) / 2;
+        }
+        place(i, entry);
+        return i;
+    }
+
+    void sift_down(size_t i) {
+        const Entry entry = m_heap[i];
+        const size_t n = m_heap.size();
+        while (2 * i + 1 < n) {
+            size_t child = 2 * i + 1;
+            if (child + 1 < n && m_heap[child + 1].cost < m_heap[child].cost)
+                ++child;
+            if (m_heap[child].cost >= entry.cost) break;
+            place(i, m_heap[child]);
+            i = child;
+        }
+        place(i, entry);
+    }
+};
+
+// Garland and Heckbert. Surface simplification using quadric error metrics
+// (1997). The faces around each vertex are a linked list of its corners in
+// flat arrays: collapsing v into u renames v in its faces and appends its
+// list to the one of u, and corners of removed faces are unlinked the next
+// time a list is walked. The heap holds the cheapest collapse of each
+// vertex, which is recomputed for the neighbours of the vertex that is left
+// and only validated when it gets to the top
+class EdgeCollapse {
+   public:
+    explicit EdgeCollapse(Mesh& mesh)
+        : m_mesh(mesh),
+          m_faces(mesh.faces),
+          m_position(mesh.vertices.size()),
+          m_first_corner(mesh.vertices.size(), SIMPLIFY_NONE),
+          m_next_corner(3 * mesh.faces.size(), SIMPLIFY_NONE),
+          m_removed_face(mesh.faces.size(), 0),
+          m_removed_vertex(mesh.vertices.size(), 0),
+          m_boundary(mesh.vertices.size(), 0),
+          m_target(mesh.vertices.size(), SIMPLIFY_NONE),
+          m_mark(mesh.vertices.size(), 0),
+          m_heap({}) {
+        const size_t n = mesh.vertices.size();
+        parallel_for(0, n, SIMPLIFY_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t v = b; v < e; ++v)
+                m_position[v] = to_double(mesh.vertices[v]);
+        });
+        // faces with a repeated vertex are never linked
+        parallel_for(0, m_faces.size(), SIMPLIFY_PARALLEL_MIN,
+                     [&](size_t b, size_t e) {
+                         for (size_t i = b; i < e; ++i) {
+                             const Vec3u& f = m_faces[i];
+                             m_removed_face[i] =
+                                 f[0] == f[1] || f[1] == f[2] || f[2] == f[0];
+                         }
+                     });
+        m_faces_left = size_t(std::count(m_removed_face.begin(),
+                                         m_removed_face.end(), 0));
+
+        const Adjacency adjacency = vertex_face_adjacency(mesh);
+        m_quadric = face_quadrics(mesh, adjacency);
+        parallel_for(0, n, SIMPLIFY_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t v = b; v < e; ++v) {
+                uint32_t* link = &m_first_corner[v];
+                for (uint32_t face : adjacency[v]) {
+                    if (m_removed_face[face]) continue;
+                    const Vec3u& f = m_faces[face];
+                    *link = 3 * face + (f[0] == v ? 0 : f[1] == v ? 1 : 2);
+                    link = &m_next_corner[*link];
+                }
+                add_boundary(uint32_t(v));
+            }
+        });
+
+        std::vector<double> costs(n);
+        parallel_for(0, n, SIMPLIFY_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t v = b; v < e; ++v)
+                costs[v] = evaluate(uint32_t(v), false);
+        });
+        m_heap = CollapseHeap(costs);
+    }
+
+    // Squared error of the costliest collapse
+    double run(size_t target_faces, double max_error) {
+        double error = 0;
+        while (m_faces_left > target_faces && !m_heap.empty()) {
+            const uint32_t v = m_heap.top();
+            const double cost = m_heap.cost(v);
+            if (cost > max_error) break;
+            const uint32_t u = m_target[v];
+            Vec3d p;
+            placement(v, u, p);
+            if (!can_collapse(v, u, p)) {
+                refresh(v, true);
+                continue;
+            }
+            collapse(v, u, p);
+            error = std::max(error, cost);
+        }
+        return error;
+    }
+
+    void finish() {
+        std::vector<uint8_t> keep(m_faces.size());
+        VecList4f vertices(m_position.size());
+        std::vector<uint32_t> order(m_position.size());
+        for (size_t i = 0; i < keep.size(); ++i) keep[i] = !m_removed_face[i];
+        for (size_t v = 0; v < vertices.size(); ++v) {
+            vertices[v] =
+                Vec4f(float(m_position[v][0]), float(m_position[v][1]),
+                      float(m_position[v][2]), m_mesh.vertices[v][3]);
+            order[v] = uint32_t(v);
+        }
+        compact_mesh(m_mesh, keep, vertices, order);
+    }
+
+   private:
+    Mesh& m_mesh;
+    VecList3u& m_faces;
+    std::vector<Vec3d> m_position;
+    std::vector<Quadric> m_quadric;
+    // corner 3 * f + k of each vertex, linked by m_next_corner
+    std::vector<uint32_t> m_first_corner;
+    std::vector<uint32_t> m_next_corner;
+    std::vector<uint8_t> m_removed_face;
+    std::vector<uint8_t> m_removed_vertex;
+    std::vector<uint8_t> m_boundary;
+    std::vector<uint32_t> m_target;  // of the cheapest collapse
+    std::vector<uint32_t> m_mark;    // of the neighbours, see can_collapse
+    uint32_t m_stamp = 0;
+    std::vector<uint32_t> m_ring;  // reused to refresh the neighbours
+    CollapseHeap m_heap;
+    size_t m_faces_left;
+
+    // Calls f(face, k) for the faces left around v, with v at corner k.
+    // Only writes to unlink removed faces, so it can be called from many
+    // threads before the first collapse
+    template <typename Func>
+    void for_each_corner(uint32_t v, const Func& f) {
+        uint32_t* link = &m_first_corner[v];
+        while (*link != SIMPLIFY_NONE) {
+            const uint32_t corner = *link;
+            if (m_removed_face[corner / 3]) {
+                *link = m_next_corner[corner];
+                continue;
+            }
+            f(corner / 3, corner % 3);
+            link = &m_next_corner[corner];
+        }
+    }
+
+    // Edges of v with a single face get a plane through them orthogonal to
+    // it, added to v (and to the other vertex from its side)
+    void add_boundary(uint32_t v) {
+        auto has_corner = [&](unsigned int offset, uint32_t other) {
+            bool found = false;
+            for_each_corner(v, [&](uint32_t face, unsigned int k) {
+                found |= m_faces[face][(k + offset) % 3] == other;
+            });
+            return found;
+        };
+        for_each_corner(v, [&](uint32_t face, unsigned int k) {
+            const Vec3u& f = m_faces[face];
+            // v -> a without a -> v, or b -> v without v -> b
+            for (unsigned int offset : {1u, 2u}) {
+                const uint32_t other = f[(k + offset) % 3];
+                if (has_corner(3 - offset, other)) continue;
+                m_boundary[v] = 1;
+                const Vec3d p0 = m_position[f[0]];
+                const Vec3d normal = cross(m_position[f[1]] - p0,
+                                           m_position[f[2]] - p0);
+                const Vec3d edge = m_position[other] - m_position[v];
+                Vec3d n = cross(edge, normal);
+                const double length = n.module();
+                if (length == 0) continue;
+                n /= length;
+                m_quadric[v] += Quadric(n, -dot(n, m_position[v]),
+                                        SIMPLIFY_BOUNDARY_WEIGHT);
+            }
+        });
+    }
+
+    // Position of the vertex that replaces v and u, and its cost: the
+    // minimum of their quadrics, or the minimum along the edge if it is
+    // not unique or too far away
+    double placement(uint32_t v, uint32_t u, Vec3d& p) const {
+        const Quadric q = m_quadric[v] + m_quadric[u];
+        const Vec3d& pv = m_position[v];
+        const Vec3d d = m_position[u] - pv;
+        if (q.minimum(p)) {
+            const Vec3d offset = p - (pv + m_position[u]) * 0.5;
+            if (dot(offset, offset) <= dot(d, d)) return q(p);
+        }
+        // q(pv + t d) = q(pv) + 2 t g + t^2 h
+        const double g = dot(q.multiply(pv), d) +
+                         (q.b0 * d[0] + q.b1 * d[1] + q.b2 * d[2]);
+        const double h = dot(d, q.multiply(d));
+        const double t = h > 0 ? std::clamp(-g / h, 0.0, 1.0)
+                               : (q(pv + d) < q(pv) ? 1.0 : 0.0);
+        p = pv + d * t;
+        return q(p);
+    }
+
+    // Whether a face with corners moving, a, b turns around when moving
+    // goes from old to p
+    bool flips(const Vec3d& old, const Vec3d& p, uint32_t a,
+               uint32_t b) const {
+        const Vec3d& pa = m_position[a];
+        const Vec3d& pb = m_position[b];
+        const Vec3d before = cross(pa - old, pb - old);
+        const Vec3d after = cross(pa - p, pb - p);
+        return dot(before, after) <= 0 && dot(before, before) > 0;
+    }
+
+    // Whether collapsing the edge v, u into p keeps the mesh manifold (the
+    // vertices adjacent to both are the ones opposite to the edge, and two
+    // boundaries are not joined through the inside) and does not flip faces
+    bool can_collapse(uint32_t v, uint32_t u, const Vec3d& p) {
+        if (m_stamp >= std::numeric_limits<uint32_t>::max() - 2) {
+            std::fill(m_mark.begin(), m_mark.end(), 0);
+            m_stamp = 0;
+        }
+        const uint32_t mark = ++m_stamp;
+        ++m_stamp;
+        bool valid = true;
+        unsigned int shared = 0, common = 0;
+        for_each_corner(v, [&](uint32_t face, unsigned int k) {
+            const uint32_t a = m_faces[face][(k + 1) % 3];
+            const uint32_t b = m_faces[face][(k + 2) % 3];
+            if (a != u) m_mark[a] = mark;
+            if (b != u) m_mark[b] = mark;
+            if (a == u || b == u)
+                ++shared;
+            else
+                valid = valid && !flips(m_position[v], p, a, b);
+        });
+        for_each_corner(u, [&](uint32_t face, unsigned int k) {
+            const uint32_t a = m_faces[face][(k + 1) % 3];
+            const uint32_t b = m_faces[face][(k + 2) % 3];
+            for (uint32_t w : {a, b}) {
+                if (w == v || m_mark[w] != mark) continue;
+                m_mark[w] = mark + 1;
+                ++common;
+            }
+            if (a != v && b != v)
+                valid = valid && !flips(m_position[u], p, a, b);
+        });
+        return valid && shared > 0 && common == shared &&
+               !(shared > 1 && m_boundary[v] && m_boundary[u]);
+    }
+
+    // Cost of the cheapest collapse of v with one of its neighbours, which
+    // is stored in m_target[v]
+    double evaluate(uint32_t v, bool validate) {
+        double best = SIMPLIFY_INFINITY;
+        uint32_t target = SIMPLIFY_NONE;
+        // each neighbour is at the end of an edge going out of v, except
+        // for one of the ones along the boundary
+        const unsigned int offsets = m_boundary[v] ? 2 : 1;
+        for_each_corner(v, [&](uint32_t face, unsigned int k) {
+            for (unsigned int offset = 1; offset <= offsets; ++offset) {
+                const uint32_t u = m_faces[face][(k + offset) % 3];
+                Vec3d p;
+                const double cost = placement(v, u, p);
+                if (cost < best && (!validate || can_collapse(v, u, p))) {
+                    best = cost;
+                    target = u;
+                }
+            }
+        });
+        m_target[v] = target;
+        return best;
+    }
+
+    void refresh(uint32_t v, bool validate) {
+        const double cost = evaluate(v, validate);
+        if (cost == SIMPLIFY_INFINITY)
+            m_heap.remove(v);
+        else
+            m_heap.update(v, cost);
+    }
+
+    // After collapsing v into u, only the edge of w with u has changed, so
+    // it is evaluated alone unless the cheapest collapse of w was into one
+    // of them
+    void refresh_edge(uint32_t w, uint32_t v, uint32_t u) {
+        if (m_target[w] == v || m_target[w] == u || !m_heap.contains(w))
+            return refresh(w, false);
+        Vec3d p;
+        const double cost = placement(w, u, p);
+        if (cost < m_heap.cost(w)) {
+            m_target[w] = u;
+            m_heap.update(w, cost);
+        }
+    }
+
+    void collapse(uint32_t v, uint32_t u, const Vec3d& p) {
+        m_position[u] = p;
+        m_quadric[u] += m_quadric[v];
+        m_boundary[u] |= m_boundary[v];
+        m_removed_vertex[v] = 1;
+        m_heap.remove(v);
+
+        // faces of the edge are removed, the other ones of v move to u
+        uint32_t* link = &m_first_corner[v];
+        while (*link != SIMPLIFY_NONE) {
+            const uint32_t corner = *link;
+            Vec3u& f = m_faces[corner / 3];
+            if (!m_removed_face[corner / 3] &&
+                (f[0] == u || f[1] == u || f[2] == u)) {
+                m_removed_face[corner / 3] = 1;
+                --m_faces_left;
+            }
+            if (m_removed_face[corner / 3]) {
+                *link = m_next_corner[corner];
+                continue;
+            }
+            f[corner % 3] = u;
+            link = &m_next_corner[corner];
+        }
+        *link = m_first_corner[u];
+        m_first_corner[u] = m_first_corner[v];
+        m_first_corner[v] = SIMPLIFY_NONE;
+
+        m_ring.clear();
+        for_each_corner(u, [&](uint32_t face, unsigned int k) {
+            m_ring.push_back(m_faces[face][(k + 1) % 3]);
+            m_ring.push_back(m_faces[face][(k + 2) % 3]);
+        });
+        std::sort(m_ring.begin(), m_ring.end());
+        m_ring.erase(std::unique(m_ring.begin(), m_ring.end()), m_ring.end());
+        refresh(u, false);
+        for (uint32_t w : m_ring) refresh_edge(w, v, u);
+    }
+};
+
+/// CLUSTERING ///
+
+// Vertex with its cell, (x << (bits_y + bits_z)) | (y << bits_z) | z
+struct CellVertex {
+    uint64_t cell;
+    uint32_t vertex;
+};
+
+// Face with its first two vertices as (a << bits) | b and its last one,
+// after rotating its lowest vertex to the front
+struct FaceKey {
+    uint64_t key;
+    uint32_t last;
+    uint32_t face;
+};
+
+};  // namespace detail
+
+float simplify_mesh(Mesh& mesh, size_t target_faces, float max_error) {
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    if (mesh.faces.size() <= target_faces) return 0;
+    detail::EdgeCollapse simplifier(mesh);
+    const double error = simplifier.run(
+        target_faces, double(max_error) * double(max_error));
+    simplifier.finish();
+    return float(std::sqrt(error));
+}
+
+void simplify_mesh_clustering(Mesh& mesh, float cell_size) {
+    using detail::SIMPLIFY_PARALLEL_MIN;
+    detail::check_faces(mesh.faces, mesh.vertices.size());
+    if (!(cell_size > 0))
+        throw detail::CommonMeshException("The cell size has to be positive");
+    const size_t n = mesh.vertices.size();
+    if (n == 0) return;
+
+    // lowest corner of the grid
+    const AABB4f box = bounds(mesh.vertices);
+    unsigned int bits[3], total_bits = 0;
+    for (unsigned int k = 0; k < 3; ++k) {
+        const double cells =
+            std::floor((double(box.max[k]) - box.min[k]) / cell_size) + 1;
+        bits[k] = cells < 4294967296.0 ? detail::bit_width(size_t(cells)) : 64;
+        total_bits += bits[k];
+    }
+    if (total_bits > 64)
+        throw detail::CommonMeshException(
+            "The cell size is too small for the extent of the mesh");
+
+    // vertices sorted by cell, and by index within each cell
+    std::vector<detail::CellVertex> cells(n);
+    detail::parallel_for(0, n, SIMPLIFY_PARALLEL_MIN, [&](size_t b, size_t e) {
+        for (size_t v = b; v < e; ++v) {
+            uint64_t cell = 0;
+            for (unsigned int k = 0; k < 3; ++k)
+                cell = cell << bits[k] |
+                       uint64_t((double(mesh.vertices[v][k]) - box.min[k]) /
+                                cell_size);
+            cells[v] = {cell, uint32_t(v)};
+        }
+    });
+    detail::radix_sort(cells, total_bits,
+                       [](const detail::CellVertex& c) { return c.cell; });
+    const std::vector<uint32_t> starts =
+        detail::run_starts(n, [&](size_t i, size_t j) {
+            return cells[i].cell == cells[j].cell;
+        });
+    const size_t clusters = starts.size() - 1;
+
+    // point of each cluster that is closest to the planes of its faces,
+    // kept within its cell, or the mean of its vertices
+    const Adjacency adjacency = vertex_face_adjacency(mesh);
+    const std::vector<detail::Quadric> quadrics =
+        detail::face_quadrics(mesh, adjacency);
+    std::vector<uint32_t> cluster(n);
+    VecList4f vertices(clusters);
+    std::vector<uint32_t> order(clusters);
+    detail::parallel_for(
+        0, clusters, SIMPLIFY_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                detail::Quadric q;
+                detail::Vec3d mean(0);
+                for (uint32_t j = starts[i]; j < starts[i + 1]; ++j) {
+                    const uint32_t v = cells[j].vertex;
+                    cluster[v] = uint32_t(i);
+                    q += quadrics[v];
+                    mean += detail::to_double(mesh.vertices[v]);
+                }
+                mean /= double(starts[i + 1] - starts[i]);
+                detail::Vec3d p;
+                if (!q.minimum(p)) p = mean;
+                for (unsigned int k = 0; k < 3; ++k)
+                    if (std::abs(p[k] - mean[k]) > cell_size) p = mean;
+                const uint32_t first = cells[starts[i]].vertex;
+                vertices[i] = Vec4f(float(p[0]), float(p[1]), float(p[2]),
+                                    mesh.vertices[first][3]);
+                order[i] = first;
+            }
+        });
+
+    // faces without repeated clusters, and the first of the ones with the
+    // same clusters in the same order: each run of faces with the same first
+    // two clusters is sorted by the last one
+    const size_t m = mesh.faces.size();
+    const unsigned int cluster_bits = detail::bit_width(clusters);
+    std::vector<detail::FaceKey> keys(m);
+    detail::parallel_for(0, m, SIMPLIFY_PARALLEL_MIN, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            Vec3u& f = mesh.faces[i];
+            f = Vec3u(cluster[f[0]], cluster[f[1]], cluster[f[2]]);
+            const unsigned int k = f[0] < f[1] ? (f[0] < f[2] ? 0 : 2)
+                                               : (f[1] < f[2] ? 1 : 2);
+            f = Vec3u(f[k], f[(k + 1) % 3], f[(k + 2) % 3]);
+            keys[i] = {uint64_t(f[0]) << cluster_bits | f[1], f[2],
+                       uint32_t(i)};
+        }
+    });
+    detail::radix_sort(keys, 2 * cluster_bits,
+                       [](const detail::FaceKey& k) { return k.key; });
+    const std::vector<uint32_t> face_starts =
+        detail::run_starts(m, [&](size_t i, size_t j) {
+            return keys[i].key == keys[j].key;
+        });
+    const uint64_t low_mask = (uint64_t(1) << cluster_bits) - 1;
+    std::vector<uint8_t> keep(m);
+    detail::parallel_for(
+        0, face_starts.size() - 1, SIMPLIFY_PARALLEL_MIN,
+        [&](size_t b, size_t e) {
+            for (size_t r = b; r < e; ++r) {
+                detail::FaceKey* begin = keys.data() + face_starts[r];
+                detail::FaceKey* end = keys.data() + face_starts[r + 1];
+                auto before = [](const detail::FaceKey& x,
+                                 const detail::FaceKey& y) {
+                    return x.last < y.last ||
+                           (x.last == y.last && x.face < y.face);
+                };
+                if (end - begin > 1) std::sort(begin, end, before);
+                const uint64_t f0 = begin->key >> cluster_bits,
+                               f1 = begin->key & low_mask;
+                for (const detail::FaceKey* k = begin; k < end; ++k)
+                    keep[k->face] = f0 != f1 && f1 != k->last &&
+                                    k->last != f0 &&
+                                    (k == begin || k[-1].last != k->last);
+            }
+        });
+    detail::compact_mesh(mesh, keep, vertices, order);
+}
+
+};  // namespace common
@@ -0,0 +1,116 @@
+/*
+ * triangulate.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Triangulation of polygonal faces
+ */
+
+#include "libcpp-common/mesh/triangulate.h"
+
+#include <cmath>
+#include <vector>
+
+namespace common {
+
+namespace detail {
+
+// Polygon projected to the plane of its two least significant axes (of
+// Newell's normal), so that the winding is preserved up to the sign
+struct ProjectedPolygon {
+    const Vec3f* points;
+    unsigned int u, v;
+    double sign;  // of the area, so that convex corners have turn() > 0
+
+    ProjectedPolygon(const Vec3f* points, size_t n) : points(points) {
+        double normal[3] = {0, 0, 0};
+        for (size_t i = 0; i < n; ++i) {
+            const Vec3f& a = points[i];
+            const Vec3f& b = points[(i + 1) % n];
+            normal[0] += (double(a.y()) - b.y()) * (double(a.z()) + b.z());
+            normal[1] += (double(a.z()) - b.z()) * (double(a.x()) + b.x());
+            normal[2] += (double(a.x()) - b.x()) * (double(a.y()) + b.y());
+        }
+        unsigned int axis = 0;
+        for (unsigned int i = 1; i < 3; ++i)
+            if (std::abs(normal[i]) > std::abs(normal[axis])) axis = i;
+        u = (axis + 1) % 3;
+        v = (axis + 2) % 3;
+        sign = normal[axis] < 0 ? -1 : 1;
+    }
+
+    // Twice the signed area of the triangle (a, b, c), positive if it turns
+    // like the polygon
+    double turn(size_t a, size_t b, size_t c) const {
+        const Vec3f &pa = points[a], &pb = points[b], &pc = points[c];
+        return sign * ((double(pb[u]) - pa[u]) * (double(pc[v]) - pa[v]) -
+                       (double(pb[v]) - pa[v]) * (double(pc[u]) - pa[u]));
+    }
+
+    bool inside(size_t p, size_t a, size_t b, size_t c) const {
+        return turn(a, b, p) >= 0 && turn(b, c, p) >= 0 && turn(c, a, p) >= 0;
+    }
+};
+
+static void fan(size_t n, unsigned int* triangles) {
+    for (unsigned int i = 1; i + 1 < n; ++i) {
+        *triangles++ = 0;
+        *triangles++ = i;
+        *triangles++ = i + 1;
+    }
+}
+
+};  // namespace detail
+
+bool is_convex_polygon(const Vec3f* points, size_t n) {
+    if (n <= 3) return true;
+    const detail::ProjectedPolygon polygon(points, n);
+    for (size_t i = 0; i < n; ++i)
+        if (polygon.turn(i, (i + 1) % n, (i + 2) % n) < 0) return false;
+    return true;
+}
+
+void triangulate_polygon(const Vec3f* points, size_t n,
+                         unsigned int* triangles) {
+    if (n < 3) return;
+    if (is_convex_polygon(points, n)) {
+        detail::fan(n, triangles);
+        return;
+    }
+
+    // ear clipping: cut convex corners whose triangle contains no other
+    // corner, until a triangle is left
+    const detail::ProjectedPolygon polygon(points, n);
+    std::vector<unsigned int> corners(n);
+    for (unsigned int i = 0; i < n; ++i) corners[i] = i;
+    size_t i = 0, misses = 0;
+    while (corners.size() > 3) {
+        const size_t m = corners.size();
+        const unsigned int a = corners[(i + m - 1) % m], b = corners[i % m],
+                           c = corners[(i + 1) % m];
+        bool ear = polygon.turn(a, b, c) > 0;
+        for (size_t j = 0; ear && j < m; ++j) {
+            const unsigned int p = corners[j];
+            ear = p == a || p == b || p == c ||
+                  points[p] == points[a] || points[p] == points[b] ||
+                  points[p] == points[c] || !polygon.inside(p, a, b, c);
+        }
+        // self-intersecting or degenerate polygons may have no ears left,
+        // then corners are cut anyway so that it always finishes
+        if (ear || misses >= m) {
+            *triangles++ = a;
+            *triangles++ = b;
+            *triangles++ = c;
+            corners.erase(corners.begin() + i % m);
+            i %= m - 1;
+            misses = 0;
+        } else {
+            i = (i + 1) % m;
+            ++misses;
+        }
+    }
+    *triangles++ = corners[0];
+    *triangles++ = corners[1];
+    *triangles++ = corners[2];
+}
+
+};  // namespace common
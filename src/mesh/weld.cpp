@@ -0,0 +1,337 @@
+/*
+ * weld.cpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Merging of duplicated vertices, e.g. of STL-like meshes in which each face
+ * has its own three vertices
+ */
+
+#include "libcpp-common/mesh/weld.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "libcpp-common/detail/check_faces.h"
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/mesh.h"
+
+namespace common {
+
+namespace detail {
+
+constexpr size_t WELD_PARALLEL_MIN = 1 << 14;
+// Buckets are sorted in up to 2^WELD_PARTITION_BITS partitions first
+constexpr unsigned int WELD_PARTITION_BITS = 10;
+
+// Cell of the grid of a position, or its bits for epsilon = 0
+struct WeldCell {
+    int64_t c[3];
+};
+
+static inline uint32_t weld_hash(const WeldCell& cell) {
+    uint64_t h = uint64_t(cell.c[0]) * 0x9e3779b97f4a7c15ull ^
+                 uint64_t(cell.c[1]) * 0xc2b2ae3d27d4eb4full ^
+                 uint64_t(cell.c[2]) * 0x165667b19e3779f9ull;
+    h ^= h >> 29;
+    return uint32_t(h ^ (h >> 32));
+}
+
+// Hash grid stored as compressed buckets: the vertices of bucket b are
+// entries[offsets[b]] to entries[offsets[b + 1] - 1], in increasing order,
+// with their positions so that a bucket is read contiguously. Cells with the
+// same hash share a bucket
+class WeldGrid {
+   public:
+    struct Entry {
+        float p[3];
+        uint32_t vertex;
+    };
+
+    WeldGrid(const VecList4f& positions, float epsilon) : m_epsilon(epsilon) {
+        const size_t n = positions.size();
+        unsigned int bits = 0;
+        while ((size_t(1) << bits) < n) ++bits;
+        m_mask = uint32_t((size_t(1) << bits) - 1);
+        // 1 / cell size. With cells of 4 * epsilon, the points at a distance
+        // of epsilon or less are in the same cell or in the neighbouring
+        // ones of the closest sides, which are only visited if p is within
+        // epsilon of them (in half of the cases for each axis)
+        m_scale = epsilon > 0 ? 0.25 / double(epsilon) : 0;
+
+        // Counting sort by bucket in two passes, so that the writes of each
+        // one go to a few places at a time instead of all over the array:
+        // by the highest bits of the bucket to a temporary array, and then
+        // each partition by the rest of them
+        const unsigned int shift =
+            bits > WELD_PARTITION_BITS ? bits - WELD_PARTITION_BITS : 0;
+        const size_t partitions = (size_t(m_mask) >> shift) + 1;
+        const size_t chunks = num_chunks(n, WELD_PARALLEL_MIN);
+        std::vector<uint32_t> cursors(chunks * partitions, 0);
+        parallel_chunks(0, n, WELD_PARALLEL_MIN,
+                        [&](size_t c, size_t b, size_t e) {
+                            uint32_t* count = &cursors[c * partitions];
+                            for (size_t i = b; i < e; ++i)
+                                ++count[bucket(positions[i].data()) >> shift];
+                        });
+        std::vector<uint32_t> partition_first(partitions + 1);
+        uint32_t offset = 0;
+        for (size_t p = 0; p < partitions; ++p) {
+            partition_first[p] = offset;
+            for (size_t c = 0; c < chunks; ++c) {
+                const uint32_t count = cursors[c * partitions + p];
+                cursors[c * partitions + p] = offset;
+                offset += count;
+            }
+        }
+        partition_first[partitions] = offset;
+        std::vector<Entry> partitioned(n);
+        parallel_chunks(0, n, WELD_PARALLEL_MIN,
+                        [&](size_t c, size_t b, size_t e) {
+                            uint32_t* cursor = &cursors[c * partitions];
+                            for (size_t i = b; i < e; ++i) {
+                                const float* p = positions[i].data();
+                                partitioned[cursor[bucket(p) >> shift]++] = {
+                                    {p[0], p[1], p[2]}, uint32_t(i)};
+                            }
+                        });
+
+        m_offsets.resize(size_t(m_mask) + 2);
+        m_entries.resize(n);
+        parallel_for(0, partitions, 1, [&](size_t b, size_t e) {
+            std::vector<uint32_t> cursor(size_t(1) << shift);
+            for (size_t p = b; p < e; ++p) {
+                const uint32_t first = partition_first[p];
+                const uint32_t last = partition_first[p + 1];
+                const uint32_t local_mask = uint32_t(cursor.size() - 1);
+                std::fill(cursor.begin(), cursor.end(), 0);
+                for (uint32_t j = first; j < last; ++j)
+                    ++cursor[bucket(partitioned[j].p) & local_mask];
+                uint32_t offset = first;
+                for (size_t i = 0; i < cursor.size(); ++i) {
+                    const uint32_t count = cursor[i];
+                    m_offsets[(p << shift) + i] = cursor[i] = offset;
+                    offset += count;
+                }
+                for (uint32_t j = first; j < last; ++j)
+                    m_entries[cursor[bucket(partitioned[j].p) & local_mask]++] =
+                        partitioned[j];
+            }
+        });
+        m_offsets.back() = uint32_t(n);
+    }
+
+    // Entries in the order of their buckets, queries for them in this order
+    // find their own bucket in the cache
+    const std::vector<Entry>& entries() const { return m_entries; }
+
+    // Calls visit(j) for the entries j of the vertices with a lower index
+    // than the one of entry i at a distance of epsilon or less of it. For
+    // epsilon = 0 only the first one is visited, as equality is transitive
+    template <typename F>
+    void for_each_close(uint32_t i, F&& visit) const {
+        const Entry& entry = m_entries[i];
+        const float* p = entry.p;
+        if (m_epsilon == 0) {
+            const uint32_t b = bucket(p);
+            for (uint32_t j = m_offsets[b]; j < m_offsets[b + 1]; ++j) {
+                const Entry& other = m_entries[j];
+                const float* q = other.p;
+                if (other.vertex >= entry.vertex) return;
+                if (p[0] == q[0] && p[1] == q[1] && p[2] == q[2])
+                    return visit(j);
+            }
+            return;
+        }
+
+        // neighbouring cell within epsilon in each axis (0 if none)
+        WeldCell base;
+        int64_t side[3];
+        for (unsigned int k = 0; k < 3; ++k) {
+            const double x = grid_coordinate(p[k]);
+            base.c[k] = cell_index(x);
+            const double fraction = x - std::floor(x);
+            side[k] = fraction < 0.25 ? -1 : fraction >= 0.75 ? 1 : 0;
+        }
+        const float epsilon2 = m_epsilon * m_epsilon;
+        uint32_t visited[8];
+        unsigned int num_visited = 0;
+        for (unsigned int n = 0; n < 8; ++n) {
+            WeldCell c = base;
+            bool skip = false;
+            for (unsigned int k = 0; k < 3; ++k) {
+                if (!(n & (1 << k))) continue;
+                skip |= side[k] == 0;
+                c.c[k] += side[k];
+            }
+            if (skip) continue;
+            // cells with the same hash are only visited once
+            const uint32_t b = weld_hash(c) & m_mask;
+            if (std::find(visited, visited + num_visited, b) !=
+                visited + num_visited)
+                continue;
+            visited[num_visited++] = b;
+            for (uint32_t j = m_offsets[b]; j < m_offsets[b + 1]; ++j) {
+                const Entry& other = m_entries[j];
+                if (other.vertex >= entry.vertex) continue;
+                const float dx = p[0] - other.p[0], dy = p[1] - other.p[1],
+                            dz = p[2] - other.p[2];
+                if (dx * dx + dy * dy + dz * dz <= epsilon2) visit(j);
+            }
+        }
+    }
+
+   private:
+    const float m_epsilon;
+    double m_scale;
+    uint32_t m_mask;
+    std::vector<uint32_t> m_offsets;
+    std::vector<Entry> m_entries;
+
+    // Cells are centered on the multiples of their size, which are usually
+    // the positions that are repeated (e.g. integer coordinates)
+    double grid_coordinate(float x) const { return x * m_scale + 0.5; }
+
+    // Cell of a grid coordinate. Huge and non-finite ones are clamped to the
+    // last cell so that the conversion is defined (NaN to cell 0): they
+    // share it, so the vertices in it are still compared with each other
+    static int64_t cell_index(double x) {
+        constexpr int64_t LIMIT = int64_t(1) << 62;
+        if (std::abs(x) < double(LIMIT)) return int64_t(std::floor(x));
+        return x > 0 ? LIMIT : x < 0 ? -LIMIT : 0;
+    }
+
+    uint32_t bucket(const float* p) const {
+        return weld_hash(cell(p)) & m_mask;
+    }
+
+    WeldCell cell(const float* p) const {
+        WeldCell result;
+        for (unsigned int k = 0; k < 3; ++k) {
+            if (m_epsilon > 0) {
+                result.c[k] = cell_index(grid_coordinate(p[k]));
+            } else {
+                const float x = p[k] + 0.0f;  // -0 becomes +0
+                uint32_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                result.c[k] = bits;
+            }
+        }
+        return result;
+    }
+};
+
+// Union-find of the entries of a grid (so that the ones of a bucket are
+// close in memory) in which the root of each set is the entry of its lowest
+// vertex, so that the sets and their roots do not depend on the order of
+// the unions. It can be used from several threads, as only roots are
+// linked, to the root of a lower vertex
+class WeldSets {
+   public:
+    explicit WeldSets(const std::vector<WeldGrid::Entry>& entries)
+        : m_entries(entries), m_parent(entries.size()) {
+        const size_t n = entries.size();
+        parallel_for(0, n, WELD_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                m_parent[i].store(uint32_t(i), std::memory_order_relaxed);
+        });
+    }
+
+    uint32_t find(uint32_t x) {
+        uint32_t parent = m_parent[x].load(std::memory_order_relaxed);
+        while (parent != x) {
+            // path halving, any ancestor of x is a valid parent for it
+            const uint32_t next =
+                m_parent[parent].load(std::memory_order_relaxed);
+            m_parent[x].store(next, std::memory_order_relaxed);
+            x = next;
+            parent = m_parent[x].load(std::memory_order_relaxed);
+        }
+        return x;
+    }
+
+    void unite(uint32_t a, uint32_t b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (m_entries[a].vertex < m_entries[b].vertex) std::swap(a, b);
+            // fails if another thread linked a in the meantime
+            uint32_t expected = a;
+            if (m_parent[a].compare_exchange_weak(expected, b)) return;
+        }
+    }
+
+   private:
+    const std::vector<WeldGrid::Entry>& m_entries;
+    std::vector<std::atomic<uint32_t>> m_parent;
+};
+
+};  // namespace detail
+
+size_t weld_vertices(Mesh& mesh, float epsilon) {
+    using detail::WELD_PARALLEL_MIN;
+    const size_t n = mesh.vertices.size();
+    detail::check_faces(mesh.faces, n);
+    if (n == 0) return 0;
+    if (!(epsilon >= 0))
+        throw detail::CommonMeshException(
+            "Welding distance must be positive or zero");
+
+    // sets of vertices joined by pairs within epsilon, each one merged with
+    // the lowest of its set
+    std::vector<uint32_t> remap(n);
+    {
+        const detail::WeldGrid grid(mesh.vertices, epsilon);
+        const auto& entries = grid.entries();
+        detail::WeldSets sets(entries);
+        detail::parallel_for(0, n, WELD_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                grid.for_each_close(uint32_t(i), [&](uint32_t j) {
+                    sets.unite(uint32_t(i), j);
+                });
+        });
+        detail::parallel_for(0, n, WELD_PARALLEL_MIN, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                remap[entries[i].vertex] =
+                    entries[sets.find(uint32_t(i))].vertex;
+        });
+    }
+
+    // vertices kept in their order. The vertex that each one is merged with
+    // is the lowest of its set, so its new index is already known
+    std::vector<uint32_t> kept;
+    for (size_t i = 0; i < n; ++i) {
+        if (remap[i] == i) {
+            remap[i] = uint32_t(kept.size());
+            kept.push_back(uint32_t(i));
+        } else {
+            remap[i] = remap[remap[i]];
+        }
+    }
+    if (kept.size() == n) return 0;
+
+    VecList4f vertices(kept.size());
+    detail::parallel_for(0, kept.size(), WELD_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 vertices[i] = mesh.vertices[kept[i]];
+                         });
+    detail::parallel_for(0, mesh.faces.size(), WELD_PARALLEL_MIN,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 for (unsigned int k = 0; k < 3; ++k)
+                                     mesh.faces[i][k] =
+                                         remap[mesh.faces[i][k]];
+                         });
+    mesh.vertices = std::move(vertices);
+    mesh.vertex_attributes.reorder(kept);
+    return n - kept.size();
+}
+
+};  // namespace common
@@ -0,0 +1,312 @@
+/*
+ * einsum.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Einstein summation over tensors with static shapes, resolved at compile time
+ */
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "libcpp-common/detail/simd.h"
+#include "libcpp-common/tensor/gemm.h"
+
+namespace common {
+
+template <typename T, size_t... Shape>
+class Tensor;
+
+namespace detail {
+
+template <typename T>
+struct is_tensor : std::false_type {};
+template <typename T, size_t... Shape>
+struct is_tensor<Tensor<T, Shape...>> : std::true_type {};
+
+template <typename Specs, typename Tensors>
+struct EinsumPlan;
+
+// Everything einsum needs to know, computed at compile time: the distinct
+// labels, their extents, the stride of each operand along each label (zero
+// if the operand does not have it) and the order of the loops
+template <typename... Specs, typename... Tensors>
+struct EinsumPlan<std::tuple<Specs...>, std::tuple<Tensors...>> {
+    static_assert((is_tensor<Tensors>::value && ...),
+                  "einsum operands must be Tensor objects");
+    static_assert(sizeof...(Tensors) > 0, "einsum needs at least one operand");
+
+    // number of input operands, the result is operand K
+    static constexpr size_t K = sizeof...(Tensors);
+    static_assert(sizeof...(Specs) == K + 1,
+                  "einsum needs one Idx per operand, plus one for the result");
+
+    using type = std::tuple_element_t<0, std::tuple<typename Tensors::type...>>;
+    static_assert((std::is_same_v<type, typename Tensors::type> && ...),
+                  "einsum operands must have the same element type");
+
+    static constexpr std::array<size_t, K + 1> ranks = {Specs::size...};
+    static constexpr size_t num_axes = (Specs::size + ...);
+
+    // labels, shapes and strides of all the operands, one after the other
+    static constexpr std::array<size_t, K + 1> first_axis = []() {
+        std::array<size_t, K + 1> result = {};
+        for (size_t op = 1; op <= K; ++op)
+            result[op] = result[op - 1] + ranks[op - 1];
+        return result;
+    }();
+    static constexpr std::array<char, num_axes> axis_labels = []() {
+        std::array<char, num_axes> result = {};
+        size_t pos = 0;
+        ((void)(std::apply([&](auto... l) { ((result[pos++] = l), ...); },
+                           Specs::labels)),
+         ...);
+        return result;
+    }();
+    static constexpr std::array<size_t, num_axes> axis_shape = []() {
+        std::array<size_t, num_axes> result = {};
+        size_t pos = 0;
+        ((void)(std::apply([&](auto... n) { ((result[pos++] = n), ...); },
+                           Tensors::shape)),
+         ...);
+        return result;
+    }();
+    static constexpr std::array<size_t, num_axes> axis_strides = []() {
+        std::array<size_t, num_axes> result = {};
+        size_t pos = 0;
+        ((void)(std::apply([&](auto... n) { ((result[pos++] = n), ...); },
+                           Tensors::strides)),
+         ...);
+        return result;
+    }();
+
+    static constexpr bool ranks_match = []() {
+        constexpr std::array<size_t, K> ndims = {Tensors::ndim...};
+        for (size_t op = 0; op < K; ++op)
+            if (ranks[op] != ndims[op]) return false;
+        return true;
+    }();
+    static_assert(ranks_match,
+                  "einsum Idx must have one label per axis of its operand");
+
+    static constexpr bool extents_match = []() {
+        for (size_t a = 0; a < first_axis[K]; ++a)
+            for (size_t b = 0; b < first_axis[K]; ++b)
+                if (axis_labels[a] == axis_labels[b] &&
+                    axis_shape[a] != axis_shape[b])
+                    return false;
+        return true;
+    }();
+    static_assert(extents_match,
+                  "einsum axes with the same label must have the same length");
+
+    static constexpr bool result_labels_ok = []() {
+        for (size_t a = first_axis[K]; a < num_axes; ++a) {
+            bool found = false;
+            for (size_t b = 0; b < first_axis[K]; ++b)
+                found = found || axis_labels[a] == axis_labels[b];
+            if (!found) return false;
+            for (size_t b = first_axis[K]; b < a; ++b)
+                if (axis_labels[a] == axis_labels[b]) return false;
+        }
+        return true;
+    }();
+    static_assert(result_labels_ok,
+                  "einsum result labels must be unique and appear in some "
+                  "operand");
+
+    // distinct labels, in order of appearance
+    static constexpr size_t num_labels = []() {
+        size_t result = 0;
+        for (size_t a = 0; a < first_axis[K]; ++a) {
+            bool seen = false;
+            for (size_t b = 0; b < a; ++b)
+                seen = seen || axis_labels[a] == axis_labels[b];
+            result += seen ? 0 : 1;
+        }
+        return result;
+    }();
+    static constexpr std::array<char, num_labels> labels = []() {
+        std::array<char, num_labels> result = {};
+        size_t n = 0;
+        for (size_t a = 0; a < first_axis[K]; ++a) {
+            bool seen = false;
+            for (size_t i = 0; i < n; ++i)
+                seen = seen || result[i] == axis_labels[a];
+            if (!seen) result[n++] = axis_labels[a];
+        }
+        return result;
+    }();
+    static constexpr size_t label_index(char l) {
+        for (size_t i = 0; i < num_labels; ++i)
+            if (labels[i] == l) return i;
+        return num_labels;
+    }
+
+    static constexpr std::array<size_t, num_labels> extents = []() {
+        std::array<size_t, num_labels> result = {};
+        for (size_t a = 0; a < first_axis[K]; ++a)
+            for (size_t i = 0; i < num_labels; ++i)
+                if (labels[i] == axis_labels[a]) result[i] = axis_shape[a];
+        return result;
+    }();
+
+    static constexpr size_t result_rank = ranks[K];
+    static constexpr std::array<size_t, result_rank> result_shape = []() {
+        std::array<size_t, result_rank> result = {};
+        for (size_t a = 0; a < result_rank; ++a)
+            for (size_t i = 0; i < num_labels; ++i)
+                if (labels[i] == axis_labels[first_axis[K] + a])
+                    result[a] = extents[i];
+        return result;
+    }();
+
+    // strides[op][label], the result is stored contiguously
+    static constexpr std::array<std::array<ptrdiff_t, num_labels>, K + 1>
+        strides = []() {
+            std::array<std::array<ptrdiff_t, num_labels>, K + 1> result = {};
+            for (size_t op = 0; op < K; ++op)
+                for (size_t a = first_axis[op]; a < first_axis[op + 1]; ++a)
+                    for (size_t i = 0; i < num_labels; ++i)
+                        if (labels[i] == axis_labels[a])
+                            result[op][i] += axis_strides[a];
+            ptrdiff_t stride = 1;
+            for (size_t a = result_rank; a-- > 0;) {
+                for (size_t i = 0; i < num_labels; ++i)
+                    if (labels[i] == axis_labels[first_axis[K] + a])
+                        result[K][i] = stride;
+                stride *= static_cast<ptrdiff_t>(result_shape[a]);
+            }
+            return result;
+        }();
+
+    // Loop order, outermost first. Labels along which more operands are
+    // unit-stride go inside, and ties are broken by the total stride (so
+    // that the innermost loops touch memory that is closest together)
+    static constexpr std::array<size_t, num_labels> order = []() {
+        std::array<size_t, num_labels> unit = {}, total = {}, result = {};
+        for (size_t i = 0; i < num_labels; ++i) {
+            result[i] = i;
+            for (size_t op = 0; op <= K; ++op) {
+                unit[i] += strides[op][i] == 1 ? 1 : 0;
+                total[i] += static_cast<size_t>(strides[op][i]);
+            }
+        }
+        auto goes_before = [&](size_t a, size_t b) {
+            if (unit[a] != unit[b]) return unit[a] < unit[b];
+            return total[a] > total[b];
+        };
+        // insertion sort, stable so equal labels keep their order
+        for (size_t i = 1; i < num_labels; ++i)
+            for (size_t j = i; j > 0 && goes_before(result[j], result[j - 1]);
+                 --j) {
+                const size_t tmp = result[j];
+                result[j] = result[j - 1];
+                result[j - 1] = tmp;
+            }
+        return result;
+    }();
+
+    // A matrix product (in any transposition) is handed over to gemm: two
+    // matrices sharing a single summed label, each with a distinct free label
+    struct GemmParams {
+        bool valid;
+        size_t m, n, k;
+        ptrdiff_t rs_a, cs_a, rs_b, cs_b, rs_c, cs_c;
+    };
+    static constexpr GemmParams gemm_params = []() {
+        GemmParams p = {};
+        if constexpr (K == 2) {
+            if (ranks[0] != 2 || ranks[1] != 2 || ranks[2] != 2 ||
+                num_labels != 3)
+                return p;
+            const char a0 = axis_labels[0], a1 = axis_labels[1];
+            const char b0 = axis_labels[2], b1 = axis_labels[3];
+            const char c0 = axis_labels[4], c1 = axis_labels[5];
+            // summed label: shared by a and b, not in the result
+            for (char s : {a0, a1}) {
+                if ((s != b0 && s != b1) || s == c0 || s == c1) continue;
+                const char i = s == a0 ? a1 : a0;
+                const char j = s == b0 ? b1 : b0;
+                if (i == s || j == s || i == j) return p;
+                if (!((c0 == i && c1 == j) || (c0 == j && c1 == i))) return p;
+                const size_t li = label_index(i), lj = label_index(j),
+                             ls = label_index(s);
+                p.valid = true;
+                p.m = extents[li];
+                p.n = extents[lj];
+                p.k = extents[ls];
+                p.rs_a = strides[0][li];
+                p.cs_a = strides[0][ls];
+                p.rs_b = strides[1][ls];
+                p.cs_b = strides[1][lj];
+                p.rs_c = strides[2][li];
+                p.cs_c = strides[2][lj];
+            }
+        }
+        return p;
+    }();
+};
+
+template <typename T, typename Plan, typename Seq>
+struct EinsumResult;
+
+template <typename T, typename Plan, size_t... I>
+struct EinsumResult<T, Plan, std::index_sequence<I...>> {
+    using type = Tensor<T, Plan::result_shape[I]...>;
+};
+
+template <typename T, typename Plan>
+struct EinsumResult<T, Plan, std::index_sequence<>> {
+    using type = T;
+};
+
+template <typename Plan, size_t D, size_t... I, typename T, typename... In>
+inline void einsum_loop(std::index_sequence<I...> seq, T* out,
+                        const In*... in) {
+    if constexpr (D == Plan::num_labels) {
+        *out += (*in * ...);
+    } else {
+        constexpr size_t label = Plan::order[D];
+        constexpr size_t n = Plan::extents[label];
+        constexpr ptrdiff_t out_stride = Plan::strides[Plan::K][label];
+        for (size_t x = 0; x < n; ++x) {
+            const ptrdiff_t px = static_cast<ptrdiff_t>(x);
+            einsum_loop<Plan, D + 1>(seq, out + px * out_stride,
+                                     (in + px * Plan::strides[I][label])...);
+        }
+    }
+}
+
+};  // namespace detail
+
+template <typename... Specs, typename... Tensors>
+auto einsum(const Tensors&... tensors) {
+    using Plan = detail::EinsumPlan<std::tuple<Specs...>,
+                                    std::tuple<Tensors...>>;
+    using T = typename Plan::type;
+    using Result = typename detail::EinsumResult<
+        T, Plan, std::make_index_sequence<Plan::result_rank>>::type;
+
+    Result result(0);
+    T* out;
+    if constexpr (Plan::result_rank == 0)
+        out = &result;
+    else
+        out = result.data();
+
+    constexpr auto g = Plan::gemm_params;
+    if constexpr (g.valid && detail::simd_supported<T> &&
+                  g.m * g.n * g.k > 512) {
+        const auto& a = std::get<0>(std::tie(tensors...));
+        const auto& b = std::get<1>(std::tie(tensors...));
+        gemm<T>(g.m, g.n, g.k, a.data(), g.rs_a, g.cs_a, b.data(), g.rs_b,
+                g.cs_b, out, g.rs_c, g.cs_c, false);
+    } else {
+        detail::einsum_loop<Plan, 0>(std::make_index_sequence<Plan::K>{}, out,
+                                     tensors.data()...);
+    }
+    return result;
+}
+
+};  // namespace common
@@ -0,0 +1,254 @@
+/*
+ * gemm.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Cache-blocked, multithreaded general matrix-matrix multiplication
+ *
+ * Follows the usual Goto/BLIS structure: B is packed in kc x nc panels that
+ * live in L3, A is packed in mc x kc blocks that live in L2, and a register
+ * blocked micro-kernel computes MR x NR tiles of C from MR-tall slivers of A
+ * and NR-wide slivers of B that stream from L1
+ */
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/simd.h"
+
+namespace common {
+
+namespace detail {
+
+template <typename T>
+struct GemmBlocking {
+    // micro-tile: MR rows x NR columns of C, kept in MR * NV registers
+    static constexpr size_t NV = 2;
+    static constexpr size_t NR = NV * simd_width<T>;
+    static constexpr size_t MR = 6;
+    // cache blocks, sized so that an A block takes ~128KB (L2) and the
+    // B panel a few MB (L3)
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC =
+        std::max<size_t>(MR, (128 * 1024 / (KC * sizeof(T))) / MR * MR);
+    static constexpr size_t NC = 4096 / NR * NR;
+};
+
+// Pack rows [0, mc) and columns [0, kc) of A in slivers of MR rows, so that
+// the micro-kernel reads them sequentially. Out of bounds rows are zeroed
+template <typename T>
+void gemm_pack_a(size_t mc, size_t kc, const T* a, ptrdiff_t rs_a,
+                 ptrdiff_t cs_a, T* packed) {
+    constexpr size_t MR = GemmBlocking<T>::MR;
+    for (size_t ir = 0; ir < mc; ir += MR) {
+        const size_t rows = std::min(MR, mc - ir);
+        for (size_t p = 0; p < kc; ++p) {
+            const T* src = a + ptrdiff_t(ir) * rs_a + ptrdiff_t(p) * cs_a;
+            for (size_t i = 0; i < rows; ++i)
+                packed[i] = src[ptrdiff_t(i) * rs_a];
+            for (size_t i = rows; i < MR; ++i) packed[i] = 0;
+            packed += MR;
+        }
+    }
+}
+
+// Pack rows [0, kc) and columns [jr_begin, jr_end) of B in slivers of NR
+// columns. Out of bounds columns are zeroed
+template <typename T>
+void gemm_pack_b(size_t nc, size_t kc, size_t jr_begin, size_t jr_end,
+                 const T* b, ptrdiff_t rs_b, ptrdiff_t cs_b, T* packed) {
+    constexpr size_t NR = GemmBlocking<T>::NR;
+    packed += jr_begin * kc;
+    for (size_t jr = jr_begin; jr < jr_end; jr += NR) {
+        const size_t cols = std::min(NR, nc - jr);
+        for (size_t p = 0; p < kc; ++p) {
+            const T* src = b + ptrdiff_t(p) * rs_b + ptrdiff_t(jr) * cs_b;
+            if (cs_b == 1) {
+                std::copy(src, src + cols, packed);
+            } else {
+                for (size_t j = 0; j < cols; ++j)
+                    packed[j] = src[ptrdiff_t(j) * cs_b];
+            }
+            for (size_t j = cols; j < NR; ++j) packed[j] = 0;
+            packed += NR;
+        }
+    }
+}
+
+// C[0:mr, 0:nr] (+)= sum_p a[p, :] x b[p, :] for the packed slivers a and b
+template <typename T>
+void gemm_micro_kernel(size_t kc, const T* a, const T* b, T* c,
+                       ptrdiff_t rs_c, ptrdiff_t cs_c, bool overwrite,
+                       size_t mr, size_t nr) {
+    using Blocking = GemmBlocking<T>;
+    constexpr size_t MR = Blocking::MR, NR = Blocking::NR, NV = Blocking::NV;
+    constexpr size_t W = simd_width<T>;
+
+    simd_t<T> acc[MR][NV];
+#pragma GCC unroll 8
+    for (size_t i = 0; i < MR; ++i)
+#pragma GCC unroll 4
+        for (size_t v = 0; v < NV; ++v) acc[i][v] = simd_t<T>{};
+
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        simd_t<T> bv[NV];
+#pragma GCC unroll 4
+        for (size_t v = 0; v < NV; ++v) bv[v] = simd_load(b + v * W);
+#pragma GCC unroll 8
+        for (size_t i = 0; i < MR; ++i) {
+            const simd_t<T> ai = simd_broadcast(a[i]);
+#pragma GCC unroll 4
+            for (size_t v = 0; v < NV; ++v) acc[i][v] += ai * bv[v];
+        }
+    }
+
+    if (mr == MR && nr == NR && cs_c == 1) {
+        // full tile with contiguous rows, write C straight from registers
+#pragma GCC unroll 8
+        for (size_t i = 0; i < MR; ++i) {
+            T* ci = c + ptrdiff_t(i) * rs_c;
+#pragma GCC unroll 4
+            for (size_t v = 0; v < NV; ++v) {
+                if (!overwrite) acc[i][v] += simd_load(ci + v * W);
+                simd_store(ci + v * W, acc[i][v]);
+            }
+        }
+        return;
+    }
+
+    // edge tile or strided C, go through a temporary tile
+    T tile[MR][NR];
+    for (size_t i = 0; i < MR; ++i)
+        for (size_t v = 0; v < NV; ++v) simd_store(&tile[i][v * W], acc[i][v]);
+    for (size_t i = 0; i < mr; ++i) {
+        for (size_t j = 0; j < nr; ++j) {
+            T& cij = c[ptrdiff_t(i) * rs_c + ptrdiff_t(j) * cs_c];
+            cij = overwrite ? tile[i][j] : cij + tile[i][j];
+        }
+    }
+}
+
+// Naive fallback for tiny problems, where packing costs more than it saves
+template <typename T>
+void gemm_reference(size_t m, size_t n, size_t k, const T* a, ptrdiff_t rs_a,
+                    ptrdiff_t cs_a, const T* b, ptrdiff_t rs_b, ptrdiff_t cs_b,
+                    T* c, ptrdiff_t rs_c, ptrdiff_t cs_c, bool accumulate) {
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            T sum = 0;
+            for (size_t p = 0; p < k; ++p)
+                sum += a[ptrdiff_t(i) * rs_a + ptrdiff_t(p) * cs_a] *
+                       b[ptrdiff_t(p) * rs_b + ptrdiff_t(j) * cs_b];
+            T& cij = c[ptrdiff_t(i) * rs_c + ptrdiff_t(j) * cs_c];
+            cij = accumulate ? cij + sum : sum;
+        }
+    }
+}
+
+template <size_t M, size_t K, size_t N, typename T, size_t... P>
+inline T gemm_small_dot(const T* a, const T* b, size_t i, size_t j,
+                        std::index_sequence<P...>) {
+    return ((a[i * K + P] * b[P * N + j]) + ...);
+}
+
+template <size_t M, size_t K, size_t N, typename T, size_t... IJ>
+inline void gemm_small_impl(const T* a, const T* b, T* c,
+                            std::index_sequence<IJ...>) {
+    ((c[IJ] = gemm_small_dot<M, K, N>(a, b, IJ / N, IJ % N,
+                                      std::make_index_sequence<K>{})),
+     ...);
+}
+
+};  // namespace detail
+
+template <size_t M, size_t K, size_t N, typename T>
+void gemm_small(const T* a, const T* b, T* c) {
+    static_assert(K > 0, "gemm_small needs a non-empty inner dimension");
+    detail::gemm_small_impl<M, K, N>(a, b, c,
+                                     std::make_index_sequence<M * N>{});
+}
+
+template <typename T>
+void gemm(size_t m, size_t n, size_t k,             //
+          const T* a, ptrdiff_t rs_a, ptrdiff_t cs_a,  //
+          const T* b, ptrdiff_t rs_b, ptrdiff_t cs_b,  //
+          T* c, ptrdiff_t rs_c, ptrdiff_t cs_c, bool accumulate) {
+    static_assert(detail::simd_supported<T>,
+                  "gemm only supports arithmetic types");
+    using Blocking = detail::GemmBlocking<T>;
+    constexpr size_t MR = Blocking::MR, NR = Blocking::NR;
+    constexpr size_t MC = Blocking::MC, KC = Blocking::KC, NC = Blocking::NC;
+
+    if (m == 0 || n == 0) return;
+    if (k == 0) {
+        if (!accumulate)
+            for (size_t i = 0; i < m; ++i)
+                for (size_t j = 0; j < n; ++j)
+                    c[ptrdiff_t(i) * rs_c + ptrdiff_t(j) * cs_c] = 0;
+        return;
+    }
+    if (m * n * k <= MR * NR * 16) {
+        detail::gemm_reference(m, n, k, a, rs_a, cs_a, b, rs_b, cs_b, c, rs_c,
+                               cs_c, accumulate);
+        return;
+    }
+
+    // split the rows of C in blocks, smaller than MC if there are not enough
+    // rows to keep all the threads busy
+    const bool parallel = double(m) * n * k >= double(1 << 21);
+    const size_t threads = parallel ? detail::num_threads() : 1;
+    const size_t rows_per_thread = (m + threads - 1) / threads;
+    const size_t mc_max =
+        std::min(MC, std::max(MR, (rows_per_thread + MR - 1) / MR * MR));
+    const size_t num_ic = (m + mc_max - 1) / mc_max;
+
+    std::vector<T> packed_b(std::min(KC, k) * ((std::min(NC, n) + NR - 1) /
+                                               NR * NR));
+    std::vector<std::vector<T>> packed_a(
+        std::min(threads, num_ic), std::vector<T>(mc_max * std::min(KC, k)));
+
+    for (size_t jc = 0; jc < n; jc += NC) {
+        const size_t nc = std::min(NC, n - jc);
+        const size_t num_jr = (nc + NR - 1) / NR;
+        for (size_t pc = 0; pc < k; pc += KC) {
+            const size_t kc = std::min(KC, k - pc);
+            const bool overwrite = pc == 0 && !accumulate;
+
+            const T* b_panel = b + ptrdiff_t(pc) * rs_b + ptrdiff_t(jc) * cs_b;
+            detail::parallel_for(
+                0, num_jr, parallel ? 4 : num_jr, [&](size_t j0, size_t j1) {
+                    detail::gemm_pack_b(nc, kc, j0 * NR, j1 * NR, b_panel,
+                                        rs_b, cs_b, packed_b.data());
+                });
+
+            detail::parallel_chunks(
+                0, num_ic, parallel ? 1 : num_ic,
+                [&](size_t chunk, size_t ic0, size_t ic1) {
+                    T* pa = packed_a[chunk].data();
+                    for (size_t icb = ic0; icb < ic1; ++icb) {
+                        const size_t ic = icb * mc_max;
+                        const size_t mc = std::min(mc_max, m - ic);
+                        detail::gemm_pack_a(
+                            mc, kc,
+                            a + ptrdiff_t(ic) * rs_a + ptrdiff_t(pc) * cs_a,
+                            rs_a, cs_a, pa);
+                        for (size_t jr = 0; jr < nc; jr += NR) {
+                            const T* pb = packed_b.data() + jr * kc;
+                            for (size_t ir = 0; ir < mc; ir += MR) {
+                                detail::gemm_micro_kernel(
+                                    kc, pa + ir * kc, pb,
+                                    c + ptrdiff_t(ic + ir) * rs_c +
+                                        ptrdiff_t(jc + jr) * cs_c,
+                                    rs_c, cs_c, overwrite,
+                                    std::min(MR, mc - ir),
+                                    std::min(NR, nc - jr));
+                            }
+                        }
+                    }
+                });
+        }
+    }
+}
+
+};  // namespace common
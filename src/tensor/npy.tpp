@@ -0,0 +1,252 @@
+/*
+ * npy.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Tensor saver/loader with a format compatible with numpy's np.save/np.load
+ */
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "libcpp-common/detail/exception.h"
+#include "libcpp-common/detail/npy.h"
+#include "libcpp-common/tensor/view.h"
+
+namespace common {
+
+namespace detail {
+
+template <typename T>
+std::string npy_descr_or_throw() {
+    const std::string descr = npy_descr<T>();
+    if (descr.empty())
+        throw CommonTensorException("Unsupported data type for NPY save");
+    return descr;
+}
+
+// Write the view in row-major order. Non-contiguous views are copied to a
+// buffer by blocks, so that the file is still written in large chunks
+template <typename T, size_t N>
+void npy_write_data(std::ostream& file, const TensorView<const T, N>& view) {
+    if constexpr (N > 0) {
+        if (!view.is_contiguous()) {
+            constexpr size_t block_bytes = 1 << 20;
+            size_t row_size = 1;
+            for (size_t i = 1; i < N; ++i) row_size *= view.shape(i);
+            const size_t block_rows =
+                std::max<size_t>(1, block_bytes / (sizeof(T) * row_size + 1));
+            std::vector<T> buffer;
+            for (size_t r = 0; r < view.shape(0); r += block_rows) {
+                const size_t rows = std::min(block_rows, view.shape(0) - r);
+                buffer.resize(rows * row_size);
+                T* p = buffer.data();
+                view.slice(Slice(static_cast<ptrdiff_t>(r),
+                                 static_cast<ptrdiff_t>(r + rows)))
+                    .for_each([&p](const T& x) { *p++ = x; });
+                file.write(reinterpret_cast<const char*>(buffer.data()),
+                           buffer.size() * sizeof(T));
+            }
+            if (!file) throw CommonTensorException("Could not write NPY data");
+            return;
+        }
+    }
+    file.write(reinterpret_cast<const char*>(view.data()),
+               view.size() * sizeof(T));
+    if (!file) throw CommonTensorException("Could not write NPY data");
+}
+
+template <typename T, size_t N>
+void npy_check_header(const NpyHeader& header,
+                      const std::array<size_t, N>& shape) {
+    if (header.descr != npy_descr<T>())
+        throw CommonTensorException("NPY file has type " + header.descr +
+                                    ", expected " + npy_descr<T>());
+    if (header.fortran_order)
+        throw CommonTensorException("NPY files in Fortran order are not "
+                                    "supported");
+    if (header.shape.size() != N ||
+        !std::equal(shape.begin(), shape.end(), header.shape.begin()))
+        throw CommonTensorException(
+            "NPY file has shape " +
+            shape_to_string(header.shape.data(), header.shape.size()) +
+            ", expected " + shape_to_string(shape.data(), N));
+}
+
+template <typename T>
+void npy_read_data(std::istream& file, T* data, size_t size) {
+    file.read(reinterpret_cast<char*>(data), size * sizeof(T));
+    if (!file) throw CommonTensorException("NPY file is truncated");
+}
+
+inline std::ofstream npy_open_write(const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        throw CommonTensorException("Could not open file " + filename);
+    return file;
+}
+
+inline std::ifstream npy_open_read(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        throw CommonTensorException("Could not open file " + filename);
+    return file;
+}
+
+};  // namespace detail
+
+/// SAVE ///
+
+template <typename T, size_t N>
+void save_npy(std::ostream& file, const TensorView<T, N>& view) {
+    using U = std::remove_const_t<T>;
+    const detail::NpyHeader header = {
+        detail::npy_descr_or_throw<U>(), false,
+        std::vector<size_t>(view.shape().begin(), view.shape().end())};
+    file << detail::npy_header(header);
+    detail::npy_write_data<U, N>(file, view);
+}
+
+template <typename T, size_t N>
+void save_npy(const std::string& filename, const TensorView<T, N>& view) {
+    std::ofstream file = detail::npy_open_write(filename);
+    save_npy(file, view);
+}
+
+template <typename T, size_t... Shape>
+void save_npy(std::ostream& file, const Tensor<T, Shape...>& tensor) {
+    save_npy(file, tensor.view());
+}
+
+template <typename T, size_t... Shape>
+void save_npy(const std::string& filename, const Tensor<T, Shape...>& tensor) {
+    save_npy(filename, tensor.view());
+}
+
+template <typename T, size_t N>
+void save_npy(std::ostream& file, const DynamicTensor<T, N>& tensor) {
+    save_npy(file, tensor.view());
+}
+
+template <typename T, size_t N>
+void save_npy(const std::string& filename, const DynamicTensor<T, N>& tensor) {
+    save_npy(filename, tensor.view());
+}
+
+/// LOAD ///
+
+template <typename T, size_t... Shape>
+void load_npy(std::istream& file, Tensor<T, Shape...>& tensor) {
+    const detail::NpyHeader header = detail::read_npy_header(file);
+    detail::npy_check_header<T>(header, Tensor<T, Shape...>::shape);
+    detail::npy_read_data(file, tensor.data(), Tensor<T, Shape...>::size);
+}
+
+template <typename T, size_t... Shape>
+void load_npy(const std::string& filename, Tensor<T, Shape...>& tensor) {
+    std::ifstream file = detail::npy_open_read(filename);
+    load_npy(file, tensor);
+}
+
+template <typename T, size_t N>
+DynamicTensor<T, N> load_npy(std::istream& file) {
+    const detail::NpyHeader header = detail::read_npy_header(file);
+    std::array<size_t, N> shape = {};
+    if (header.shape.size() == N)
+        std::copy(header.shape.begin(), header.shape.end(), shape.begin());
+    detail::npy_check_header<T>(header, shape);
+    DynamicTensor<T, N> result(shape);
+    detail::npy_read_data(file, result.data(), result.size());
+    return result;
+}
+
+template <typename T, size_t N>
+DynamicTensor<T, N> load_npy(const std::string& filename) {
+    std::ifstream file = detail::npy_open_read(filename);
+    return load_npy<T, N>(file);
+}
+
+/// STREAMING WRITER ///
+
+template <typename T, size_t N>
+NpyWriter<T, N>::NpyWriter(const std::string& filename,
+                           const std::array<size_t, N - 1>& row_shape)
+    : m_file(detail::npy_open_write(filename)),
+      m_row_shape(row_shape),
+      m_row_size(1),
+      m_rows(0) {
+    for (size_t n : m_row_shape) m_row_size *= n;
+    // reserve space for a header with the longest possible number of rows,
+    // so that it can be rewritten in place when the writer is closed
+    detail::NpyHeader longest = header();
+    longest.shape[0] = std::numeric_limits<size_t>::max();
+    m_header_length = detail::npy_header(longest).size();
+    m_file << detail::npy_header(header(), m_header_length);
+}
+
+template <typename T, size_t N>
+NpyWriter<T, N>::~NpyWriter() {
+    try {
+        close();
+    } catch (const detail::CommonException&) {
+        // destructors cannot throw, call close() to handle errors
+    }
+}
+
+template <typename T, size_t N>
+detail::NpyHeader NpyWriter<T, N>::header() const {
+    detail::NpyHeader result = {detail::npy_descr_or_throw<T>(), false, {}};
+    result.shape.push_back(m_rows);
+    result.shape.insert(result.shape.end(), m_row_shape.begin(),
+                        m_row_shape.end());
+    return result;
+}
+
+template <typename T, size_t N>
+void NpyWriter<T, N>::append(const T* data, size_t rows) {
+    if (!m_file.is_open())
+        throw detail::CommonTensorException("NpyWriter is already closed");
+    m_file.write(reinterpret_cast<const char*>(data),
+                 rows * m_row_size * sizeof(T));
+    if (!m_file)
+        throw detail::CommonTensorException("Could not write NPY data");
+    m_rows += rows;
+}
+
+template <typename T, size_t N>
+template <typename U, size_t M>
+void NpyWriter<T, N>::append(const TensorView<U, M>& view) {
+    static_assert(std::is_same_v<std::remove_const_t<U>, T>,
+                  "NpyWriter::append with a different data type");
+    static_assert(M == N || M + 1 == N,
+                  "NpyWriter::append needs a row or a block of rows");
+    constexpr bool single_row = M + 1 == N;
+    if (!std::equal(m_row_shape.begin(), m_row_shape.end(),
+                    view.shape().begin() + (single_row ? 0 : 1)))
+        throw detail::CommonTensorException(
+            "NpyWriter::append with shape " +
+            detail::shape_to_string(view.shape().data(), M) +
+            ", rows have shape " +
+            detail::shape_to_string(m_row_shape.data(), N - 1));
+    if (!m_file.is_open())
+        throw detail::CommonTensorException("NpyWriter is already closed");
+    detail::npy_write_data<T, M>(m_file, view);
+    m_rows += single_row ? 1 : view.shape(0);
+}
+
+template <typename T, size_t N>
+template <size_t... Shape>
+void NpyWriter<T, N>::append(const Tensor<T, Shape...>& tensor) {
+    append(tensor.view());
+}
+
+template <typename T, size_t N>
+void NpyWriter<T, N>::close() {
+    if (!m_file.is_open()) return;
+    m_file.seekp(0);
+    m_file << detail::npy_header(header(), m_header_length);
+    m_file.close();
+    if (m_file.fail())
+        throw detail::CommonTensorException("Could not write NPY header");
+}
+
+};  // namespace common
@@ -0,0 +1,432 @@
+/*
+ * reduce.tpp
+ * Diego Royo Meneses - Oct. 2026
+ *
+ * Parallel reductions (sum, mean, min, max, prod, argmax) over tensor axes
+ */
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "libcpp-common/detail/parallel.h"
+#include "libcpp-common/detail/simd.h"
+
+namespace common {
+
+template <typename T, size_t... Shape>
+class Tensor;
+
+namespace detail {
+
+/// REDUCTION OPERATORS ///
+
+// apply works both with scalars and SIMD packs
+struct SumOp {
+    template <typename T>
+    static constexpr T identity() {
+        return T(0);
+    }
+    template <typename V>
+    static inline V apply(const V& a, const V& b) {
+        return a + b;
+    }
+};
+
+struct ProdOp {
+    template <typename T>
+    static constexpr T identity() {
+        return T(1);
+    }
+    template <typename V>
+    static inline V apply(const V& a, const V& b) {
+        return a * b;
+    }
+};
+
+struct MinOp {
+    template <typename T>
+    static constexpr T identity() {
+        return std::numeric_limits<T>::has_infinity
+                   ? std::numeric_limits<T>::infinity()
+                   : std::numeric_limits<T>::max();
+    }
+    template <typename V>
+    static inline V apply(const V& a, const V& b) {
+        return b < a ? b : a;
+    }
+};
+
+struct MaxOp {
+    template <typename T>
+    static constexpr T identity() {
+        return std::numeric_limits<T>::has_infinity
+                   ? -std::numeric_limits<T>::infinity()
+                   : std::numeric_limits<T>::lowest();
+    }
+    template <typename V>
+    static inline V apply(const V& a, const V& b) {
+        return a < b ? b : a;
+    }
+};
+
+// Arrays above this number of elements are reduced using several threads
+static constexpr size_t REDUCE_PARALLEL_THRESHOLD = 1 << 18;
+// Length of the blocks added naively in pairwise summation
+static constexpr size_t REDUCE_PAIRWISE_BLOCK = 256;
+
+/// CONTIGUOUS KERNELS ///
+
+// Several independent SIMD accumulators, so that consecutive iterations do
+// not depend on each other and the loads can be pipelined
+template <typename Op, typename T>
+T reduce_block(const T* p, size_t n) {
+    T result = Op::template identity<T>();
+    size_t i = 0;
+    if constexpr (simd_supported<T>) {
+        constexpr size_t W = simd_width<T>, K = 4;
+        if (n >= K * W) {
+            simd_t<T> acc[K];
+            for (size_t k = 0; k < K; ++k) acc[k] = simd_broadcast(result);
+            for (; i + K * W <= n; i += K * W)
+#pragma GCC unroll 4
+                for (size_t k = 0; k < K; ++k)
+                    acc[k] = Op::apply(acc[k], simd_load(p + i + k * W));
+            for (; i + W <= n; i += W)
+                acc[0] = Op::apply(acc[0], simd_load(p + i));
+            acc[0] = Op::apply(Op::apply(acc[0], acc[1]),
+                               Op::apply(acc[2], acc[3]));
+            for (size_t l = 0; l < W; ++l)
+                result = Op::apply(result, T(acc[0][l]));
+        }
+    }
+    for (; i < n; ++i) result = Op::apply(result, p[i]);
+    return result;
+}
+
+template <typename Op, typename T>
+T reduce_pairwise(const T* p, size_t n) {
+    if (n <= REDUCE_PAIRWISE_BLOCK) return reduce_block<Op>(p, n);
+    const size_t half = n / 2;
+    return Op::apply(reduce_pairwise<Op>(p, half),
+                     reduce_pairwise<Op>(p + half, n - half));
+}
+
+template <typename T>
+T sum_kahan(const T* p, size_t n) {
+    T sum = 0, c = 0;
+    auto add = [&sum, &c](T x) {
+        const T y = x - c;
+        const T t = sum + y;
+        c = (t - sum) - y;
+        sum = t;
+    };
+    size_t n_simd = 0;
+    if constexpr (simd_supported<T>) {
+        constexpr size_t W = simd_width<T>;
+        n_simd = n / W * W;
+        simd_t<T> vsum = {}, vc = {};
+        for (size_t i = 0; i < n_simd; i += W) {
+            const simd_t<T> y = simd_load(p + i) - vc;
+            const simd_t<T> t = vsum + y;
+            vc = (t - vsum) - y;
+            vsum = t;
+        }
+        for (size_t l = 0; l < W; ++l) {
+            add(vsum[l]);
+            add(-vc[l]);
+        }
+    }
+    for (size_t i = n_simd; i < n; ++i) add(p[i]);
+    return sum;
+}
+
+template <typename Op, typename T>
+T reduce_contiguous(const T* p, size_t n, Accumulation accumulation) {
+    if constexpr (std::is_same_v<Op, SumOp> && std::is_floating_point_v<T>) {
+        if (accumulation == Accumulation::Kahan) return sum_kahan(p, n);
+        if (accumulation == Accumulation::Pairwise)
+            return reduce_pairwise<Op>(p, n);
+    }
+    return reduce_block<Op>(p, n);
+}
+
+template <typename Op, typename T, size_t... I>
+inline T reduce_unrolled(const T* p, std::index_sequence<I...>) {
+    T result = Op::template identity<T>();
+    ((result = Op::apply(result, p[I])), ...);
+    return result;
+}
+
+/// STRIDED KERNELS ///
+
+// out[i] = reduction of in[r * row_stride + i] over r in [0, rows), for all
+// i in [0, n). The inner loop is unit-stride so the compiler vectorizes it
+template <typename Op, typename T>
+void reduce_rows(const T* in, size_t rows, size_t row_stride, size_t n,
+                 T* out, Accumulation accumulation) {
+    if constexpr (std::is_same_v<Op, SumOp> && std::is_floating_point_v<T>) {
+        if (accumulation == Accumulation::Kahan) {
+            std::vector<T> c(n, 0);
+            std::fill(out, out + n, T(0));
+            for (size_t r = 0; r < rows; ++r) {
+                const T* row = in + r * row_stride;
+                for (size_t i = 0; i < n; ++i) {
+                    const T y = row[i] - c[i];
+                    const T t = out[i] + y;
+                    c[i] = (t - out[i]) - y;
+                    out[i] = t;
+                }
+            }
+            return;
+        }
+        if (accumulation == Accumulation::Pairwise &&
+            rows > REDUCE_PAIRWISE_BLOCK / 4) {
+            const size_t half = rows / 2;
+            std::vector<T> tmp(n);
+            reduce_rows<Op>(in, half, row_stride, n, out, accumulation);
+            reduce_rows<Op>(in + half * row_stride, rows - half, row_stride,
+                            n, tmp.data(), accumulation);
+            for (size_t i = 0; i < n; ++i) out[i] += tmp[i];
+            return;
+        }
+    }
+    std::fill(out, out + n, Op::template identity<T>());
+    for (size_t r = 0; r < rows; ++r) {
+        const T* row = in + r * row_stride;
+        for (size_t i = 0; i < n; ++i) out[i] = Op::apply(out[i], row[i]);
+    }
+}
+
+template <typename Op, size_t Outer, size_t R, size_t Inner, typename T>
+void reduce_axis(const T* in, T* out, Accumulation accumulation) {
+    auto reduce_outer = [&](size_t o0, size_t o1) {
+        for (size_t o = o0; o < o1; ++o) {
+            const T* base = in + o * R * Inner;
+            if constexpr (Inner == 1 && R <= 16) {
+                out[o] = reduce_unrolled<Op>(base,
+                                             std::make_index_sequence<R>{});
+            } else if constexpr (Inner == 1) {
+                out[o] = reduce_contiguous<Op>(base, R, accumulation);
+            } else {
+                reduce_rows<Op>(base, R, Inner, Inner, out + o * Inner,
+                                accumulation);
+            }
+        }
+    };
+
+    if constexpr (Outer * R * Inner < REDUCE_PARALLEL_THRESHOLD) {
+        reduce_outer(0, Outer);
+    } else {
+        if (Outer >= num_threads()) {
+            parallel_for(0, Outer, 1, reduce_outer);
+            return;
+        }
+        // few outer elements, split the reduced axis among the threads and
+        // combine their partial results in order (so the result is
+        // deterministic for a given number of threads)
+        constexpr size_t min_chunk =
+            std::max<size_t>(1, REDUCE_PARALLEL_THRESHOLD / 16 / Inner);
+        for (size_t o = 0; o < Outer; ++o) {
+            const T* base = in + o * R * Inner;
+            std::vector<T> partial(num_chunks(R, min_chunk) * Inner);
+            parallel_chunks(0, R, min_chunk,
+                            [&](size_t chunk, size_t r0, size_t r1) {
+                                T* dst = partial.data() + chunk * Inner;
+                                if constexpr (Inner == 1)
+                                    *dst = reduce_contiguous<Op>(
+                                        base + r0, r1 - r0, accumulation);
+                                else
+                                    reduce_rows<Op>(base + r0 * Inner, r1 - r0,
+                                                    Inner, Inner, dst,
+                                                    accumulation);
+                            });
+            reduce_rows<Op>(partial.data(), partial.size() / Inner, Inner,
+                            Inner, out + o * Inner, Accumulation::Naive);
+        }
+    }
+}
+
+/// ARGMAX ///
+
+template <typename T>
+size_t argmax_contiguous(const T* p, size_t n) {
+    if (n == 0) return 0;
+    const T max = reduce_block<MaxOp>(p, n);
+    for (size_t i = 0; i < n; ++i)
+        if (p[i] == max) return i;
+    return 0;  // only NaNs
+}
+
+template <size_t Outer, size_t R, size_t Inner, typename T>
+void argmax_axis(const T* in, size_t* out) {
+    auto argmax_outer = [&](size_t o0, size_t o1) {
+        for (size_t o = o0; o < o1; ++o) {
+            const T* base = in + o * R * Inner;
+            if constexpr (Inner == 1) {
+                out[o] = argmax_contiguous(base, R);
+            } else {
+                std::vector<T> best(base, base + Inner);
+                size_t* idx = out + o * Inner;
+                std::fill(idx, idx + Inner, 0);
+                for (size_t r = 1; r < R; ++r) {
+                    const T* row = base + r * Inner;
+                    for (size_t i = 0; i < Inner; ++i) {
+                        if (row[i] > best[i]) {
+                            best[i] = row[i];
+                            idx[i] = r;
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    if constexpr (Outer * R * Inner < REDUCE_PARALLEL_THRESHOLD) {
+        argmax_outer(0, Outer);
+    } else if constexpr (Outer == 1 && Inner == 1) {
+        // single long array: each thread finds the maximum of its chunk
+        constexpr size_t min_chunk = REDUCE_PARALLEL_THRESHOLD / 16;
+        std::vector<size_t> partial(num_chunks(R, min_chunk));
+        parallel_chunks(0, R, min_chunk,
+                        [&](size_t chunk, size_t r0, size_t r1) {
+                            partial[chunk] =
+                                r0 + argmax_contiguous(in + r0, r1 - r0);
+                        });
+        size_t best = partial[0];
+        for (size_t i : partial)
+            if (in[i] > in[best]) best = i;
+        *out = best;
+    } else {
+        parallel_for(0, Outer, 1, argmax_outer);
+    }
+}
+
+/// COMPILE-TIME REDUCTION PLANS ///
+
+// Reduction of the [outer, r, inner] view of a tensor over its r axis
+struct ReduceStep {
+    size_t outer, r, inner;
+};
+
+// Splits the reduction of a tensor with the given shape over the given axes
+// in steps, each reducing a run of consecutive axes. Steps go from the last
+// axis to the first one, and reduced axes keep length one in between steps
+template <typename Axes, size_t... Shape>
+struct ReducePlan;
+
+template <size_t... Axes, size_t... Shape>
+struct ReducePlan<AxesTag<Axes...>, Shape...> {
+    static constexpr size_t ndim = sizeof...(Shape);
+    static constexpr size_t naxes = sizeof...(Axes);
+    static constexpr std::array<size_t, ndim> shape = {Shape...};
+
+    static_assert(naxes > 0, "At least one axis must be reduced");
+    static_assert(((Axes < ndim) && ...), "Reduction axis out of range");
+
+    static constexpr std::array<bool, ndim> mask = []() {
+        std::array<bool, ndim> result = {};
+        ((result[Axes < ndim ? Axes : 0] = true), ...);
+        return result;
+    }();
+
+    static constexpr size_t mask_count = []() {
+        size_t result = 0;
+        for (size_t i = 0; i < ndim; ++i) result += mask[i] ? 1 : 0;
+        return result;
+    }();
+    static_assert(mask_count == naxes, "Reduction axes must be unique");
+
+    // number of reduced elements per output element
+    static constexpr size_t count = []() {
+        size_t result = 1;
+        for (size_t i = 0; i < ndim; ++i)
+            if (mask[i]) result *= shape[i];
+        return result;
+    }();
+
+    static constexpr size_t num_steps = []() {
+        size_t result = 0;
+        for (size_t i = 0; i < ndim; ++i)
+            if (mask[i] && (i + 1 == ndim || !mask[i + 1])) ++result;
+        return result;
+    }();
+
+    static constexpr std::array<ReduceStep, num_steps> steps = []() {
+        std::array<ReduceStep, num_steps> result = {};
+        std::array<size_t, ndim> current = shape;
+        size_t step = 0;
+        for (size_t last = ndim; last-- > 0;) {
+            if (!mask[last]) continue;
+            size_t first = last;
+            while (first > 0 && mask[first - 1]) --first;
+            ReduceStep s = {1, 1, 1};
+            for (size_t i = 0; i < first; ++i) s.outer *= current[i];
+            for (size_t i = first; i <= last; ++i) {
+                s.r *= current[i];
+                current[i] = 1;
+            }
+            for (size_t i = last + 1; i < ndim; ++i) s.inner *= current[i];
+            result[step++] = s;
+            if (first == 0) break;
+            last = first;
+        }
+        return result;
+    }();
+
+    template <bool KeepDims>
+    static constexpr auto result_shape() {
+        std::array<size_t, KeepDims ? ndim : ndim - naxes> result = {};
+        for (size_t i = 0, j = 0; i < ndim; ++i) {
+            if (!mask[i])
+                result[j++] = shape[i];
+            else if (KeepDims)
+                result[j++] = 1;
+        }
+        return result;
+    }
+};
+
+template <typename Plan, bool KeepDims>
+struct ReducedShape {
+    static constexpr auto value = Plan::template result_shape<KeepDims>();
+};
+
+template <typename T, typename ShapeHolder, typename Seq>
+struct TensorOfShape;
+
+template <typename T, typename ShapeHolder, size_t... I>
+struct TensorOfShape<T, ShapeHolder, std::index_sequence<I...>> {
+    using type = Tensor<T, ShapeHolder::value[I]...>;
+};
+
+// reducing all the axes (without keepdims) returns a scalar
+template <typename T, typename ShapeHolder>
+struct TensorOfShape<T, ShapeHolder, std::index_sequence<>> {
+    using type = T;
+};
+
+// Type that results from reducing a tensor with the given plan
+template <typename T, typename Plan, bool KeepDims>
+using reduced_t = typename TensorOfShape<
+    T, ReducedShape<Plan, KeepDims>,
+    std::make_index_sequence<ReducedShape<Plan, KeepDims>::value.size()>>::
+    type;
+
+template <typename Op, typename Plan, size_t Step = 0, typename T>
+void run_reduce_plan(const T* in, T* out, Accumulation accumulation) {
+    constexpr ReduceStep s = Plan::steps[Step];
+    if constexpr (Step + 1 == Plan::num_steps) {
+        reduce_axis<Op, s.outer, s.r, s.inner>(in, out, accumulation);
+    } else {
+        std::vector<T> tmp(s.outer * s.inner);
+        reduce_axis<Op, s.outer, s.r, s.inner>(in, tmp.data(), accumulation);
+        run_reduce_plan<Op, Plan, Step + 1>(tmp.data(), out, accumulation);
+    }
+}
+
+};  // namespace detail
+
+};  // namespace common
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "libcpp-common/geometry/aabb.h"
+#include "libcpp-common/test.h"
+
+using namespace common;
+
+TEST_CASE(00_aabb, {
+    AABB3f empty;
+    TEST_TRUE(empty.empty());
+    TEST_EQ(empty.surface_area(), 0.f);
+
+    AABB3f a(Vec3f(0, 0, 0), Vec3f(2, 1, 1));
+    AABB3f b(Vec3f(1, 0.5f, -1), Vec3f(3, 3, 0.5f));
+    TEST_EQ(a.surface_area(), 10.f);
+    TEST_EQ(a.largest_axis(), 0u);
+    TEST_TRUE(merge(a, empty) == a);
+    TEST_TRUE(merge(a, b) == AABB3f(Vec3f(0, 0, -1), Vec3f(3, 3, 1)));
+    TEST_TRUE(intersection(a, b) ==
+              AABB3f(Vec3f(1, 0.5f, 0), Vec3f(2, 1, 0.5f)));
+    TEST_TRUE(a.overlaps(b));
+    AABB3f c(Vec3f(5), Vec3f(6));
+    TEST_TRUE(!a.overlaps(c) && intersection(a, c).empty());
+    TEST_TRUE(a.contains(Vec3f(1, 1, 0)) && !a.contains(Vec3f(1, 1.5f, 0)));
+    TEST_EQ(a.distance2(Vec3f(4, 0.5f, 2)), 5.f);
+
+    // rays along x, one of them parallel to the faces at y = 0 and z = 0
+    const float inf = std::numeric_limits<float>::infinity();
+    const Vec3f inverse(1, inf, inf);
+    float tmin = 0, tmax = inf;
+    TEST_TRUE(a.intersect(Vec3f(-1, 0.5f, 0.5f), inverse, tmin, tmax));
+    TEST_EQ(tmin, 1.f);
+    TEST_EQ(tmax, 3.f);
+    tmin = 0, tmax = inf;
+    TEST_TRUE(a.intersect(Vec3f(-1, 0, 0), inverse, tmin, tmax));
+    tmin = 0, tmax = inf;
+    TEST_TRUE(!a.intersect(Vec3f(-1, 2, 0.5f), inverse, tmin, tmax));
+    tmin = 0, tmax = 0.5f;
+    TEST_TRUE(!a.intersect(Vec3f(-1, 0.5f, 0.5f), inverse, tmin, tmax));
+})
+
+TEST_CASE(01_bounds, {
+    TEST_TRUE(bounds(VecList3f()).empty());
+
+    // sizes around the SIMD and thread splits, against a plain loop
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-100, 100);
+    for (size_t n : {1, 3, 7, 17, 1000, 300001}) {
+        VecList3f points3(n);
+        VecList4f points4(n);
+        VecList2i points2(n);
+        for (size_t i = 0; i < n; ++i) {
+            points3[i] = Vec3f(dist(rng), dist(rng), dist(rng));
+            points4[i] = Vec4f(points3[i], dist(rng));
+            points2[i] = Vec2i(int(dist(rng)), int(dist(rng)));
+        }
+        points3[n / 2].y() = std::nanf("");  // ignored
+        AABB3f box3;
+        AABB4f box4;
+        AABB2i box2;
+        for (size_t i = 0; i < n; ++i) {
+            box3.extend(points3[i]);
+            box4.extend(points4[i]);
+            box2.extend(points2[i]);
+        }
+        const AABB3f result3 = bounds(points3);
+        const AABB4f result4 = bounds(points4);
+        const AABB2i result2 = bounds(points2);
+        TEST_TRUE(result3 == box3 && result4 == box4 && result2 == box2);
+        TEST_TRUE(!std::isnan(result3.min.y()) &&
+                  !std::isnan(result3.max.y()));
+    }
+})
@@ -58,10 +58,10 @@ TEST_CASE(03_constructor_n_values, {
     Vec3i v3(1, 2, 3);
     Vec4i v4(1, 2, 3, 4);
     Vec<int, 10> v10(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
-    for (int i = 1; i <= 2; ++i) TEST_TRUE(v2[i] = i);
-    for (int i = 1; i <= 3; ++i) TEST_TRUE(v3[i] = i);
-    for (int i = 1; i <= 4; ++i) TEST_TRUE(v4[i] = i);
-    for (int i = 1; i <= 10; ++i) TEST_TRUE(v10[i] = i);
+    for (int i = 0; i < 2; ++i) TEST_TRUE(v2[i] == i + 1);
+    for (int i = 0; i < 3; ++i) TEST_TRUE(v3[i] == i + 1);
+    for (int i = 0; i < 4; ++i) TEST_TRUE(v4[i] == i + 1);
+    for (int i = 0; i < 10; ++i) TEST_TRUE(v10[i] == i + 1);
 })
 
 TEST_CASE(04_conversion_vec3_vec4, {
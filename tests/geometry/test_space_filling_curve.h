@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "libcpp-common/geometry/space_filling_curve.h"
+#include "libcpp-common/test.h"
+
+using namespace common;
+
+TEST_CASE(00_morton, {
+    std::mt19937 rng(4);
+    for (int i = 0; i < 1000; ++i) {
+        const uint32_t x = rng() & 0x1fffff, y = rng() & 0x1fffff,
+                       z = rng() & 0x1fffff;
+        uint64_t expected64 = 0;
+        uint32_t expected32 = 0;
+        for (unsigned int b = 0; b < 21; ++b) {
+            const uint64_t bits = ((x >> b) & 1) | (((y >> b) & 1) << 1) |
+                                  (((z >> b) & 1) << 2);
+            expected64 |= bits << (3 * b);
+            if (b < 10) expected32 |= uint32_t(bits) << (3 * b);
+        }
+        TEST_TRUE(morton_encode<uint64_t>(x, y, z) == expected64);
+        TEST_TRUE(morton_encode<uint32_t>(x & 0x3ff, y & 0x3ff, z & 0x3ff) ==
+                  expected32);
+    }
+})
+
+// The curve starts by filling the corner of 8^3 cells of the grid (of 2^10
+// or 2^21 cells per axis) with indices 0 to 511, through neighbouring cells
+TEST_CASE(01_hilbert, {
+    std::vector<int> cell32(512, -1), cell64(512, -1);
+    for (uint32_t c = 0; c < 512; ++c) {
+        const uint32_t x = c & 7, y = (c >> 3) & 7, z = c >> 6;
+        const uint32_t h32 = hilbert_encode<uint32_t>(x, y, z);
+        const uint64_t h64 = hilbert_encode<uint64_t>(x, y, z);
+        TEST_TRUE(h32 < 512 && h64 < 512);
+        cell32[h32] = int(c);
+        cell64[h64] = int(c);
+    }
+    for (const std::vector<int>* cells : {&cell32, &cell64}) {
+        for (uint32_t h = 0; h < 512; ++h) TEST_TRUE((*cells)[h] >= 0);
+        for (uint32_t h = 1; h < 512; ++h) {
+            const int a = (*cells)[h - 1], b = (*cells)[h];
+            const int distance = std::abs((a & 7) - (b & 7)) +
+                                 std::abs(((a >> 3) & 7) - ((b >> 3) & 7)) +
+                                 std::abs((a >> 6) - (b >> 6));
+            TEST_EQ(distance, 1);
+        }
+    }
+})
+
+TEST_CASE(02_sort_along_curve, {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> u(-10, 10);
+    VecList3f points;
+    // and above the sizes split between threads by the codes and the sort
+    for (size_t n : {5000, 200000}) {
+        points = VecList3f(n);
+        for (size_t i = 0; i < points.size(); ++i)
+            points[i] = Vec3f(u(rng), u(rng), u(rng));
+        const VecList3f original = points;
+        std::vector<uint32_t> ids(points.size());
+        VecList3f copies = points;
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = uint32_t(i);
+
+        for (Curve curve : {Curve::Morton, Curve::Hilbert}) {
+            std::vector<uint32_t> order =
+                sort_along_curve(points, curve, ids, copies);
+            TEST_EQ(order.size(), points.size());
+            const std::vector<uint64_t> codes =
+                curve_codes<uint64_t>(points, curve);
+            bool sorted = true;
+            for (size_t i = 0; i < points.size(); ++i) {
+                sorted &= points[i] == copies[i];
+                sorted &= points[i] == original[ids[i]];
+                if (i > 0) sorted &= codes[i - 1] <= codes[i];
+            }
+            TEST_TRUE(sorted);
+            // sorting again keeps the order
+            order = sort_order(codes, 63);
+            bool same = true;
+            for (size_t i = 0; i < order.size(); ++i) same &= order[i] == i;
+            TEST_TRUE(same);
+        }
+    }
+
+    // points out of the box are clamped to its cells
+    const AABB3f box(Vec3f(0, 0, 0), Vec3f(1, 1, 1));
+    VecList3f outside(3);
+    outside[0] = Vec3f(-1e30f, 0, 0);
+    outside[1] = Vec3f(1e30f, 1, 1);
+    outside[2] = Vec3f(1, 1, 1);
+    const std::vector<uint32_t> clamped =
+        curve_codes<uint32_t>(outside, Curve::Morton, box);
+    TEST_EQ(clamped[0], 0u);
+    TEST_EQ(clamped[1], clamped[2]);
+    TEST_EQ(clamped[2], (uint32_t(1) << 30) - 1);
+
+    std::vector<uint32_t> short_ids(10);
+    bool thrown = false;
+    try {
+        sort_along_curve(points, Curve::Morton, short_ids);
+    } catch (const common::detail::CommonGeometryException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "libcpp-common/geometry/spatial.h"
+#include "libcpp-common/test.h"
+
+using namespace common;
+
+// Points in [0, 10)^3, a tenth of them repeated, as Vec4 with w = 1
+VecList4f random_points(size_t n, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(0, 10);
+    VecList4f points(n);
+    for (size_t i = 0; i < n; ++i)
+        points[i] = i % 10 == 9 ? points[i / 2]
+                                : Vec4f(dist(rng), dist(rng), dist(rng), 1);
+    return points;
+}
+
+// Squared distances of the points within r of p, sorted, by brute force
+std::vector<float> brute_force(const VecList4f& points, const Vec3f& p,
+                               float r) {
+    std::vector<float> result;
+    for (const Vec4f& q : points) {
+        const float d2 = (q.xyz() - p).module2();
+        if (d2 <= r * r) result.push_back(d2);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<float> sorted_distances(const std::vector<Neighbor<float>>& found,
+                                    const VecList4f& points, const Vec3f& p) {
+    std::vector<float> result;
+    for (const Neighbor<float>& n : found)
+        if ((points[n.index].xyz() - p).module2() == n.distance2)
+            result.push_back(n.distance2);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST_CASE(00_kdtree, {
+    const VecList4f points = random_points(5000, 1);
+    KDTree4f tree(points, 4);
+    TEST_EQ(tree.size(), 5000);
+    const VecList4f queries = random_points(100, 2);
+    bool nearest = true, knn = true, radius = true;
+    std::vector<Neighbor<float>> found;
+    for (const Vec4f& q : queries) {
+        const Vec3f p = q.xyz();
+        const std::vector<float> all = brute_force(points, p, 100);
+        const Neighbor<float> n = tree.nearest(p);
+        nearest &= n.found() && n.distance2 == all[0];
+        found.resize(10);
+        const size_t count = tree.knn(p, 10, found.data());
+        knn &= count == 10 && sorted_distances(found, points, p) ==
+                                  std::vector<float>(all.begin(),
+                                                     all.begin() + 10);
+        tree.radius(p, 0.8f, found);
+        radius &= sorted_distances(found, points, p) ==
+                  brute_force(points, p, 0.8f);
+    }
+    TEST_TRUE(nearest && knn && radius);
+
+    // too far, and more neighbours than points
+    TEST_TRUE(!tree.nearest(Vec3f(100, 0, 0), 1).found());
+    const VecList4f few = random_points(3, 3);
+    KDTree4f small(few);
+    found.resize(5);
+    const size_t count = small.knn(Vec3f(0, 0, 0), 5, found.data());
+    TEST_EQ(count, 3);
+    TEST_TRUE(found[2].found() && !found[3].found() && !found[4].found());
+    TEST_TRUE(!KDTree3f().nearest(Vec3f(0, 0, 0)).found());
+})
+
+TEST_CASE(01_kdtree_batched, {
+    // large enough to be partitioned by several threads
+    const VecList4f points = random_points(200000, 4);
+    const KDTree4f tree(points);
+    const VecList4f queries = random_points(2000, 5);
+    std::vector<Neighbor<float>> knn(4 * queries.size());
+    tree.knn(queries.data(), queries.size(), 4, knn.data());
+    const NeighborRows<float> rows =
+        tree.radius(queries.data(), queries.size(), 0.2f);
+    TEST_EQ(rows.size(), queries.size());
+    bool ok = true;
+    std::vector<Neighbor<float>> found;
+    for (size_t i = 0; ok && i < queries.size(); i += 37) {
+        const Vec3f p = queries[i].xyz();
+        const std::vector<float> all = brute_force(points, p, 0.5f);
+        found.assign(knn.begin() + 4 * i, knn.begin() + 4 * i + 4);
+        ok = sorted_distances(found, points, p) ==
+             std::vector<float>(all.begin(), all.begin() + 4);
+        found.assign(rows[i].begin(), rows[i].end());
+        ok &= sorted_distances(found, points, p) ==
+              brute_force(points, p, 0.2f);
+    }
+    TEST_TRUE(ok);
+})
+
+TEST_CASE(02_hash_grid, {
+    const VecList4f points = random_points(20000, 6);
+    HashGrid4f grid(points, 0.5f);
+    TEST_EQ(grid.size(), points.size());
+    const VecList4f queries = random_points(500, 7);
+    bool radius = true, nearest = true, large = true;
+    std::vector<Neighbor<float>> found;
+    for (const Vec4f& q : queries) {
+        const Vec3f p = q.xyz();
+        grid.radius(p, 0.5f, found);
+        const std::vector<float> expected = brute_force(points, p, 0.5f);
+        radius &= sorted_distances(found, points, p) == expected;
+        const Neighbor<float> n = grid.nearest(p);
+        nearest &= expected.empty() ? !n.found()
+                                    : n.distance2 == expected[0];
+        grid.radius(p, 1.3f, found);
+        large &= sorted_distances(found, points, p) ==
+                 brute_force(points, p, 1.3f);
+    }
+    TEST_TRUE(radius && nearest && large);
+
+    const NeighborRows<float> rows =
+        grid.radius(queries.data(), queries.size(), 0.3f);
+    bool batched = rows.size() == queries.size();
+    for (size_t i = 0; batched && i < queries.size(); ++i) {
+        found.assign(rows[i].begin(), rows[i].end());
+        batched = sorted_distances(found, points, queries[i].xyz()) ==
+                  brute_force(points, queries[i].xyz(), 0.3f);
+    }
+    TEST_TRUE(batched);
+
+    // unbounded and non-finite queries
+    const float inf = std::numeric_limits<float>::infinity();
+    grid.radius(Vec3f(1, 2, 3), inf, found);
+    TEST_EQ(found.size(), points.size());
+    grid.radius(Vec3f(inf, 0, 0), 1, found);
+    TEST_TRUE(found.empty());
+    TEST_TRUE(!grid.nearest(Vec3f(std::nanf(""), 0, 0), 1).found());
+    TEST_TRUE(grid.nearest(Vec3f(-1e15f, 0, 0), inf).found());
+
+    bool thrown = false;
+    try {
+        HashGrid4f bad(points, 0);
+    } catch (const common::detail::CommonGeometryException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+
+#include "libcpp-common/geometry/transform.h"
+#include "libcpp-common/test.h"
+
+using namespace common;
+
+template <typename V>
+static bool near_vec(const V& a, const V& b, float eps = 1e-4f) {
+    for (unsigned int k = 0; k < V::size; ++k)
+        if (std::abs(a[k] - b[k]) > eps) return false;
+    return true;
+}
+
+static bool near_affine(const Affinef& a, const Affinef& b,
+                        float eps = 1e-4f) {
+    for (unsigned int i = 0; i < 3; ++i)
+        if (!near_vec(a.rows[i], b.rows[i], eps)) return false;
+    return true;
+}
+
+TEST_CASE(00_quat, {
+    const float pi = std::acos(-1.0f);
+    const Quatf q = Quatf::axis_angle(Vec3f(0, 0, 2), pi / 2);
+    TEST_TRUE(near_vec(q * Vec3f(1, 0, 0), Vec3f(0, 1, 0)));
+
+    // same rotation as the 4x4 matrix, also after composing
+    const Vec3f axis = Vec3f(1, 2, -3).normalized();
+    const Quatf r = Quatf::axis_angle(axis, 0.7f);
+    const Mat4f m = Mat4f::rotation_axis_angle(Vec4f(axis, 0), 0.7f);
+    const Vec3f v(0.3f, -1.5f, 2);
+    TEST_TRUE(near_vec(r * v, (m * Vec4f(v, 1)).xyz()));
+    TEST_TRUE(near_vec((q * r) * v, q * (r * v)));
+    TEST_TRUE(near_vec(r.inverse() * (r * v), v));
+
+    // to a matrix and back, for rotations of all the branches of Shepperd's
+    for (float angle : {0.5f, 2.5f, 3.1f})
+        for (const Vec3f& a : {Vec3f(1, 0.1f, 0), Vec3f(0, 1, 0.1f),
+                               Vec3f(0.1f, 0, 1)}) {
+            const Quatf p = Quatf::axis_angle(a, angle);
+            Quatf back = Quatf::from_matrix(p.matrix());
+            if (dot(back, p) < 0) back = -back;
+            TEST_TRUE(near_vec(Vec4f(back.x, back.y, back.z, back.w),
+                               Vec4f(p.x, p.y, p.z, p.w)));
+        }
+
+    // interpolations, by the shortest path
+    const Quatf a = Quatf::axis_angle(Vec3f(0, 1, 0), 0.2f);
+    const Quatf b = Quatf::axis_angle(Vec3f(0, 1, 0), 1.4f);
+    const Quatf half = slerp(a, b, 0.5f);
+    TEST_TRUE(
+        near_vec(half * v, Quatf::axis_angle(Vec3f(0, 1, 0), 0.8f) * v));
+    TEST_TRUE(near_vec(slerp(a, -b, 0.25f) * v,
+                       Quatf::axis_angle(Vec3f(0, 1, 0), 0.5f) * v));
+    TEST_TRUE(near_vec(slerp(a, b, 0.f) * v, a * v));
+    TEST_TRUE(near_vec(nlerp(a, a, 0.5f) * v, a * v));
+})
+
+TEST_CASE(01_affine, {
+    const Affinef pose(Quatf::axis_angle(Vec3f(1, 1, 0), 0.9f),
+                       Vec3f(1, -2, 0.5f));
+    const Affinef stretch = Affinef::scale(Vec3f(2, 0.5f, 3)) *
+                            Affinef::translation(Vec3f(0, 1, 0));
+    const Vec3f p(0.25f, 1, -2);
+
+    // same as the 4x4 matrices
+    const Mat4f product = pose.matrix() * stretch.matrix();
+    TEST_TRUE(near_affine(pose * stretch, Affinef(product)));
+    TEST_TRUE(near_vec((pose * stretch) * p, pose * (stretch * p)));
+    TEST_TRUE(near_vec(pose * p, (pose.matrix() * Vec4f(p, 1)).xyz()));
+    TEST_TRUE(near_vec(pose * Vec4f(p, 0), Vec4f(pose.apply_vector(p), 0)));
+    TEST_TRUE(near_vec(stretch * p, Vec3f(0.5f, 1, -6)));
+
+    // inverses
+    TEST_TRUE(near_affine(pose.rigid_inverse() * pose, Affinef()));
+    TEST_TRUE(near_affine(pose.inverse() * pose, Affinef()));
+    TEST_TRUE(near_affine(stretch * stretch.inverse(), Affinef()));
+    TEST_TRUE(near_affine((pose * stretch).inverse(),
+                          Affinef(product.inverse())));
+})
+
+TEST_CASE(02_affine_lists, {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u(-10, 10);
+    const Affinef a(Quatf::axis_angle(Vec3f(0.3f, -1, 2), 1.1f),
+                    Vec3f(5, -1, 0.5f));
+    const Affinef b = Affinef::scale(Vec3f(1, 2, 3)) * a;
+    // around the sizes of a pack and of the group of packs
+    for (size_t n : {0, 1, 2, 3, 5, 8, 17, 1000, 100001}) {
+        VecList3f p3(n);
+        VecList4f p4(n);
+        for (size_t i = 0; i < n; ++i) {
+            p3[i] = Vec3f(u(rng), u(rng), u(rng));
+            p4[i] = Vec4f(p3[i], i % 2);
+        }
+        const VecList3f points = b * p3, vectors = b.apply_vectors(p3);
+        const VecList4f homogeneous = b * p4, vectors4 = b.apply_vectors(p4);
+        TEST_EQ(points.size(), n);
+        TEST_EQ(homogeneous.size(), n);
+        bool same = true;
+        for (size_t i = 0; i < n; ++i) {
+            same &= near_vec(points[i], b * p3[i], 1e-3f);
+            same &= near_vec(vectors[i], b.apply_vector(p3[i]), 1e-3f);
+            same &= near_vec(homogeneous[i], b * p4[i], 1e-3f);
+            same &= near_vec(vectors4[i],
+                             Vec4f(b.apply_vector(p4[i].xyz()), p4[i].w()),
+                             1e-3f);
+        }
+        TEST_TRUE(same);
+    }
+})
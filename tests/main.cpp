@@ -3,8 +3,14 @@
 #include "libcpp-common/test.h"
 // specific tests
 #include "geometry/test_geometry.h"
+#include "geometry/test_aabb.h"
+#include "geometry/test_spatial.h"
+#include "geometry/test_space_filling_curve.h"
+#include "geometry/test_transform.h"
+#include "mesh/test_mesh.h"
+#include "tensor/test_tensor.h"
 
 int main() {
     common::test::run_tests();
     return 0;
-}
\ No newline at end of file
+}
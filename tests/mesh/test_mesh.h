@@ -0,0 +1,1459 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "libcpp-common/mesh.h"
+#include "libcpp-common/test.h"
+
+using namespace common;
+
+// Helpers to write small PLY files for the tests
+template <typename T>
+void ply_put(std::string& body, T value, bool big_endian = false) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if (big_endian) std::reverse(bytes, bytes + sizeof(T));
+    body.append(bytes, sizeof(T));
+}
+
+std::string write_test_file(const std::string& name,
+                            const std::string& contents) {
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream file(filename, std::ios::binary);
+    file << contents;
+    return filename;
+}
+
+// Unit square split in two triangles, as binary PLY with some extra data
+std::string binary_quad_ply(bool big_endian) {
+    std::string ply = std::string("ply\nformat binary_") +
+                      (big_endian ? "big" : "little") +
+                      "_endian 1.0\n"
+                      "comment extra properties that are ignored\n"
+                      "element vertex 4\n"
+                      "property double x\n"
+                      "property uchar red\n"
+                      "property double y\n"
+                      "property double z\n"
+                      "element face 2\n"
+                      "property list uchar uint vertex_indices\n"
+                      "element edge 1\n"
+                      "property list uchar int vertex_indices\n"
+                      "end_header\n";
+    const double xy[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    for (const auto& v : xy) {
+        ply_put<double>(ply, v[0], big_endian);
+        ply_put<uint8_t>(ply, 255);
+        ply_put<double>(ply, v[1], big_endian);
+        ply_put<double>(ply, 0.5, big_endian);
+    }
+    const uint32_t faces[2][3] = {{0, 1, 2}, {0, 2, 3}};
+    for (const auto& f : faces) {
+        ply_put<uint8_t>(ply, 3);
+        for (uint32_t i : f) ply_put<uint32_t>(ply, i, big_endian);
+    }
+    ply_put<uint8_t>(ply, 2);
+    ply_put<int32_t>(ply, 0, big_endian);
+    ply_put<int32_t>(ply, 1, big_endian);
+    return ply;
+}
+
+bool is_test_quad(const Mesh& mesh) {
+    return mesh.vertices.size() == 4 && mesh.faces.size() == 2 &&
+           mesh.vertices[2] == Vec4f(1, 1, 0.5f, 1) &&
+           mesh.vertices[3] == Vec4f(0, 1, 0.5f, 1) &&
+           mesh.faces[1] == Vec3u(0, 2, 3);
+}
+
+TEST_CASE(00_ply_ascii, {
+    const std::string filename = write_test_file(
+        "common_test_ascii.ply",
+        "ply\n"
+        "format ascii 1.0\n"
+        "comment quad\n"
+        "element vertex 4\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "property float nx\n"
+        "element face 2\n"
+        "property list uchar int vertex_indices\n"
+        "property uchar red\n"
+        "end_header\n"
+        "0 0 0.5 1\n1 0 0.5 1\n1 1 0.5 1\n0 1 0.5 1\n"
+        "3 0 1 2 255\n3 0 2 3 255\n");
+    TEST_TRUE(is_test_quad(load_mesh(filename.c_str())));
+    std::filesystem::remove(filename);
+})
+
+TEST_CASE(01_ply_binary, {
+    for (bool big_endian : {false, true}) {
+        const std::string filename = write_test_file(
+            "common_test_binary.ply", binary_quad_ply(big_endian));
+        TEST_TRUE(is_test_quad(load_mesh(filename.c_str())));
+        std::filesystem::remove(filename);
+    }
+})
+
+TEST_CASE(02_ply_binary_face_properties, {
+    // faces with other properties besides the indices
+    std::string ply =
+        "ply\nformat binary_little_endian 1.0\n"
+        "element vertex 3\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "element face 1\n"
+        "property uchar flags\n"
+        "property list int ushort vertex_index\n"
+        "end_header\n";
+    for (int i = 0; i < 9; ++i) ply_put<float>(ply, float(i));
+    ply_put<uint8_t>(ply, 7);
+    ply_put<int32_t>(ply, 3);
+    for (uint16_t i : {2, 1, 0}) ply_put<uint16_t>(ply, i);
+    const std::string filename = write_test_file("common_test_face.ply", ply);
+    Mesh mesh = load_mesh(filename.c_str());
+    TEST_EQ(mesh.vertices[1], Vec4f(3, 4, 5, 1));
+    TEST_EQ(mesh.faces[0], Vec3u(2, 1, 0));
+    std::filesystem::remove(filename);
+})
+
+TEST_CASE(03_ply_errors, {
+    // truncated body
+    std::string ply = binary_quad_ply(false);
+    ply.resize(ply.size() - 20);
+    const std::string filename = write_test_file("common_test_bad.ply", ply);
+    bool thrown = false;
+    try {
+        load_mesh(filename.c_str());
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+    std::filesystem::remove(filename);
+})
+
+TEST_CASE(04_ply_large, {
+    // large enough to be decoded by several threads
+    constexpr size_t N = 300000;
+    std::string ply = "ply\nformat binary_little_endian 1.0\n"
+                      "element vertex " + std::to_string(N) + "\n"
+                      "property float x\nproperty float y\nproperty float z\n"
+                      "element face " + std::to_string(N) + "\n"
+                      "property list uchar int vertex_indices\n"
+                      "end_header\n";
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = 0; j < 3; ++j) ply_put<float>(ply, float(i + j));
+    for (size_t i = 0; i < N; ++i) {
+        ply_put<uint8_t>(ply, 3);
+        for (size_t j = 0; j < 3; ++j) ply_put<int32_t>(ply, (i + j) % N);
+    }
+    Mesh mesh = load_ply(reinterpret_cast<const uint8_t*>(ply.data()),
+                         ply.size());
+    bool ok = mesh.vertices.size() == N && mesh.faces.size() == N;
+    for (size_t i = 0; ok && i < N; ++i)
+        ok = mesh.vertices[i] == Vec4f(i, i + 1, i + 2, 1) &&
+             mesh.faces[i] == Vec3u(i, (i + 1) % N, (i + 2) % N);
+    TEST_TRUE(ok);
+})
+
+TEST_CASE(05_ply_ascii_large, {
+    // several MB of text, parsed in chunks by several threads
+    constexpr size_t N = 100000;
+    std::string ply = "ply\nformat ascii 1.0\n"
+                      "element vertex " + std::to_string(N) + "\n"
+                      "property float x\nproperty float y\nproperty float z\n"
+                      "property uchar red\n"
+                      "element face " + std::to_string(N) + "\n"
+                      "property list uchar int vertex_indices\n"
+                      "end_header\n";
+    for (size_t i = 0; i < N; ++i)
+        ply += std::to_string(i) + ".5 " + std::to_string(i + 1) + " -" +
+               std::to_string(i + 2) + "e1 255\r\n";
+    for (size_t i = 0; i < N; ++i)
+        ply += "3 " + std::to_string(i) + "  " + std::to_string((i + 1) % N) +
+               "\t" + std::to_string((i + 2) % N) + "\n";
+    Mesh mesh = load_ply(reinterpret_cast<const uint8_t*>(ply.data()),
+                         ply.size());
+    bool ok = mesh.vertices.size() == N && mesh.faces.size() == N;
+    for (size_t i = 0; ok && i < N; ++i)
+        ok = mesh.vertices[i] == Vec4f(i + 0.5f, i + 1, -(i + 2.f) * 10, 1) &&
+             mesh.faces[i] == Vec3u(i, (i + 1) % N, (i + 2) % N);
+    TEST_TRUE(ok);
+})
+
+TEST_CASE(06_compact_mesh, {
+    const std::string filename =
+        write_test_file("common_test_compact.ply", binary_quad_ply(false));
+    CompactMesh quad = load_compact_mesh(filename.c_str());
+    std::filesystem::remove(filename);
+    TEST_TRUE(quad.has_16bit_indices());
+    TEST_EQ(quad.faces16.size(), 2);
+    TEST_TRUE(quad.faces32.empty());
+    TEST_EQ(quad.vertices[2], Vec3f(1, 1, 0.5f));
+    TEST_EQ(quad.face(1), Vec3u(0, 2, 3));
+    TEST_TRUE(is_test_quad(quad.to_mesh()));
+    size_t sum = quad.visit_faces([](const auto& faces) {
+        size_t result = 0;
+        for (const auto& f : faces) result += f[0] + f[1] + f[2];
+        return result;
+    });
+    TEST_EQ(sum, 8);
+
+    // more than 65536 vertices need 32-bit indices
+    Mesh mesh;
+    mesh.vertices.assign(70000, Vec4f(1, 2, 3, 1));
+    mesh.faces = {Vec3u(0, 1, 69999)};
+    CompactMesh large = compact(mesh);
+    TEST_TRUE(!large.has_16bit_indices());
+    TEST_EQ(large.face(0), Vec3u(0, 1, 69999));
+    TEST_EQ(large.homogeneous()[5], Vec4f(1, 2, 3, 1));
+})
+
+TEST_CASE(07_mesh_attributes, {
+    // binary, only the requested attributes are loaded
+    for (bool big_endian : {false, true}) {
+        const std::string ply = binary_quad_ply(big_endian);
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(ply.data());
+        Mesh mesh = load_ply(data, ply.size());
+        TEST_TRUE(mesh.vertex_attributes.empty());
+        TEST_TRUE(mesh.face_attributes.empty());
+
+        AttributeMask mask;
+        mask.vertex = {"red", "nx"};
+        mesh = load_ply(data, ply.size(), mask);
+        TEST_TRUE(is_test_quad(mesh));
+        TEST_EQ(mesh.vertex_attributes.num_channels(), 1);
+        TEST_TRUE(mesh.vertex_attributes.get<uint8_t>("red") ==
+                  std::vector<uint8_t>(4, 255));
+        TEST_TRUE(mesh.vertex_attributes.get_as<float>("red") ==
+                  std::vector<float>(4, 255.f));
+
+        CompactMesh compact_mesh = load_compact_ply(data, ply.size(), mask);
+        TEST_TRUE(compact_mesh.vertex_attributes.has("red"));
+        TEST_TRUE(compact_mesh.to_mesh().vertex_attributes.has("red"));
+    }
+
+    // ascii, every attribute
+    const std::string ply =
+        "ply\nformat ascii 1.0\n"
+        "element vertex 3\n"
+        "property float x\nproperty float nx\nproperty float y\n"
+        "property float z\nproperty short u\n"
+        "element face 1\n"
+        "property list uchar int vertex_indices\nproperty uchar red\n"
+        "end_header\n"
+        "0 0.5 0 0 -1\n1 -0.25 0 0 2\n0 1e1 1 0 -3\n"
+        "3 0 1 2 200\n";
+    Mesh mesh = load_ply(reinterpret_cast<const uint8_t*>(ply.data()),
+                         ply.size(), AttributeMask::everything());
+    TEST_EQ(mesh.vertices[2], Vec4f(0, 1, 0, 1));
+    TEST_EQ(mesh.faces[0], Vec3u(0, 1, 2));
+    TEST_TRUE(mesh.vertex_attributes.names() ==
+              std::vector<std::string>({"nx", "u"}));
+    TEST_TRUE(mesh.vertex_attributes.get<float>("nx") ==
+              std::vector<float>({0.5f, -0.25f, 10.f}));
+    TEST_TRUE(mesh.vertex_attributes.get<int16_t>("u") ==
+              std::vector<int16_t>({-1, 2, -3}));
+    TEST_TRUE(mesh.face_attributes.get<uint8_t>("red") ==
+              std::vector<uint8_t>({200}));
+
+    bool thrown = false;
+    try {
+        mesh.vertex_attributes.get<double>("nx");
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+    mesh.vertex_attributes.erase("nx");
+    TEST_TRUE(!mesh.vertex_attributes.has("nx"));
+})
+
+// Mesh with n vertices in a line and n - 2 faces, with one attribute each
+Mesh attribute_test_mesh(size_t n) {
+    Mesh mesh;
+    std::vector<double> height(n);
+    std::vector<int16_t> material(n - 2);
+    for (size_t i = 0; i < n; ++i) {
+        mesh.vertices.push_back(Vec4f(i, 0.5f * i, -1.f * i, 1));
+        height[i] = 0.25 * i;
+    }
+    for (unsigned int i = 0; i + 2 < n; ++i) {
+        mesh.faces.push_back(Vec3u(i, i + 1, i + 2));
+        material[i] = -static_cast<int16_t>(i % 100);
+    }
+    mesh.vertex_attributes.set("height", height);
+    mesh.face_attributes.set("material", material);
+    return mesh;
+}
+
+bool is_same_mesh(const Mesh& a, const Mesh& b) {
+    return a.vertices == b.vertices && a.faces == b.faces &&
+           a.vertex_attributes.get<double>("height") ==
+               b.vertex_attributes.get<double>("height") &&
+           a.face_attributes.get<int16_t>("material") ==
+               b.face_attributes.get<int16_t>("material");
+}
+
+TEST_CASE(08_ply_save, {
+    // larger than a write block
+    for (size_t n : {size_t(5), size_t(300000)}) {
+        const Mesh mesh = attribute_test_mesh(n);
+        const std::string filename =
+            (std::filesystem::temp_directory_path() / "common_test_save.ply")
+                .string();
+        save_mesh(filename.c_str(), mesh);
+        const Mesh loaded =
+            load_mesh(filename.c_str(), AttributeMask::everything());
+        TEST_TRUE(is_same_mesh(mesh, loaded));
+        save_mesh(filename.c_str(), compact(mesh));
+        const CompactMesh compact_loaded =
+            load_compact_mesh(filename.c_str(), AttributeMask::everything());
+        TEST_TRUE(is_same_mesh(mesh, compact_loaded.to_mesh()));
+        std::filesystem::remove(filename);
+    }
+})
+
+TEST_CASE(09_mesh_cache, {
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "common_test_cache.cmesh")
+            .string();
+    // 16 and 32-bit indices
+    for (size_t n : {size_t(100), size_t(70000)}) {
+        const Mesh mesh = attribute_test_mesh(n);
+        save_mesh(filename.c_str(), mesh);
+        TEST_TRUE(is_same_mesh(
+            mesh, load_mesh(filename.c_str(), AttributeMask::everything())));
+        const CompactMesh compact_mesh = load_compact_mesh(filename.c_str());
+        TEST_TRUE(compact_mesh.vertex_attributes.empty());
+        TEST_EQ(compact_mesh.has_16bit_indices(), n <= 65536);
+        TEST_EQ(compact_mesh.face(n - 3), mesh.faces[n - 3]);
+
+        MappedMesh mapped(filename.c_str());
+        TEST_EQ(mapped.num_vertices(), n);
+        TEST_EQ(mapped.num_faces(), n - 2);
+        TEST_EQ(mapped.vertices()[n - 1], mesh.vertices[n - 1].xyz());
+        TEST_EQ(mapped.face(7), Vec3u(7, 8, 9));
+        TEST_TRUE((mapped.faces16() != nullptr) == (n <= 65536));
+        TEST_EQ(mapped.vertex_attribute<double>("height")[4], 1.0);
+        TEST_EQ(mapped.face_attribute<int16_t>("material")[3], -3);
+        TEST_TRUE(!mapped.has_vertex_attribute("material"));
+        TEST_TRUE(is_same_mesh(
+            mesh, mapped.to_mesh(AttributeMask::everything())));
+    }
+
+    // truncated files are detected
+    std::string contents;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), {});
+    }
+
+    // the types in the table of attributes (after the 64-byte header, each
+    // one at byte 8 of its 64-byte entry) are stored in the files, so they
+    // must not change
+    uint32_t types[2];
+    std::memcpy(&types[0], contents.data() + 64 + 8, sizeof(uint32_t));
+    std::memcpy(&types[1], contents.data() + 128 + 8, sizeof(uint32_t));
+    TEST_EQ(types[0], 7u);  // height, double
+    TEST_EQ(types[1], 2u);  // material, int16_t
+    using common::detail::MeshCacheType;
+    using common::detail::mesh_cache_type_of;
+    TEST_TRUE(mesh_cache_type_of<int8_t>() == MeshCacheType(0) &&
+              mesh_cache_type_of<uint8_t>() == MeshCacheType(1) &&
+              mesh_cache_type_of<int16_t>() == MeshCacheType(2) &&
+              mesh_cache_type_of<uint16_t>() == MeshCacheType(3) &&
+              mesh_cache_type_of<int32_t>() == MeshCacheType(4) &&
+              mesh_cache_type_of<uint32_t>() == MeshCacheType(5) &&
+              mesh_cache_type_of<float>() == MeshCacheType(6) &&
+              mesh_cache_type_of<double>() == MeshCacheType(7));
+
+    // and unknown types are rejected
+    std::string unknown = contents;
+    unknown[64 + 8] = 8;
+    write_test_file("common_test_cache.cmesh", unknown);
+    bool unknown_thrown = false;
+    try {
+        load_mesh(filename.c_str());
+    } catch (const common::detail::CommonMeshException&) {
+        unknown_thrown = true;
+    }
+    TEST_TRUE(unknown_thrown);
+
+    write_test_file("common_test_cache.cmesh",
+                    contents.substr(0, contents.size() - 1));
+    bool thrown = false;
+    try {
+        load_mesh(filename.c_str());
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+    std::filesystem::remove(filename);
+})
+
+// Twice the signed area of each triangle in the XY plane, and their sum
+bool all_counterclockwise(const Mesh& mesh, float& area) {
+    bool result = true;
+    area = 0;
+    for (const Vec3u& f : mesh.faces) {
+        const Vec4f a = mesh.vertices[f[0]], b = mesh.vertices[f[1]],
+                    c = mesh.vertices[f[2]];
+        const float twice = (b.x() - a.x()) * (c.y() - a.y()) -
+                            (b.y() - a.y()) * (c.x() - a.x());
+        result &= twice > 0;
+        area += twice / 2;
+    }
+    return result;
+}
+
+TEST_CASE(10_triangulate_polygon, {
+    // L shape, starting at a corner that cannot see the whole polygon
+    const Vec3f l_shape[] = {Vec3f(2, 1, 0), Vec3f(1, 1, 0), Vec3f(1, 2, 0),
+                             Vec3f(0, 2, 0), Vec3f(0, 0, 0), Vec3f(2, 0, 0)};
+    const Vec3f square[] = {Vec3f(0, 0, 1), Vec3f(1, 0, 1), Vec3f(1, 1, 1),
+                            Vec3f(0, 1, 1)};
+    TEST_TRUE(!is_convex_polygon(l_shape, 6));
+    TEST_TRUE(is_convex_polygon(square, 4));
+    TEST_EQ(polygon_triangles(6), 4);
+    TEST_EQ(polygon_triangles(2), 0);
+
+    unsigned int triangles[12];
+    triangulate_polygon(square, 4, triangles);
+    TEST_TRUE(std::equal(triangles, triangles + 6,
+                         std::vector<unsigned int>({0, 1, 2, 0, 2, 3}).begin()));
+    triangulate_polygon(l_shape, 6, triangles);
+    Mesh mesh;
+    for (const Vec3f& p : l_shape) mesh.vertices.push_back(Vec4f(p, 1));
+    for (int t = 0; t < 4; ++t)
+        mesh.faces.push_back(Vec3u(triangles[3 * t], triangles[3 * t + 1],
+                                   triangles[3 * t + 2]));
+    float area;
+    TEST_TRUE(all_counterclockwise(mesh, area));
+    TEST_EQ(area, 3.f);
+})
+
+TEST_CASE(11_ply_polygons, {
+    // a triangle, a square and the L shape of 10_triangulate_polygon, with
+    // a face attribute that is copied to all their triangles
+    const std::string ascii =
+        "ply\nformat ascii 1.0\n"
+        "element vertex 10\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "element face 3\n"
+        "property list ushort int vertex_indices\nproperty uchar group\n"
+        "end_header\n"
+        "2 1 0\n1 1 0\n1 2 0\n0 2 0\n0 0 0\n2 0 0\n"
+        "3 0 0\n4 0 0\n4 1 0\n3 1 0\n"
+        "3 6 7 9 1\n"
+        "4 6 7 8 9 2\n"
+        "6 0 1 2 3 4 5 3\n";
+    std::string binary =
+        "ply\nformat binary_big_endian 1.0\n"
+        "element vertex 10\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "element face 3\n"
+        "property list ushort int vertex_indices\nproperty uchar group\n"
+        "end_header\n";
+    const float xy[10][2] = {{2, 1}, {1, 1}, {1, 2}, {0, 2}, {0, 0},
+                             {2, 0}, {3, 0}, {4, 0}, {4, 1}, {3, 1}};
+    for (const auto& v : xy) {
+        ply_put<float>(binary, v[0], true);
+        ply_put<float>(binary, v[1], true);
+        ply_put<float>(binary, 0.f, true);
+    }
+    const std::vector<std::vector<int32_t>> faces = {
+        {6, 7, 9}, {6, 7, 8, 9}, {0, 1, 2, 3, 4, 5}};
+    for (size_t i = 0; i < faces.size(); ++i) {
+        ply_put<uint16_t>(binary, faces[i].size(), true);
+        for (int32_t v : faces[i]) ply_put<int32_t>(binary, v, true);
+        ply_put<uint8_t>(binary, i + 1);
+    }
+
+    for (const std::string& ply : {ascii, binary}) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(ply.data());
+        Mesh mesh = load_ply(data, ply.size(), AttributeMask::everything());
+        TEST_EQ(mesh.faces.size(), 1 + 2 + 4);
+        TEST_EQ(mesh.faces[0], Vec3u(6, 7, 9));
+        TEST_EQ(mesh.faces[2], Vec3u(6, 8, 9));
+        float area;
+        TEST_TRUE(all_counterclockwise(mesh, area));
+        TEST_EQ(area, 0.5f + 1 + 3);
+        TEST_TRUE(mesh.face_attributes.get<uint8_t>("group") ==
+                  std::vector<uint8_t>({1, 2, 2, 3, 3, 3, 3}));
+        CompactMesh compact_mesh = load_compact_ply(data, ply.size());
+        TEST_TRUE(compact_mesh.to_mesh().faces == mesh.faces);
+    }
+})
+
+TEST_CASE(12_obj, {
+    const std::string obj =
+        "# square and triangle\r\n"
+        "mtllib scene.mtl\r\n"
+        "o square\r\n"
+        "v 0 0 0\r\nv 1 0 0\r\nv 1 1 0\r\nv 0 1 0 1.0\r\n"
+        "vt 0 0\r\nvt 1 0\r\nvt 1 1\r\nvt 0 1\r\nvt 0.5\r\n"
+        "vn 0 0 1\r\n"
+        "usemtl red\r\ns off\r\n"
+        "f 1/1/1 2/2/1 3/3/1 4/4/1  # comment\r\n"
+        "\r\n"
+        "g triangle\r\n"
+        "v 2 0 0\r\n"
+        "f -4/5 -1/-1 -3/-4\r\n"
+        "f 1 2\r\n"  // degenerate, ignored
+        "l 1 2\r\n";
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(obj.data());
+    TEST_TRUE(test_obj(data, obj.size()));
+    TEST_TRUE(!test_obj(data, 10));  // only a comment
+
+    // positions as vertices
+    Mesh mesh = load_obj(data, obj.size());
+    TEST_EQ(mesh.vertices.size(), 5);
+    TEST_EQ(mesh.vertices[4], Vec4f(2, 0, 0, 1));
+    TEST_TRUE(mesh.faces == VecList3u({Vec3u(0, 1, 2), Vec3u(0, 2, 3),
+                                       Vec3u(1, 4, 2)}));
+    TEST_TRUE(mesh.vertex_attributes.empty());
+
+    // a vertex for each v/vt/vn, in order of first use
+    mesh = load_obj(data, obj.size(), AttributeMask::everything());
+    TEST_EQ(mesh.vertices.size(), 7);
+    TEST_TRUE(mesh.faces == VecList3u({Vec3u(0, 1, 2), Vec3u(0, 2, 3),
+                                       Vec3u(4, 5, 6)}));
+    TEST_EQ(mesh.vertices[4], Vec4f(1, 0, 0, 1));
+    TEST_TRUE(mesh.vertex_attributes.get<float>("u") ==
+              std::vector<float>({0, 1, 1, 0, 0.5f, 0.5f, 1}));
+    TEST_TRUE(mesh.vertex_attributes.get<float>("v") ==
+              std::vector<float>({0, 0, 1, 1, 0, 0, 0}));
+    TEST_TRUE(mesh.vertex_attributes.get<float>("nz") ==
+              std::vector<float>({1, 1, 1, 1, 0, 0, 0}));
+
+    // only normals: the square shares one normal, so it has 4 vertices
+    AttributeMask normals;
+    normals.vertex = {"nx", "ny", "nz"};
+    CompactMesh compact_mesh = load_compact_obj(data, obj.size(), normals);
+    TEST_EQ(compact_mesh.vertices.size(), 4 + 3);
+    TEST_TRUE(!compact_mesh.vertex_attributes.has("u"));
+
+    bool thrown = false;
+    try {
+        const std::string bad = "v 0 0 0\nf 1 2 3\n";
+        load_obj(reinterpret_cast<const uint8_t*>(bad.data()), bad.size());
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
+
+TEST_CASE(13_obj_large, {
+    // n x n grid of quads, larger than a parsing chunk
+    const unsigned int n = 400;
+    std::string obj;
+    for (unsigned int y = 0; y < n; ++y)
+        for (unsigned int x = 0; x < n; ++x)
+            obj += "v " + std::to_string(x) + " " + std::to_string(y) +
+                   " 0\nvt " + std::to_string(x) + " 0\n";
+    for (unsigned int y = 0; y + 1 < n; ++y)
+        for (unsigned int x = 0; x + 1 < n; ++x) {
+            const unsigned int i = y * n + x + 1;
+            obj += "f";
+            for (unsigned int v : {i, i + 1, i + n + 1, i + n})
+                obj += " " + std::to_string(v) + "/" + std::to_string(v);
+            obj += "\n";
+        }
+    const std::string filename = write_test_file("common_test_large.obj", obj);
+    Mesh mesh = load_mesh(filename.c_str());
+    Mesh with_uv = load_mesh(filename.c_str(), AttributeMask::everything());
+    std::filesystem::remove(filename);
+
+    TEST_EQ(mesh.faces.size(), 2 * (n - 1) * (n - 1));
+    TEST_EQ(mesh.faces[2 * n], Vec3u(n + 1, n + 2, 2 * n + 2));
+    TEST_EQ(mesh.vertices[n * n - 1], Vec4f(n - 1, n - 1, 0, 1));
+    // same vertices, numbered in order of first use
+    TEST_EQ(with_uv.vertices.size(), n * n);
+    bool ok = true;
+    const std::vector<float>& u = with_uv.vertex_attributes.get<float>("u");
+    for (size_t i = 0; ok && i < with_uv.faces.size(); ++i)
+        for (unsigned int k = 0; k < 3; ++k) {
+            const Vec4f& a = mesh.vertices[mesh.faces[i][k]];
+            const Vec4f& b = with_uv.vertices[with_uv.faces[i][k]];
+            ok &= a == b && u[with_uv.faces[i][k]] == a.x();
+        }
+    TEST_TRUE(ok);
+    TEST_EQ(with_uv.faces[0], Vec3u(0, 1, 2));
+})
+
+// Random triangles of size ~0.05 inside the unit cube
+Mesh random_triangles(size_t n, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(0, 1);
+    std::uniform_real_distribution<float> offset(-0.05f, 0.05f);
+    Mesh mesh;
+    for (size_t i = 0; i < n; ++i) {
+        const Vec3f c(position(rng), position(rng), position(rng));
+        for (unsigned int k = 0; k < 3; ++k)
+            mesh.vertices.push_back(Vec4f(
+                c + Vec3f(offset(rng), offset(rng), offset(rng)), 1.0f));
+        mesh.faces.push_back(Vec3u(3 * i, 3 * i + 1, 3 * i + 2));
+    }
+    return mesh;
+}
+
+// Reference queries, in double precision and testing every face
+double brute_force_hit(const Mesh& mesh, const Ray& ray, uint32_t& face) {
+    double best = ray.tmax;
+    face = NO_FACE;
+    for (size_t i = 0; i < mesh.faces.size(); ++i) {
+        const Vec4f& a = mesh.vertices[mesh.faces[i][0]];
+        const Vec4f& b = mesh.vertices[mesh.faces[i][1]];
+        const Vec4f& c = mesh.vertices[mesh.faces[i][2]];
+        // solve o + t * d = a + u * (b - a) + v * (c - a) by Cramer's rule
+        double m[3][3], r[3];
+        for (unsigned int k = 0; k < 3; ++k) {
+            m[k][0] = double(b[k]) - a[k];
+            m[k][1] = double(c[k]) - a[k];
+            m[k][2] = -double(ray.direction[k]);
+            r[k] = double(ray.origin[k]) - a[k];
+        }
+        auto det = [](double m[3][3]) {
+            return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                   m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                   m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        };
+        const double d = det(m);
+        if (d == 0) continue;
+        double x[3];
+        for (unsigned int j = 0; j < 3; ++j) {
+            double mj[3][3];
+            for (unsigned int k = 0; k < 3; ++k)
+                for (unsigned int l = 0; l < 3; ++l)
+                    mj[k][l] = l == j ? r[k] : m[k][l];
+            x[j] = det(mj) / d;
+        }
+        if (x[0] >= 0 && x[1] >= 0 && x[0] + x[1] <= 1 && x[2] >= ray.tmin &&
+            x[2] <= best) {
+            best = x[2];
+            face = i;
+        }
+    }
+    return best;
+}
+
+double brute_force_distance(const Mesh& mesh, const Vec3f& p) {
+    auto segment = [&](const Vec3f& a, const Vec3f& b) {
+        const Vec3f ab = b - a;
+        const float t =
+            std::clamp(dot(p - a, ab) / std::max(ab.module2(), 1e-30f), 0.0f,
+                       1.0f);
+        return (a + ab * t - p).module();
+    };
+    double best = std::numeric_limits<double>::infinity();
+    for (const Vec3u& f : mesh.faces) {
+        const Vec3f a = mesh.vertices[f[0]].xyz();
+        const Vec3f b = mesh.vertices[f[1]].xyz();
+        const Vec3f c = mesh.vertices[f[2]].xyz();
+        const Vec3f n = cross(b - a, c - a).normalized();
+        const Vec3f q = p - n * dot(p - a, n);  // projection on the plane
+        if (dot(cross(b - a, q - a), n) >= 0 &&
+            dot(cross(c - b, q - b), n) >= 0 &&
+            dot(cross(a - c, q - c), n) >= 0)
+            best = std::min<double>(best, std::abs(dot(p - a, n)));
+        best = std::min<double>(
+            best, std::min({segment(a, b), segment(b, c), segment(c, a)}));
+    }
+    return best;
+}
+
+TEST_CASE(14_bvh, {
+    // more faces than BVH_PARALLEL_MIN, so that the top levels are built in
+    // parallel
+    const Mesh mesh = random_triangles(40000, 1);
+    const BVH bvh(mesh);
+    TEST_EQ(bvh.num_faces(), mesh.faces.size());
+    TEST_TRUE(bvh.depth() <= 65);
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> position(-0.5f, 1.5f);
+    std::vector<Ray> rays;
+    for (unsigned int i = 0; i < 200; ++i) {
+        const Vec3f a(position(rng), position(rng), position(rng));
+        const Vec3f b(position(rng), position(rng), position(rng));
+        rays.push_back(Ray(a, b - a, 0, i % 2 == 0 ? 1.0f : 1e30f));
+    }
+    std::vector<RayHit> hits(rays.size());
+    std::unique_ptr<bool[]> occluded(new bool[rays.size()]);
+    bvh.intersect(rays.data(), rays.size(), hits.data());
+    bvh.occluded(rays.data(), rays.size(), occluded.get());
+    size_t num_hits = 0;
+    bool ok = true;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        uint32_t face;
+        const double t = brute_force_hit(mesh, rays[i], face);
+        ok &= hits[i].hit() == (face != NO_FACE) &&
+              occluded[i] == hits[i].hit();
+        if (face == NO_FACE) continue;
+        num_hits++;
+        ok &= std::abs(hits[i].t - t) < 1e-4;
+        // the hit is on the face that was found
+        const Vec3u& f = mesh.faces[hits[i].face];
+        const Vec3f p =
+            mesh.vertices[f[0]].xyz() * (1 - hits[i].u - hits[i].v) +
+            mesh.vertices[f[1]].xyz() * hits[i].u +
+            mesh.vertices[f[2]].xyz() * hits[i].v;
+        ok &= (p - rays[i].at(hits[i].t)).module() < 1e-4f;
+    }
+    TEST_TRUE(ok);
+    TEST_TRUE(num_hits > 10);
+
+    std::vector<Vec3f> points;
+    for (unsigned int i = 0; i < 100; ++i)
+        points.push_back(Vec3f(position(rng), position(rng), position(rng)));
+    std::vector<ClosestPoint> closest(points.size());
+    bvh.closest_point(points.data(), points.size(), closest.data());
+    ok = true;
+    for (size_t i = 0; i < points.size(); ++i)
+        ok &= std::abs(std::sqrt(closest[i].distance2) -
+                       brute_force_distance(mesh, points[i])) < 1e-4 &&
+              (closest[i].point - points[i]).module2() ==
+                  closest[i].distance2;
+    TEST_TRUE(ok);
+    TEST_TRUE(!bvh.closest_point(points[0], 1e-6f).found());
+
+    // compact meshes give the same tree, empty meshes an empty one
+    const BVH compact_bvh(compact(mesh));
+    TEST_EQ(compact_bvh.num_nodes(), bvh.num_nodes());
+    TEST_EQ(compact_bvh.intersect(rays[1]).face, hits[1].face);
+    const BVH empty((Mesh()));
+    TEST_TRUE(empty.empty() && !empty.intersect(rays[0]).hit() &&
+              !empty.occluded(rays[0]));
+
+    Mesh bad = mesh;
+    bad.faces[10][1] = bad.vertices.size();
+    bool thrown = false;
+    try {
+        BVH bad_bvh(bad);
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
+
+// Compares the packet kernels with intersect_triangle, for rays aimed close
+// to the triangles so that about half of the tests hit
+template <size_t W>
+bool packets_match_scalar(unsigned int seed) {
+    const Mesh mesh = random_triangles(64, seed);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> jitter(-0.01f, 0.01f);
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < 64; ++i) {
+        const Vec3u& f = mesh.faces[i];
+        const Vec3f target = (mesh.vertices[f[0]].xyz() +
+                              mesh.vertices[f[1]].xyz() +
+                              mesh.vertices[f[2]].xyz()) *
+                                 (1.0f / 3) +
+                             Vec3f(jitter(rng), jitter(rng), jitter(rng));
+        const Vec3f origin(jitter(rng) * 100, jitter(rng) * 100, -1);
+        rays.push_back(Ray(origin, target - origin, 0, i % 3 ? 1e30f : 1.0f));
+    }
+    auto vertex = [&](size_t f, unsigned int k) {
+        return mesh.vertices[mesh.faces[f][k]].xyz();
+    };
+    auto close = [](const RayHit& a, const RayHit& b) {
+        return a.face == b.face &&
+               (!a.hit() || (std::abs(a.t - b.t) < 1e-5f &&
+                             std::abs(a.u - b.u) < 1e-5f &&
+                             std::abs(a.v - b.v) < 1e-5f));
+    };
+
+    bool ok = true;
+    size_t num_hits = 0;
+    // one ray, W triangles (the last packet is not full)
+    for (size_t first = 0; first < mesh.faces.size(); first += W + 1) {
+        TrianglePacket<W> packet;
+        const size_t n = std::min(W, mesh.faces.size() - first);
+        for (size_t i = 0; i < n; ++i)
+            packet.set(i, vertex(first + i, 0), vertex(first + i, 1),
+                       vertex(first + i, 2));
+        for (const Ray& ray : rays) {
+            RayHit expected;
+            uint32_t expected_mask = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const Vec3f v0 = vertex(first + i, 0);
+                float t, u, v;
+                if (intersect_triangle(ray, v0, vertex(first + i, 1) - v0,
+                                       vertex(first + i, 2) - v0, ray.tmax,
+                                       t, u, v)) {
+                    expected_mask |= 1u << i;
+                    if (t <= expected.t) expected = {t, u, v, uint32_t(i)};
+                }
+            }
+            num_hits += expected.hit();
+            ok &= close(intersect(ray, packet), expected) &&
+                  intersect_mask(ray, packet) == expected_mask;
+        }
+    }
+    // W rays, one triangle at a time
+    for (size_t first = 0; first < rays.size(); first += W - 1) {
+        RayPacket<W> packet;
+        HitPacket<W> hits;
+        const size_t n = std::min(W - 1, rays.size() - first);
+        for (size_t i = 0; i < n; ++i) packet.set(i, rays[first + i]);
+        for (size_t f = 0; f < mesh.faces.size(); ++f)
+            intersect(packet, vertex(f, 0), vertex(f, 1), vertex(f, 2), f,
+                      hits);
+        for (size_t i = 0; i < W; ++i) {
+            RayHit expected;
+            for (size_t f = 0; i < n && f < mesh.faces.size(); ++f) {
+                const Ray& ray = rays[first + i];
+                const Vec3f v0 = vertex(f, 0);
+                if (intersect_triangle(ray, v0, vertex(f, 1) - v0,
+                                       vertex(f, 2) - v0,
+                                       std::min(ray.tmax, expected.t),
+                                       expected.t, expected.u, expected.v))
+                    expected.face = f;
+            }
+            ok &= close(hits.get(i), expected);
+        }
+    }
+    return ok && num_hits > 20;
+}
+
+TEST_CASE(15_intersect_packets, {
+    TEST_TRUE(packets_match_scalar<4>(3));
+    TEST_TRUE(packets_match_scalar<8>(4));
+
+    // edges count as hits, parallel rays do not
+    float t, u, v;
+    const Vec3f v0(0, 0, 0), e1(1, 0, 0), e2(0, 1, 0);
+    TEST_TRUE(intersect_triangle(Ray(Vec3f(0.5f, 0, 1), Vec3f(0, 0, -1)), v0,
+                                 e1, e2, 10, t, u, v) &&
+              t == 1 && u == 0.5f && v == 0);
+    TEST_TRUE(!intersect_triangle(Ray(Vec3f(0, 0, 1), Vec3f(1, 0, 0)), v0, e1,
+                                  e2, 10, t, u, v));
+    TEST_TRUE(!intersect_triangle(Ray(Vec3f(0.2f, 0.2f, 1), Vec3f(0, 0, -1)),
+                                  v0, e1, e2, 0.5f, t, u, v));
+})
+
+// Grid of n x n quads with the faces shuffled, with the original index of
+// each vertex and face as attributes
+Mesh shuffled_grid(unsigned int n, unsigned int seed) {
+    Mesh mesh;
+    std::vector<uint32_t> vertex_ids, face_ids;
+    for (unsigned int y = 0; y <= n; ++y) {
+        for (unsigned int x = 0; x <= n; ++x) {
+            vertex_ids.push_back(mesh.vertices.size());
+            mesh.vertices.push_back(Vec4f(x, y, 0.1f * (x % 3), 1));
+        }
+    }
+    for (unsigned int y = 0; y < n; ++y) {
+        for (unsigned int x = 0; x < n; ++x) {
+            const unsigned int v = y * (n + 1) + x;
+            mesh.faces.push_back(Vec3u(v, v + 1, v + n + 2));
+            mesh.faces.push_back(Vec3u(v, v + n + 2, v + n + 1));
+        }
+    }
+    std::shuffle(mesh.faces.begin(), mesh.faces.end(), std::mt19937(seed));
+    for (size_t i = 0; i < mesh.faces.size(); ++i) face_ids.push_back(i);
+    mesh.vertex_attributes.set("id", vertex_ids);
+    mesh.face_attributes.set("id", face_ids);
+    return mesh;
+}
+
+// Same triangles (by position, with their winding) and attributes that
+// followed their vertices/faces
+bool same_triangles(const Mesh& original, const Mesh& mesh) {
+    if (mesh.faces.size() != original.faces.size() ||
+        mesh.vertices.size() != original.vertices.size())
+        return false;
+    const auto& vertex_ids = mesh.vertex_attributes.get<uint32_t>("id");
+    const auto& face_ids = mesh.face_attributes.get<uint32_t>("id");
+    std::vector<bool> seen(mesh.faces.size(), false);
+    for (size_t i = 0; i < mesh.faces.size(); ++i) {
+        const uint32_t id = face_ids[i];
+        if (seen[id]) return false;
+        seen[id] = true;
+        for (unsigned int k = 0; k < 3; ++k) {
+            const uint32_t v = mesh.faces[i][k], u = original.faces[id][k];
+            if (mesh.vertices[v] != original.vertices[u] ||
+                vertex_ids[v] != u)
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE(16_optimize_vertex_cache, {
+    const Mesh original = shuffled_grid(60, 5);
+    const VertexCacheStats before = analyze_vertex_cache(original);
+    TEST_TRUE(before.acmr > 2.5);
+    for (VertexCacheMethod method :
+         {VertexCacheMethod::Tipsify, VertexCacheMethod::Forsyth}) {
+        Mesh mesh = original;
+        optimize_vertex_cache(mesh, method);
+        TEST_TRUE(same_triangles(original, mesh));
+        const VertexCacheStats after = analyze_vertex_cache(mesh);
+        TEST_TRUE(after.acmr < 0.8);
+        TEST_TRUE(after.atvr >= 1 && after.atvr < 1.6);
+    }
+
+    // one face, and a face with a repeated vertex
+    Mesh small;
+    small.vertices = {Vec4f(0, 0, 0, 1), Vec4f(1, 0, 0, 1), Vec4f(0, 1, 0, 1)};
+    small.faces = {Vec3u(0, 1, 2), Vec3u(0, 0, 1)};
+    optimize_vertex_cache(small, VertexCacheMethod::Forsyth);
+    TEST_EQ(small.faces.size(), size_t(2));
+    TEST_EQ(analyze_vertex_cache(small).vertices_transformed, size_t(3));
+
+    bool thrown = false;
+    small.faces.push_back(Vec3u(0, 1, 3));
+    try {
+        optimize_vertex_cache(small);
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
+
+TEST_CASE(17_optimize_vertex_fetch, {
+    Mesh original = shuffled_grid(40, 6);
+    original.vertices.push_back(Vec4f(-1, -1, -1, 1));  // unused
+    original.vertex_attributes.get<uint32_t>("id").push_back(
+        original.vertices.size() - 1);
+    Mesh mesh = original;
+    optimize_vertex_cache(mesh);
+    optimize_vertex_fetch(mesh);
+    TEST_TRUE(same_triangles(original, mesh));
+    TEST_EQ(mesh.vertices.back(), original.vertices.back());
+    // vertices are first used in order
+    uint32_t next = 0;
+    for (const Vec3u& f : mesh.faces)
+        for (unsigned int k = 0; k < 3; ++k) {
+            TEST_TRUE(f[k] <= next);
+            if (f[k] == next) ++next;
+        }
+    TEST_TRUE(analyze_vertex_fetch(mesh).overfetch <
+              analyze_vertex_fetch(original).overfetch);
+    TEST_TRUE(analyze_vertex_fetch(mesh).overfetch < 1.5);
+
+    // consecutive vertices are close (~21 units apart for a random order)
+    mesh = original;
+    sort_vertices_morton(mesh);
+    TEST_TRUE(same_triangles(original, mesh));
+    float length = 0;
+    for (size_t i = 1; i < mesh.vertices.size(); ++i)
+        length +=
+            (mesh.vertices[i].xyz() - mesh.vertices[i - 1].xyz()).module();
+    TEST_TRUE(length / mesh.vertices.size() < 3);
+})
+
+// Faces of a grid with their own three vertices, moved by up to jitter
+Mesh triangle_soup(unsigned int n, float jitter, unsigned int seed) {
+    const Mesh grid = shuffled_grid(n, seed);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> offset(-jitter, jitter);
+    Mesh soup;
+    std::vector<uint32_t> ids;
+    for (const Vec3u& f : grid.faces) {
+        soup.faces.push_back(Vec3u(soup.vertices.size(),
+                                   soup.vertices.size() + 1,
+                                   soup.vertices.size() + 2));
+        for (unsigned int k = 0; k < 3; ++k) {
+            soup.vertices.push_back(grid.vertices[f[k]] +
+                                    Vec4f(offset(rng), offset(rng), 0, 0));
+            ids.push_back(f[k]);
+        }
+    }
+    soup.vertex_attributes.set("id", ids);
+    return soup;
+}
+
+TEST_CASE(18_weld_vertices, {
+    const unsigned int n = 50;
+    const size_t grid_vertices = (n + 1) * (n + 1);
+    for (float jitter : {0.0f, 1e-3f}) {
+        const Mesh soup = triangle_soup(n, jitter, 7);
+        Mesh mesh = soup;
+        // copies of a vertex are 2 * sqrt(2) * jitter apart at most
+        const size_t removed = weld_vertices(mesh, jitter * 3);
+        TEST_EQ(removed, soup.vertices.size() - grid_vertices);
+        TEST_EQ(mesh.vertices.size(), grid_vertices);
+        TEST_EQ(mesh.faces.size(), soup.faces.size());
+        // each vertex is the first one of its position in the soup
+        const auto& ids = mesh.vertex_attributes.get<uint32_t>("id");
+        std::vector<bool> seen(grid_vertices, false);
+        bool ok = true;
+        for (size_t i = 0; i < mesh.faces.size(); ++i)
+            for (unsigned int k = 0; k < 3; ++k) {
+                const uint32_t v = mesh.faces[i][k];
+                const Vec4f d = mesh.vertices[v] - soup.vertices[3 * i + k];
+                ok &= ids[v] == soup.vertex_attributes.get<uint32_t>(
+                                    "id")[3 * i + k] &&
+                      std::abs(d[0]) <= 2 * jitter &&
+                      std::abs(d[1]) <= 2 * jitter;
+            }
+        for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+            ok &= !seen[ids[v]];
+            seen[ids[v]] = true;
+        }
+        TEST_TRUE(ok);
+    }
+
+    // nothing to merge without a tolerance
+    Mesh mesh = triangle_soup(10, 1e-3f, 8);
+    const size_t removed = weld_vertices(mesh);
+    TEST_EQ(removed, size_t(0));
+
+    // -0 and 0 are the same position, w is ignored
+    mesh = Mesh();
+    mesh.vertices = {Vec4f(0, 1, 2, 1), Vec4f(-0.0f, 1, 2, 2),
+                     Vec4f(0, 1, 2.5f, 1)};
+    mesh.faces = {Vec3u(2, 1, 0)};
+    TEST_TRUE(weld_vertices(mesh) == 1);
+    TEST_EQ(mesh.faces[0], Vec3u(1, 0, 0));
+    TEST_TRUE(weld_vertices(mesh, 0.5f) == 1);
+    TEST_EQ(mesh.faces[0], Vec3u(0, 0, 0));
+
+    // chains through a vertex with a higher index, c is far from a
+    mesh.vertices = {Vec4f(0, 0, 0, 1), Vec4f(1.8f, 0, 0, 1),
+                     Vec4f(0.9f, 0, 0, 1), Vec4f(5, 0, 0, 1)};
+    mesh.faces = {Vec3u(0, 1, 2), Vec3u(1, 2, 3)};
+    TEST_TRUE(weld_vertices(mesh, 1) == 2);
+    TEST_EQ(mesh.faces[0], Vec3u(0, 0, 0));
+    TEST_EQ(mesh.faces[1], Vec3u(0, 0, 1));
+
+    // huge and non-finite coordinates
+    const float inf = std::numeric_limits<float>::infinity();
+    mesh.vertices = {Vec4f(inf, 0, 0, 1), Vec4f(-inf, 1, 0, 1),
+                     Vec4f(std::nanf(""), 0, 0, 1), Vec4f(3e38f, 0, 0, 1),
+                     Vec4f(3e38f, 0, 0, 1)};
+    mesh.faces = {Vec3u(0, 1, 2), Vec3u(2, 3, 4)};
+    TEST_TRUE(weld_vertices(mesh, 1e-30f) == 1);
+    TEST_EQ(mesh.faces[1], Vec3u(2, 3, 3));
+
+    bool thrown = false;
+    mesh.faces.push_back(Vec3u(0, 1, 7));
+    try {
+        weld_vertices(mesh);
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
+
+// Sphere of radius 1 with n rings of n vertices, and the poles
+Mesh uv_sphere(unsigned int n) {
+    Mesh mesh;
+    const float pi = 3.14159265f;
+    mesh.vertices.push_back(Vec4f(0, 0, 1, 1));
+    for (unsigned int i = 1; i <= n; ++i)
+        for (unsigned int j = 0; j < n; ++j) {
+            const float theta = pi * i / (n + 1), phi = 2 * pi * j / n;
+            mesh.vertices.push_back(Vec4f(std::sin(theta) * std::cos(phi),
+                                          std::sin(theta) * std::sin(phi),
+                                          std::cos(theta), 1));
+        }
+    mesh.vertices.push_back(Vec4f(0, 0, -1, 1));
+    const unsigned int last = mesh.vertices.size() - 1;
+    for (unsigned int j = 0; j < n; ++j) {
+        const unsigned int a = 1 + j, b = 1 + (j + 1) % n;
+        mesh.faces.push_back(Vec3u(0, a, b));
+        mesh.faces.push_back(Vec3u(last, b + (n - 1) * n, a + (n - 1) * n));
+        for (unsigned int i = 0; i + 1 < n; ++i) {
+            const unsigned int c = a + i * n, d = b + i * n;
+            mesh.faces.push_back(Vec3u(c, c + n, d + n));
+            mesh.faces.push_back(Vec3u(c, d + n, d));
+        }
+    }
+    return mesh;
+}
+
+bool close(const Vec3f& a, const Vec3f& b) {
+    return (a - b).module() < 1e-5f;
+}
+
+Vec3f vertex_normal(const Mesh& mesh, size_t v, const char* x = "nx",
+                    const char* y = "ny", const char* z = "nz") {
+    const MeshAttributes& attributes = mesh.vertex_attributes;
+    return Vec3f(attributes.get<float>(x)[v], attributes.get<float>(y)[v],
+                 attributes.get<float>(z)[v]);
+}
+
+TEST_CASE(19_vertex_normals, {
+    // smooth surface, every face counts
+    Mesh sphere = uv_sphere(100);
+    for (NormalWeighting weighting :
+         {NormalWeighting::Uniform, NormalWeighting::Area,
+          NormalWeighting::Angle}) {
+        compute_vertex_normals(sphere, weighting);
+        bool ok = true;
+        for (size_t v = 0; v < sphere.vertices.size(); ++v)
+            ok &= dot(vertex_normal(sphere, v), sphere.vertices[v].xyz()) >
+                  0.999f;
+        TEST_TRUE(ok);
+    }
+    const VecList3f face_normals = compute_face_normals(sphere);
+    bool ok = true;
+    for (size_t i = 0; i < sphere.faces.size(); ++i)
+        ok &= dot(face_normals[i],
+                  sphere.vertices[sphere.faces[i][0]].xyz()) > 0.99f;
+    TEST_TRUE(ok);
+
+    // corner of a box with one of its sides split in two triangles, only
+    // the angles do not depend on it. Plus a degenerate face and a vertex
+    // without faces
+    Mesh corner;
+    corner.vertices = {Vec4f(0, 0, 0, 1), Vec4f(1, 0, 0, 1),
+                       Vec4f(0, 1, 0, 1), Vec4f(0, 0, 1, 1),
+                       Vec4f(1, 0, 1, 1), Vec4f(5, 5, 5, 1)};
+    corner.faces = {Vec3u(0, 1, 2), Vec3u(0, 3, 4), Vec3u(0, 4, 1),
+                    Vec3u(0, 2, 3), Vec3u(1, 1, 2)};
+    TEST_TRUE(close(compute_face_normals(corner)[4], Vec3f(0)));
+    // channels that are already there are reused
+    const float* nx = corner.vertex_attributes
+                          .set("nx", std::vector<float>(6, 7.0f))
+                          .data();
+    compute_vertex_normals(corner, NormalWeighting::Angle);
+    TEST_EQ(corner.vertex_attributes.get<float>("nx").data(), nx);
+    TEST_TRUE(close(vertex_normal(corner, 0), Vec3f(1, 1, 1).normalized()));
+    TEST_TRUE(close(vertex_normal(corner, 5), Vec3f(0)));
+    compute_vertex_normals(corner, NormalWeighting::Uniform);
+    TEST_TRUE(close(vertex_normal(corner, 0), Vec3f(1, 2, 1).normalized()));
+})
+
+TEST_CASE(20_vertex_tangents, {
+    Mesh mesh = shuffled_grid(20, 9);
+    bool thrown = false;
+    try {
+        compute_vertex_tangents(mesh);
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+
+    // u along x, v along y or -y
+    std::vector<float> u, v;
+    for (const Vec4f& p : mesh.vertices) {
+        u.push_back(0.1f * p.x());
+        v.push_back(0.1f * p.y());
+    }
+    mesh.vertex_attributes.set("u", u);
+    mesh.vertex_attributes.set("v", v);
+    compute_vertex_tangents(mesh);
+    bool ok = true;
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const Vec3f n = vertex_normal(mesh, i);
+        const Vec3f t = vertex_normal(mesh, i, "tx", "ty", "tz");
+        ok &= std::abs(dot(n, t)) < 1e-5f &&
+              std::abs(t.module() - 1) < 1e-5f && t.x() > 0.9f &&
+              mesh.vertex_attributes.get<float>("tw")[i] == 1;
+    }
+    TEST_TRUE(ok);
+
+    for (float& x : v) x = -x;
+    mesh.vertex_attributes.set("v", v);
+    compute_vertex_tangents(mesh);
+    const auto& tw = mesh.vertex_attributes.get<float>("tw");
+    TEST_TRUE(
+        std::all_of(tw.begin(), tw.end(), [](float w) { return w == -1; }));
+})
+
+TEST_CASE(21_adjacency, {
+    // large enough for the radix sorts to be split between threads
+    const unsigned int n = 200;
+    const Mesh mesh = shuffled_grid(n, 10);
+    const size_t num_vertices = mesh.vertices.size();
+
+    std::vector<std::vector<uint32_t>> faces(num_vertices);
+    std::vector<std::vector<uint32_t>> neighbours(num_vertices);
+    for (uint32_t i = 0; i < mesh.faces.size(); ++i) {
+        for (unsigned int k = 0; k < 3; ++k) {
+            const uint32_t a = mesh.faces[i][k], b = mesh.faces[i][(k + 1) % 3];
+            faces[a].push_back(i);
+            neighbours[a].push_back(b);
+            neighbours[b].push_back(a);
+        }
+    }
+    for (auto& row : neighbours) {
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+    }
+    const Adjacency vertex_faces = vertex_face_adjacency(mesh);
+    const Adjacency vertex_vertices = vertex_vertex_adjacency(mesh);
+    TEST_EQ(vertex_faces.size(), num_vertices);
+    TEST_EQ(vertex_vertices.size(), num_vertices);
+    bool same = true;
+    for (size_t v = 0; v < num_vertices; ++v) {
+        const Adjacency::Row f = vertex_faces[v], u = vertex_vertices[v];
+        same &= std::vector<uint32_t>(f.begin(), f.end()) == faces[v] &&
+                std::vector<uint32_t>(u.begin(), u.end()) == neighbours[v];
+    }
+    TEST_TRUE(same);
+
+    const HalfEdgeMesh half_edges(mesh);
+    TEST_EQ(half_edges.num_half_edges(), 3 * mesh.faces.size());
+    TEST_EQ(half_edges.num_non_manifold_edges(), size_t(0));
+    bool twins = true;
+    size_t boundary = 0;
+    for (uint32_t h = 0; h < half_edges.num_half_edges(); ++h) {
+        const uint32_t t = half_edges.twin(h);
+        if (t == HalfEdgeMesh::NONE) {
+            ++boundary;
+            continue;
+        }
+        twins &= half_edges.twin(t) == h &&
+                 half_edges.origin(t) == half_edges.target(h) &&
+                 half_edges.target(t) == half_edges.origin(h);
+    }
+    TEST_TRUE(twins);
+    TEST_EQ(boundary, size_t(4 * n));
+    const size_t num_edges = half_edges.edges().size();
+    TEST_EQ(num_edges, size_t(2 * n * (n + 1) + n * n));
+
+    // the rotation around each vertex goes through all its faces
+    bool rotations = true;
+    size_t boundary_vertices = 0;
+    for (uint32_t v = 0; v < num_vertices; ++v) {
+        std::vector<uint32_t> around;
+        half_edges.for_each_outgoing(v, [&](uint32_t h) {
+            rotations &= half_edges.origin(h) == v;
+            around.push_back(HalfEdgeMesh::face(h));
+        });
+        std::sort(around.begin(), around.end());
+        rotations &= around == faces[v];
+        boundary_vertices += half_edges.is_boundary_vertex(v);
+    }
+    TEST_TRUE(rotations);
+    TEST_EQ(boundary_vertices, size_t(4 * n));
+
+    // a third face on an edge
+    Mesh fan;
+    fan.vertices = {Vec4f(0, 0, 0, 1), Vec4f(1, 0, 0, 1), Vec4f(0, 1, 0, 1),
+                    Vec4f(0, -1, 0, 1), Vec4f(0, 0, 1, 1)};
+    fan.faces = {Vec3u(0, 1, 2), Vec3u(1, 0, 3), Vec3u(0, 1, 4)};
+    const HalfEdgeMesh non_manifold(fan);
+    TEST_EQ(non_manifold.num_non_manifold_edges(), size_t(1));
+    TEST_TRUE(non_manifold.is_boundary(0));
+
+    fan.faces.push_back(Vec3u(0, 1, 5));
+    bool thrown = false;
+    try {
+        vertex_vertex_adjacency(fan);
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
+
+// Twice the area of the faces, signed by their orientation around z
+float signed_area_z(const Mesh& mesh) {
+    float area = 0;
+    for (const Vec3u& f : mesh.faces) {
+        const Vec3f p0 = mesh.vertices[f[0]].xyz();
+        area += cross(mesh.vertices[f[1]].xyz() - p0,
+                      mesh.vertices[f[2]].xyz() - p0)
+                    .z();
+    }
+    return area;
+}
+
+bool all_vertices_used(const Mesh& mesh) {
+    const Adjacency adjacency = vertex_face_adjacency(mesh);
+    for (size_t v = 0; v < adjacency.size(); ++v)
+        if (adjacency.degree(v) == 0) return false;
+    return true;
+}
+
+TEST_CASE(22_simplify_mesh, {
+    Mesh sphere = uv_sphere(64);
+    const size_t target = sphere.faces.size() / 10;
+    const float error = simplify_mesh(sphere, target);
+    TEST_TRUE(sphere.faces.size() <= target &&
+              sphere.faces.size() + 2 >= target);
+    TEST_TRUE(error > 0 && error < 0.05f);
+    const HalfEdgeMesh half_edges(sphere);
+    bool closed = half_edges.num_non_manifold_edges() == 0;
+    for (uint32_t h = 0; h < half_edges.num_half_edges(); ++h)
+        closed &= !half_edges.is_boundary(h);
+    TEST_TRUE(closed);
+    TEST_TRUE(all_vertices_used(sphere));
+    TEST_TRUE(std::all_of(
+        sphere.vertices.begin(), sphere.vertices.end(),
+        [](const Vec4f& p) { return std::abs(p.xyz().module() - 1) < 0.05f; }));
+
+    // a flat square collapses without error to its corners, which are
+    // kept by the planes of the boundary, and no face is flipped
+    Mesh grid = shuffled_grid(20, 11);
+    for (Vec4f& p : grid.vertices) p.z() = 0;
+    const float flat_error = simplify_mesh(grid, 0, 1e-3f);
+    TEST_TRUE(flat_error < 1e-3f);
+    TEST_EQ(grid.faces.size(), size_t(2));
+    TEST_EQ(grid.vertices.size(), size_t(4));
+    TEST_TRUE(std::abs(signed_area_z(grid) - 2 * 400) < 1e-2f);
+    bool corners = true;
+    for (const Vec4f& p : grid.vertices)
+        corners &= (p.x() == 0 || p.x() == 20) && (p.y() == 0 || p.y() == 20);
+    TEST_TRUE(corners);
+    TEST_EQ(grid.vertex_attributes.get<uint32_t>("id").size(), size_t(4));
+    TEST_EQ(grid.face_attributes.get<uint32_t>("id").size(), size_t(2));
+
+    // faces that are left keep their order and attributes
+    Mesh mesh = shuffled_grid(20, 12);
+    simplify_mesh(mesh, mesh.faces.size() / 2);
+    const auto& face_ids = mesh.face_attributes.get<uint32_t>("id");
+    TEST_EQ(face_ids.size(), mesh.faces.size());
+    TEST_TRUE(std::is_sorted(face_ids.begin(), face_ids.end()));
+    TEST_TRUE(all_vertices_used(mesh));
+})
+
+TEST_CASE(23_simplify_mesh_clustering, {
+    Mesh sphere = uv_sphere(64);
+    const size_t faces = sphere.faces.size();
+    simplify_mesh_clustering(sphere, 0.25f);
+    TEST_TRUE(sphere.faces.size() < faces / 10 && sphere.faces.size() > 50);
+    TEST_TRUE(all_vertices_used(sphere));
+    TEST_TRUE(std::all_of(
+        sphere.vertices.begin(), sphere.vertices.end(),
+        [](const Vec4f& p) { return std::abs(p.xyz().module() - 1) < 0.25f; }));
+    std::vector<std::array<uint32_t, 3>> triangles;
+    bool valid = true;
+    for (const Vec3u& f : sphere.faces) {
+        valid &= f[0] != f[1] && f[1] != f[2] && f[2] != f[0];
+        std::array<uint32_t, 3> t = {f[0], f[1], f[2]};
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    valid &= std::adjacent_find(triangles.begin(), triangles.end()) ==
+             triangles.end();
+    TEST_TRUE(valid);
+
+    // each vertex gets the attributes of one of its cell
+    Mesh grid = shuffled_grid(20, 13);
+    const Mesh original = grid;
+    simplify_mesh_clustering(grid, 3);
+    const auto& ids = grid.vertex_attributes.get<uint32_t>("id");
+    bool same_cell = ids.size() == grid.vertices.size();
+    for (size_t v = 0; same_cell && v < ids.size(); ++v)
+        for (unsigned int k = 0; k < 3; ++k)
+            same_cell &= std::abs(grid.vertices[v][k] -
+                                  original.vertices[ids[v]][k]) < 2 * 3;
+    TEST_TRUE(same_cell);
+
+    bool thrown = false;
+    try {
+        simplify_mesh_clustering(sphere, 0);
+    } catch (const common::detail::CommonMeshException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
+
+// Mesh put together from the batches of a PlyStreamReader
+Mesh stream_ply_mesh(const std::string& ply, size_t batch_size,
+                     std::vector<uint8_t>& groups) {
+    std::istringstream file(ply);
+    Mesh mesh;
+    size_t next_vertex = 0, next_triangle = 0;
+    bool in_order = true;
+    stream_ply(
+        file,
+        [&](const PlyVertexBatch& batch) {
+            in_order &= batch.first == next_vertex &&
+                        batch.vertices.size() <= batch_size;
+            next_vertex += batch.vertices.size();
+            for (const Vec4f& v : batch.vertices) mesh.vertices.push_back(v);
+        },
+        [&](const PlyFaceBatch& batch) {
+            in_order &= batch.first_triangle == next_triangle;
+            next_triangle += batch.faces.size();
+            for (const Vec3u& f : batch.faces) mesh.faces.push_back(f);
+            if (batch.attributes.has("group")) {
+                const auto& g = batch.attributes.get<uint8_t>("group");
+                groups.insert(groups.end(), g.begin(), g.end());
+            }
+        },
+        AttributeMask::everything(), batch_size);
+    if (!in_order) mesh.vertices.clear();
+    return mesh;
+}
+
+TEST_CASE(24_ply_stream, {
+    std::vector<uint8_t> groups;
+    for (bool big_endian : {false, true}) {
+        Mesh mesh = stream_ply_mesh(binary_quad_ply(big_endian), 3, groups);
+        TEST_TRUE(is_test_quad(mesh));
+    }
+
+    // batches that end in the middle of the buffered blocks, and lines
+    constexpr size_t N = 50000;
+    std::string binary = "ply\nformat binary_little_endian 1.0\n"
+                         "element vertex " + std::to_string(N) + "\n"
+                         "property float x\nproperty float y\n"
+                         "property float z\n"
+                         "element face " + std::to_string(N) + "\n"
+                         "property list uchar int vertex_indices\n"
+                         "end_header\n";
+    std::string ascii = "ply\nformat ascii 1.0\n"
+                        "element vertex " + std::to_string(N) + "\n"
+                        "property float x\nproperty float y\n"
+                        "property float z\n"
+                        "element face " + std::to_string(N) + "\n"
+                        "property list uchar int vertex_indices\n"
+                        "end_header\n";
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = 0; j < 3; ++j) ply_put<float>(binary, float(i + j));
+        ascii += std::to_string(i) + " " + std::to_string(i + 1) + " " +
+                 std::to_string(i + 2) + "\n \n";
+    }
+    for (size_t i = 0; i < N; ++i) {
+        ply_put<uint8_t>(binary, 3);
+        for (size_t j = 0; j < 3; ++j) ply_put<int32_t>(binary, (i + j) % N);
+        ascii += "3 " + std::to_string(i) + " " + std::to_string((i + 1) % N) +
+                 " " + std::to_string((i + 2) % N) + "\r\n";
+    }
+    ascii.pop_back();  // last line without a line break
+    ascii.pop_back();
+    for (const std::string& ply : {binary, ascii}) {
+        Mesh mesh = stream_ply_mesh(ply, 7777, groups);
+        bool ok = mesh.vertices.size() == N && mesh.faces.size() == N;
+        for (size_t i = 0; ok && i < N; ++i)
+            ok = mesh.vertices[i] == Vec4f(i, i + 1, i + 2, 1) &&
+                 mesh.faces[i] == Vec3u(i, (i + 1) % N, (i + 2) % N);
+        TEST_TRUE(ok);
+    }
+
+    // polygons are split in fans, with their attributes in each triangle
+    const std::string polygons =
+        "ply\nformat ascii 1.0\n"
+        "element vertex 5\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "element face 2\n"
+        "property list ushort int vertex_indices\nproperty uchar group\n"
+        "end_header\n"
+        "0 0 0\n1 0 0\n1 1 0\n0 1 0\n2 0 0\n"
+        "4 0 1 2 3 1\n"
+        "3 1 4 2 2\n";
+    groups.clear();
+    Mesh mesh = stream_ply_mesh(polygons, 1, groups);
+    TEST_EQ(mesh.faces.size(), 3);
+    TEST_EQ(mesh.faces[1], Vec3u(0, 2, 3));
+    TEST_TRUE(groups == std::vector<uint8_t>({1, 1, 2}));
+
+    for (const std::string& ply : {binary.substr(0, binary.size() - 5),
+                                   ascii.substr(0, ascii.size() - 12)}) {
+        bool thrown = false;
+        try {
+            stream_ply_mesh(ply, 1000, groups);
+        } catch (const common::detail::CommonMeshException&) {
+            thrown = true;
+        }
+        TEST_TRUE(thrown);
+    }
+})
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "libcpp-common/tensor.h"
+#include "libcpp-common/test.h"
+
+using namespace common;
+
+template <typename T>
+std::vector<T> random_vector(size_t n, unsigned int seed = 0) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(-4, 4);
+    std::vector<T> result(n);
+    for (auto& x : result) x = static_cast<T>(dist(rng));
+    return result;
+}
+
+TEST_CASE(00_matmul_small, {
+    Tensor<float, 2, 3> a({{1, 2, 3}, {4, 5, 6}});
+    Tensor<float, 3, 2> b({{7, 8}, {9, 10}, {11, 12}});
+    Tensor<float, 2, 2> c = a * b;
+    TEST_EQ(c(0, 0), 58);
+    TEST_EQ(c(0, 1), 64);
+    TEST_EQ(c(1, 0), 139);
+    TEST_EQ(c(1, 1), 154);
+})
+
+TEST_CASE(01_matmul_blocked, {
+    // integer-valued floats, so that the result is exact in any order
+    constexpr size_t N = 37, M = 300, U = 53;
+    auto a = std::make_unique<Tensor<float, N, M>>();
+    auto b = std::make_unique<Tensor<float, M, U>>();
+    auto va = random_vector<float>(N * M, 1);
+    auto vb = random_vector<float>(M * U, 2);
+    std::copy(va.begin(), va.end(), a->data());
+    std::copy(vb.begin(), vb.end(), b->data());
+    auto c = (*a) * (*b);
+    bool ok = true;
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = 0; j < U; ++j) {
+            float expected = 0;
+            for (size_t k = 0; k < M; ++k) expected += (*a)(i, k) * (*b)(k, j);
+            ok = ok && c(i, j) == expected;
+        }
+    TEST_TRUE(ok);
+})
+
+TEST_CASE(02_gemm_strides, {
+    // C^T += A^T * B with A, B stored transposed and C column-major
+    const size_t m = 70, n = 90, k = 129;
+    auto at = random_vector<double>(k * m, 3);  // k x m
+    auto b = random_vector<double>(k * n, 4);   // k x n
+    auto ct = random_vector<double>(n * m, 5);  // n x m
+    auto expected = ct;
+    for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < n; ++j)
+            for (size_t p = 0; p < k; ++p)
+                expected[j * m + i] += at[p * m + i] * b[p * n + j];
+    gemm<double>(m, n, k, at.data(), 1, m, b.data(), n, 1, ct.data(), 1, m,
+                 true);
+    TEST_TRUE(ct == expected);
+})
+
+TEST_CASE(03_gemm_integer, {
+    const size_t m = 65, n = 33, k = 17;
+    auto a = random_vector<int>(m * k, 6), b = random_vector<int>(k * n, 7);
+    std::vector<int> c(m * n), expected(m * n, 0);
+    for (size_t i = 0; i < m; ++i)
+        for (size_t p = 0; p < k; ++p)
+            for (size_t j = 0; j < n; ++j)
+                expected[i * n + j] += a[i * k + p] * b[p * n + j];
+    gemm<int>(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n, 1);
+    TEST_TRUE(c == expected);
+})
+
+TEST_CASE(04_view_slice, {
+    Tensor<int, 3, 4> t({{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9, 10, 11}});
+    auto row = t.view()[1];
+    TEST_EQ(row.shape(0), 4);
+    TEST_EQ(row(2), 6);
+    auto col = t.view().slice(all, -1);
+    TEST_EQ(col.shape(0), 3);
+    TEST_EQ(col(2), 11);
+    auto block = t.view().slice(Slice(1, 3), Slice(Slice::none, Slice::none, -2));
+    TEST_EQ(block.shape(0), 2);
+    TEST_EQ(block.shape(1), 2);
+    TEST_EQ(block(0, 0), 7);
+    TEST_EQ(block(1, 1), 9);
+    block(0, 0) = 100;  // views do not copy
+    TEST_EQ(t(1, 3), 100);
+    TEST_EQ(t.view().slice(Slice(5)).size(), 0);
+})
+
+TEST_CASE(05_view_transpose_permute, {
+    Tensor<float, 2, 3, 4> t;
+    for (size_t i = 0; i < t.size; ++i) t.at(i) = i;
+    auto tt = t.view().transpose();
+    TEST_EQ(tt.shape(0), 4);
+    TEST_EQ(tt(3, 2, 1), t(1, 2, 3));
+    auto p = t.view().permute({1, 2, 0});
+    TEST_EQ(p(2, 3, 1), t(1, 2, 3));
+    TEST_TRUE(t.view().is_contiguous());
+    TEST_TRUE(!tt.is_contiguous());
+    TEST_TRUE(tt.copy().view().is_contiguous());
+})
+
+TEST_CASE(06_view_broadcasting, {
+    Tensor<int, 3, 1> a({{1}, {2}, {3}});
+    Tensor<int, 4> b({10, 20, 30, 40});
+    auto c = a.view() + b.view();
+    TEST_EQ(c.shape(0), 3);
+    TEST_EQ(c.shape(1), 4);
+    TEST_EQ(c(2, 3), 43);
+    TEST_EQ(c(0, 1), 21);
+    Tensor<int, 2, 4> d;
+    d.view() += b.view();
+    d.view()[1] *= 2;
+    TEST_EQ(d(0, 2), 30);
+    TEST_EQ(d(1, 2), 60);
+    bool thrown = false;
+    try {
+        Tensor<int, 3> e;
+        auto f = b.view() - e.view();
+    } catch (const common::detail::CommonTensorException&) {
+        thrown = true;
+    }
+    TEST_TRUE(thrown);
+})
+
+TEST_CASE(07_view_grid, {
+    Bitmap3f image(4, 2, Color3f(0, 0, 0), true, true);
+    image(1, 0) = Color3f(1, 2, 3);
+    auto v = make_view(image);
+    TEST_EQ(v.shape(0), 2);
+    TEST_EQ(v.shape(1), 4);
+    TEST_EQ(v.shape(2), 3);
+    TEST_EQ(v(0, 1, 2), 3);
+    v.slice(1, all, 0).fill(5);  // red channel of the row y = 1
+    TEST_EQ(image(3, 1).r(), 5);
+    TEST_EQ(image(3, 0).r(), 0);
+})
+
+TEST_CASE(08_reduce_axes, {
+    Tensor<int, 2, 3, 4> t;
+    for (size_t i = 0; i < t.size; ++i) t.at(i) = i;
+    TEST_EQ(t.sum(), 276);
+    Tensor<int, 2, 4> s1 = t.sum(axes<1>);
+    TEST_EQ(s1(1, 2), 14 + 18 + 22);
+    Tensor<int, 2, 1, 4> s1k = t.sum(axes<1>, keepdims);
+    TEST_EQ(s1k(1, 0, 2), 14 + 18 + 22);
+    Tensor<int, 3> s02 = t.sum(axes<0, 2>);
+    TEST_EQ(s02(1), 4 + 5 + 6 + 7 + 16 + 17 + 18 + 19);
+    TEST_EQ(t.sum(axes<0, 1, 2>), 276);
+    Tensor<int, 2, 3> mx = t.max(axes<2>);
+    TEST_EQ(mx(1, 1), 19);
+    TEST_EQ(t.min(axes<0>)(2, 3), 11);
+    TEST_EQ(t.mean(axes<2>)(0, 0), 1);
+    Tensor<float, 2, 2> p({{1, 2}, {3, 4}});
+    TEST_EQ(p.prod(), 24);
+    TEST_EQ(p.prod(axes<0>)(1), 8);
+})
+
+TEST_CASE(09_reduce_argmax, {
+    Tensor<float, 3, 4> t({{0, 9, 2, 3}, {4, 5, 6, 7}, {8, 1, 10, 3}});
+    TEST_EQ(t.argmax(), 10);
+    Tensor<size_t, 4> a0 = t.argmax(axes<0>);
+    TEST_EQ(a0(0), 2);
+    TEST_EQ(a0(1), 0);
+    TEST_EQ(a0(3), 1);
+    Tensor<size_t, 3, 1> a1 = t.argmax(axes<1>, keepdims);
+    TEST_EQ(a1(0, 0), 1);
+    TEST_EQ(a1(1, 0), 3);
+})
+
+TEST_CASE(10_reduce_large_precision, {
+    // 2^22 copies of 0.1f: naive float accumulation drifts far from the result
+    constexpr size_t N = 1 << 22;
+    auto t = std::make_unique<Tensor<float, N>>(0.1f);
+    const double expected = double(0.1f) * N;
+    TEST_TRUE(std::abs(t->sum(Accumulation::Pairwise) - expected) < 1);
+    TEST_TRUE(std::abs(t->sum(Accumulation::Kahan) - expected) < 1);
+    t->at(12345) = 5;
+    TEST_EQ(t->max(), 5);
+    TEST_EQ(t->argmax(), 12345);
+    auto m = std::make_unique<Tensor<float, 4, N / 4>>(0.1f);
+    auto rows = m->sum(axes<1>);
+    TEST_TRUE(std::abs(rows(3) - expected / 4) < 1);
+    auto cols = m->sum(axes<0>, Accumulation::Kahan);
+    TEST_TRUE(std::abs(cols(7) - 0.4f) < 1e-6f);
+})
+
+TEST_CASE(11_einsum_matmul, {
+    constexpr size_t N = 17, M = 40, U = 23;
+    Tensor<double, N, M> a;
+    Tensor<double, M, U> b;
+    auto va = random_vector<double>(N * M, 3);
+    auto vb = random_vector<double>(M * U, 4);
+    std::copy(va.begin(), va.end(), a.data());
+    std::copy(vb.begin(), vb.end(), b.data());
+    Tensor<double, N, U> c = a * b;
+    auto ik = einsum<Idx<'i', 'j'>, Idx<'j', 'k'>, Idx<'i', 'k'>>(a, b);
+    auto ki = einsum<Idx<'i', 'j'>, Idx<'j', 'k'>, Idx<'k', 'i'>>(a, b);
+    bool ok = true;
+    for (size_t i = 0; i < N; ++i)
+        for (size_t k = 0; k < U; ++k)
+            ok = ok && ik(i, k) == c(i, k) && ki(k, i) == c(i, k);
+    TEST_TRUE(ok);
+    // a^T a, contracting over the rows of both operands
+    auto ata = einsum<Idx<'j', 'i'>, Idx<'j', 'k'>, Idx<'i', 'k'>>(a, a);
+    double expected = 0;
+    for (size_t j = 0; j < N; ++j) expected += a(j, 2) * a(j, 5);
+    TEST_EQ(ata(2, 5), expected);
+})
+
+TEST_CASE(12_einsum_general, {
+    Tensor<int, 3, 3> m({{1, 2, 3}, {4, 5, 6}, {7, 8, 9}});
+    TEST_EQ((einsum<Idx<'i', 'i'>, Idx<>>(m)), 15);
+    Tensor<int, 3> d = einsum<Idx<'i', 'i'>, Idx<'i'>>(m);
+    TEST_EQ(d(2), 9);
+    TEST_EQ((einsum<Idx<'i', 'j'>, Idx<>>(m)), 45);
+    Tensor<int, 3> rows = einsum<Idx<'i', 'j'>, Idx<'i'>>(m);
+    TEST_EQ(rows(1), 15);
+    Tensor<int, 2> u({1, 2});
+    Tensor<int, 3> v({3, 4, 5});
+    Tensor<int, 2, 3> outer = einsum<Idx<'i'>, Idx<'j'>, Idx<'i', 'j'>>(u, v);
+    TEST_EQ(outer(1, 2), 10);
+    TEST_EQ((einsum<Idx<'i'>, Idx<'i'>, Idx<>>(v, v)), 50);
+    // batched matrix-vector product
+    Tensor<int, 2, 3, 3> t;
+    for (size_t i = 0; i < t.size; ++i) t.data()[i] = static_cast<int>(i);
+    Tensor<int, 2, 3> mv = einsum<Idx<'b', 'i', 'j'>, Idx<'j'>,
+                                  Idx<'b', 'i'>>(t, v);
+    TEST_EQ(mv(0, 0), 0 * 3 + 1 * 4 + 2 * 5);
+    TEST_EQ(mv(1, 2), 15 * 3 + 16 * 4 + 17 * 5);
+})
+
+TEST_CASE(13_npy_roundtrip, {
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "common_test.npy").string();
+    Tensor<float, 2, 3> a({{1, 2, 3}, {4, 5, 6}});
+    save_npy(filename, a);
+    Tensor<float, 2, 3> b;
+    load_npy(filename, b);
+    TEST_TRUE(std::equal(a.data(), a.data() + a.size, b.data()));
+    auto d = load_npy<float, 2>(filename);
+    TEST_EQ(d.shape(1), 3);
+    TEST_EQ(d(1, 2), 6);
+    // header is padded so that the data is 64-byte aligned
+    TEST_EQ((std::filesystem::file_size(filename) - 6 * sizeof(float)) % 64, 0);
+    // strided views are saved in row-major order
+    save_npy(filename, a.view().transpose());
+    Tensor<float, 3, 2> t;
+    load_npy(filename, t);
+    TEST_EQ(t(2, 1), 6);
+    TEST_EQ(t(0, 1), 4);
+    Tensor<double, 2, 3> wrong_type;
+    Tensor<float, 2, 2> wrong_shape;
+    int thrown = 0;
+    try {
+        load_npy(filename, wrong_type);
+    } catch (const common::detail::CommonTensorException&) {
+        thrown++;
+    }
+    try {
+        load_npy(filename, wrong_shape);
+    } catch (const common::detail::CommonTensorException&) {
+        thrown++;
+    }
+    TEST_EQ(thrown, 2);
+    std::filesystem::remove(filename);
+})
+
+TEST_CASE(14_npy_writer, {
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "common_test.npy").string();
+    {
+        NpyWriter<int, 3> writer(filename, {2, 3});
+        Tensor<int, 2, 3> row({{0, 1, 2}, {3, 4, 5}});
+        writer.append(row);
+        Tensor<int, 3, 2, 3> block;
+        for (size_t i = 0; i < block.size; ++i)
+            block.data()[i] = static_cast<int>(6 + i);
+        writer.append(block);
+        writer.append(block.view().slice(Slice(1, 3)));
+        TEST_EQ(writer.rows(), 6);
+    }
+    auto d = load_npy<int, 3>(filename);
+    TEST_EQ(d.shape(0), 6);
+    TEST_EQ(d(0, 1, 2), 5);
+    TEST_EQ(d(3, 1, 2), 6 + 17);
+    TEST_EQ(d(4, 0, 0), 6 + 6);
+    std::filesystem::remove(filename);
+})
+
+TEST_CASE(15_gemm_parallel, {
+    // m * n * k above the threshold at which the rows of C are split between
+    // threads, with sizes that are not multiples of the blocks
+    const size_t m = 161, n = 170, k = 180;
+    auto a = random_vector<float>(m * k, 8), b = random_vector<float>(k * n, 9);
+    std::vector<float> c(m * n), expected(m * n, 0);
+    for (size_t i = 0; i < m; ++i)
+        for (size_t p = 0; p < k; ++p)
+            for (size_t j = 0; j < n; ++j)
+                expected[i * n + j] += a[i * k + p] * b[p * n + j];
+    gemm<float>(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n, 1);
+    TEST_TRUE(c == expected);
+})